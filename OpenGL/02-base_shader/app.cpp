@@ -5,8 +5,11 @@
 #include <string>
 #include <ranges>
 
+#include "framework.hpp"
 #include "i_homework.hpp"
 #include "opengl/gl.hpp"
+#include "opengl/gl_timer.hpp"
+#include "profiler/profiler.hpp"
 
 namespace {
 
@@ -90,6 +93,8 @@ std::unique_ptr<IHomework> g_work;
 
 void App::Create()
 {
+    PROFILE_SCOPE("App::Create");
+
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         throw std::runtime_error{"SDL init failed"};
     }
@@ -123,37 +128,26 @@ void App::Create()
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
         // 指定使用核心配置文件（不含过时的固定管线函数）
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-#if !defined(NDEBUG)
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
-#endif
+        Framework::set_context_attributes();
     }
 
     window_ = SDL::Meta<SDL_Window>::create(
         "hello opengl",
         WINDOW_WIDTH,
         WINDOW_HEIGHT,
-        SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_OPENGL);
+        Framework::window_flags(SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_OPENGL));
 
     gl_context_ = SDL::Meta<SDL::SDL_GLContext>::create(window_.get());
 
     SDL_GL_MakeCurrent(window_.get(), gl_context_.get());
     SDL_GL_SetSwapInterval(1); // Enable vsync
-    if(!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(SDL_GL_GetProcAddress)) ) {
-        throw std::runtime_error{"gladLoadGLLoader load failed"};
-	}
-
-    int flags{};
-    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
-    if (flags & GL_CONTEXT_FLAG_DEBUG_BIT) { // enable OpenGL debug context if context allows for debug context
-        // SDL_assert(false);
-        glEnable(GL_DEBUG_OUTPUT);
-        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS); // makes sure errors are displayed synchronously
-        glDebugMessageCallback(GL::glDebugOutput, nullptr);
-        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
-    }
+    Framework::load_gl(window_.get());
 
     g_work = std::make_unique<Demo>();
-    g_work->init();
+    {
+        PROFILE_SCOPE("IHomework::init");
+        g_work->init();
+    }
 }
 
 void App::Destory()
@@ -166,7 +160,12 @@ void App::Destory()
 void App::Render()
 {
     // render
-    g_work->render();
+    {
+        PROFILE_SCOPE("IHomework::render");
+        GL::GpuScope gpu_zone{"render"};
+        g_work->render();
+    }
+    Framework::before_swap(window_.get());
 
     // 显示
     SDL_GL_SwapWindow(window_.get());
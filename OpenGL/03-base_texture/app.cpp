@@ -1,12 +1,22 @@
 #include "app.hpp"
 
 #include <array>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <ranges>
 
+#include "async_load.hpp"
+#include "framework.hpp"
 #include "i_homework.hpp"
 #include "opengl/gl.hpp"
+#include "opengl/gl_call.hpp"
+#include "opengl/gl_texture_cache.hpp"
+#include "opengl/gl_timer.hpp"
+#include "profiler/profiler.hpp"
+#include "startup_graph.hpp"
+#include "task.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
@@ -18,6 +28,14 @@ constexpr auto WINDOW_HEIGHT {static_cast<int>(1080*0.8f)};
 std::shared_ptr<SDL_Window> window_;
 std::shared_ptr<SDL::SDL_GLContext> gl_context_;
 
+std::unique_ptr<GL::TextureCache> g_textures;
+
+constexpr GL::TextureOptions TEXTURE_OPTIONS{.min_filter = GL_NEAREST, .mag_filter = GL_NEAREST};
+constexpr auto BACKEND_TEXTURE {"./preview-backend.jpg"};
+constexpr auto FRONTEND_TEXTURE{"./preview-frontend.jpg"};
+// --gl-budget 时前景层每隔这么多帧在显示与隐藏之间切换
+constexpr uint64_t FRONTEND_TOGGLE_FRAMES{120};
+
 } // namespace
 
 struct Demo : public IHomework
@@ -27,91 +45,76 @@ struct Demo : public IHomework
     GLuint EBO_{};
     std::shared_ptr<GL::ShaderProgram> gl_shader_program_;
 
-    GLuint backend_tex_{};
-    GLuint frontend_tex_{};
+    GL::TextureHandle backend_tex_{};
+    GL::TextureHandle frontend_tex_{};
+
+    // --gl-budget 时网格与纹理登记到 Framework::residency()，被驱逐后在 render 中重新创建
+    GL::ResourceId mesh_id_{};
+    GL::ResourceId backend_id_{};
+    GL::ResourceId frontend_id_{};
+    // 纹理重新加载完成前代替它绘制
+    GLuint fallback_tex_{};
+    uint64_t frame_{};
 
     ~Demo() override {
-        glDeleteTextures(1, &backend_tex_);
-        glDeleteTextures(1, &frontend_tex_);
-        glDeleteBuffers(1, &VBO_);
-        glDeleteBuffers(1, &EBO_);
-        glDeleteVertexArrays(1, &VAO_);
+        delete_mesh();
+        glDeleteTextures(1, &fallback_tex_);
     }
 
-    void init() override {
-        const GL::Shader vertex_shader{GL_VERTEX_SHADER, "shader/vertex.glsl"};
-        const GL::Shader fragment_shader{GL_FRAGMENT_SHADER, "shader/fragment.glsl"};
-        gl_shader_program_ = std::make_shared<GL::ShaderProgram>(vertex_shader, fragment_shader);
+    // 着色器与纹理在 init_async 中加载，完成前只清屏
+    Framework::Task<> init_async() override {
+        // 着色器源文件的读取与纹理的读文件、解码同时进行，全部就绪后在 GL 线程继续
+        auto [program, backend_tex, frontend_tex]{co_await Framework::when_all(
+            Framework::compile_program("shader/vertex.glsl", "shader/fragment.glsl"),
+            Framework::load_texture(*g_textures, BACKEND_TEXTURE, TEXTURE_OPTIONS),
+            Framework::load_texture(*g_textures, FRONTEND_TEXTURE, TEXTURE_OPTIONS))};
+        co_await Framework::tasks().on_main();
 
+        set_border_color(backend_tex);
         {
-            glGenTextures(1, &backend_tex_);
-            GL::glCheckError();
-            glBindTexture(GL_TEXTURE_2D, backend_tex_);
-            GL::glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-            constexpr float borderColor[]{ 1.0f, 1.0f, 0.0f, 1.0f };
-            glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-            int32_t width{};
-            int32_t height{};
-            int32_t n_channels{};
-            stbi_set_flip_vertically_on_load(true);
-            uint8_t *image_data{stbi_load("./preview-backend.jpg", &width, &height, &n_channels, 0)};
-            if (nullptr == image_data) {
-                throw std::runtime_error{"load texture failed"};
-            }
-
-            GLenum format{GL_RGB}; // 根据实际通道数设置格式
-            if (n_channels == 4) { format = GL_RGBA; }
-            else if (n_channels == 1) { format = GL_RED; }
-
-            glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height, 0, format, GL_UNSIGNED_BYTE, image_data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-
-            // glBindTexture(GL_TEXTURE_2D, 0);
+            // 纹理在 render 中绑定，重新加载后 id 会变化
+            program->use();
+            glUniform1i(program->getUniformLocation("u_backend_tex0"),  0);
+            glUniform1i(program->getUniformLocation("u_frontend_tex1"), 1);
         }
-        {
-            glGenTextures(1, &frontend_tex_);
-            GL::glCheckError();
-            glBindTexture(GL_TEXTURE_2D, frontend_tex_);
-            GL::glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            int32_t width{};
-            int32_t height{};
-            int32_t n_channels{};
-            stbi_set_flip_vertically_on_load(true);
-            uint8_t *image_data{stbi_load("./preview-frontend.jpg", &width, &height, &n_channels, 0)};
-            if (nullptr == image_data) {
-                throw std::runtime_error{"load texture failed"};
-            }
+        gl_shader_program_ = std::move(program);
+        backend_tex_ = std::move(backend_tex);
+        frontend_tex_ = std::move(frontend_tex);
 
-            GLenum format{GL_RGB}; // 根据实际通道数设置格式
-            if (n_channels == 4) { format = GL_RGBA; }
-            else if (n_channels == 1) { format = GL_RED; }
+        if (auto *residency{Framework::residency()}; nullptr != residency) {
+            backend_id_ = add_texture(*residency, backend_tex_, BACKEND_TEXTURE, true);
+            frontend_id_ = add_texture(*residency, frontend_tex_, FRONTEND_TEXTURE, false);
+        }
+    }
 
-            glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height, 0, format, GL_UNSIGNED_BYTE, image_data);
-            glGenerateMipmap(GL_TEXTURE_2D);
+    // 仅 backend 纹理使用边框颜色
+    static void set_border_color(const GL::TextureHandle &texture) {
+        constexpr float borderColor[]{ 1.0f, 1.0f, 0.0f, 1.0f };
+        GL::Call::glBindTexture(GL_TEXTURE_2D, texture.id());
+        GL::Call::glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+    }
 
-            // glBindTexture(GL_TEXTURE_2D, 0);
-        }
-        {
-            gl_shader_program_->use();
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, backend_tex_);
-            glUniform1i(gl_shader_program_->getUniformLocation("u_backend_tex0"),  0);
-
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, frontend_tex_);
-            glUniform1i(gl_shader_program_->getUniformLocation("u_frontend_tex1"), 1);
-        }
+    // 驱逐时只释放句柄，纹理在下一次 TextureCache::update() 时删除；重新加载在后台读取、解码，上传完成前绘制 fallback_tex_
+    GL::ResourceId add_texture(GL::ResidencyManager &residency, GL::TextureHandle &texture, const char *path, bool border) {
+        return residency.add(GL::ResourceKind::Texture, [&texture, path, border]() -> std::optional<uint64_t> {
+            if (!texture) {
+                texture = g_textures->load(path, TEXTURE_OPTIONS);
+            }
+            if (texture.failed()) {
+                return uint64_t{0};
+            }
+            if (!texture.ready()) {
+                return std::nullopt;
+            }
+            if (border) {
+                set_border_color(texture);
+            }
+            return GL::texture_bytes(texture.id());
+        }, [&texture] { texture = {}; });
+    }
 
+    // 返回顶点与索引缓冲的字节数
+    uint64_t create_mesh() {
         /**
          * 扩张 UV 坐标
          */
@@ -159,6 +162,31 @@ struct Demo : public IHomework
             glBindBuffer(GL_ARRAY_BUFFER, 0);
             glBindVertexArray(0);
         }
+        return sizeof(vertex) + sizeof(indices);
+    }
+
+    void delete_mesh() {
+        glDeleteBuffers(1, &VBO_);
+        glDeleteBuffers(1, &EBO_);
+        glDeleteVertexArrays(1, &VAO_);
+        VBO_ = 0;
+        EBO_ = 0;
+        VAO_ = 0;
+    }
+
+    void init() override {
+        // 中灰
+        constexpr std::array<uint8_t, 4> FALLBACK_PIXEL{128, 128, 128, 255};
+        glCreateTextures(GL_TEXTURE_2D, 1, &fallback_tex_);
+        glTextureStorage2D(fallback_tex_, 1, GL_RGBA8, 1, 1);
+        glTextureSubImage2D(fallback_tex_, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, FALLBACK_PIXEL.data());
+
+        if (auto *residency{Framework::residency()}; nullptr != residency) {
+            mesh_id_ = residency->add(GL::ResourceKind::Mesh, [this] { return create_mesh(); }, [this] { delete_mesh(); });
+        }
+        else {
+            create_mesh();
+        }
 
         // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
@@ -168,9 +196,24 @@ struct Demo : public IHomework
         // 清屏
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (nullptr == gl_shader_program_) {
+            return;
+        }
+
+        // 被驱逐的网格与纹理在此重新创建；有预算时前景层交替显示与隐藏，隐藏期间不使用，预算不足时被驱逐，再次显示时重新加载
+        bool backend{true};
+        bool frontend{true};
+        if (auto *residency{Framework::residency()}; nullptr != residency) {
+            residency->use(mesh_id_);
+            backend = residency->use(backend_id_);
+            frontend = 0 == frame_ / FRONTEND_TOGGLE_FRAMES % 2 && residency->use(frontend_id_);
+        }
+        frame_ += 1;
 
         // 绘制
         gl_shader_program_->use();
+        glBindTextureUnit(0, backend && backend_tex_.ready() ? backend_tex_.id() : fallback_tex_);
+        glBindTextureUnit(1, frontend && frontend_tex_.ready() ? frontend_tex_.id() : fallback_tex_);
 
         glBindVertexArray(VAO_);
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
@@ -182,11 +225,23 @@ std::unique_ptr<IHomework> g_work;
 
 void App::Create()
 {
-    if (!SDL_Init(SDL_INIT_VIDEO)) {
-        throw std::runtime_error{"SDL init failed"};
-    }
+    PROFILE_SCOPE("App::Create");
+    using Thread = Framework::StartupGraph::Thread;
 
-    {
+    g_work = std::make_unique<Demo>();
+    g_textures = std::make_unique<GL::TextureCache>(
+        Framework::options().texture_client_upload ? GL::TextureUpload::Client : GL::TextureUpload::Pbo);
+    g_textures->set_asset_pack(Framework::asset_pack());
+    Framework::add_idle_check([] { return 0 == g_textures->pending(); });
+
+    // 读文件与解码在工作线程上与窗口、上下文的创建并行，GL 任务在上下文就绪后立即执行
+    Framework::StartupGraph graph;
+    const auto sdl_init{graph.add("SDL_Init", Thread::Main, [] {
+        if (!SDL_Init(SDL_INIT_VIDEO)) {
+            throw std::runtime_error{"SDL init failed"};
+        }
+    })};
+    const auto create_window{graph.add("create window", Thread::Main, [] {
         // 启用双缓冲：前台缓冲显示当前帧，后台缓冲绘制下一帧
         // 交换缓冲时可避免画面撕裂，提升渲染流畅性（默认开启）
         SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
@@ -215,50 +270,52 @@ void App::Create()
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
         // 指定使用核心配置文件（不含过时的固定管线函数）
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-#if !defined(NDEBUG)
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
-#endif
-    }
-
-    window_ = SDL::Meta<SDL_Window>::create(
-        "Learn OpenGL",
-        WINDOW_WIDTH,
-        WINDOW_HEIGHT,
-        SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_OPENGL);
-
-    gl_context_ = SDL::Meta<SDL::SDL_GLContext>::create(window_.get());
-
-    SDL_GL_MakeCurrent(window_.get(), gl_context_.get());
-    SDL_GL_SetSwapInterval(1); // Enable vsync
-    if(!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(SDL_GL_GetProcAddress)) ) {
-        throw std::runtime_error{"gladLoadGLLoader load failed"};
-	}
-
-    int flags{};
-    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
-    if (flags & GL_CONTEXT_FLAG_DEBUG_BIT) { // enable OpenGL debug context if context allows for debug context
-        // SDL_assert(false);
-        glEnable(GL_DEBUG_OUTPUT);
-        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS); // makes sure errors are displayed synchronously
-        glDebugMessageCallback(GL::glDebugOutput, nullptr);
-        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
-    }
-
-    g_work = std::make_unique<Demo>();
-    g_work->init();
+        Framework::set_context_attributes();
+
+        window_ = SDL::Meta<SDL_Window>::create(
+            "Learn OpenGL",
+            WINDOW_WIDTH,
+            WINDOW_HEIGHT,
+            Framework::window_flags(SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_OPENGL));
+    }, {sdl_init})};
+    const auto gl_ready{graph.add("create GL context", Thread::Main, [] {
+        gl_context_ = SDL::Meta<SDL::SDL_GLContext>::create(window_.get());
+
+        SDL_GL_MakeCurrent(window_.get(), gl_context_.get());
+        SDL_GL_SetSwapInterval(1); // Enable vsync
+        Framework::load_gl(window_.get());
+    }, {create_window})};
+
+    g_work->prepare(graph, gl_ready);
+    graph.add("IHomework::init", Thread::Main, [] { g_work->init(); }, graph.all_tasks());
+    graph.run();
+
+    Framework::tasks().spawn("IHomework::init_async", g_work->init_async());
 }
 
 void App::Destory()
 {
     g_work.reset();
+    if (nullptr != g_textures) {
+        SDL_Log("textures: %s", g_textures->stats().to_string().c_str());
+        g_textures.reset();
+    }
 
     SDL_Quit();
 }
 
 void App::Render()
 {
+    // 上传后台解码完成的纹理
+    g_textures->update();
+
     // render
-    g_work->render();
+    {
+        PROFILE_SCOPE("IHomework::render");
+        GL::GpuScope gpu_zone{"render"};
+        g_work->render();
+    }
+    Framework::before_swap(window_.get());
 
     // 显示
     SDL_GL_SwapWindow(window_.get());
@@ -1,18 +1,30 @@
 #include "app.hpp"
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <memory>
+#include <numeric>
 #include <ranges>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <thread>
 
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb/stb_image.h>
 
+#include "framework.hpp"
 #include "i_homework.hpp"
+#include "jobs/task_graph.hpp"
 #include "opengl/gl.hpp"
+#include "opengl/gl_texture_atlas.hpp"
+#include "opengl/gl_texture_cache.hpp"
+#include "opengl/gl_timer.hpp"
+#include "profiler/profiler.hpp"
+#include "startup_graph.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
 
 namespace {
 
@@ -22,6 +34,21 @@ constexpr auto WINDOW_HEIGHT {static_cast<int>(1080*0.8f)};
 std::shared_ptr<SDL_Window> window_;
 std::shared_ptr<SDL::SDL_GLContext> gl_context_;
 
+std::unique_ptr<GL::TextureCache> g_textures;
+
+constexpr std::array CUBE_POSITIONS{
+    glm::vec3( 0.0f,  0.0f,  0.0f),
+    glm::vec3( 2.0f,  5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f,  3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f,  2.0f, -2.5f),
+    glm::vec3( 1.5f,  0.2f, -1.5f),
+    glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+
 } // namespace
 
 struct Demo : public IHomework
@@ -31,90 +58,107 @@ struct Demo : public IHomework
     GLuint EBO_{};
     std::shared_ptr<GL::ShaderProgram> gl_shader_program_;
 
-    GLuint backend_tex_{};
-    GLuint frontend_tex_{};
+    // 放入图集后释放；单层放不下的图片保留为单独的纹理，索引为 STANDALONE
+    GL::TextureHandle backend_tex_{};
+    GL::TextureHandle frontend_tex_{};
+    // 两张纹理拷入同一个数组纹理，绘制时只绑定一次
+    static constexpr uint32_t STANDALONE{0xFFFFFFFFu};
+    std::unique_ptr<GL::TextureAtlas> atlas_{};
+    uint32_t backend_index_{};
+    uint32_t frontend_index_{};
+
+    // --gl-budget 时登记到 Framework::residency()：网格可驱逐；图集的来源纹理已释放，不能重建，不驱逐
+    GL::ResourceId mesh_id_{};
+    GL::ResourceId atlas_id_{};
 
     glm::mat4 model_mat_{1.0f};
     glm::mat4 view_mat_{1.0f};
     glm::mat4 projection_mat_{1.0f};
 
+    // 每帧由 frame_graph_ 在任务系统上更新，render 只读取结果并发出绘制
+    std::array<glm::mat4, CUBE_POSITIONS.size()> models_{};
+    std::array<size_t, CUBE_POSITIONS.size()> draw_order_{};
+    Jobs::TaskGraph frame_graph_{};
+
     ~Demo() override {
+        atlas_.reset();
         gl_shader_program_.reset();
-        glDeleteBuffers(1, &VBO_);
-        glDeleteBuffers(1, &EBO_);
-        glDeleteTextures(1, &frontend_tex_);
-        glDeleteTextures(1, &backend_tex_);
-        glDeleteVertexArrays(1, &VAO_);
+        delete_mesh();
     }
 
-    void init() override {
-        glEnable(GL_DEPTH_TEST);
-
-        const GL::Shader vertex_shader{GL_VERTEX_SHADER, "shader/vertex.glsl"};
-        const GL::Shader fragment_shader{GL_FRAGMENT_SHADER, "shader/fragment.glsl"};
-        gl_shader_program_ = std::make_shared<GL::ShaderProgram>(vertex_shader, fragment_shader);
-
-        {
-            glGenTextures(1, &backend_tex_);
-            GL::glCheckError();
-            glBindTexture(GL_TEXTURE_2D, backend_tex_);
-            GL::glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            int32_t width{};
-            int32_t height{};
-            int32_t n_channels{};
-            stbi_set_flip_vertically_on_load(true);
-            uint8_t *image_data{stbi_load("./preview-backend.jpg", &width, &height, &n_channels, 0)};
-            if (nullptr == image_data) {
+    GL::ShaderSource vertex_source_{};
+    GL::ShaderSource fragment_source_{};
+
+    void prepare(Framework::StartupGraph &graph, Framework::StartupGraph::TaskId gl_ready) override {
+        using Thread = Framework::StartupGraph::Thread;
+
+        const auto read_vertex{graph.add("read vertex.glsl", Thread::Worker, [this] {
+            vertex_source_.code = std::string{Framework::load_asset("shader/vertex.glsl").text()};
+        })};
+        const auto read_fragment{graph.add("read fragment.glsl", Thread::Worker, [this] {
+            fragment_source_.code = std::string{Framework::load_asset("shader/fragment.glsl").text()};
+        })};
+
+        // 编译与链接交给加载线程的共享上下文，与下面的纹理上传并行；init 开始时等待完成
+        graph.add("submit shaders", Thread::Main, [this] {
+            Framework::resource_loader().submit("compile shaders", [this] {
+                const GL::Shader vertex_shader{GL_VERTEX_SHADER, vertex_source_};
+                const GL::Shader fragment_shader{GL_FRAGMENT_SHADER, fragment_source_};
+                gl_shader_program_ = std::make_shared<GL::ShaderProgram>(vertex_shader, fragment_shader);
+            });
+        }, {gl_ready, read_vertex, read_fragment});
+
+        // 读文件与解码在纹理缓存的线程池中进行，此处只需在上下文就绪后完成上传
+        // 立方体缩小显示，使用三线性过滤；有 mip_convert 生成的 .mipc 时直接使用预生成的 mip 链
+        constexpr GL::TextureOptions options{.min_filter = GL_LINEAR_MIPMAP_LINEAR, .mag_filter = GL_LINEAR};
+        backend_tex_ = g_textures->load("./preview-backend.jpg", options);
+        frontend_tex_ = g_textures->load("./preview-frontend.jpg", options);
+        graph.add("upload textures", Thread::Main, [this] {
+            g_textures->finish();
+            if (backend_tex_.failed() || frontend_tex_.failed()) {
                 throw std::runtime_error{"load texture failed"};
             }
 
-            GLenum format{GL_RGB}; // 根据实际通道数设置格式
-            if (n_channels == 4) { format = GL_RGBA; }
-            else if (n_channels == 1) { format = GL_RED; }
-            glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height, 0, format, GL_UNSIGNED_BYTE, image_data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-
-            glBindTexture(GL_TEXTURE_2D, 0);
-        }
-        {
-            glGenTextures(1, &frontend_tex_);
-            GL::glCheckError();
-            glBindTexture(GL_TEXTURE_2D, frontend_tex_);
-            GL::glCheckError();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            int32_t width{};
-            int32_t height{};
-            int32_t n_channels{};
-            stbi_set_flip_vertically_on_load(true);
-            uint8_t *image_data{stbi_load("./preview-frontend.jpg", &width, &height, &n_channels, 0)};
-            if (nullptr == image_data) {
-                throw std::runtime_error{"load texture failed"};
-            }
+            // 层大小按图片确定，不超过 GL_MAX_TEXTURE_SIZE
+            constexpr GLsizei ATLAS_LEVELS{5};
+            GLint max_size{};
+            glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+            const auto required = [](const GL::TextureHandle &texture) {
+                return GL::TextureAtlas::required_layer_size(texture.width(), texture.height(), ATLAS_LEVELS);
+            };
+            const GLsizei layer_size{std::min<GLsizei>(std::max(required(backend_tex_), required(frontend_tex_)), max_size)};
+            atlas_ = std::make_unique<GL::TextureAtlas>(GL_RGBA8, layer_size, ATLAS_LEVELS);
+            const auto add = [this](GL::TextureHandle &texture) {
+                const auto levels{static_cast<GLsizei>(std::bit_width(static_cast<unsigned>(std::max(texture.width(), texture.height()))))};
+                const auto index{atlas_->add(texture.id(), texture.width(), texture.height(), levels)};
+                if (!index.has_value()) {
+                    SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "atlas: %dx%d texture kept standalone", texture.width(), texture.height());
+                    return STANDALONE;
+                }
+                texture = {};
+                return *index;
+            };
+            backend_index_ = add(backend_tex_);
+            frontend_index_ = add(frontend_tex_);
+            SDL_Log("atlas: %s", atlas_->to_string().c_str());
+        }, {gl_ready});
+    }
 
-            GLenum format{GL_RGB}; // 根据实际通道数设置格式
-            if (n_channels == 4) { format = GL_RGBA; }
-            else if (n_channels == 1) { format = GL_RED; }
-            glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height, 0, format, GL_UNSIGNED_BYTE, image_data);
-            glGenerateMipmap(GL_TEXTURE_2D);
+    // 着色器与纹理已由 prepare 中的任务创建
+    void init() override {
+        Framework::resource_loader().finish();
+        glEnable(GL_DEPTH_TEST);
 
-            glBindTexture(GL_TEXTURE_2D, 0);
-        }
         {
             gl_shader_program_->use();
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, backend_tex_);
-            glUniform1i(gl_shader_program_->getUniformLocation("u_backend_tex0"), 0);
-
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, frontend_tex_);
-            glUniform1i(gl_shader_program_->getUniformLocation("u_frontend_tex1"), 1);
+            atlas_->bind(0, 0);
+            glUniform1i(gl_shader_program_->getUniformLocation("u_atlas"), 0);
+            glUniform1ui(gl_shader_program_->getUniformLocation("u_backend_index"), backend_index_);
+            glUniform1ui(gl_shader_program_->getUniformLocation("u_frontend_index"), frontend_index_);
+            glBindTextureUnit(1, backend_tex_.id());
+            glBindTextureUnit(2, frontend_tex_.id());
+            glUniform1i(gl_shader_program_->getUniformLocation("u_backend_tex"), 1);
+            glUniform1i(gl_shader_program_->getUniformLocation("u_frontend_tex"), 2);
 
             model_mat_ = glm::rotate(model_mat_, glm::radians(50.0f), glm::vec3(0.5f, 1.0f, 0.0f));
             view_mat_ = glm::translate(view_mat_, glm::vec3(0.0f, 0.0f, -3.0f));
@@ -129,6 +173,45 @@ struct Demo : public IHomework
             glUniformMatrix4fv(gl_shader_program_->getUniformLocation("u_projection_mat"), 1, GL_FALSE, glm::value_ptr(projection_mat_));
         }
 
+        if (auto *residency{Framework::residency()}; nullptr != residency) {
+            mesh_id_ = residency->add(GL::ResourceKind::Mesh, [this] { return create_mesh(); }, [this] { delete_mesh(); });
+            atlas_id_ = residency->add(GL::ResourceKind::Texture, [this] { return GL::texture_bytes(atlas_->texture()); },
+                [this] { atlas_.reset(); }, false);
+        }
+        else {
+            create_mesh();
+        }
+
+        // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+        for (size_t i{}; i < models_.size(); ++i) {
+            models_[i] = glm::translate(glm::mat4{1.0f}, CUBE_POSITIONS[i]);
+        }
+        std::iota(draw_order_.begin(), draw_order_.end(), size_t{0});
+
+        // 结构不变，构建一次后每帧执行
+        const auto animate{frame_graph_.add("animate cubes", [this] {
+            // 只有 10 个矩阵，低于默认的 16 KiB 时总在调用线程执行；按一个矩阵（一个缓存行）切分
+            Jobs::parallel_for(Framework::jobs(), "animate cubes", std::span<glm::mat4>{models_}, [](std::span<glm::mat4> chunk, size_t first) {
+                for (size_t i{}; i < chunk.size(); ++i) {
+                    if (const auto index{first + i}; index % 3 == 0) {
+                        const float angle{20.0f * static_cast<float>(index) + 10.0f};
+                        chunk[i] = glm::rotate(chunk[i], glm::radians(angle) * 0.01f, glm::vec3(1.0f, 0.3f, 0.5f));
+                    }
+                }
+            }, sizeof(glm::mat4));
+        })};
+        // 由近到远绘制，被遮挡的片元可在深度测试中提前丢弃
+        frame_graph_.add("sort draws", [this] {
+            std::ranges::sort(draw_order_, [this](size_t lhs, size_t rhs) {
+                return (view_mat_ * models_[lhs][3]).z > (view_mat_ * models_[rhs][3]).z;
+            });
+        }, {animate});
+    }
+
+    // 返回顶点缓冲的字节数
+    uint64_t create_mesh() {
         constexpr std::array vertex{
             // x      y     z      r     g     b      u     v
             // -0.5f,  0.5f, 0.0f,  1.0f, 1.0f, 0.0f,  0.0f, 1.0f, // left top
@@ -201,52 +284,37 @@ struct Demo : public IHomework
             glBindBuffer(GL_ARRAY_BUFFER, 0);
             glBindVertexArray(0);
         }
+        return sizeof(vertex);
+    }
 
-        // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    void delete_mesh() {
+        glDeleteBuffers(1, &VBO_);
+        glDeleteBuffers(1, &EBO_);
+        glDeleteVertexArrays(1, &VAO_);
+        VBO_ = 0;
+        EBO_ = 0;
+        VAO_ = 0;
     }
 
     void render() override {
-        constexpr glm::vec3 cubePositions[]{
-            glm::vec3( 0.0f,  0.0f,  0.0f),
-            glm::vec3( 2.0f,  5.0f, -15.0f),
-            glm::vec3(-1.5f, -2.2f, -2.5f),
-            glm::vec3(-3.8f, -2.0f, -12.3f),
-            glm::vec3( 2.4f, -0.4f, -3.5f),
-            glm::vec3(-1.7f,  3.0f, -7.5f),
-            glm::vec3( 1.3f, -2.0f, -2.5f),
-            glm::vec3( 1.5f,  2.0f, -2.5f),
-            glm::vec3( 1.5f,  0.2f, -1.5f),
-            glm::vec3(-1.3f,  1.0f, -1.5f)
-        };
-        static glm::mat4 model_arr[] {
-            glm::translate(glm::mat4{1.0f}, cubePositions[0]),
-            glm::translate(glm::mat4{1.0f}, cubePositions[1]),
-            glm::translate(glm::mat4{1.0f}, cubePositions[2]),
-            glm::translate(glm::mat4{1.0f}, cubePositions[3]),
-            glm::translate(glm::mat4{1.0f}, cubePositions[4]),
-            glm::translate(glm::mat4{1.0f}, cubePositions[5]),
-            glm::translate(glm::mat4{1.0f}, cubePositions[6]),
-            glm::translate(glm::mat4{1.0f}, cubePositions[7]),
-            glm::translate(glm::mat4{1.0f}, cubePositions[8]),
-            glm::translate(glm::mat4{1.0f}, cubePositions[9]),
-        };
+        frame_graph_.run(Framework::jobs());
 
         // 清屏
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        // 被驱逐的网格在此重新创建
+        if (auto *residency{Framework::residency()}; nullptr != residency) {
+            residency->use(mesh_id_);
+            residency->use(atlas_id_);
+        }
+
         // 绘制
         gl_shader_program_->use();
 
         glBindVertexArray(VAO_);
-        for (auto i{0}; i < 10; i++) {
-            glm::mat4 &model = model_arr[i];
-            if (i % 3 == 0) {
-                float angle = 20.0f * static_cast<float>(i) + 10.0f;
-                model = glm::rotate(model, glm::radians(angle) * 0.01f, glm::vec3(1.0f, 0.3f, 0.5f));
-            }
-            glUniformMatrix4fv(gl_shader_program_->getUniformLocation("u_model_mat"), 1, GL_FALSE, glm::value_ptr(model));
+        for (const auto i : draw_order_) {
+            glUniformMatrix4fv(gl_shader_program_->getUniformLocation("u_model_mat"), 1, GL_FALSE, glm::value_ptr(models_[i]));
             glDrawArrays(GL_TRIANGLES, 0, 36);
         }
 
@@ -260,11 +328,23 @@ std::unique_ptr<IHomework> g_work;
 
 void App::Create()
 {
-    if (!SDL_Init(SDL_INIT_VIDEO)) {
-        throw std::runtime_error{"SDL init failed"};
-    }
+    PROFILE_SCOPE("App::Create");
+    using Thread = Framework::StartupGraph::Thread;
 
-    {
+    g_work = std::make_unique<Demo>();
+    g_textures = std::make_unique<GL::TextureCache>(
+        Framework::options().texture_client_upload ? GL::TextureUpload::Client : GL::TextureUpload::Pbo);
+    g_textures->set_asset_pack(Framework::asset_pack());
+    Framework::add_idle_check([] { return 0 == g_textures->pending(); });
+
+    // 读文件与解码在工作线程上与窗口、上下文的创建并行，GL 任务在上下文就绪后立即执行
+    Framework::StartupGraph graph;
+    const auto sdl_init{graph.add("SDL_Init", Thread::Main, [] {
+        if (!SDL_Init(SDL_INIT_VIDEO)) {
+            throw std::runtime_error{"SDL init failed"};
+        }
+    })};
+    const auto create_window{graph.add("create window", Thread::Main, [] {
         // 启用双缓冲：前台缓冲显示当前帧，后台缓冲绘制下一帧
         // 交换缓冲时可避免画面撕裂，提升渲染流畅性（默认开启）
         SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
@@ -293,50 +373,50 @@ void App::Create()
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
         // 指定使用核心配置文件（不含过时的固定管线函数）
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-#if !defined(NDEBUG)
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
-#endif
-    }
-
-    window_ = SDL::Meta<SDL_Window>::create(
-        "Learn OpenGL",
-        WINDOW_WIDTH,
-        WINDOW_HEIGHT,
-        SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_OPENGL);
-
-    gl_context_ = SDL::Meta<SDL::SDL_GLContext>::create(window_.get());
-
-    SDL_GL_MakeCurrent(window_.get(), gl_context_.get());
-    SDL_GL_SetSwapInterval(1); // Enable vsync
-    if(!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(SDL_GL_GetProcAddress)) ) {
-        throw std::runtime_error{"gladLoadGLLoader load failed"};
-	}
-
-    int flags{};
-    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
-    if (flags & GL_CONTEXT_FLAG_DEBUG_BIT) { // enable OpenGL debug context if context allows for debug context
-        // SDL_assert(false);
-        glEnable(GL_DEBUG_OUTPUT);
-        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS); // makes sure errors are displayed synchronously
-        glDebugMessageCallback(GL::glDebugOutput, nullptr);
-        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
-    }
-
-    g_work = std::make_unique<Demo>();
-    g_work->init();
+        Framework::set_context_attributes();
+
+        window_ = SDL::Meta<SDL_Window>::create(
+            "Learn OpenGL",
+            WINDOW_WIDTH,
+            WINDOW_HEIGHT,
+            Framework::window_flags(SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_OPENGL));
+    }, {sdl_init})};
+    const auto gl_ready{graph.add("create GL context", Thread::Main, [] {
+        gl_context_ = SDL::Meta<SDL::SDL_GLContext>::create(window_.get());
+
+        SDL_GL_MakeCurrent(window_.get(), gl_context_.get());
+        SDL_GL_SetSwapInterval(1); // Enable vsync
+        Framework::load_gl(window_.get());
+    }, {create_window})};
+
+    g_work->prepare(graph, gl_ready);
+    graph.add("IHomework::init", Thread::Main, [] { g_work->init(); }, graph.all_tasks());
+    graph.run();
 }
 
 void App::Destory()
 {
     g_work.reset();
+    if (nullptr != g_textures) {
+        SDL_Log("textures: %s", g_textures->stats().to_string().c_str());
+        g_textures.reset();
+    }
 
     SDL_Quit();
 }
 
 void App::Render()
 {
+    // 上传后台解码完成的纹理
+    g_textures->update();
+
     // render
-    g_work->render();
+    {
+        PROFILE_SCOPE("IHomework::render");
+        GL::GpuScope gpu_zone{"render"};
+        g_work->render();
+    }
+    Framework::before_swap(window_.get());
 
     // 显示
     SDL_GL_SwapWindow(window_.get());
@@ -3,8 +3,33 @@
 layout (location = 0) in  vec2 v_tex_coord;
 layout (location = 0) out vec4 f_color;
 
-uniform sampler2D u_backend_tex0;
-uniform sampler2D u_frontend_tex1;
+// 与 GL::AtlasRegion 对应：uv_transform 为 (scale.xy, offset.xy)，layer.x 为数组层
+struct AtlasRegion {
+    vec4 uv_transform;
+    vec4 layer;
+};
+layout (std430, binding = 0) readonly buffer AtlasTable {
+    AtlasRegion u_regions[];
+};
+
+uniform sampler2DArray u_atlas;
+uniform uint u_backend_index;
+uniform uint u_frontend_index;
+// 图集单层放不下的图片（索引为 STANDALONE）仍使用单独的纹理
+uniform sampler2D u_backend_tex;
+uniform sampler2D u_frontend_tex;
+
+const uint STANDALONE = 0xFFFFFFFFu;
+
+// 图集中的 uv 已向内收缩半个纹素，这里先钳制到 [0, 1] 以保持 CLAMP_TO_EDGE 行为
+vec4 sampleAtlas(uint index, sampler2D standalone, vec2 tex_coord) {
+    if (index == STANDALONE) {
+        return texture(standalone, clamp(tex_coord, 0.0, 1.0));
+    }
+    AtlasRegion region = u_regions[index];
+    vec2 uv = clamp(tex_coord, 0.0, 1.0) * region.uv_transform.xy + region.uv_transform.zw;
+    return texture(u_atlas, vec3(uv, region.layer.x));
+}
 
 vec2 flipTexXCoord(vec2 tex_coord) {
     return vec2(1.0 - tex_coord.x, tex_coord.y);
@@ -12,6 +37,6 @@ vec2 flipTexXCoord(vec2 tex_coord) {
 
 void main()
 {
-    f_color = mix(texture(u_backend_tex0, v_tex_coord), texture(u_frontend_tex1, flipTexXCoord(v_tex_coord)), 0.3);
-    // f_color = mix(texture(u_backend_tex0, v_tex_coord), texture(u_frontend_tex1, v_tex_coord), 0.3);
+    f_color = mix(sampleAtlas(u_backend_index, u_backend_tex, v_tex_coord), sampleAtlas(u_frontend_index, u_frontend_tex, flipTexXCoord(v_tex_coord)), 0.3);
+    // f_color = mix(sampleAtlas(u_backend_index, u_backend_tex, v_tex_coord), sampleAtlas(u_frontend_index, u_frontend_tex, v_tex_coord), 0.3);
 }
\ No newline at end of file
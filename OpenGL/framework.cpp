@@ -0,0 +1,686 @@
+#include "framework.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <coroutine>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "image/image_diff.hpp"
+#include "image/tga.hpp"
+#include "opengl/gl.hpp"
+#include "opengl/gl_capture.hpp"
+#include "opengl/gl_debug_log.hpp"
+#include "opengl/gl_loader.hpp"
+#include "opengl/gl_memory.hpp"
+#include "opengl/gl_stats.hpp"
+#include "opengl/gl_timer.hpp"
+#include "opengl/gl_trace.hpp"
+#include "profiler/profiler.hpp"
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
+namespace {
+
+// 超过 golden_frame 之后仍在加载的最大帧数
+constexpr uint64_t GOLDEN_MAX_WAIT_FRAMES{600};
+
+Framework::Options g_options;
+Framework::ContextInfo g_context_info;
+SDL_AppResult g_frame_result{SDL_APP_CONTINUE};
+uint64_t g_frame_index{};
+std::unique_ptr<GL::FrameCapture> g_capture;
+std::unique_ptr<GL::GpuProfiler> g_gpu_profiler;
+std::unique_ptr<GL::DebugLog> g_debug_log;
+std::unique_ptr<Framework::ResourceLoader> g_loader;
+std::shared_ptr<const Image::AssetPack> g_asset_pack;
+std::unique_ptr<Image::IoScheduler> g_io;
+std::unique_ptr<Framework::TaskScheduler> g_tasks;
+std::unique_ptr<Jobs::JobSystem> g_jobs;
+std::unique_ptr<GL::ResidencyManager> g_residency;
+std::vector<std::function<bool()>> g_idle_checks;
+SDL_Window *g_window{};
+
+struct ZoneTotal
+{
+    uint64_t count{};
+    int64_t total_ns{};
+};
+std::map<std::string_view, ZoneTotal> g_gpu_zone_totals;
+
+struct StartupTiming
+{
+    std::chrono::steady_clock::time_point context_ready{};
+    double loader_ms{};
+    GL::Loader::LoadStats loader_stats{};
+};
+StartupTiming g_startup;
+
+template <class T>
+T parse_number(std::string_view name, std::string_view text)
+{
+    T value{};
+    const auto [ptr, ec]{std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (ec != std::errc{} || ptr != text.data() + text.size()) {
+        throw std::runtime_error{std::format("ERROR::OPTIONS what:invalid value '{}' for {}", text, name)};
+    }
+    return value;
+}
+
+std::vector<uint8_t> read_back_buffer(int width, int height)
+{
+    const auto row_bytes{static_cast<size_t>(width) * 4};
+    std::vector<uint8_t> pixels(row_bytes * static_cast<size_t>(height));
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glReadBuffer(GL_BACK);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    GL::glCheckError();
+
+    // OpenGL 的原点在左下角，翻转为自上而下
+    std::vector<uint8_t> row(row_bytes);
+    for (size_t top{}, bottom{static_cast<size_t>(height) - 1}; top < bottom; ++top, --bottom) {
+        std::copy_n(pixels.data() + top * row_bytes, row_bytes, row.data());
+        std::copy_n(pixels.data() + bottom * row_bytes, row_bytes, pixels.data() + top * row_bytes);
+        std::copy_n(row.data(), row_bytes, pixels.data() + bottom * row_bytes);
+    }
+    return pixels;
+}
+
+bool loading_idle()
+{
+    if (nullptr != g_tasks && 0 != g_tasks->pending()) {
+        return false;
+    }
+    return std::ranges::all_of(g_idle_checks, [](const auto &idle) { return idle(); });
+}
+
+SDL_AppResult check_golden(const std::vector<uint8_t> &frame, int width, int height)
+{
+    const auto &path{g_options.golden_path};
+    if (g_options.golden_update) {
+        Image::write_tga(path, static_cast<uint32_t>(width), static_cast<uint32_t>(height), frame);
+        SDL_Log("golden: updated %s (%dx%d)", path.string().c_str(), width, height);
+        return SDL_APP_SUCCESS;
+    }
+
+    int golden_width{};
+    int golden_height{};
+    int n_channels{};
+    std::unique_ptr<uint8_t, decltype(&stbi_image_free)> golden{
+        stbi_load(path.string().c_str(), &golden_width, &golden_height, &n_channels, 4),
+        &stbi_image_free};
+    if (nullptr == golden) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "golden: can not load %s: %s",
+            path.string().c_str(), stbi_failure_reason());
+        return SDL_APP_FAILURE;
+    }
+    if (golden_width != width || golden_height != height) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "golden: size mismatch, frame %dx%d golden %dx%d",
+            width, height, golden_width, golden_height);
+        return SDL_APP_FAILURE;
+    }
+
+    const Image::DiffOptions diff_options{
+        .channel_tolerance    = g_options.golden_tolerance,
+        .perceptual_threshold = g_options.golden_perceptual_threshold,
+        .max_mismatch_ratio   = g_options.golden_max_mismatch_ratio,
+    };
+    const std::span<const uint8_t> golden_pixels{golden.get(), frame.size()};
+    const auto result{Image::diff_rgba8(frame, golden_pixels,
+        static_cast<uint32_t>(width), static_cast<uint32_t>(height), diff_options)};
+
+    const auto summary{std::format(
+        "golden: {} over_tolerance={} perceptual_mismatch={} max_delta={} max_perceptual={:.5f} psnr={:.2f}dB",
+        path.string(), result.over_tolerance_pixels, result.perceptual_mismatch_pixels,
+        result.max_channel_delta, result.max_perceptual_delta, result.psnr)};
+    if (result.passed(diff_options)) {
+        SDL_Log("%s PASSED", summary.c_str());
+        return SDL_APP_SUCCESS;
+    }
+
+    auto diff_path{path};
+    diff_path.replace_extension(".diff.tga");
+    Image::write_tga(diff_path, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+        Image::make_diff_image(frame, golden_pixels,
+            static_cast<uint32_t>(width), static_cast<uint32_t>(height), diff_options));
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s FAILED, diff written to %s",
+        summary.c_str(), diff_path.string().c_str());
+    return SDL_APP_FAILURE;
+}
+
+// 读取整个文件，回调在 before_swap 的 poll() 中执行，把协程交给下一次 run_tasks() 恢复
+struct IoRead
+{
+    std::filesystem::path path{};
+    Image::IoResult result{};
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        Framework::io_scheduler().read(path, [this, handle](Image::IoResult &&done) {
+            result = std::move(done);
+            Framework::tasks().resume_on_main(handle);
+        });
+    }
+    Image::IoResult await_resume() { return std::move(result); }
+};
+
+} // namespace
+
+namespace Framework {
+
+void parse_options(int argc, char *argv[])
+{
+    for (int i{1}; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+        const auto next_value = [&]() -> std::string_view {
+            if (i + 1 >= argc) {
+                throw std::runtime_error{std::format("ERROR::OPTIONS what:missing value for {}", arg)};
+            }
+            return argv[++i];
+        };
+
+        if ("--headless" == arg) {
+            g_options.headless = true;
+        }
+        else if ("--golden" == arg) {
+            g_options.golden_path = next_value();
+        }
+        else if ("--golden-update" == arg) {
+            g_options.golden_update = true;
+        }
+        else if ("--golden-frame" == arg) {
+            g_options.golden_frame = parse_number<uint64_t>(arg, next_value());
+        }
+        else if ("--golden-tolerance" == arg) {
+            g_options.golden_tolerance = parse_number<uint8_t>(arg, next_value());
+        }
+        else if ("--golden-threshold" == arg) {
+            g_options.golden_perceptual_threshold = parse_number<double>(arg, next_value());
+        }
+        else if ("--golden-max-mismatch" == arg) {
+            g_options.golden_max_mismatch_ratio = parse_number<double>(arg, next_value());
+        }
+        else if ("--capture" == arg) {
+            g_options.capture_path = next_value();
+        }
+        else if ("--capture-fps" == arg) {
+            g_options.capture_fps = parse_number<uint32_t>(arg, next_value());
+        }
+        else if ("--trace" == arg) {
+            g_options.trace_path = next_value();
+        }
+        else if ("--gl-stats" == arg) {
+            g_options.gl_stats_interval = parse_number<uint64_t>(arg, next_value());
+        }
+        else if ("--gl-memory" == arg) {
+            g_options.gl_memory_interval = parse_number<uint64_t>(arg, next_value());
+        }
+        else if ("--gl-budget" == arg) {
+            g_options.gl_budget_mib = parse_number<uint64_t>(arg, next_value());
+        }
+        else if ("--gpu-profile" == arg) {
+            g_options.gpu_profile = true;
+        }
+        else if ("--profile" == arg) {
+            g_options.profile_path = next_value();
+        }
+        else if ("--gl-context" == arg) {
+            const auto value{next_value()};
+            if (context_profile_name(ContextProfile::Debug) == value) {
+                g_options.context_profile = ContextProfile::Debug;
+            }
+            else if (context_profile_name(ContextProfile::Production) == value) {
+                g_options.context_profile = ContextProfile::Production;
+            }
+            else {
+                throw std::runtime_error{std::format("ERROR::OPTIONS what:invalid value '{}' for {}", value, arg)};
+            }
+        }
+        else if ("--gl-full-loader" == arg) {
+            g_options.gl_full_loader = true;
+        }
+        else if ("--gl-sync-loader" == arg) {
+            g_options.gl_sync_loader = true;
+        }
+        else if ("--gl-debug-async" == arg) {
+            g_options.gl_debug_async = true;
+        }
+        else if ("--texture-client-upload" == arg) {
+            g_options.texture_client_upload = true;
+        }
+        else if ("--asset-pack" == arg) {
+            g_options.asset_pack_path = next_value();
+        }
+        else if ("--io-backend" == arg) {
+            const auto value{next_value()};
+            if (Image::io_backend_name(Image::IoBackend::Auto) == value) {
+                g_options.io_backend = Image::IoBackend::Auto;
+            }
+            else if (Image::io_backend_name(Image::IoBackend::Uring) == value) {
+                g_options.io_backend = Image::IoBackend::Uring;
+            }
+            else if (Image::io_backend_name(Image::IoBackend::Threads) == value) {
+                g_options.io_backend = Image::IoBackend::Threads;
+            }
+            else {
+                throw std::runtime_error{std::format("ERROR::OPTIONS what:invalid value '{}' for {}", value, arg)};
+            }
+        }
+        else if ("--task-budget" == arg) {
+            g_options.task_budget_ms = parse_number<double>(arg, next_value());
+        }
+        else if ("--job-workers" == arg) {
+            g_options.job_workers = parse_number<size_t>(arg, next_value());
+        }
+        else if ("--max-speed" == arg) {
+            g_options.max_speed = true;
+        }
+        else if (!arg.starts_with("--")) {
+            g_options.arguments.emplace_back(arg);
+        }
+        else {
+            throw std::runtime_error{std::format("ERROR::OPTIONS what:unknown option {}", arg)};
+        }
+    }
+
+    if (!g_options.profile_path.empty() && !Profiler::ENABLED) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "profile: not compiled in, rebuild with -DENABLE_PROFILER=ON");
+        g_options.profile_path.clear();
+    }
+
+    if (g_options.headless) {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    }
+
+    // 在任何工作线程启动之前打开，之后只读
+    if (!g_options.asset_pack_path.empty()) {
+        g_asset_pack = std::make_shared<const Image::AssetPack>(g_options.asset_pack_path);
+        SDL_Log("assets: %zu entries from %s", g_asset_pack->size(), g_options.asset_pack_path.string().c_str());
+    }
+}
+
+const Options &options()
+{
+    return g_options;
+}
+
+SDL_WindowFlags window_flags(SDL_WindowFlags flags)
+{
+    if (g_options.headless) {
+        flags |= SDL_WINDOW_HIDDEN;
+    }
+    return flags;
+}
+
+void set_context_attributes()
+{
+    switch (g_options.context_profile) {
+        case ContextProfile::Debug:
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_NO_ERROR, 0);
+            break;
+        case ContextProfile::Production:
+            // KHR_no_error 与 debug context 不能同时请求
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_NO_ERROR, 1);
+            break;
+    }
+}
+
+const ContextInfo &context_info()
+{
+    return g_context_info;
+}
+
+namespace {
+
+void after_gl_load(SDL_Window *window)
+{
+    int flags{};
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    g_context_info = {
+        .profile  = g_options.context_profile,
+        .debug    = 0 != (flags & GL_CONTEXT_FLAG_DEBUG_BIT),
+        .no_error = 0 != (flags & GL_CONTEXT_FLAG_NO_ERROR_BIT),
+    };
+    SDL_Log("gl-context: %s (debug=%d no_error=%d) %s", context_profile_name(g_context_info.profile).data(),
+        g_context_info.debug, g_context_info.no_error, reinterpret_cast<const char *>(glGetString(GL_VERSION)));
+    if (ContextProfile::Production == g_context_info.profile && !g_context_info.no_error) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "gl-context: KHR_no_error not granted by the driver, validation stays on");
+    }
+
+    // debug context 下接管 GL debug message，先于拦截层安装，glDebugMessageCallback 不进入 trace
+    if (g_context_info.debug) {
+        g_debug_log = std::make_unique<GL::DebugLog>();
+        g_debug_log->install(!g_options.gl_debug_async);
+    }
+
+    if (!g_options.trace_path.empty()) {
+        int width{};
+        int height{};
+        SDL_GetWindowSizeInPixels(window, &width, &height);
+        GL::Trace::start_recording(g_options.trace_path, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+    }
+
+    // 导出 CPU profile 时同时记录 GPU zone，放在同一时间轴上
+    if (g_options.gpu_profile || !g_options.profile_path.empty()) {
+        g_gpu_profiler = std::make_unique<GL::GpuProfiler>();
+        g_gpu_profiler->set_frame_callback([](const GL::GpuFrame &frame) {
+            for (const auto &zone : frame.zones) {
+                auto &total{g_gpu_zone_totals[zone.name]};
+                total.count += 1;
+                total.total_ns += zone.end_ns - zone.begin_ns;
+                Profiler::add_gpu_zone(zone.name, zone.begin_ns, zone.end_ns);
+            }
+        });
+        GL::GpuProfiler::set_current(g_gpu_profiler.get());
+    }
+
+    if (0 != g_options.gl_stats_interval) {
+        if constexpr (GL::Stats::ENABLED) {
+            GL::Stats::install();
+        }
+        else {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "gl-stats: not compiled in, rebuild with -DENABLE_GL_FRAME_STATS=ON");
+            g_options.gl_stats_interval = 0;
+        }
+    }
+
+    if (0 != g_options.gl_memory_interval) {
+        GL::Memory::install();
+    }
+
+    if (0 != g_options.gl_budget_mib) {
+        g_residency = std::make_unique<GL::ResidencyManager>(g_options.gl_budget_mib * 1024 * 1024);
+    }
+}
+
+} // namespace
+
+void load_gl(SDL_Window *window)
+{
+    PROFILE_SCOPE("Framework::load_gl");
+    g_startup.context_ready = std::chrono::steady_clock::now();
+    g_window = window;
+    const auto proc{reinterpret_cast<GLADloadproc>(SDL_GL_GetProcAddress)};
+    const bool loaded{g_options.gl_full_loader
+        ? 0 != gladLoadGLLoader(proc)
+        : GL::Loader::load(proc, &g_startup.loader_stats)};
+    if (!loaded) {
+        throw std::runtime_error{"ERROR::GL_LOADER what:can not load OpenGL functions"};
+    }
+    g_startup.loader_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - g_startup.context_ready).count();
+    after_gl_load(window);
+}
+
+void before_swap(SDL_Window *window)
+{
+    ++g_frame_index;
+    if (1 == g_frame_index) {
+        const double first_frame_ms{std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - g_startup.context_ready).count()};
+        if (g_options.gl_full_loader) {
+            SDL_Log("startup: glad loader %.3f ms, context to first frame %.3f ms",
+                g_startup.loader_ms, first_frame_ms);
+        }
+        else {
+            const auto &stats{g_startup.loader_stats};
+            SDL_Log("startup: minimal loader %.3f ms (%zu eager, %zu missing, %zu deferred, %zu resolved lazily), "
+                "context to first frame %.3f ms", g_startup.loader_ms, stats.eager, stats.missing, stats.deferred,
+                GL::Loader::lazy_resolved(), first_frame_ms);
+        }
+    }
+    if (nullptr != g_loader) {
+        g_loader->poll();
+    }
+    if (nullptr != g_io) {
+        g_io->poll();
+    }
+    if (nullptr != g_debug_log) {
+        g_debug_log->drain();
+    }
+    if (nullptr != g_gpu_profiler) {
+        g_gpu_profiler->end_frame();
+    }
+    GL::Trace::end_frame();
+    GL::Stats::end_frame();
+    if (0 != g_options.gl_stats_interval && 0 == g_frame_index % g_options.gl_stats_interval) {
+        SDL_Log("gl-stats: %s", GL::Stats::last_frame().to_string().c_str());
+    }
+    if (nullptr != g_residency) {
+        g_residency->end_frame();
+    }
+    if (0 != g_options.gl_memory_interval && 0 == g_frame_index % g_options.gl_memory_interval) {
+        SDL_Log("gl-memory: %s", GL::Memory::usage().to_string().c_str());
+        if (nullptr != g_residency) {
+            SDL_Log("gl-budget: %s", g_residency->stats().to_string().c_str());
+        }
+    }
+
+    int width{};
+    int height{};
+    SDL_GetWindowSizeInPixels(window, &width, &height);
+
+    if (!g_options.capture_path.empty()) {
+        if (nullptr == g_capture) {
+            try {
+                g_capture = std::make_unique<GL::FrameCapture>(
+                    g_options.capture_path, width, height, g_options.capture_fps);
+            }
+            catch (const std::runtime_error &error) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "capture: %s", error.what());
+                g_options.capture_path.clear();
+            }
+        }
+        if (nullptr != g_capture) {
+            g_capture->capture();
+        }
+    }
+
+    // 画面取决于加载进度，等异步加载全部结束后再比对
+    if (!g_options.golden_path.empty() && SDL_APP_CONTINUE == g_frame_result && g_frame_index >= g_options.golden_frame) {
+        if (loading_idle()) {
+            g_frame_result = check_golden(read_back_buffer(width, height), width, height);
+        }
+        else if (g_frame_index - g_options.golden_frame >= GOLDEN_MAX_WAIT_FRAMES) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "golden: still loading %" SDL_PRIu64 " frames after frame %" SDL_PRIu64,
+                GOLDEN_MAX_WAIT_FRAMES, g_options.golden_frame);
+            g_frame_result = SDL_APP_FAILURE;
+        }
+    }
+}
+
+void shutdown()
+{
+    g_idle_checks.clear();
+    // 协程帧中可能有 GL 对象与纹理句柄，在 App::Destory 之前销毁
+    if (nullptr != g_tasks) {
+        SDL_Log("tasks: %s", g_tasks->stats().to_string().c_str());
+        g_tasks.reset();
+    }
+    if (nullptr != g_jobs) {
+        SDL_Log("jobs: %zu threads, %s", g_jobs->thread_count(), g_jobs->stats().to_string().c_str());
+        g_jobs.reset();
+    }
+    // 卸载回调删除程序登记的 GL 对象，须在 App::Destory 之前
+    if (nullptr != g_residency) {
+        SDL_Log("gl-budget: %s", g_residency->stats().to_string().c_str());
+        g_residency.reset();
+    }
+    // 加载线程的上下文与主上下文共享对象，先于 App::Destory 停止
+    if (nullptr != g_loader) {
+        SDL_Log("loader: %s", g_loader->stats().to_string().c_str());
+        g_loader.reset();
+    }
+    // 销毁时等待已交给内核的读取结束，之后不再调用回调
+    if (nullptr != g_io) {
+        SDL_Log("io: %s, %s", Image::io_backend_name(g_io->backend()).data(), g_io->stats().to_string().c_str());
+        g_io.reset();
+    }
+    // 按安装的相反顺序卸载拦截层
+    if (0 != g_options.gl_memory_interval) {
+        GL::Memory::uninstall();
+        SDL_Log("gl-memory: %s", GL::Memory::usage().to_string().c_str());
+    }
+    if (0 != g_options.gl_stats_interval) {
+        GL::Stats::uninstall();
+    }
+    if (!g_options.profile_path.empty()) {
+        try {
+            const auto events{Profiler::write_chrome_trace(g_options.profile_path)};
+            SDL_Log("profile: %zu events written to %s", events, g_options.profile_path.string().c_str());
+        }
+        catch (const std::runtime_error &error) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "profile: %s", error.what());
+        }
+    }
+    if (g_options.gpu_profile && nullptr != g_gpu_profiler) {
+        for (const auto &[name, total] : g_gpu_zone_totals) {
+            SDL_Log("gpu: %-24s avg %.3f ms over %" SDL_PRIu64 " frames", std::string{name}.c_str(),
+                static_cast<double>(total.total_ns) / 1e6 / static_cast<double>(total.count), total.count);
+        }
+        SDL_Log("gpu: %" SDL_PRIu64 " frames dropped, gl-context %s", g_gpu_profiler->dropped_frames(),
+            context_profile_name(g_context_info.profile).data());
+    }
+    g_gpu_profiler.reset();
+    if (GL::Trace::is_recording()) {
+        const auto frames{GL::Trace::stop_recording()};
+        SDL_Log("trace: %s done, %" SDL_PRIu64 " frames", g_options.trace_path.string().c_str(), frames);
+    }
+    if (nullptr != g_capture) {
+        g_capture->finish();
+        if (g_capture->write_failed()) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "capture: write to %s failed, the file is incomplete",
+                g_options.capture_path.string().c_str());
+        }
+        SDL_Log("capture: %s done, %" SDL_PRIu64 " frames written, %" SDL_PRIu64 " frames dropped",
+            g_options.capture_path.string().c_str(), g_capture->captured_frames(), g_capture->dropped_frames());
+        g_capture.reset();
+    }
+    if (nullptr != g_debug_log) {
+        g_debug_log->uninstall();
+        g_debug_log.reset();
+    }
+}
+
+ResourceLoader &resource_loader()
+{
+    if (nullptr == g_loader) {
+        if (nullptr == g_window) {
+            throw std::runtime_error{"ERROR::LOADER what:resource_loader() called before load_gl()"};
+        }
+        // trace、gl-stats、gl-memory 拦截层只记录单个线程的调用，此时改为在渲染线程执行
+        const bool layers{!g_options.trace_path.empty() || 0 != g_options.gl_stats_interval || 0 != g_options.gl_memory_interval};
+        g_loader = std::make_unique<ResourceLoader>(g_window, !g_options.gl_sync_loader && !layers);
+    }
+    return *g_loader;
+}
+
+Image::IoScheduler &io_scheduler()
+{
+    if (nullptr == g_io) {
+        g_io = std::make_unique<Image::IoScheduler>(Image::IoSchedulerOptions{.backend = g_options.io_backend});
+        SDL_Log("io: %s backend", Image::io_backend_name(g_io->backend()).data());
+    }
+    return *g_io;
+}
+
+TaskScheduler &tasks()
+{
+    if (nullptr == g_tasks) {
+        g_tasks = std::make_unique<TaskScheduler>(jobs());
+    }
+    return *g_tasks;
+}
+
+Jobs::JobSystem &jobs()
+{
+    if (nullptr == g_jobs) {
+        g_jobs = std::make_unique<Jobs::JobSystem>(g_options.job_workers);
+    }
+    return *g_jobs;
+}
+
+void add_idle_check(std::function<bool()> idle)
+{
+    g_idle_checks.push_back(std::move(idle));
+}
+
+GL::ResidencyManager *residency()
+{
+    return g_residency.get();
+}
+
+void run_tasks()
+{
+    if (nullptr == g_tasks) {
+        return;
+    }
+    try {
+        g_tasks->run(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::duration<double, std::milli>{g_options.task_budget_ms}));
+    }
+    catch (const std::exception &error) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "tasks: %s", error.what());
+        request_quit(SDL_APP_FAILURE);
+    }
+    catch (...) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "tasks: unknown exception");
+        request_quit(SDL_APP_FAILURE);
+    }
+}
+
+Task<Image::AssetBytes> read_asset(std::string path)
+{
+    if (nullptr != g_asset_pack) {
+        if (const auto *entry{g_asset_pack->find(path)}; nullptr != entry) {
+            if (Image::PackCompression::None != entry->compression) {
+                co_await tasks().on_worker();
+            }
+            co_return g_asset_pack->load(*entry);
+        }
+    }
+    // io_scheduler() 只在 GL 线程创建与轮询
+    co_await tasks().on_main();
+    auto result{co_await IoRead{path}};
+    if (0 != result.error) {
+        throw std::runtime_error{std::format("ERROR::ASSET what:read {} failed: {}", path, std::generic_category().message(result.error))};
+    }
+    const size_t size{result.data.size()};
+    co_return Image::AssetBytes{result.data.release(), size};
+}
+
+std::shared_ptr<const Image::AssetPack> asset_pack()
+{
+    return g_asset_pack;
+}
+
+Image::AssetBytes load_asset(std::string_view path)
+{
+    return Image::load_asset(g_asset_pack.get(), path);
+}
+
+SDL_AppResult frame_result()
+{
+    return g_frame_result;
+}
+
+void request_quit(SDL_AppResult result)
+{
+    g_frame_result = result;
+}
+
+} // namespace Framework
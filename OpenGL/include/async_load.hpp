@@ -0,0 +1,47 @@
+#pragma once
+
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "framework.hpp"
+#include "opengl/gl.hpp"
+#include "opengl/gl_texture_cache.hpp"
+#include "task.hpp"
+
+/**
+ * 供 IHomework::init_async 使用的加载任务，均在 GL 线程上结束
+ * 放在头文件中，与 GL::TextureCache 一样由包含它的程序提供 stb_image 的实现
+ */
+namespace Framework {
+
+/**
+ * 读文件与解码在纹理缓存的线程池中进行，上传由 TextureCache::update() 按预算完成，
+ * 这里每帧检查一次，上传完成后返回；解码失败时抛出异常
+ */
+inline Task<GL::TextureHandle> load_texture(GL::TextureCache &cache, std::filesystem::path path, GL::TextureOptions options = {})
+{
+    co_await tasks().on_main();
+    auto texture{cache.load(path, options)};
+    while (!texture.ready() && !texture.failed()) {
+        co_await tasks().next_frame();
+    }
+    if (texture.failed()) {
+        throw std::runtime_error{std::format("ERROR::TEXTURE what:can not load {}", path.string())};
+    }
+    co_return texture;
+}
+
+// 两个源文件同时读取，读完后在 GL 线程编译链接
+inline Task<std::shared_ptr<GL::ShaderProgram>> compile_program(std::string vertex_path, std::string fragment_path)
+{
+    auto [vertex, fragment]{co_await when_all(read_asset(std::move(vertex_path)), read_asset(std::move(fragment_path)))};
+    co_await tasks().on_main();
+    const GL::Shader vertex_shader{GL_VERTEX_SHADER, GL::ShaderSource{std::string{vertex.text()}}};
+    const GL::Shader fragment_shader{GL_FRAGMENT_SHADER, GL::ShaderSource{std::string{fragment.text()}}};
+    co_return std::make_shared<GL::ShaderProgram>(vertex_shader, fragment_shader);
+}
+
+} // namespace Framework
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cinttypes>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "image/asset_pack.hpp"
+#include "image/io_scheduler.hpp"
+#include "jobs/job_system.hpp"
+#include "opengl/gl_residency.hpp"
+#include "resource_loader.hpp"
+#include "task.hpp"
+
+namespace Framework {
+
+/**
+ * GL 上下文配置
+ *   Debug       debug context，驱动做完整校验，debug message 由 GL::DebugLog 输出
+ *   Production  GL_KHR_no_error context，驱动跳过参数校验，不注册 debug 回调；出错时行为未定义
+ */
+enum class ContextProfile : uint8_t { Debug, Production };
+
+constexpr std::string_view context_profile_name(ContextProfile profile)
+{
+    switch (profile) {
+        case ContextProfile::Debug:      return "debug";
+        case ContextProfile::Production: return "production";
+    }
+    return "unknown";
+}
+
+struct Options
+{
+    // 隐藏窗口并使用 SDL offscreen 视频驱动，便于在无显示环境下运行
+    bool headless{false};
+
+    // 非空时在 golden_frame 帧之后、加载全部结束（见 add_idle_check）的第一帧截取画面，与该路径下的 golden image 比对
+    std::filesystem::path golden_path{};
+    bool golden_update{false};  // 用当前画面覆盖 golden image
+    uint64_t golden_frame{60};
+    uint8_t golden_tolerance{2};
+    double golden_perceptual_threshold{0.01};
+    double golden_max_mismatch_ratio{0.0};
+
+    // 非空时把每一帧录制为 Y4M，回读经 PBO 环异步完成
+    std::filesystem::path capture_path{};
+    uint32_t capture_fps{60};
+
+    // 每隔 n 帧输出一次 GL 调用统计，0 表示关闭；需以 ENABLE_GL_FRAME_STATS 构建
+    uint64_t gl_stats_interval{0};
+
+    // 记录 GPU 内存分配（GL::Memory），每隔 n 帧与退出时输出各类别的当前与峰值用量，0 表示关闭
+    uint64_t gl_memory_interval{0};
+
+    // GPU 内存预算（MiB），非 0 时创建 Framework::residency()，超出时按 LRU 驱逐已登记的纹理与网格
+    uint64_t gl_budget_mib{0};
+
+    // 启用 GPU 计时 zone（GL::GpuScope），退出时输出各 zone 的平均耗时
+    bool gpu_profile{false};
+
+    // 非空时在退出时把 PROFILE_SCOPE 与 GPU zone 导出为 Chrome trace JSON；需以 ENABLE_PROFILER 构建
+    std::filesystem::path profile_path{};
+
+    // 未指定时 Debug 构建使用 debug，Release 构建使用 production
+#if defined(NDEBUG)
+    ContextProfile context_profile{ContextProfile::Production};
+#else
+    ContextProfile context_profile{ContextProfile::Debug};
+#endif
+
+    // 用 gladLoadGLLoader 解析全部入口，而不是 GL::Loader 的精简加载（用于对比启动耗时）
+    bool gl_full_loader{false};
+
+    // debug context 下关闭 GL_DEBUG_OUTPUT_SYNCHRONOUS，由后台线程输出 debug message
+    bool gl_debug_async{false};
+
+    // Framework::resource_loader() 的任务在渲染线程同步执行，而不是加载线程的共享上下文（用于对比）
+    bool gl_sync_loader{false};
+
+    // GL::TextureCache 不经 PBO 上传环，直接从客户端内存上传（用于对比）
+    bool texture_client_upload{false};
+
+    // 非空时从该资源包（asset_pack 生成）读取资源，包中没有的仍从文件读取
+    std::filesystem::path asset_pack_path{};
+
+    // Framework::io_scheduler() 的后端，auto 时优先 io_uring，不可用时使用线程池
+    Image::IoBackend io_backend{Image::IoBackend::Auto};
+
+    // Framework::tasks() 每帧在 GL 线程上恢复协程的时间预算
+    double task_budget_ms{2.0};
+
+    // Framework::jobs() 的工作线程数，0 时为硬件线程数 - 1
+    size_t job_workers{0};
+
+    // 非空时录制全部 GL 调用，可用 gl_replay 回放
+    std::filesystem::path trace_path{};
+
+    // 不限制帧率（回放时不按录制的调用间隔等待）
+    bool max_speed{false};
+
+    // 不以 -- 开头的参数，由具体程序解释
+    std::vector<std::string> arguments{};
+};
+
+/**
+ * 解析命令行参数，需在 App::Create 之前调用
+ *   --headless
+ *   --golden <path.tga> [--golden-update] [--golden-frame <n>]
+ *   [--golden-tolerance <0-255>] [--golden-threshold <0-1>] [--golden-max-mismatch <0-1>]
+ *   --capture <path.y4m> [--capture-fps <n>]
+ *   --trace <path.gltrace>
+ *   --gl-stats <n>
+ *   --gl-memory <n>
+ *   --gl-budget <MiB>
+ *   --gpu-profile
+ *   --profile <path.json>
+ *   --gl-context <debug|production>
+ *   --gl-debug-async
+ *   --gl-full-loader
+ *   --gl-sync-loader
+ *   --texture-client-upload
+ *   --asset-pack <path.pak>
+ *   --io-backend <auto|io_uring|threads>
+ *   --task-budget <ms>
+ *   --job-workers <n>
+ *   --max-speed
+ */
+void parse_options(int argc, char *argv[]);
+const Options &options();
+
+// 按运行模式补充窗口标志
+SDL_WindowFlags window_flags(SDL_WindowFlags flags);
+
+// 在创建 GL 上下文之前调用，按 context profile 设置上下文标志
+void set_context_attributes();
+
+// 实际创建的上下文信息，load_gl 之后有效
+struct ContextInfo
+{
+    ContextProfile profile{};
+    bool debug{false};
+    bool no_error{false};
+};
+const ContextInfo &context_info();
+
+/**
+ * 在 SDL_GL_MakeCurrent 之后调用：加载 GL 入口函数，并按命令行参数安装 debug log、trace 等
+ * 第一帧 before_swap 时输出从这里到第一帧的耗时
+ */
+void load_gl(SDL_Window *window);
+
+/**
+ * 后台 GL 资源加载线程，第一次调用时创建（须在渲染线程、load_gl 之后）
+ * before_swap 每帧调用其 poll()，shutdown 时销毁
+ */
+ResourceLoader &resource_loader();
+
+// --asset-pack 打开的资源包，未指定时为 nullptr；在 parse_options 中打开，可在任意线程使用
+std::shared_ptr<const Image::AssetPack> asset_pack();
+
+// 从资源包或文件读取资源，path 为相对工作目录的路径；不存在时抛出异常
+Image::AssetBytes load_asset(std::string_view path);
+
+/**
+ * 异步文件读取调度器，第一次调用时创建（须在渲染线程）
+ * before_swap 每帧调用其 poll()，读取回调在渲染线程执行；shutdown 时销毁，未交付的结果丢弃
+ */
+Image::IoScheduler &io_scheduler();
+
+/**
+ * 协程任务调度器，第一次调用时创建（须在 GL 线程）；on_worker() 的协程在 jobs() 的线程上恢复
+ * SDL_AppIterate 每帧调用 run_tasks() 推进，shutdown 时销毁，尚未结束的任务不再恢复
+ */
+TaskScheduler &tasks();
+
+// 每帧在 App::Render 之前调用一次；任务抛出的异常输出到日志并结束程序
+void run_tasks();
+
+/**
+ * 异步读取资源：包中有时直接从映射内存返回（压缩的条目在工作线程解压），
+ * 否则经 io_scheduler() 读取，结果在下一帧的 run_tasks() 中于 GL 线程返回；不存在时抛出异常
+ */
+Task<Image::AssetBytes> read_asset(std::string path);
+
+/**
+ * 每帧 CPU 工作（变换更新、剔除、命令构建）用的工作窃取任务系统，第一次调用时创建（须在 GL 线程）
+ * GL 线程在 Jobs::JobSystem::wait() / TaskGraph::run() 中参与执行；shutdown 时销毁
+ */
+Jobs::JobSystem &jobs();
+
+/**
+ * --gl-budget 指定时在 load_gl 中创建，否则为 nullptr；只能在 GL 线程使用
+ * 程序登记可重新创建的纹理与网格，绘制前 use()；before_swap 每帧调用 end_frame()，
+ * shutdown 时卸载仍驻留的资源后销毁，因此回调引用的对象须活到 shutdown 之后
+ */
+GL::ResidencyManager *residency();
+
+/**
+ * 登记一个加载状态检查（如 TextureCache::pending() 为 0），只能在 GL 线程调用
+ * golden 比对等到 tasks() 没有未结束的任务且全部检查为 true 才截取画面，超过 golden_frame 之后 600 帧仍未空闲时失败
+ */
+void add_idle_check(std::function<bool()> idle);
+
+// 在 IHomework::render 之后、SDL_GL_SwapWindow 之前调用
+void before_swap(SDL_Window *window);
+
+// 在 App::Destory 之前调用，此时 GL 上下文仍然有效
+void shutdown();
+
+// SDL_AppIterate 的返回值，golden 比对结束后不再是 SDL_APP_CONTINUE
+SDL_AppResult frame_result();
+
+// 在下一次 SDL_AppIterate 返回时结束程序
+void request_quit(SDL_AppResult result);
+
+} // namespace Framework
@@ -1,9 +1,20 @@
 #pragma once
 
+#include "startup_graph.hpp"
+#include "task.hpp"
+
 struct IHomework
 {
     virtual ~IHomework() = default;
 
+    // 在窗口与 GL 上下文创建之前调用，可向启动图添加读文件、解码等工作线程任务，
+    // 以及依赖 gl_ready 的 GL 任务；init 在这些任务全部完成后执行
+    virtual void prepare(Framework::StartupGraph &graph, Framework::StartupGraph::TaskId gl_ready) {
+        (void)graph;
+        (void)gl_ready;
+    }
     virtual void init() = 0;
+    // init 之后交给 Framework::tasks() 执行，可在其中 co_await 加载资源；结束前 render 照常调用，须自行判断资源是否就绪
+    virtual Framework::Task<> init_async() { co_return; }
     virtual void render() = 0;
 };
\ No newline at end of file
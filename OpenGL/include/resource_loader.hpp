@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cinttypes>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <SDL3/SDL.h>
+
+namespace Framework {
+
+struct ResourceLoaderStats
+{
+    uint64_t completed{};
+    double total_work_ms{};     // 任务本身在加载线程上的耗时
+    double max_work_ms{};
+    double max_latency_ms{};    // 从 submit 到渲染线程调用 ready
+    bool threaded{};
+
+    std::string to_string() const;
+};
+
+/**
+ * 后台 GL 资源加载线程
+ *
+ * 加载线程持有第二个 GL 上下文（隐藏的 1x1 窗口，SDL_GL_SHARE_WITH_CURRENT_CONTEXT），与主上下文共享对象。
+ * submit() 的 work 在加载线程上按提交顺序执行：创建并填充缓冲、纹理，编译链接着色器程序；
+ * 每个任务之后插入 fence 并 glFlush，渲染线程的 poll() 发现 fence 已完成（不等待）后调用 ready，
+ * 此时对象内容对主上下文可见，可以直接绑定使用。
+ * VAO、FBO 等容器对象不在上下文间共享，只能在 ready 中创建。
+ *
+ * 无法创建共享上下文、以 --gl-sync-loader 运行或安装了 trace / gl-stats / gl-memory 拦截层（计数不加锁）时，
+ * work 改为在 poll() 中于渲染线程同步执行，行为相同，只是不再并行。
+ * work 或 ready 抛出的异常在 poll() 或 finish() 中重新抛出，之后的任务照常执行；
+ * fence 等待失败（GL_WAIT_FAILED）时该任务的 ready 不再调用，poll() 抛出异常。
+ */
+class ResourceLoader
+{
+public:
+    using Work = std::function<void()>;     // 加载线程，加载上下文为当前上下文
+    using Ready = std::function<void()>;    // 渲染线程
+
+    // 在渲染线程、主上下文为当前上下文时构造
+    explicit ResourceLoader(SDL_Window *window, bool threaded = true);
+    ~ResourceLoader();
+    ResourceLoader(const ResourceLoader &) = delete;
+    ResourceLoader(ResourceLoader &&) = delete;
+    ResourceLoader &operator=(const ResourceLoader &) = delete;
+    ResourceLoader &operator=(ResourceLoader &&) = delete;
+
+    // name 必须是字符串常量；可在任意线程调用
+    void submit(const char *name, Work work, Ready ready = {});
+
+    // 渲染线程每帧调用一次，对已完成的任务按提交顺序调用 ready，返回调用的个数
+    size_t poll();
+
+    // 阻塞到目前提交的任务全部完成并调用 ready（启动阶段使用）
+    void finish();
+
+    size_t pending() const;
+    bool threaded() const;
+    ResourceLoaderStats stats() const;
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+} // namespace Framework
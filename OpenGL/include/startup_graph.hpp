@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cinttypes>
+#include <functional>
+#include <vector>
+
+namespace Framework {
+
+/**
+ * 启动依赖图
+ *
+ * 每个任务声明运行线程与依赖，run() 时无依赖的工作线程任务立即开始（读文件、解码图片等，可早于窗口创建），
+ * 主线程任务（SDL、GL 上下文与 GL 调用）在依赖完成后按添加顺序在调用 run() 的线程执行。
+ * 每个任务写入一个 PROFILE_SCOPE，--profile 导出的 trace 中即为启动时间线；结束时输出一行汇总。
+ *
+ * name 必须是字符串常量；任一任务抛出异常时不再开始新任务，等正在执行的任务结束后重新抛出。
+ */
+class StartupGraph
+{
+public:
+    using TaskId = size_t;
+
+    enum class Thread : uint8_t { Worker, Main };
+
+    StartupGraph() = default;
+    ~StartupGraph() = default;
+    StartupGraph(const StartupGraph &) = delete;
+    StartupGraph(StartupGraph &&) = delete;
+    StartupGraph &operator=(const StartupGraph &) = delete;
+    StartupGraph &operator=(StartupGraph &&) = delete;
+
+    // dependencies 只能是已添加的任务，因此图中不会有环
+    TaskId add(const char *name, Thread thread, std::function<void()> work, std::vector<TaskId> dependencies = {});
+
+    // 目前已添加的全部任务，用于添加最后执行的任务
+    std::vector<TaskId> all_tasks() const;
+
+    void run();
+
+private:
+    struct Task
+    {
+        const char *name{};
+        Thread thread{};
+        std::function<void()> work{};
+        std::vector<TaskId> dependents{};
+        size_t pending{};       // 未完成的依赖数
+        int64_t begin_ns{};
+        int64_t end_ns{};
+    };
+
+    std::vector<Task> tasks_{};
+};
+
+} // namespace Framework
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+namespace Jobs {
+class JobSystem;
+} // namespace Jobs
+
+namespace Framework {
+
+template <class T = void>
+class Task;
+
+namespace detail {
+
+// 任务结束时转到 co_await 它的协程
+struct TaskFinal
+{
+    bool await_ready() const noexcept { return false; }
+    template <class Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+        if (const auto continuation{handle.promise().continuation}; continuation) {
+            return continuation;
+        }
+        return std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+};
+
+struct TaskPromiseBase
+{
+    std::coroutine_handle<> continuation{};
+    std::exception_ptr error{};
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    TaskFinal final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+template <class T>
+struct TaskPromise : TaskPromiseBase
+{
+    std::optional<T> value{};
+
+    Task<T> get_return_object() noexcept;
+    void return_value(T result) { value.emplace(std::move(result)); }
+    T result() {
+        if (nullptr != error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase
+{
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void result() const {
+        if (nullptr != error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * 协程任务
+ *
+ * 惰性启动：创建时不执行，被 co_await（或交给 TaskScheduler::spawn）时才在当前线程开始，
+ * 结束后直接在结束所在的线程恢复等待者。只能 co_await 一次，异常在 co_await 处重新抛出。
+ * 协程参数按值传递，引用参数在第一次挂起之后可能已失效；lambda 协程的捕获随 lambda 对象销毁，同样改用参数。
+ */
+template <class T>
+class [[nodiscard]] Task
+{
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_{handle} {}
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+    Task(Task &&other) noexcept : handle_{std::exchange(other.handle_, {})} {}
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    bool valid() const { return static_cast<bool>(handle_); }
+    bool done() const { return handle_ && handle_.done(); }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle{};
+
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) const noexcept {
+                handle.promise().continuation = caller;
+                return handle;
+            }
+            T await_resume() const { return handle.promise().result(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle_{};
+};
+
+namespace detail {
+
+template <class T>
+Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+    return Task<T>{std::coroutine_handle<TaskPromise>::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return Task<void>{std::coroutine_handle<TaskPromise>::from_promise(*this)};
+}
+
+struct WhenAllCounter
+{
+    std::atomic<size_t> remaining{};
+    std::coroutine_handle<> continuation{};
+
+    // 返回 true 表示是最后一个，由调用者恢复等待者
+    bool arrive() noexcept { return 1 == remaining.fetch_sub(1, std::memory_order_acq_rel); }
+};
+
+// 包装 when_all 的一个子任务，子任务结束后在 final_suspend 中计数
+class WhenAllChild
+{
+public:
+    struct promise_type
+    {
+        WhenAllCounter *counter{};
+
+        WhenAllChild get_return_object() noexcept {
+            return WhenAllChild{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        auto final_suspend() const noexcept {
+            struct Final
+            {
+                bool await_ready() const noexcept { return false; }
+                // arrive 之后其他子任务可能已恢复等待者并销毁本帧，不能再访问帧内的任何东西
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+                    auto &counter{*handle.promise().counter};
+                    const auto continuation{counter.continuation};
+                    if (counter.arrive()) {
+                        return continuation;
+                    }
+                    return std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+            return Final{};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+
+    explicit WhenAllChild(std::coroutine_handle<promise_type> handle) : handle_{handle} {}
+    ~WhenAllChild() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+    WhenAllChild(WhenAllChild &&other) noexcept : handle_{std::exchange(other.handle_, {})} {}
+    WhenAllChild &operator=(WhenAllChild &&) = delete;
+    WhenAllChild(const WhenAllChild &) = delete;
+    WhenAllChild &operator=(const WhenAllChild &) = delete;
+
+    void start(WhenAllCounter &counter) {
+        handle_.promise().counter = &counter;
+        handle_.resume();
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle_{};
+};
+
+template <class T>
+WhenAllChild when_all_child(Task<T> task, std::optional<T> &value, std::exception_ptr &error)
+{
+    try {
+        value.emplace(co_await std::move(task));
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+}
+
+template <size_t N>
+struct WhenAllStart
+{
+    std::array<WhenAllChild, N> &children;
+    WhenAllCounter counter{};
+
+    bool await_ready() const noexcept { return 0 == N; }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        // 多出的 1 由这里持有，子任务全部同步完成时不挂起
+        counter.continuation = handle;
+        counter.remaining.store(N + 1, std::memory_order_relaxed);
+        for (auto &child : children) {
+            child.start(counter);
+        }
+        return !counter.arrive();
+    }
+    void await_resume() const noexcept {}
+};
+
+template <class... T, size_t... I>
+Task<std::tuple<T...>> when_all(std::index_sequence<I...>, Task<T>... tasks)
+{
+    std::tuple<std::optional<T>...> values;
+    std::array<std::exception_ptr, sizeof...(T)> errors{};
+    std::array<WhenAllChild, sizeof...(T)> children{when_all_child(std::move(tasks), std::get<I>(values), errors[I])...};
+    co_await WhenAllStart<sizeof...(T)>{children};
+    for (const auto &error : errors) {
+        if (nullptr != error) {
+            std::rethrow_exception(error);
+        }
+    }
+    co_return std::tuple<T...>{std::move(*std::get<I>(values))...};
+}
+
+} // namespace detail
+
+/**
+ * 同时开始多个任务，全部结束后返回各自的结果（T 不能是 void）
+ * 子任务在当前线程依次开始，等待者在最后结束的子任务所在线程恢复；
+ * 有子任务抛出异常时仍等待其余的结束，再抛出第一个异常
+ */
+template <class... T>
+Task<std::tuple<T...>> when_all(Task<T>... tasks)
+{
+    return detail::when_all(std::index_sequence_for<T...>{}, std::move(tasks)...);
+}
+
+struct TaskSchedulerStats
+{
+    uint64_t spawned{};
+    uint64_t completed{};
+    uint64_t failed{};
+    uint64_t main_resumes{};        // run() 中在 GL 线程恢复的次数
+    uint64_t worker_resumes{};
+    double max_run_ms{};            // 单次 run() 的最长耗时
+
+    std::string to_string() const;
+};
+
+/**
+ * 协程任务调度器
+ *
+ * spawn() 的任务从 co_await on_worker() 起在 Jobs::JobSystem 的线程上继续（读文件、解码等 CPU 工作），
+ * co_await on_main() 起在 GL 线程上继续（GL 调用）。GL 线程每帧调用一次 run()，
+ * 在预算内恢复等待 GL 线程的协程，超出预算的留到下一帧，帧循环不会因加载阻塞太久。
+ * 加载代码因此可以顺序书写，I/O、解码与上传仍然重叠进行。
+ *
+ * 在构造的线程（GL 线程）上 on_main() 不挂起；next_frame() 总是挂起到下一次 run()，用于轮询。
+ * 任务抛出的异常在 run() 中重新抛出。析构时等待正在工作线程上执行的协程挂起，尚未结束的任务直接销毁（不再恢复）；
+ * jobs 须比 TaskScheduler 活得长。
+ */
+class TaskScheduler
+{
+public:
+    explicit TaskScheduler(Jobs::JobSystem &jobs);
+    ~TaskScheduler();
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler(TaskScheduler &&) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(TaskScheduler &&) = delete;
+
+    // 在调用线程上开始执行 task，直到第一次挂起；name 必须是字符串常量，可在任意线程调用
+    void spawn(const char *name, Task<> task);
+
+    auto on_worker() { return Switch{this, Target::Worker}; }
+    auto on_main() { return Switch{this, Target::Main}; }
+    auto next_frame() { return Switch{this, Target::NextFrame}; }
+
+    // 自定义 awaitable 在完成回调中调用，把挂起的协程交给 GL 线程或工作线程恢复；可在任意线程调用
+    void resume_on_main(std::coroutine_handle<> handle);
+    void resume_on_worker(std::coroutine_handle<> handle);
+
+    // GL 线程每帧调用一次，返回恢复的协程个数；预算用完前至少恢复一个
+    size_t run(std::chrono::microseconds budget);
+
+    // 尚未结束的任务数
+    size_t pending() const;
+    TaskSchedulerStats stats() const;
+
+private:
+    enum class Target : uint8_t { Worker, Main, NextFrame };
+
+    struct Switch
+    {
+        TaskScheduler *scheduler{};
+        Target target{};
+
+        bool await_ready() const noexcept {
+            return Target::Main == target && std::this_thread::get_id() == scheduler->gl_thread_;
+        }
+        void await_suspend(std::coroutine_handle<> handle) const { scheduler->post(target, handle); }
+        void await_resume() const noexcept {}
+    };
+
+    void post(Target target, std::coroutine_handle<> handle);
+
+    struct State;
+    std::unique_ptr<State> state_;
+    const std::thread::id gl_thread_{std::this_thread::get_id()};
+};
+
+} // namespace Framework
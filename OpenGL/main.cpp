@@ -6,16 +6,19 @@
 #include <stdexcept>
 
 #include "app.hpp"
+#include "framework.hpp"
+#include "profiler/profiler.hpp"
 
 extern "C" {
 
 SDL_AppResult SDLCALL SDL_AppInit(void **appstate, int argc, char *argv[])
 {
     (void)appstate;
-    (void)argc;
-    (void)argv;
+    PROFILE_THREAD_NAME("main");
+    PROFILE_SCOPE("SDL_AppInit");
 
     try {
+        Framework::parse_options(argc, argv);
         App::Create();
     }
     catch (const std::runtime_error &error) {
@@ -35,16 +38,20 @@ void SDLCALL SDL_AppQuit(void *appstate, SDL_AppResult result)
     (void)appstate;
     (void)result;
 
+    Framework::shutdown();
     App::Destory();
 }
 
 SDL_AppResult SDLCALL SDL_AppIterate(void *appstate)
 {
     (void)appstate;
+    PROFILE_FRAME();
+    PROFILE_SCOPE("SDL_AppIterate");
 
+    Framework::run_tasks();
     App::Render();
 
-    return SDL_AppResult::SDL_APP_CONTINUE;
+    return Framework::frame_result();
 }
 
 SDL_AppResult SDLCALL SDL_AppEvent(void *appstate, SDL_Event *event)
@@ -0,0 +1,283 @@
+#include "resource_loader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <format>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <glad/glad.h>
+
+#include "SDL/SDL.hpp"
+#include "opengl/gl_loader.hpp"
+#include "profiler/profiler.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// finish() 等待单个 fence 的上限，超时说明驱动异常
+constexpr GLuint64 FINISH_TIMEOUT_NS{10'000'000'000};
+
+double elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+namespace Framework {
+
+std::string ResourceLoaderStats::to_string() const
+{
+    return std::format("{} tasks on {}, work {:.3f} ms (max {:.3f} ms), max latency {:.3f} ms",
+        completed, threaded ? "loader thread" : "render thread", total_work_ms, max_work_ms, max_latency_ms);
+}
+
+struct ResourceLoader::State
+{
+    struct Task
+    {
+        const char *name{};
+        Work work{};
+        Ready ready{};
+        Clock::time_point submitted{};
+    };
+
+    struct Done
+    {
+        GLsync fence{};
+        Ready ready{};
+        Clock::time_point submitted{};
+        std::exception_ptr error{};
+    };
+
+    std::shared_ptr<SDL_Window> window{};
+    std::shared_ptr<SDL::SDL_GLContext> context{};
+
+    mutable std::mutex mutex{};
+    std::condition_variable_any tasks_cv{};
+    std::condition_variable done_cv{};
+    std::deque<Task> tasks{};
+    std::deque<Done> done{};
+    size_t running{};           // 已取出、尚未放入 done 的任务
+    ResourceLoaderStats stats{};
+
+    std::jthread thread{};
+
+    void record(Clock::time_point start) {
+        const double work_ms{elapsed_ms(start)};
+        stats.total_work_ms += work_ms;
+        stats.max_work_ms = std::max(stats.max_work_ms, work_ms);
+    }
+
+    void loop(std::stop_token token) {
+        PROFILE_THREAD_NAME("gl loader");
+        SDL_GL_MakeCurrent(window.get(), context.get());
+        std::unique_lock lock{mutex};
+        // 停止时不再执行排队的任务
+        while (tasks_cv.wait(lock, token, [this] { return !tasks.empty(); }) && !token.stop_requested()) {
+            auto task{std::move(tasks.front())};
+            tasks.pop_front();
+            running += 1;
+            lock.unlock();
+
+            Done result{.ready = std::move(task.ready), .submitted = task.submitted};
+            const auto start{Clock::now()};
+            {
+                PROFILE_SCOPE(task.name);
+                try {
+                    task.work();
+                }
+                catch (...) {
+                    result.error = std::current_exception();
+                }
+                // flush 之后其他上下文才能等到这个 fence
+                result.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                glFlush();
+            }
+
+            lock.lock();
+            record(start);
+            running -= 1;
+            done.push_back(std::move(result));
+            done_cv.notify_all();
+        }
+        lock.unlock();
+        SDL_GL_MakeCurrent(window.get(), nullptr);
+    }
+};
+
+ResourceLoader::ResourceLoader(SDL_Window *window, bool threaded)
+    : state_{std::make_unique<State>()}
+{
+    if (!threaded) {
+        return;
+    }
+    const auto start{Clock::now()};
+    // SDL_GL_CreateContext 会把新上下文设为当前上下文，创建后切回主上下文
+    const auto main_context{SDL_GL_GetCurrentContext()};
+    try {
+        SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+        state_->window = SDL::Meta<SDL_Window>::create("gl loader", 1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+        state_->context = SDL::Meta<SDL::SDL_GLContext>::create(state_->window.get());
+    }
+    catch (const std::runtime_error &error) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "loader: no shared context (%s), loading on the render thread", error.what());
+        state_->context.reset();
+        state_->window.reset();
+    }
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+    SDL_GL_MakeCurrent(window, main_context);
+
+    if (nullptr != state_->context) {
+        // 跳板不再改写 glad 的函数指针，未解析的入口仍在首次调用时解析
+        GL::Loader::begin_threaded();
+        state_->stats.threaded = true;
+        state_->thread = std::jthread{[state = state_.get()](std::stop_token token) { state->loop(token); }};
+        SDL_Log("loader: shared context and thread ready in %.3f ms", elapsed_ms(start));
+    }
+}
+
+ResourceLoader::~ResourceLoader()
+{
+    if (state_->thread.joinable()) {
+        state_->thread.request_stop();
+        state_->tasks_cv.notify_all();
+        state_->thread.join();
+    }
+    // 未完成的任务直接丢弃；fence 属于共享对象，可在主上下文中删除
+    for (const auto &done : state_->done) {
+        glDeleteSync(done.fence);
+    }
+}
+
+void ResourceLoader::submit(const char *name, Work work, Ready ready)
+{
+    if (nullptr == work) {
+        throw std::runtime_error{std::format("ERROR::LOADER what:{} has no work", name)};
+    }
+    {
+        const std::lock_guard lock{state_->mutex};
+        state_->tasks.push_back({name, std::move(work), std::move(ready), Clock::now()});
+    }
+    state_->tasks_cv.notify_one();
+}
+
+size_t ResourceLoader::poll()
+{
+    auto &state{*state_};
+    size_t called{};
+
+    if (!state.stats.threaded) {
+        // 只执行调用时已提交的任务，ready 中再提交的任务留到下一次
+        std::deque<State::Task> tasks;
+        {
+            const std::lock_guard lock{state.mutex};
+            tasks.swap(state.tasks);
+        }
+        // 与加载线程相同，出错的任务不影响之后的任务，第一个异常在全部执行后重新抛出
+        std::exception_ptr error;
+        for (auto &task : tasks) {
+            const auto start{Clock::now()};
+            try {
+                PROFILE_SCOPE(task.name);
+                task.work();
+                if (nullptr != task.ready) {
+                    task.ready();
+                }
+            }
+            catch (...) {
+                error = nullptr == error ? std::current_exception() : error;
+                continue;
+            }
+            const std::lock_guard lock{state.mutex};
+            state.record(start);
+            state.stats.completed += 1;
+            state.stats.max_latency_ms = std::max(state.stats.max_latency_ms, elapsed_ms(task.submitted));
+            called += 1;
+        }
+        if (nullptr != error) {
+            std::rethrow_exception(error);
+        }
+        return called;
+    }
+
+    while (true) {
+        State::Done done;
+        {
+            const std::lock_guard lock{state.mutex};
+            if (state.done.empty()) {
+                break;
+            }
+            // 同一上下文的 fence 按顺序完成，队首未完成时后面的也未完成
+            const GLenum status{glClientWaitSync(state.done.front().fence, 0, 0)};
+            if (GL_TIMEOUT_EXPIRED == status) {
+                break;
+            }
+            done = std::move(state.done.front());
+            state.done.pop_front();
+            if (GL_WAIT_FAILED == status) {
+                // 无法确认加载线程的命令已完成，不调用 ready；之后的任务留到下一次 poll()
+                const GLenum gl_error{glGetError()};
+                glDeleteSync(done.fence);
+                throw std::runtime_error{std::format("ERROR::LOADER what:wait for the loader fence failed, glGetError 0x{:04X}", gl_error)};
+            }
+        }
+        glDeleteSync(done.fence);
+        if (nullptr != done.error) {
+            std::rethrow_exception(done.error);
+        }
+        if (nullptr != done.ready) {
+            done.ready();
+        }
+        const std::lock_guard lock{state.mutex};
+        state.stats.completed += 1;
+        state.stats.max_latency_ms = std::max(state.stats.max_latency_ms, elapsed_ms(done.submitted));
+        called += 1;
+    }
+    return called;
+}
+
+void ResourceLoader::finish()
+{
+    auto &state{*state_};
+    if (state.stats.threaded) {
+        GLsync last{};
+        {
+            std::unique_lock lock{state.mutex};
+            state.done_cv.wait(lock, [&state] { return state.tasks.empty() && 0 == state.running; });
+            if (!state.done.empty()) {
+                last = state.done.back().fence;
+            }
+        }
+        if (nullptr != last && GL_TIMEOUT_EXPIRED == glClientWaitSync(last, GL_SYNC_FLUSH_COMMANDS_BIT, FINISH_TIMEOUT_NS)) {
+            throw std::runtime_error{"ERROR::LOADER what:timeout waiting for the loader context"};
+        }
+    }
+    poll();
+}
+
+size_t ResourceLoader::pending() const
+{
+    const std::lock_guard lock{state_->mutex};
+    return state_->tasks.size() + state_->running + state_->done.size();
+}
+
+bool ResourceLoader::threaded() const
+{
+    return state_->stats.threaded;
+}
+
+ResourceLoaderStats ResourceLoader::stats() const
+{
+    const std::lock_guard lock{state_->mutex};
+    return state_->stats;
+}
+
+} // namespace Framework
@@ -0,0 +1,187 @@
+#include "startup_graph.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <format>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <SDL3/SDL.h>
+
+#include "profiler/profiler.hpp"
+
+namespace {
+
+constexpr size_t MAX_WORKERS{8};
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+namespace Framework {
+
+StartupGraph::TaskId StartupGraph::add(
+    const char *name, Thread thread, std::function<void()> work, std::vector<TaskId> dependencies)
+{
+    const TaskId id{tasks_.size()};
+    std::ranges::sort(dependencies);
+    const auto [first, last]{std::ranges::unique(dependencies)};
+    dependencies.erase(first, last);
+    for (const auto dependency : dependencies) {
+        if (dependency >= id) {
+            throw std::runtime_error{std::format("ERROR::STARTUP what:{} depends on unknown task {}", name, dependency)};
+        }
+        tasks_[dependency].dependents.push_back(id);
+    }
+    tasks_.push_back({
+        .name    = name,
+        .thread  = thread,
+        .work    = std::move(work),
+        .pending = dependencies.size(),
+    });
+    return id;
+}
+
+std::vector<StartupGraph::TaskId> StartupGraph::all_tasks() const
+{
+    std::vector<TaskId> ids(tasks_.size());
+    for (TaskId id{}; id < ids.size(); ++id) {
+        ids[id] = id;
+    }
+    return ids;
+}
+
+void StartupGraph::run()
+{
+    std::mutex mutex;
+    std::condition_variable worker_cv;
+    std::condition_variable main_cv;
+    std::set<TaskId> worker_ready;      // 按添加顺序取任务
+    std::set<TaskId> main_ready;
+    size_t remaining{tasks_.size()};
+    std::exception_ptr error;
+
+    const auto make_ready = [&](TaskId id) {
+        (Thread::Worker == tasks_[id].thread ? worker_ready : main_ready).insert(id);
+    };
+    for (TaskId id{}; id < tasks_.size(); ++id) {
+        if (0 == tasks_[id].pending) {
+            make_ready(id);
+        }
+    }
+
+    // 在不持有锁时调用
+    const auto execute = [&](TaskId id) {
+        auto &task{tasks_[id]};
+        std::exception_ptr failure;
+        task.begin_ns = now_ns();
+        try {
+            PROFILE_SCOPE(task.name);
+            task.work();
+        }
+        catch (...) {
+            failure = std::current_exception();
+        }
+        task.end_ns = now_ns();
+
+        std::lock_guard lock{mutex};
+        remaining -= 1;
+        if (nullptr != failure) {
+            if (nullptr == error) {
+                error = failure;
+            }
+        }
+        else {
+            for (const auto dependent : task.dependents) {
+                if (0 == --tasks_[dependent].pending) {
+                    make_ready(dependent);
+                }
+            }
+        }
+        worker_cv.notify_all();
+        main_cv.notify_all();
+    };
+
+    const auto worker_tasks{static_cast<size_t>(std::ranges::count(tasks_, Thread::Worker, &Task::thread))};
+    const size_t worker_count{std::min({std::max<size_t>(2, std::thread::hardware_concurrency()), MAX_WORKERS, worker_tasks})};
+    const int64_t start_ns{now_ns()};
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(worker_count);
+        for (size_t i{}; i < worker_count; ++i) {
+            workers.emplace_back([&] {
+                PROFILE_THREAD_NAME("startup worker");
+                std::unique_lock lock{mutex};
+                while (true) {
+                    worker_cv.wait(lock, [&] { return !worker_ready.empty() || 0 == remaining || nullptr != error; });
+                    if (nullptr != error || worker_ready.empty()) {
+                        return;
+                    }
+                    const TaskId id{worker_ready.extract(worker_ready.begin()).value()};
+                    lock.unlock();
+                    execute(id);
+                    lock.lock();
+                }
+            });
+        }
+
+        std::unique_lock lock{mutex};
+        while (0 != remaining && nullptr == error) {
+            if (main_ready.empty()) {
+                main_cv.wait(lock, [&] { return !main_ready.empty() || 0 == remaining || nullptr != error; });
+                continue;
+            }
+            const TaskId id{main_ready.extract(main_ready.begin()).value()};
+            lock.unlock();
+            execute(id);
+            lock.lock();
+        }
+        // 出错时唤醒空闲的工作线程退出，正在执行的任务在 jthread 析构时等待完成
+        worker_cv.notify_all();
+    }
+    if (nullptr != error) {
+        std::rethrow_exception(error);
+    }
+
+    // 关键路径：依赖总在前面添加，按添加顺序即为拓扑序
+    std::vector<int64_t> path_ns(tasks_.size());
+    std::vector<TaskId> previous(tasks_.size(), tasks_.size());
+    int64_t work_ns{};
+    int64_t end_ns{start_ns};
+    for (TaskId id{}; id < tasks_.size(); ++id) {
+        const auto &task{tasks_[id]};
+        const int64_t duration{task.end_ns - task.begin_ns};
+        work_ns += duration;
+        end_ns = std::max(end_ns, task.end_ns);
+        path_ns[id] += duration;
+        for (const auto dependent : task.dependents) {
+            if (path_ns[id] > path_ns[dependent]) {
+                path_ns[dependent] = path_ns[id];
+                previous[dependent] = id;
+            }
+        }
+    }
+    std::string critical_path;
+    if (!tasks_.empty()) {
+        for (TaskId id{static_cast<TaskId>(std::ranges::max_element(path_ns) - path_ns.begin())};
+             id < tasks_.size(); id = previous[id]) {
+            critical_path.insert(0, std::format("{}{}", tasks_[id].name, critical_path.empty() ? "" : " > "));
+        }
+    }
+    const auto to_ms = [](int64_t ns) { return static_cast<double>(ns) / 1e6; };
+    SDL_Log("%s", std::format("startup: {} tasks on {} workers, wall {:.2f} ms, work {:.2f} ms, critical path {:.2f} ms ({})",
+        tasks_.size(), worker_count, to_ms(end_ns - start_ns), to_ms(work_ns),
+        to_ms(path_ns.empty() ? 0 : std::ranges::max(path_ns)), critical_path).c_str());
+}
+
+} // namespace Framework
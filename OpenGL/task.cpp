@@ -0,0 +1,239 @@
+#include "task.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <format>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "jobs/job_system.hpp"
+#include "profiler/profiler.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+} // namespace
+
+namespace Framework {
+
+std::string TaskSchedulerStats::to_string() const
+{
+    return std::format("{} spawned, {} completed ({} failed), {} resumes on the GL thread, {} on workers, max run {:.3f} ms",
+        spawned, completed, failed, main_resumes, worker_resumes, max_run_ms);
+}
+
+struct TaskScheduler::State
+{
+    // spawn 的最外层协程，结束时在 final_suspend 中把自己交给 run() 销毁
+    struct Root
+    {
+        struct promise_type
+        {
+            State *state{};
+
+            Root get_return_object() noexcept { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            auto final_suspend() const noexcept {
+                struct Final
+                {
+                    bool await_ready() const noexcept { return false; }
+                    void await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+                        handle.promise().state->finish(handle);
+                    }
+                    void await_resume() const noexcept {}
+                };
+                return Final{};
+            }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+
+        std::coroutine_handle<promise_type> handle{};
+    };
+
+    explicit State(Jobs::JobSystem &jobs) : jobs{jobs} {}
+
+    Jobs::JobSystem &jobs;
+    Jobs::Counter worker_counter{};                     // 已提交、尚未执行完的工作线程恢复
+    std::atomic<bool> stopping{false};
+
+    mutable std::mutex mutex{};
+    std::deque<std::coroutine_handle<>> main_queue{};
+    std::vector<std::coroutine_handle<>> next_frame{};
+    std::vector<std::coroutine_handle<>> roots{};       // 尚未结束
+    std::vector<std::coroutine_handle<>> finished{};    // 已结束，等待 run() 销毁
+    std::deque<std::exception_ptr> errors{};
+    TaskSchedulerStats stats{};
+
+    static Root run_root(State &state, const char *name, Task<> task) {
+        std::exception_ptr error;
+        try {
+            co_await std::move(task);
+        }
+        catch (const std::exception &exception) {
+            error = std::make_exception_ptr(std::runtime_error{std::format("ERROR::TASK what:{}: {}", name, exception.what())});
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        if (nullptr != error) {
+            const std::lock_guard lock{state.mutex};
+            state.stats.failed += 1;
+            state.errors.push_back(error);
+        }
+    }
+
+    void finish(std::coroutine_handle<> handle) {
+        const std::lock_guard lock{mutex};
+        std::erase(roots, handle);
+        finished.push_back(handle);
+        stats.completed += 1;
+    }
+
+    // 作为一个 Jobs::Job 在任务系统的线程上恢复，与每帧的 CPU 工作共用线程，不另开线程池
+    void post_worker(std::coroutine_handle<> handle) {
+        jobs.run("task resume", [this, handle] {
+            // 停止时不再恢复排队的协程
+            if (stopping.load(std::memory_order_acquire)) {
+                return;
+            }
+            {
+                const std::lock_guard lock{mutex};
+                stats.worker_resumes += 1;
+            }
+            handle.resume();
+        }, worker_counter);
+    }
+};
+
+TaskScheduler::TaskScheduler(Jobs::JobSystem &jobs)
+    : state_{std::make_unique<State>(jobs)}
+{
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    // 等正在恢复的协程挂起或结束，之后才能销毁它们的帧；JobSystem 在 TaskScheduler 之后销毁
+    state_->stopping.store(true, std::memory_order_release);
+    state_->jobs.wait(state_->worker_counter);
+    // 销毁最外层的帧时，其中的 Task 依次销毁各层子协程；队列里只是这些帧的句柄
+    for (const auto handle : state_->roots) {
+        handle.destroy();
+    }
+    for (const auto handle : state_->finished) {
+        handle.destroy();
+    }
+}
+
+void TaskScheduler::spawn(const char *name, Task<> task)
+{
+    auto root{State::run_root(*state_, name, std::move(task))};
+    root.handle.promise().state = state_.get();
+    {
+        const std::lock_guard lock{state_->mutex};
+        state_->roots.push_back(root.handle);
+        state_->stats.spawned += 1;
+    }
+    root.handle.resume();
+}
+
+void TaskScheduler::resume_on_main(std::coroutine_handle<> handle)
+{
+    post(Target::Main, handle);
+}
+
+void TaskScheduler::resume_on_worker(std::coroutine_handle<> handle)
+{
+    post(Target::Worker, handle);
+}
+
+void TaskScheduler::post(Target target, std::coroutine_handle<> handle)
+{
+    if (Target::Worker == target) {
+        state_->post_worker(handle);
+        return;
+    }
+    const std::lock_guard lock{state_->mutex};
+    if (Target::Main == target) {
+        state_->main_queue.push_back(handle);
+    }
+    else {
+        state_->next_frame.push_back(handle);
+    }
+}
+
+size_t TaskScheduler::run(std::chrono::microseconds budget)
+{
+    PROFILE_SCOPE("TaskScheduler::run");
+    auto &state{*state_};
+    const auto start{Clock::now()};
+
+    std::vector<std::coroutine_handle<>> finished;
+    {
+        const std::lock_guard lock{state.mutex};
+        finished.swap(state.finished);
+        // 上一帧 next_frame() 挂起的协程排在本帧新到的之前
+        state.main_queue.insert(state.main_queue.begin(), state.next_frame.begin(), state.next_frame.end());
+        state.next_frame.clear();
+    }
+    // 帧中可能有 GL 对象，在 GL 线程销毁
+    for (const auto handle : finished) {
+        handle.destroy();
+    }
+
+    size_t resumed{};
+    while (true) {
+        std::coroutine_handle<> handle;
+        {
+            const std::lock_guard lock{state.mutex};
+            if (state.main_queue.empty()) {
+                break;
+            }
+            handle = state.main_queue.front();
+            state.main_queue.pop_front();
+        }
+        handle.resume();
+        resumed += 1;
+        if (std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start) >= budget) {
+            break;
+        }
+    }
+    // 没有工作线程时（单核）由 GL 线程在预算内推进，至少执行一个
+    if (1 == state.jobs.thread_count()) {
+        while (!state.worker_counter.done() && state.jobs.help()
+            && std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start) < budget) {
+        }
+    }
+
+    std::exception_ptr error;
+    {
+        const std::lock_guard lock{state.mutex};
+        state.stats.main_resumes += resumed;
+        state.stats.max_run_ms = std::max(state.stats.max_run_ms,
+            std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        if (!state.errors.empty()) {
+            error = state.errors.front();
+            state.errors.pop_front();
+        }
+    }
+    if (nullptr != error) {
+        std::rethrow_exception(error);
+    }
+    return resumed;
+}
+
+size_t TaskScheduler::pending() const
+{
+    const std::lock_guard lock{state_->mutex};
+    return state_->roots.size();
+}
+
+TaskSchedulerStats TaskScheduler::stats() const
+{
+    const std::lock_guard lock{state_->mutex};
+    return state_->stats;
+}
+
+} // namespace Framework
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "image/asset_pack.hpp"
+
+/**
+ * 把程序运行时读取的资源打成一个 .pak，程序以 --asset-pack <file.pak> 运行时从包中读取
+ *   asset_pack [--store] [--chunk <KiB>] -o <file.pak> -C <root> <file|directory>... [-C <root> <file|directory>...]
+ *   asset_pack --list <file.pak>
+ * 输入为相对其前面最近一个 root（默认为当前目录）的文件或目录（递归），包内名字即相对 root 的路径，与程序中使用的相对路径一致；
+ * 多个 root 用于把源码目录中的资源与构建时生成的资源（如 .mipc）打进同一个包
+ *   --store  不压缩，全部条目都可直接映射
+ *   --chunk  压缩块大小，默认 64 KiB；块越小解压的并行度越高，压缩率越低
+ *   --list   列出包中的条目并校验全部压缩条目
+ */
+
+namespace {
+
+struct Input
+{
+    std::filesystem::path root{};
+    std::string path{};
+};
+
+std::vector<Image::AssetSource> collect(const std::vector<Input> &inputs)
+{
+    std::vector<Image::AssetSource> sources;
+    for (const auto &[root, input] : inputs) {
+        const auto add = [&](const std::filesystem::path &file) {
+            sources.push_back({file.lexically_relative(root).generic_string(), file});
+        };
+        const auto path{root / input};
+        if (std::filesystem::is_directory(path)) {
+            // 目录内按名字排序，打包结果与遍历顺序无关
+            std::vector<std::filesystem::path> files;
+            for (const auto &entry : std::filesystem::recursive_directory_iterator{path}) {
+                if (entry.is_regular_file()) {
+                    files.push_back(entry.path());
+                }
+            }
+            std::ranges::sort(files);
+            for (const auto &file : files) {
+                add(file);
+            }
+        }
+        else if (std::filesystem::is_regular_file(path)) {
+            add(path);
+        }
+        else {
+            throw std::runtime_error{std::format("ERROR::ASSET_PACK what:{} not found", path.string())};
+        }
+    }
+    return sources;
+}
+
+void list(const std::filesystem::path &path)
+{
+    const Image::AssetPack pack{path};
+    uint64_t raw_bytes{};
+    uint64_t stored_bytes{};
+    for (const auto &entry : pack.entries()) {
+        // 解压一次，损坏的条目在此报错
+        const auto bytes{pack.load(entry)};
+        raw_bytes += entry.size;
+        stored_bytes += entry.stored_bytes;
+        std::printf("%s\n", std::format("{:>10} {:>10} {:<4} {}", entry.size, entry.stored_bytes,
+            Image::PackCompression::Lz == entry.compression ? "lz" : "raw", pack.name(entry)).c_str());
+    }
+    std::printf("%s\n", std::format("{} entries, {:.1f} KB -> {:.1f} KB, file {:.1f} KB", pack.size(),
+        static_cast<double>(raw_bytes) / 1024.0, static_cast<double>(stored_bytes) / 1024.0,
+        static_cast<double>(std::filesystem::file_size(path)) / 1024.0).c_str());
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    constexpr const char *USAGE{"usage: asset_pack [--store] [--chunk <KiB>] -o <file.pak> -C <root> <file|directory>... [-C <root> ...]\n"
+                                "       asset_pack --list <file.pak>\n"};
+    Image::AssetPackOptions options{};
+    std::filesystem::path root{"."};
+    std::filesystem::path output;
+    std::filesystem::path list_path;
+    std::vector<Input> inputs;
+    try {
+        for (int i{1}; i < argc; ++i) {
+            const std::string_view arg{argv[i]};
+            const bool has_value{i + 1 < argc};
+            if ("--store" == arg) {
+                options.compress = false;
+            }
+            else if ("--chunk" == arg && has_value) {
+                options.chunk_bytes = static_cast<uint32_t>(std::stoul(argv[++i]) * 1024);
+            }
+            else if ("-C" == arg && has_value) {
+                root = argv[++i];
+            }
+            else if ("-o" == arg && has_value) {
+                output = argv[++i];
+            }
+            else if ("--list" == arg && has_value) {
+                list_path = argv[++i];
+            }
+            else {
+                inputs.push_back({root, std::string{arg}});
+            }
+        }
+        if (!list_path.empty()) {
+            list(list_path);
+            return 0;
+        }
+        if (output.empty() || inputs.empty()) {
+            std::fprintf(stderr, "%s", USAGE);
+            return 1;
+        }
+
+        const auto start{std::chrono::steady_clock::now()};
+        const auto sources{collect(inputs)};
+        const auto summary{Image::write_asset_pack(output, sources, options)};
+        std::printf("%s\n", std::format("{}: {} entries ({} compressed), {:.1f} KB -> {:.1f} KB, {:.1f} ms",
+            output.string(), summary.entries, summary.compressed,
+            static_cast<double>(summary.raw_bytes) / 1024.0, static_cast<double>(summary.file_bytes) / 1024.0,
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()).c_str());
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <format>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include "image/bc_encode.hpp"
+#include "image/image_diff.hpp"
+
+/**
+ * 块压缩编码基准：对每种格式与质量档位输出编码吞吐（MPix/s）与解码后的 PSNR
+ *   bc_bench [--runs N] [image]
+ * 不指定图片时使用 2048x2048 的合成图（渐变 + 高频纹理 + 渐变 alpha）；每项取 N 次（默认 3）中最快的一次。
+ * BC1 只有 1 位 alpha，PSNR 与按 128 阈值化后的原图比较（透明像素解码为黑色）。
+ */
+
+namespace {
+
+struct Source
+{
+    std::string name{};
+    uint32_t width{};
+    uint32_t height{};
+    std::vector<uint8_t> pixels{};
+};
+
+Source synthetic(uint32_t size)
+{
+    Source source{std::format("synthetic {}x{}", size, size), size, size, {}};
+    source.pixels.resize(static_cast<size_t>(size) * size * 4);
+    for (uint32_t y{}; y < size; ++y) {
+        for (uint32_t x{}; x < size; ++x) {
+            uint8_t *pixel{source.pixels.data() + (static_cast<size_t>(y) * size + x) * 4};
+            pixel[0] = static_cast<uint8_t>(x * 255 / (size - 1));
+            pixel[1] = static_cast<uint8_t>(y * 255 / (size - 1));
+            pixel[2] = static_cast<uint8_t>((x ^ y) * 7 + (x * y >> 5));
+            pixel[3] = static_cast<uint8_t>(255 - (x + y) * 127 / (size - 1));
+        }
+    }
+    return source;
+}
+
+Source load(const std::string &path)
+{
+    int width{};
+    int height{};
+    int channels{};
+    const std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> pixels{
+        stbi_load(path.c_str(), &width, &height, &channels, 4), &stbi_image_free};
+    if (nullptr == pixels) {
+        throw std::runtime_error{std::format("ERROR::BC_BENCH what:can not decode {}: {}", path, stbi_failure_reason())};
+    }
+    const size_t bytes{static_cast<size_t>(width) * static_cast<size_t>(height) * 4};
+    return {path, static_cast<uint32_t>(width), static_cast<uint32_t>(height), {pixels.get(), pixels.get() + bytes}};
+}
+
+void bench(const Source &source, Image::BcFormat format, Image::BcQuality quality, int runs)
+{
+    std::vector<uint8_t> blocks;
+    double best_ms{std::numeric_limits<double>::max()};
+    for (int run{}; run < runs; ++run) {
+        const auto start{std::chrono::steady_clock::now()};
+        blocks = Image::bc_encode(source.pixels, source.width, source.height, format, quality);
+        best_ms = std::min(best_ms, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    const auto decoded{Image::bc_decode(blocks, source.width, source.height, format)};
+    auto reference{source.pixels};
+    if (Image::BcFormat::Bc1 == format) {
+        for (size_t i{}; i < reference.size(); i += 4) {
+            if (reference[i + 3] < 128) {
+                std::fill_n(reference.begin() + static_cast<std::ptrdiff_t>(i), 4, uint8_t{0});
+            }
+            else {
+                reference[i + 3] = 255;
+            }
+        }
+    }
+    const auto diff{Image::diff_rgba8(reference, decoded, source.width, source.height)};
+    const double megapixels{static_cast<double>(source.width) * source.height / 1e6};
+    std::printf("%s\n", std::format("{:<4} {:<7} {:>9.2f} ms {:>8.1f} MPix/s {:>7.2f} dB  {:.1f}:1",
+        Image::bc_format_name(format), Image::bc_quality_name(quality), best_ms, megapixels * 1000.0 / std::max(best_ms, 1e-3),
+        diff.psnr, static_cast<double>(source.pixels.size()) / static_cast<double>(blocks.size())).c_str());
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    try {
+        int runs{3};
+        std::string path;
+        for (int i{1}; i < argc; ++i) {
+            const std::string_view arg{argv[i]};
+            if ("--runs" == arg && i + 1 < argc) {
+                const std::string_view text{argv[++i]};
+                const auto [ptr, ec]{std::from_chars(text.data(), text.data() + text.size(), runs)};
+                if (ec != std::errc{} || ptr != text.data() + text.size() || runs <= 0) {
+                    throw std::runtime_error{std::format("ERROR::BC_BENCH what:invalid argument '{}'", text)};
+                }
+            }
+            else {
+                path = arg;
+            }
+        }
+
+        const auto source{path.empty() ? synthetic(2048) : load(path)};
+        std::printf("%s\n", std::format("{}, {} threads, best of {} runs",
+            source.name, std::max(1u, std::thread::hardware_concurrency()), runs).c_str());
+        for (const auto format : {Image::BcFormat::Bc1, Image::BcFormat::Bc3, Image::BcFormat::Bc7}) {
+            for (const auto quality : {Image::BcQuality::Fast, Image::BcQuality::Normal, Image::BcQuality::High}) {
+                bench(source, format, quality, runs);
+            }
+        }
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
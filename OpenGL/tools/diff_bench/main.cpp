@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <format>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "image/image_diff.hpp"
+
+/**
+ * golden image 比对基准：diff_rgba8 处理一帧的耗时
+ *   diff_bench [--width N] [--height N] [--runs N] [--max-ms X]
+ * 默认 3840x2160（4K），每项取 runs 次（默认 20）中最快的一次。
+ * 分别测完全相同、全部在通道容差内、1% 像素超出容差三种帧，并给出单线程 SIMD 与标量路径作对比。
+ * 指定 --max-ms 时，1% 超出容差一项（典型的回归帧）超过该耗时则返回 1，可用于 ctest。
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    uint32_t width{3840};
+    uint32_t height{2160};
+    int runs{20};
+    double max_ms{0.0};
+};
+
+double best_ms(int runs, const std::function<void()> &fn)
+{
+    double best{std::numeric_limits<double>::max()};
+    for (int run{}; run < runs; ++run) {
+        const auto start{Clock::now()};
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+template <class T>
+T parse_argument(std::string_view text)
+{
+    T value{};
+    const auto [ptr, ec]{std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (ec != std::errc{} || ptr != text.data() + text.size() || !(value > T{})) {
+        throw std::runtime_error{std::format("ERROR::DIFF_BENCH what:invalid argument '{}'", text)};
+    }
+    return value;
+}
+
+// 返回 diff_rgba8 的耗时
+double bench_frame(std::string_view name, const std::vector<uint8_t> &golden, const std::vector<uint8_t> &frame, const Options &options)
+{
+    const size_t n_pixels{static_cast<size_t>(options.width) * options.height};
+    const Image::DiffOptions diff_options{};
+    Image::DiffResult result{};
+    const double threaded_ms{best_ms(options.runs, [&] {
+        result = Image::diff_rgba8(golden, frame, options.width, options.height, diff_options);
+    })};
+    // 对比路径的结果与 diff_rgba8 一并检查，避免被优化掉
+    Image::detail::DiffAccum simd{};
+    const double simd_ms{best_ms(options.runs, [&] {
+        simd = Image::detail::diff_range(golden.data(), frame.data(), n_pixels, diff_options);
+    })};
+    Image::detail::DiffAccum scalar{};
+    const double scalar_ms{best_ms(options.runs, [&] {
+        scalar = {};
+        Image::detail::diff_scalar(golden.data(), frame.data(), n_pixels, diff_options, scalar);
+    })};
+    if (simd.over_tolerance != result.over_tolerance_pixels || scalar.over_tolerance != result.over_tolerance_pixels) {
+        throw std::runtime_error{std::format("ERROR::DIFF_BENCH what:{} paths disagree", name)};
+    }
+
+    const auto gigabytes_per_second = [&](double ms) {
+        return static_cast<double>(golden.size() + frame.size()) / (1024.0 * 1024.0 * 1024.0) * 1000.0 / std::max(ms, 1e-3);
+    };
+    std::printf("%s\n", std::format("{:<18} diff_rgba8 {:>7.3f} ms {:>6.1f} GB/s   1 thread {:>7.3f} ms   scalar {:>7.3f} ms   "
+        "{} over tolerance, {} mismatched", name, threaded_ms, gigabytes_per_second(threaded_ms), simd_ms, scalar_ms,
+        result.over_tolerance_pixels, result.perceptual_mismatch_pixels).c_str());
+    return threaded_ms;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    try {
+        Options options;
+        for (int i{1}; i < argc; ++i) {
+            const std::string_view arg{argv[i]};
+            if ("--width" == arg && i + 1 < argc) {
+                options.width = parse_argument<uint32_t>(argv[++i]);
+            }
+            else if ("--height" == arg && i + 1 < argc) {
+                options.height = parse_argument<uint32_t>(argv[++i]);
+            }
+            else if ("--runs" == arg && i + 1 < argc) {
+                options.runs = parse_argument<int>(argv[++i]);
+            }
+            else if ("--max-ms" == arg && i + 1 < argc) {
+                options.max_ms = parse_argument<double>(argv[++i]);
+            }
+            else {
+                throw std::runtime_error{std::format("ERROR::DIFF_BENCH what:unknown argument '{}'", arg)};
+            }
+        }
+
+        const size_t n_pixels{static_cast<size_t>(options.width) * options.height};
+        std::vector<uint8_t> golden(n_pixels * 4);
+        for (size_t i{}; i < golden.size(); ++i) {
+            golden[i] = static_cast<uint8_t>(i * 7 + i / 4093);
+        }
+
+        // 容差内的误差（驱动间的舍入差异），每个通道 ±1
+        auto rounding{golden};
+        for (size_t i{}; i < rounding.size(); i += 3) {
+            rounding[i] = static_cast<uint8_t>(rounding[i] < 255 ? rounding[i] + 1 : rounding[i] - 1);
+        }
+        // 每 100 个像素有一个明显变化
+        auto changed{golden};
+        for (size_t p{}; p < n_pixels; p += 100) {
+            changed[p * 4] = static_cast<uint8_t>(changed[p * 4] ^ 0x80);
+        }
+
+        std::printf("%s\n", std::format("{}x{}, {} SIMD pixels, {} threads, best of {} runs", options.width, options.height,
+            Image::detail::SIMD_PIXELS, std::max(1u, std::thread::hardware_concurrency()), options.runs).c_str());
+        bench_frame("identical", golden, golden, options);
+        bench_frame("within tolerance", golden, rounding, options);
+        const double changed_ms{bench_frame("1% changed", golden, changed, options)};
+
+        if (options.max_ms > 0.0 && changed_ms > options.max_ms) {
+            std::fprintf(stderr, "%s\n", std::format("diff_bench: {:.3f} ms exceeds the {:.3f} ms target", changed_ms, options.max_ms).c_str());
+            return 1;
+        }
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "app.hpp"
+
+#include <algorithm>
+#include <format>
+#include <memory>
+#include <stdexcept>
+
+#include "framework.hpp"
+#include "opengl/gl.hpp"
+#include "opengl/gl_trace.hpp"
+
+/**
+ * 回放 --trace 录制的 GL 调用流
+ *   gl_replay <path.gltrace>              按录制时的调用间隔回放
+ *   gl_replay <path.gltrace> --max-speed  不等待，度量纯驱动开销
+ * 同样支持 --golden / --capture，可对回放画面做比对或录屏
+ */
+
+namespace {
+
+std::shared_ptr<SDL_Window> window_;
+std::shared_ptr<SDL::SDL_GLContext> gl_context_;
+std::unique_ptr<GL::Trace::Replayer> replayer_;
+
+void report()
+{
+    const auto &stats{replayer_->stats()};
+    const double frames{static_cast<double>(std::max<uint64_t>(stats.frames, 1))};
+    SDL_Log("%s", std::format(
+        "replay: {} frames, {} calls ({} unknown), avg {:.3f} ms/frame, worst {:.3f} ms, {:.0f} calls/s, gl-context {}",
+        stats.frames, stats.calls, stats.unknown_calls, stats.total_ms / frames, stats.worst_frame_ms,
+        stats.total_ms > 0.0 ? static_cast<double>(stats.calls) * 1000.0 / stats.total_ms : 0.0,
+        Framework::context_profile_name(Framework::context_info().profile)).c_str());
+    if (replayer_->names_diverged()) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "replay: object names differ from the recording, results may be wrong");
+    }
+}
+
+} // namespace
+
+void App::Create()
+{
+    const auto &options{Framework::options()};
+    if (options.arguments.empty()) {
+        throw std::runtime_error{"ERROR::REPLAY what:usage: gl_replay <path.gltrace> [--max-speed]"};
+    }
+    replayer_ = std::make_unique<GL::Trace::Replayer>(options.arguments.front());
+
+    if (!SDL_Init(SDL_INIT_VIDEO)) {
+        throw std::runtime_error{"SDL init failed"};
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
+    SDL_GL_SetAttribute(SDL_GL_RED_SIZE,   8);
+    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE,  8);
+    SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+    SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    Framework::set_context_attributes();
+
+    // trace 记录的是像素尺寸，不启用高 DPI 以保证默认帧缓冲大小一致
+    window_ = SDL::Meta<SDL_Window>::create(
+        "gl replay",
+        static_cast<int>(replayer_->width()),
+        static_cast<int>(replayer_->height()),
+        Framework::window_flags(SDL_WINDOW_OPENGL));
+
+    gl_context_ = SDL::Meta<SDL::SDL_GLContext>::create(window_.get());
+
+    SDL_GL_MakeCurrent(window_.get(), gl_context_.get());
+    // 帧间隔已包含在 trace 中（录制时的 vsync 等待也计入调用间隔），回放时关闭 vsync
+    SDL_GL_SetSwapInterval(0);
+    Framework::load_gl(window_.get());
+}
+
+void App::Destory()
+{
+    if (nullptr != replayer_) {
+        report();
+    }
+    replayer_.reset();
+    gl_context_.reset();
+    window_.reset();
+
+    SDL_Quit();
+}
+
+void App::Render()
+{
+    try {
+        if (!replayer_->replay_frame(Framework::options().max_speed)) {
+            Framework::request_quit(SDL_APP_SUCCESS);
+            return;
+        }
+    }
+    catch (const std::runtime_error &error) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", error.what());
+        Framework::request_quit(SDL_APP_FAILURE);
+        return;
+    }
+    Framework::before_swap(window_.get());
+
+    SDL_GL_SwapWindow(window_.get());
+}
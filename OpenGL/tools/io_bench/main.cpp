@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "image/io_scheduler.hpp"
+
+/**
+ * 异步 I/O 调度器基准：与 std::ifstream 同步读取（GL::make_shader 的方式）比较吞吐与单次请求延迟
+ *   io_bench [--files N] [--size KiB] [--reads N] [--depth N] [--cold] [dir]
+ * 不指定目录时在临时目录生成 N 个（默认 64）大小为 size（默认 1024 KiB）的文件。
+ * 每种后端各跑两项：整文件读取，以及在全部文件中随机读取 64 KiB 的块（默认 4096 次）。
+ * --cold 在每项之前用 posix_fadvise(DONTNEED) 丢弃页缓存（仅 Linux），测的是真实磁盘而不是内存拷贝。
+ * 同步读取的延迟是单次读取耗时；调度器的请求一次全部提交，延迟从 read() 到读完，包含排队时间。
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t RANDOM_BLOCK{64 * 1024};
+
+struct Options
+{
+    size_t files{64};
+    size_t size_kib{1024};
+    size_t reads{4096};
+    uint32_t depth{64};
+    bool cold{};
+    std::filesystem::path dir{};
+};
+
+struct Run
+{
+    size_t bytes{};
+    double elapsed_ms{};
+    std::vector<double> latencies{};
+};
+
+size_t parse_count(std::string_view text)
+{
+    size_t value{};
+    const auto [ptr, ec]{std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (ec != std::errc{} || ptr != text.data() + text.size() || 0 == value) {
+        throw std::runtime_error{std::format("ERROR::IO_BENCH what:invalid argument '{}'", text)};
+    }
+    return value;
+}
+
+std::vector<std::filesystem::path> make_files(const Options &options)
+{
+    std::filesystem::create_directories(options.dir);
+    std::vector<std::filesystem::path> paths;
+    std::mt19937 random{42};
+    std::vector<char> content(options.size_kib * 1024);
+    for (size_t i{}; i < options.files; ++i) {
+        auto path{options.dir / std::format("{:04}.bin", i)};
+        if (!std::filesystem::exists(path) || std::filesystem::file_size(path) != content.size()) {
+            std::ranges::generate(content, [&random] { return static_cast<char>(random()); });
+            std::ofstream{path, std::ios::binary}.write(content.data(), static_cast<std::streamsize>(content.size()));
+        }
+        paths.push_back(std::move(path));
+    }
+    return paths;
+}
+
+std::vector<std::filesystem::path> list_files(const std::filesystem::path &dir)
+{
+    std::vector<std::filesystem::path> paths;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator{dir}) {
+        if (entry.is_regular_file() && entry.file_size() > 0) {
+            paths.push_back(entry.path());
+        }
+    }
+    if (paths.empty()) {
+        throw std::runtime_error{std::format("ERROR::IO_BENCH what:no files in {}", dir.string())};
+    }
+    std::ranges::sort(paths);
+    return paths;
+}
+
+void drop_cache([[maybe_unused]] const std::vector<std::filesystem::path> &paths)
+{
+#if defined(__linux__)
+    for (const auto &path : paths) {
+        const int fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (fd >= 0) {
+            ::fdatasync(fd);
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+double elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// 与 GL::read_shader_file 相同：rdbuf 读入 stringstream
+Run sync_whole(const std::vector<std::filesystem::path> &paths)
+{
+    Run run;
+    const auto start{Clock::now()};
+    for (const auto &path : paths) {
+        const auto begin{Clock::now()};
+        std::ifstream file{path, std::ios::binary};
+        std::stringstream stream;
+        stream << file.rdbuf();
+        run.bytes += stream.view().size();
+        run.latencies.push_back(elapsed_ms(begin));
+    }
+    run.elapsed_ms = elapsed_ms(start);
+    return run;
+}
+
+struct Block
+{
+    size_t file{};
+    uint64_t offset{};
+};
+
+Run sync_random(const std::vector<std::filesystem::path> &paths, const std::vector<Block> &blocks)
+{
+    std::vector<std::ifstream> files;
+    for (const auto &path : paths) {
+        files.emplace_back(path, std::ios::binary);
+    }
+    Run run;
+    std::vector<char> buffer(RANDOM_BLOCK);
+    const auto start{Clock::now()};
+    for (const auto &block : blocks) {
+        const auto begin{Clock::now()};
+        auto &file{files[block.file]};
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(block.offset));
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        run.bytes += static_cast<size_t>(file.gcount());
+        run.latencies.push_back(elapsed_ms(begin));
+    }
+    run.elapsed_ms = elapsed_ms(start);
+    return run;
+}
+
+Run async_run(Image::IoScheduler &io, const std::function<void(const Image::IoScheduler::Callback &)> &submit)
+{
+    Run run;
+    const auto start{Clock::now()};
+    submit([&run](Image::IoResult &&result) {
+        if (0 != result.error) {
+            throw std::runtime_error{std::format("ERROR::IO_BENCH what:read failed, errno {}", result.error)};
+        }
+        run.bytes += result.data.size();
+        run.latencies.push_back(result.latency_ms);
+    });
+    // 像帧循环一样边读边交付，结果缓冲区及时释放复用，否则测到的主要是新内存的缺页
+    while (io.pending() > 0) {
+        if (0 == io.poll()) {
+            std::this_thread::yield();
+        }
+    }
+    io.finish();
+    run.elapsed_ms = elapsed_ms(start);
+    return run;
+}
+
+Run async_whole(Image::IoScheduler &io, const std::vector<std::filesystem::path> &paths)
+{
+    return async_run(io, [&](const Image::IoScheduler::Callback &callback) {
+        for (const auto &path : paths) {
+            io.read(path, callback);
+        }
+    });
+}
+
+Run async_random(Image::IoScheduler &io, const std::vector<std::filesystem::path> &paths, const std::vector<Block> &blocks)
+{
+    std::vector<std::shared_ptr<const Image::IoFile>> files;
+    for (const auto &path : paths) {
+        files.push_back(std::make_shared<const Image::IoFile>(path));
+    }
+    return async_run(io, [&](const Image::IoScheduler::Callback &callback) {
+        for (const auto &block : blocks) {
+            io.read(files[block.file], block.offset, RANDOM_BLOCK, callback);
+        }
+    });
+}
+
+void report(std::string_view name, Run &&run)
+{
+    std::ranges::sort(run.latencies);
+    const auto percentile{[&run](double p) {
+        return run.latencies.empty() ? 0.0 : run.latencies[static_cast<size_t>(p * static_cast<double>(run.latencies.size() - 1))];
+    }};
+    const double megabytes{static_cast<double>(run.bytes) / (1024.0 * 1024.0)};
+    std::printf("%s\n", std::format("{:<22} {:>9.2f} ms {:>9.1f} MB/s   p50 {:>8.3f} ms   p99 {:>8.3f} ms",
+        name, run.elapsed_ms, megabytes * 1000.0 / std::max(run.elapsed_ms, 1e-3), percentile(0.5), percentile(0.99)).c_str());
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    try {
+        Options options;
+        for (int i{1}; i < argc; ++i) {
+            const std::string_view arg{argv[i]};
+            if ("--files" == arg && i + 1 < argc) {
+                options.files = parse_count(argv[++i]);
+            }
+            else if ("--size" == arg && i + 1 < argc) {
+                options.size_kib = parse_count(argv[++i]);
+            }
+            else if ("--reads" == arg && i + 1 < argc) {
+                options.reads = parse_count(argv[++i]);
+            }
+            else if ("--depth" == arg && i + 1 < argc) {
+                options.depth = static_cast<uint32_t>(std::min<size_t>(parse_count(argv[++i]), 4096));
+            }
+            else if ("--cold" == arg) {
+                options.cold = true;
+            }
+            else {
+                options.dir = arg;
+            }
+        }
+
+        const auto paths{options.dir.empty()
+            ? make_files({.files = options.files, .size_kib = options.size_kib, .dir = std::filesystem::temp_directory_path() / "io_bench"})
+            : list_files(options.dir)};
+
+        std::mt19937 random{7};
+        std::vector<Block> blocks;
+        for (size_t i{}; i < options.reads; ++i) {
+            const size_t file{random() % paths.size()};
+            const auto size{std::filesystem::file_size(paths[file])};
+            blocks.push_back({file, size > RANDOM_BLOCK ? random() % (size - RANDOM_BLOCK) : 0});
+        }
+
+        const auto measure{[&](std::string_view name, const std::function<Run()> &bench) {
+            if (options.cold) {
+                drop_cache(paths);
+            }
+            report(name, bench());
+        }};
+
+        std::printf("%s\n", std::format("{} files, {} random reads of {} KiB, depth {}{}",
+            paths.size(), blocks.size(), RANDOM_BLOCK / 1024, options.depth, options.cold ? ", cold cache" : "").c_str());
+        measure("ifstream whole", [&] { return sync_whole(paths); });
+        measure("ifstream random", [&] { return sync_random(paths, blocks); });
+        for (const auto backend : {Image::IoBackend::Uring, Image::IoBackend::Threads}) {
+            std::unique_ptr<Image::IoScheduler> io;
+            try {
+                io = std::make_unique<Image::IoScheduler>(Image::IoSchedulerOptions{.backend = backend, .queue_depth = options.depth});
+            }
+            catch (const std::runtime_error &error) {
+                std::printf("%s\n", error.what());
+                continue;
+            }
+            const std::string_view backend_name{Image::io_backend_name(backend)};
+            measure(std::format("{} whole", backend_name), [&] { return async_whole(*io, paths); });
+            measure(std::format("{} random", backend_name), [&] { return async_random(*io, paths, blocks); });
+            std::printf("  %s\n", io->stats().to_string().c_str());
+        }
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
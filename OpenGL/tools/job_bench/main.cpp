@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <format>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/ext.hpp>
+#include <glm/glm.hpp>
+
+#include "jobs/job_system.hpp"
+#include "jobs/task_graph.hpp"
+
+/**
+ * 任务系统基准：每帧变换更新的单线程与并行耗时，以及每帧任务图本身的开销
+ *   job_bench [--count N] [--passes N] [--workers N] [--width N] [--layers N] [--frames N]
+ * 变换更新对 count（默认 1M）个物体由位置与旋转计算模型矩阵，重复 passes 次（默认 20）取平均，
+ * 分别用单线程循环、按缓存行切分的 parallel_for、以及每次只领取一个元素的 parallel_for（对比用）；
+ * 并行结果与单线程逐个比较，不一致时返回 1。
+ * 任务图有 layers 层（默认 4）、每层 width 个（默认 64）空节点，每个节点依赖上一层相邻的两个，
+ * 重复执行 frames 帧（默认 1000），得到每帧与每个节点的调度开销。
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    size_t count{1024 * 1024};
+    size_t passes{20};
+    size_t workers{0};
+    size_t width{64};
+    size_t layers{4};
+    size_t frames{1000};
+};
+
+struct Object
+{
+    glm::vec3 position{};
+    float angle{};
+};
+
+size_t parse_count(std::string_view text)
+{
+    size_t value{};
+    const auto [ptr, ec]{std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (ec != std::errc{} || ptr != text.data() + text.size() || 0 == value) {
+        throw std::runtime_error{std::format("ERROR::JOB_BENCH what:invalid argument '{}'", text)};
+    }
+    return value;
+}
+
+double elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void update(std::span<const Object> objects, std::span<glm::mat4> models, size_t first, float time)
+{
+    for (size_t i{}; i < models.size(); ++i) {
+        const auto &object{objects[first + i]};
+        models[i] = glm::rotate(glm::translate(glm::mat4{1.0f}, object.position), object.angle + time, glm::vec3(1.0f, 0.3f, 0.5f));
+    }
+}
+
+// 计算相同，结果须逐位一致
+void verify(std::string_view name, std::span<const glm::mat4> models, std::span<const glm::mat4> expected)
+{
+    for (size_t i{}; i < expected.size(); ++i) {
+        if (models[i] != expected[i]) {
+            throw std::runtime_error{std::format("ERROR::JOB_BENCH what:{} differs from serial at object {}", name, i)};
+        }
+    }
+}
+
+void report(std::string_view name, double total_ms, size_t passes, size_t count, double baseline_ms)
+{
+    const double pass_ms{total_ms / static_cast<double>(passes)};
+    std::printf("%s\n", std::format("{:<26} {:>9.3f} ms/pass {:>9.1f} M/s {:>7.2f}x",
+        name, pass_ms, static_cast<double>(count) / (pass_ms * 1000.0), baseline_ms / pass_ms).c_str());
+}
+
+void bench_transforms(Jobs::JobSystem &jobs, const Options &options)
+{
+    std::vector<Object> objects(options.count);
+    for (size_t i{}; i < objects.size(); ++i) {
+        const auto x{static_cast<float>(i % 1024)};
+        const auto z{static_cast<float>(i / 1024)};
+        objects[i] = {glm::vec3(x, 0.0f, -z), 0.001f * static_cast<float>(i)};
+    }
+    std::vector<glm::mat4> models(options.count);
+
+    const auto measure{[&](const std::function<void(float)> &pass) {
+        pass(0.0f);
+        const auto start{Clock::now()};
+        for (size_t i{}; i < options.passes; ++i) {
+            pass(static_cast<float>(i + 1) * 0.01f);
+        }
+        return elapsed_ms(start);
+    }};
+
+    const double serial_ms{measure([&](float time) { update(objects, models, 0, time); })};
+    const double baseline_ms{serial_ms / static_cast<double>(options.passes)};
+    report("serial", serial_ms, options.passes, options.count, baseline_ms);
+    // 每次测量的最后一遍 time 相同
+    const std::vector<glm::mat4> expected{models};
+
+    std::ranges::fill(models, glm::mat4{0.0f});
+    report("parallel_for cache lines", measure([&](float time) {
+        Jobs::parallel_for(jobs, "update transforms", std::span<glm::mat4>{models}, [&](std::span<glm::mat4> chunk, size_t first) {
+            update(objects, chunk, first, time);
+        });
+    }), options.passes, options.count, baseline_ms);
+    verify("parallel_for cache lines", models, expected);
+
+    std::ranges::fill(models, glm::mat4{0.0f});
+    report("parallel_for grain 1", measure([&](float time) {
+        Jobs::parallel_for(jobs, "update transforms", options.count, 1, [&](size_t begin, size_t end) {
+            update(objects, std::span<glm::mat4>{models}.subspan(begin, end - begin), begin, time);
+        });
+    }), options.passes, options.count, baseline_ms);
+    verify("parallel_for grain 1", models, expected);
+}
+
+void bench_graph(Jobs::JobSystem &jobs, const Options &options)
+{
+    Jobs::TaskGraph graph;
+    std::vector<Jobs::TaskGraph::NodeId> previous;
+    for (size_t layer{}; layer < options.layers; ++layer) {
+        std::vector<Jobs::TaskGraph::NodeId> current;
+        for (size_t i{}; i < options.width; ++i) {
+            std::vector<Jobs::TaskGraph::NodeId> dependencies;
+            if (!previous.empty()) {
+                dependencies.push_back(previous[i]);
+                dependencies.push_back(previous[(i + 1) % previous.size()]);
+            }
+            current.push_back(graph.add("node", [] {}, std::move(dependencies)));
+        }
+        previous = std::move(current);
+    }
+
+    graph.run(jobs);
+    const auto start{Clock::now()};
+    for (size_t i{}; i < options.frames; ++i) {
+        graph.run(jobs);
+    }
+    const double frame_us{elapsed_ms(start) * 1000.0 / static_cast<double>(options.frames)};
+    std::printf("%s\n", std::format("{:<26} {:>9.2f} us/frame {:>7.1f} ns/node",
+        std::format("graph {}x{}", options.layers, options.width), frame_us, frame_us * 1000.0 / static_cast<double>(graph.size())).c_str());
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    try {
+        Options options;
+        for (int i{1}; i < argc; ++i) {
+            const std::string_view arg{argv[i]};
+            if ("--count" == arg && i + 1 < argc) {
+                options.count = parse_count(argv[++i]);
+            }
+            else if ("--passes" == arg && i + 1 < argc) {
+                options.passes = parse_count(argv[++i]);
+            }
+            else if ("--workers" == arg && i + 1 < argc) {
+                options.workers = parse_count(argv[++i]);
+            }
+            else if ("--width" == arg && i + 1 < argc) {
+                options.width = parse_count(argv[++i]);
+            }
+            else if ("--layers" == arg && i + 1 < argc) {
+                options.layers = parse_count(argv[++i]);
+            }
+            else if ("--frames" == arg && i + 1 < argc) {
+                options.frames = parse_count(argv[++i]);
+            }
+            else {
+                throw std::runtime_error{std::format("ERROR::JOB_BENCH what:unknown argument '{}'", arg)};
+            }
+        }
+
+        Jobs::JobSystem jobs{options.workers};
+        std::printf("%s\n", std::format("{} threads, {} objects, {} passes", jobs.thread_count(), options.count, options.passes).c_str());
+        bench_transforms(jobs, options);
+        bench_graph(jobs, options);
+        std::printf("  %s\n", jobs.stats().to_string().c_str());
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
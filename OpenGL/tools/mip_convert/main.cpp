@@ -0,0 +1,166 @@
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include "image/mip_chain.hpp"
+#include "image/pixel_convert.hpp"
+#include "image/virtual_texture.hpp"
+
+/**
+ * 把图片离线转换为 .mipc（完整 mip 链），GL::TextureCache 遇到同名 .mipc 时不再解码原图
+ *   mip_convert [--srgb] [--no-flip] [--premultiply] [--format rgba8|bc1|bc3|bc7] [--quality fast|normal|high] [--virtual]
+ *               [--output-dir <dir>] <image>...
+ * 输出与输入同目录、扩展名替换为 .mipc
+ *   --srgb     按 sRGB 存储（GL_SRGB8_ALPHA8 或对应的 sRGB 压缩格式），mip 在线性空间平均
+ *   --no-flip  保持图片的行顺序；默认上下翻转，与运行时 TextureOptions::flip_vertically 一致
+ *   --premultiply  预乘 alpha 后再生成 mip，避免透明像素的颜色渗入
+ *   --format   默认 rgba8；bc1/bc3/bc7 在生成 mip 后逐级压缩，运行时直接以压缩格式上传
+ *   --quality  压缩质量，默认 high（离线转换不在乎耗时）
+ *   --virtual  改为输出分页的 .vtex，供 GL::VirtualTexture 按需加载；只支持 rgba8
+ *   --output-dir  输出到该目录（不存在时创建），而不是输入所在的目录；构建时由 add_asset_pack 使用
+ */
+
+namespace {
+
+struct Settings
+{
+    bool srgb{};
+    bool flip{true};
+    bool premultiply{};
+    std::optional<Image::BcFormat> compression{};
+    Image::BcQuality quality{Image::BcQuality::High};
+    bool virtual_texture{};
+    std::filesystem::path output_dir{};
+};
+
+std::optional<Image::BcFormat> parse_format(std::string_view text)
+{
+    for (const auto format : {Image::BcFormat::Bc1, Image::BcFormat::Bc3, Image::BcFormat::Bc7}) {
+        if (Image::bc_format_name(format) == text) {
+            return format;
+        }
+    }
+    if ("rgba8" != text) {
+        throw std::runtime_error{std::format("ERROR::MIP_CONVERT what:unknown format '{}'", text)};
+    }
+    return std::nullopt;
+}
+
+Image::BcQuality parse_quality(std::string_view text)
+{
+    for (const auto quality : {Image::BcQuality::Fast, Image::BcQuality::Normal, Image::BcQuality::High}) {
+        if (Image::bc_quality_name(quality) == text) {
+            return quality;
+        }
+    }
+    throw std::runtime_error{std::format("ERROR::MIP_CONVERT what:unknown quality '{}'", text)};
+}
+
+void convert(const std::filesystem::path &input, const Settings &settings)
+{
+    const auto start{std::chrono::steady_clock::now()};
+
+    int width{};
+    int height{};
+    int channels{};
+    stbi_set_flip_vertically_on_load(0);
+    const std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> pixels{
+        stbi_load(input.string().c_str(), &width, &height, &channels, 4), &stbi_image_free};
+    if (nullptr == pixels) {
+        throw std::runtime_error{std::format("ERROR::MIP_CONVERT what:can not decode {}: {}", input.string(), stbi_failure_reason())};
+    }
+
+    const std::span rgba{pixels.get(), static_cast<size_t>(width) * static_cast<size_t>(height) * 4};
+    Image::convert_rgba8_in_place(rgba, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+        {.flip_vertically = settings.flip, .premultiply_alpha = settings.premultiply});
+    auto chain{Image::build_mip_chain(rgba, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+        settings.srgb ? Image::MipFormat::Srgb8Alpha8 : Image::MipFormat::Rgba8)};
+    if (settings.compression.has_value()) {
+        chain = Image::compress_mip_chain(chain, *settings.compression, settings.quality);
+    }
+    auto output{settings.output_dir.empty() ? input : settings.output_dir / input.filename()};
+    if (settings.virtual_texture) {
+        output.replace_extension(".vtex");
+        Image::write_virtual_texture(output, chain);
+    }
+    else {
+        output.replace_extension(".mipc");
+        Image::write_mip_chain(output, chain);
+    }
+
+    std::printf("%s\n", std::format("{} -> {}: {}x{} {}, {} levels, {:.1f} KB, {:.1f} ms",
+        input.string(), output.string(), width, height,
+        settings.compression.has_value() ? Image::bc_format_name(*settings.compression) : "rgba8", chain.levels.size(),
+        static_cast<double>(std::filesystem::file_size(output)) / 1024.0,
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()).c_str());
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    constexpr const char *USAGE{"usage: mip_convert [--srgb] [--no-flip] [--premultiply] [--format rgba8|bc1|bc3|bc7] [--quality fast|normal|high] [--virtual]\n"
+                                "                   [--output-dir <dir>] <image>...\n"};
+    Settings settings{};
+    std::vector<std::filesystem::path> inputs;
+    try {
+        for (int i{1}; i < argc; ++i) {
+            const std::string_view arg{argv[i]};
+            const bool has_value{i + 1 < argc};
+            if ("--srgb" == arg) {
+                settings.srgb = true;
+            }
+            else if ("--no-flip" == arg) {
+                settings.flip = false;
+            }
+            else if ("--premultiply" == arg) {
+                settings.premultiply = true;
+            }
+            else if ("--format" == arg && has_value) {
+                settings.compression = parse_format(argv[++i]);
+            }
+            else if ("--quality" == arg && has_value) {
+                settings.quality = parse_quality(argv[++i]);
+            }
+            else if ("--virtual" == arg) {
+                settings.virtual_texture = true;
+            }
+            else if ("--output-dir" == arg && has_value) {
+                settings.output_dir = argv[++i];
+            }
+            else {
+                inputs.emplace_back(arg);
+            }
+        }
+        if (inputs.empty()) {
+            std::fprintf(stderr, "%s", USAGE);
+            return 1;
+        }
+        if (settings.virtual_texture && settings.compression.has_value()) {
+            throw std::runtime_error{"ERROR::MIP_CONVERT what:--virtual only supports rgba8"};
+        }
+
+        if (!settings.output_dir.empty()) {
+            std::filesystem::create_directories(settings.output_dir);
+        }
+        for (const auto &input : inputs) {
+            convert(input, settings);
+        }
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <format>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "image/pixel_convert.hpp"
+
+/**
+ * 像素转换基准：各转换步骤的 SIMD 路径对比标量路径，融合的单次遍历对比逐步骤各扫一遍
+ *   pixel_bench [size] [runs]    size x size 的图，默认 4096；每项取 runs 次（默认 5）中最快的一次
+ * 计时前先校验当前 CPU 可用的每条 SIMD 路径与标量路径逐字节一致（包括不足一块的尾部），不一致时返回 1。
+ * 吞吐按写出的 RGBA 字节计算；sRGB 查表与翻转没有 SIMD 版本，以同样大小的内存拷贝作为参照。
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double best_ms(int runs, const std::function<void()> &fn)
+{
+    double best{std::numeric_limits<double>::max()};
+    for (int run{}; run < runs; ++run) {
+        const auto start{Clock::now()};
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+void report(std::string_view name, size_t bytes, double simd_ms, double scalar_ms)
+{
+    const auto megabytes_per_second = [bytes](double ms) {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0) * 1000.0 / std::max(ms, 1e-3);
+    };
+    std::printf("%s\n", std::format("{:<24} {:>8.2f} ms {:>8.0f} MB/s   baseline {:>8.2f} ms {:>8.0f} MB/s   x{:.2f}",
+        name, simd_ms, megabytes_per_second(simd_ms), scalar_ms, megabytes_per_second(scalar_ms), scalar_ms / std::max(simd_ms, 1e-3)).c_str());
+}
+
+constexpr std::array ALL_PATHS{
+    Image::SimdPath::Scalar, Image::SimdPath::Sse2, Image::SimdPath::Ssse3, Image::SimdPath::Avx2, Image::SimdPath::Neon};
+
+size_t first_difference(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b)
+{
+    return static_cast<size_t>(std::ranges::mismatch(a, b).in1 - a.begin());
+}
+
+// 扩展与预乘分别在整幅图与各种尾部长度上与标量路径比较
+void verify_path(Image::SimdPath path, const std::vector<uint8_t> &rgb, const std::vector<uint8_t> &rgba)
+{
+    const size_t n_pixels{rgba.size() / 4};
+    for (const size_t n : {size_t{0}, size_t{1}, size_t{3}, size_t{4}, size_t{5}, size_t{7}, size_t{8}, size_t{9},
+             size_t{15}, size_t{16}, size_t{17}, size_t{33}, n_pixels - 1, n_pixels}) {
+        const size_t count{std::min(n, n_pixels)};
+        std::vector<uint8_t> expected(count * 4);
+        std::vector<uint8_t> actual(count * 4);
+        Image::detail::expand_rgb_scalar(rgb.data(), expected.data(), count);
+        Image::detail::expand_rgb(rgb.data(), actual.data(), count, path);
+        if (expected != actual) {
+            throw std::runtime_error{std::format("ERROR::PIXEL_BENCH what:{} rgb -> rgba of {} pixels differs from scalar at byte {}",
+                Image::simd_path_name(path), count, first_difference(expected, actual))};
+        }
+        expected.assign(rgba.begin(), rgba.begin() + static_cast<std::ptrdiff_t>(count * 4));
+        actual = expected;
+        Image::detail::premultiply_scalar(expected.data(), count);
+        Image::detail::premultiply(actual.data(), count, path);
+        if (expected != actual) {
+            throw std::runtime_error{std::format("ERROR::PIXEL_BENCH what:{} premultiply of {} pixels differs from scalar at byte {}",
+                Image::simd_path_name(path), count, first_difference(expected, actual))};
+        }
+    }
+}
+
+template <class T>
+T parse_argument(std::string_view text)
+{
+    T value{};
+    const auto [ptr, ec]{std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (ec != std::errc{} || ptr != text.data() + text.size() || 0 == value) {
+        throw std::runtime_error{std::format("ERROR::PIXEL_BENCH what:invalid argument '{}'", text)};
+    }
+    return value;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    try {
+        const uint32_t size{argc > 1 ? parse_argument<uint32_t>(argv[1]) : 4096u};
+        const int runs{argc > 2 ? parse_argument<int>(argv[2]) : 5};
+        const size_t n_pixels{static_cast<size_t>(size) * size};
+
+        std::vector<uint8_t> rgb(n_pixels * 3);
+        std::vector<uint8_t> rgba(n_pixels * 4);
+        for (size_t i{}; i < rgb.size(); ++i) {
+            rgb[i] = static_cast<uint8_t>(i * 7 + i / 4093);
+        }
+        Image::convert_to_rgba8(rgb, 3, size, size, rgba);
+        for (size_t i{3}; i < rgba.size(); i += 4) {
+            rgba[i] = static_cast<uint8_t>(i / 4 * 13);
+        }
+        const auto source{rgba};
+        std::vector<uint8_t> work(rgba.size());
+        const auto restore = [&] { std::copy(source.begin(), source.end(), work.begin()); };
+
+        std::string verified;
+        for (const auto path : ALL_PATHS) {
+            if (Image::simd_path_supported(path)) {
+                verify_path(path, rgb, source);
+                verified += std::format(" {}", Image::simd_path_name(path));
+            }
+        }
+        std::printf("%s\n", std::format("{}x{}, active path {}, verified against scalar:{}, best of {} runs",
+            size, size, Image::simd_path_name(Image::simd_path()), verified, runs).c_str());
+
+        const double expand_scalar_ms{best_ms(runs, [&] { Image::detail::expand_rgb_scalar(rgb.data(), rgba.data(), n_pixels); })};
+        // 预乘原地修改，计时包含恢复数据的拷贝，两边相同
+        const double premultiply_scalar_ms{best_ms(runs, [&] { restore(); Image::detail::premultiply_scalar(work.data(), n_pixels); })};
+        for (const auto path : ALL_PATHS) {
+            if (Image::SimdPath::Scalar == path || !Image::simd_path_supported(path)) {
+                continue;
+            }
+            const auto name{Image::simd_path_name(path)};
+            report(std::format("rgb -> rgba ({})", name), rgba.size(),
+                best_ms(runs, [&] { Image::detail::expand_rgb(rgb.data(), rgba.data(), n_pixels, path); }), expand_scalar_ms);
+            report(std::format("premultiply ({})", name), rgba.size(),
+                best_ms(runs, [&] { restore(); Image::detail::premultiply(work.data(), n_pixels, path); }), premultiply_scalar_ms);
+        }
+
+        const double copy_ms{best_ms(runs, restore)};
+        report("srgb -> linear (table)", rgba.size(),
+            best_ms(runs, [&] { restore(); Image::detail::srgb_to_linear_scalar(work.data(), n_pixels); }), copy_ms);
+
+        // stb_image 的翻转同样是逐行交换
+        report("flip in place", rgba.size(),
+            best_ms(runs, [&] { Image::flip_vertically(work, static_cast<size_t>(size) * 4, size); }), copy_ms);
+
+        const Image::PixelConvert all{.flip_vertically = true, .srgb_to_linear = true, .premultiply_alpha = true};
+        report("fused rgb (all steps)", rgba.size(),
+            best_ms(runs, [&] { Image::convert_to_rgba8(rgb, 3, size, size, rgba, all); }),
+            best_ms(runs, [&] {
+                Image::convert_to_rgba8(rgb, 3, size, size, rgba);
+                Image::flip_vertically(rgba, static_cast<size_t>(size) * 4, size);
+                Image::detail::srgb_to_linear_scalar(rgba.data(), n_pixels);
+                Image::detail::premultiply(rgba.data(), n_pixels);
+            }));
+        report("fused rgba in place", rgba.size(),
+            best_ms(runs, [&] { restore(); Image::convert_rgba8_in_place(work, size, size, all); }),
+            best_ms(runs, [&] {
+                restore();
+                Image::flip_vertically(work, static_cast<size_t>(size) * 4, size);
+                Image::detail::srgb_to_linear_scalar(work.data(), n_pixels);
+                Image::detail::premultiply(work.data(), n_pixels);
+            }));
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,258 @@
+#include "app.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "framework.hpp"
+#include "opengl/gl.hpp"
+#include "opengl/gl_streaming_texture.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
+/**
+ * 流式纹理回放：GL::ImageSequence 预读解码 + GL::StreamingTexture 上传
+ *   sequence_player [path] [fps] [decode_ahead]
+ * path 为图片目录或 .mjpeg 文件，按 fps（默认 60）回放一遍后退出；未指定 path 时改为 1920x1080 的软件画布，
+ * 每帧只上传移动方块前后所在的脏矩形，共 600 帧。
+ * 帧号由经过的时间决定（--max-speed 时每次渲染前进一帧），当前帧未解码完成时继续显示上一帧并计为迟到；
+ * 退出时输出迟到帧数、最差的 update 与渲染耗时。
+ */
+
+namespace {
+
+constexpr GLsizei CANVAS_WIDTH{1920};
+constexpr GLsizei CANVAS_HEIGHT{1080};
+constexpr GLsizei CANVAS_BLOCK{128};
+constexpr size_t CANVAS_FRAMES{600};
+
+using Clock = std::chrono::steady_clock;
+
+std::shared_ptr<SDL_Window> window_;
+std::shared_ptr<SDL::SDL_GLContext> gl_context_;
+
+std::unique_ptr<GL::ImageSequence> g_sequence;
+std::unique_ptr<GL::StreamingTexture> g_texture;
+GLuint g_read_framebuffer{};
+double g_fps{60.0};
+size_t g_decode_ahead{6};
+
+// 没有图片序列时使用的软件画布
+std::vector<uint8_t> g_canvas;
+GL::TextureRect g_block{};
+std::vector<GL::TextureRect> g_dirty;
+
+Clock::time_point g_start{};
+size_t g_rendered{};            // 已渲染的帧数
+size_t g_shown{};               // 已显示的不同帧数
+size_t g_next{};                // 下一个应显示的帧号
+uint64_t g_late{};
+double g_worst_frame_ms{};
+
+template <class T>
+T parse_argument(std::string_view text)
+{
+    T value{};
+    const auto [ptr, ec]{std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (ec != std::errc{} || ptr != text.data() + text.size() || T{} == value) {
+        throw std::runtime_error{std::format("ERROR::SEQUENCE_PLAYER what:invalid argument '{}'", text)};
+    }
+    return value;
+}
+
+size_t frame_count()
+{
+    return nullptr != g_sequence ? g_sequence->frame_count() : CANVAS_FRAMES;
+}
+
+void fill_rect(const GL::TextureRect &rect, uint8_t r, uint8_t g, uint8_t b)
+{
+    for (GLint y{rect.y}; y < rect.y + rect.height; ++y) {
+        uint8_t *row{g_canvas.data() + (static_cast<size_t>(y) * CANVAS_WIDTH + static_cast<size_t>(rect.x)) * 4};
+        for (GLint x{}; x < rect.width; ++x, row += 4) {
+            row[0] = r;
+            row[1] = g;
+            row[2] = b;
+            row[3] = 255;
+        }
+    }
+}
+
+// 擦除方块旧位置并画到新位置，两处都计为脏矩形
+void draw_canvas(size_t frame)
+{
+    const auto t{static_cast<double>(frame) / static_cast<double>(CANVAS_FRAMES)};
+    const GL::TextureRect next{
+        static_cast<GLint>(t * (CANVAS_WIDTH - CANVAS_BLOCK)),
+        static_cast<GLint>((0.5 + 0.4 * std::sin(t * 12.566)) * (CANVAS_HEIGHT - CANVAS_BLOCK)),
+        CANVAS_BLOCK, CANVAS_BLOCK};
+    g_dirty.push_back(g_block);
+    g_dirty.push_back(next);
+    fill_rect(g_block, 51, 77, 77);
+    fill_rect(next, static_cast<uint8_t>(frame * 3), 200, static_cast<uint8_t>(255 - frame));
+    g_block = next;
+}
+
+// 返回是否上传了新的一帧
+bool update_texture(size_t frame)
+{
+    if (nullptr == g_sequence) {
+        draw_canvas(frame);
+        if (!g_texture->update(g_canvas, static_cast<size_t>(CANVAS_WIDTH) * 4, g_dirty)) {
+            return false;   // 脏矩形保留到下一帧
+        }
+        g_dirty.clear();
+        return true;
+    }
+
+    const auto decoded{g_sequence->acquire(frame)};
+    if (nullptr == decoded) {
+        return false;
+    }
+    if (static_cast<GLsizei>(decoded->width) != g_texture->width() || static_cast<GLsizei>(decoded->height) != g_texture->height()) {
+        throw std::runtime_error{std::format("ERROR::SEQUENCE_PLAYER what:frame {} is {}x{}, expected {}x{}",
+            frame, decoded->width, decoded->height, g_texture->width(), g_texture->height())};
+    }
+    return g_texture->update(decoded->rgba, static_cast<size_t>(decoded->width) * 4);
+}
+
+} // namespace
+
+void App::Create()
+{
+    const auto &arguments{Framework::options().arguments};
+    if (arguments.size() > 1) {
+        g_fps = parse_argument<double>(arguments[1]);
+    }
+    if (arguments.size() > 2) {
+        g_decode_ahead = parse_argument<size_t>(arguments[2]);
+    }
+    // 先开始解码，与窗口、上下文的创建并行
+    if (!arguments.empty()) {
+        g_sequence = GL::ImageSequence::open(arguments[0], g_decode_ahead);
+    }
+
+    if (!SDL_Init(SDL_INIT_VIDEO)) {
+        throw std::runtime_error{"SDL init failed"};
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
+    SDL_GL_SetAttribute(SDL_GL_RED_SIZE,   8);
+    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE,  8);
+    SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    Framework::set_context_attributes();
+
+    window_ = SDL::Meta<SDL_Window>::create(
+        "sequence player", 960, 540, Framework::window_flags(SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE));
+    gl_context_ = SDL::Meta<SDL::SDL_GLContext>::create(window_.get());
+
+    SDL_GL_MakeCurrent(window_.get(), gl_context_.get());
+    SDL_GL_SetSwapInterval(Framework::options().max_speed ? 0 : 1);
+    Framework::load_gl(window_.get());
+
+    // 纹理尺寸取第一帧；等待第一帧解码只发生在启动时
+    GLsizei width{CANVAS_WIDTH};
+    GLsizei height{CANVAS_HEIGHT};
+    if (nullptr != g_sequence) {
+        std::shared_ptr<const GL::DecodedFrame> first;
+        while (nullptr == (first = g_sequence->acquire(0))) {
+            if (g_sequence->stats().failed > 0) {
+                throw std::runtime_error{"ERROR::SEQUENCE_PLAYER what:decode first frame failed"};
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        width = static_cast<GLsizei>(first->width);
+        height = static_cast<GLsizei>(first->height);
+    }
+    else {
+        g_canvas.resize(static_cast<size_t>(CANVAS_WIDTH) * CANVAS_HEIGHT * 4);
+        fill_rect({0, 0, CANVAS_WIDTH, CANVAS_HEIGHT}, 51, 77, 77);
+        g_dirty.push_back({0, 0, CANVAS_WIDTH, CANVAS_HEIGHT});
+    }
+    g_texture = std::make_unique<GL::StreamingTexture>(width, height);
+
+    glGenFramebuffers(1, &g_read_framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, g_read_framebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_texture->id(), 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    SDL_Log("%s", std::format("sequence player: {} frames of {}x{} at {} fps, decode ahead {}",
+        frame_count(), width, height, g_fps, nullptr != g_sequence ? g_decode_ahead : 0).c_str());
+    g_start = Clock::now();
+}
+
+void App::Destory()
+{
+    if (nullptr != g_texture) {
+        SDL_Log("%s", std::format("played {} of {} frames in {} renders, {} late, worst frame {:.3f} ms",
+            g_shown, frame_count(), g_rendered, g_late, g_worst_frame_ms).c_str());
+        SDL_Log("texture: %s; ring: %s", g_texture->stats().to_string().c_str(), g_texture->ring_stats().to_string().c_str());
+    }
+    if (nullptr != g_sequence) {
+        SDL_Log("sequence: %s", g_sequence->stats().to_string().c_str());
+    }
+    glDeleteFramebuffers(1, &g_read_framebuffer);
+    g_texture.reset();
+    g_sequence.reset();
+    gl_context_.reset();
+    window_.reset();
+
+    SDL_Quit();
+}
+
+void App::Render()
+{
+    const auto frame_start{Clock::now()};
+
+    // 按时间应显示的帧；跳过的帧不再上传
+    const size_t due{Framework::options().max_speed ? g_rendered
+        : static_cast<size_t>(std::chrono::duration<double>(frame_start - g_start).count() * g_fps)};
+    if (due >= frame_count()) {
+        Framework::request_quit(SDL_APP_SUCCESS);
+        return;
+    }
+    if (due >= g_next) {
+        if (update_texture(due)) {
+            g_shown += 1;
+            g_next = due + 1;
+        }
+        else {
+            g_late += 1;
+        }
+    }
+
+    int window_width{};
+    int window_height{};
+    SDL_GetWindowSizeInPixels(window_.get(), &window_width, &window_height);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    // 保持宽高比居中显示
+    const double scale{std::min(static_cast<double>(window_width) / g_texture->width(), static_cast<double>(window_height) / g_texture->height())};
+    const auto width{static_cast<GLint>(g_texture->width() * scale)};
+    const auto height{static_cast<GLint>(g_texture->height() * scale)};
+    const GLint x{(window_width - width) / 2};
+    const GLint y{(window_height - height) / 2};
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, g_read_framebuffer);
+    glBlitFramebuffer(0, 0, g_texture->width(), g_texture->height(), x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    Framework::before_swap(window_.get());
+    SDL_GL_SwapWindow(window_.get());
+    g_rendered += 1;
+    g_worst_frame_ms = std::max(g_worst_frame_ms, std::chrono::duration<double, std::milli>(Clock::now() - frame_start).count());
+}
@@ -0,0 +1,243 @@
+#include "app.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "framework.hpp"
+#include "opengl/gl.hpp"
+#include "opengl/gl_upload_ring.hpp"
+
+/**
+ * 纹理上传基准：对比 glTexSubImage2D 直接读取客户端内存与经 GL::UploadRing（持久映射 PBO）上传
+ *   upload_bench [size] [count]    依次上传 count 张 size x size 的 RGBA8 纹理，默认 2048 64
+ * 两种方式各跑一轮，每帧最多上传 FRAME_BYTES，按 256 KiB 分块（与 GL::TextureCache 相同）；
+ * 每轮结束 glFinish 后输出吞吐（MB/s）与最差帧耗时。关闭 vsync，可配合 --headless 运行。
+ */
+
+namespace {
+
+constexpr size_t CHUNK_BYTES{256 * 1024};
+constexpr size_t FRAME_BYTES{8 << 20};
+
+enum class Mode : uint8_t { Client, Pbo, Done };
+
+constexpr std::string_view mode_name(Mode mode)
+{
+    switch (mode) {
+        case Mode::Client: return "client";
+        case Mode::Pbo:    return "pbo";
+        case Mode::Done:   break;
+    }
+    return "done";
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct Run
+{
+    std::vector<GLuint> textures{};
+    size_t texture{};           // 正在上传的纹理
+    GLsizei row{};              // 下一块的起始行
+    uint64_t bytes{};
+    uint64_t frames{};
+    uint64_t ring_full{};       // 上传环已满、本帧提前结束的次数
+    double worst_frame_ms{};
+    double worst_upload_ms{};
+    Clock::time_point start{};
+};
+
+std::shared_ptr<SDL_Window> window_;
+std::shared_ptr<SDL::SDL_GLContext> gl_context_;
+
+GLsizei g_size{2048};
+size_t g_count{64};
+std::vector<uint8_t> g_pixels;
+Mode g_mode{Mode::Client};
+Run g_run;
+std::unique_ptr<GL::UploadRing> g_ring;
+
+template <class T>
+T parse_argument(std::string_view text)
+{
+    T value{};
+    const auto [ptr, ec]{std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (ec != std::errc{} || ptr != text.data() + text.size() || 0 == value) {
+        throw std::runtime_error{std::format("ERROR::UPLOAD_BENCH what:invalid argument '{}'", text)};
+    }
+    return value;
+}
+
+double elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// 纹理存储在计时之外分配
+void begin_run()
+{
+    g_run = {};
+    g_run.textures.resize(g_count);
+    glGenTextures(static_cast<GLsizei>(g_count), g_run.textures.data());
+    for (const auto texture : g_run.textures) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, g_size, g_size);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glFinish();
+    g_run.start = Clock::now();
+}
+
+void end_run()
+{
+    glFinish();
+    const double total_ms{elapsed_ms(g_run.start)};
+    const double megabytes{static_cast<double>(g_run.bytes) / (1024.0 * 1024.0)};
+    SDL_Log("%s", std::format(
+        "upload {}: {:.1f} MB in {:.1f} ms = {:.0f} MB/s, {} frames, worst frame {:.3f} ms, worst upload {:.3f} ms{}",
+        mode_name(g_mode), megabytes, total_ms, megabytes * 1000.0 / std::max(total_ms, 1e-3), g_run.frames,
+        g_run.worst_frame_ms, g_run.worst_upload_ms,
+        Mode::Pbo == g_mode ? std::format(", ring full {} ({})", g_run.ring_full, g_ring->stats().to_string()) : "").c_str());
+
+    glDeleteTextures(static_cast<GLsizei>(g_run.textures.size()), g_run.textures.data());
+    g_run.textures.clear();
+}
+
+// 返回本帧是否还有剩余纹理
+bool upload_frame()
+{
+    const auto row_bytes{static_cast<size_t>(g_size) * 4};
+    const auto chunk_rows{static_cast<GLsizei>(std::max<size_t>(1, CHUNK_BYTES / row_bytes))};
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Mode::Pbo == g_mode ? g_ring->buffer() : 0);
+    size_t frame_bytes{};
+    while (frame_bytes < FRAME_BYTES && g_run.texture < g_run.textures.size()) {
+        const GLsizei rows{std::min(chunk_rows, g_size - g_run.row)};
+        const auto bytes{static_cast<size_t>(rows) * row_bytes};
+        const auto *source{g_pixels.data() + static_cast<size_t>(g_run.row) * row_bytes};
+
+        const void *pixels{source};
+        if (Mode::Pbo == g_mode) {
+            const auto allocation{g_ring->try_allocate(bytes)};
+            if (!allocation.has_value()) {
+                g_run.ring_full += 1;
+                break;
+            }
+            std::memcpy(allocation->data, source, bytes);
+            pixels = reinterpret_cast<const void *>(allocation->offset);
+        }
+        glBindTexture(GL_TEXTURE_2D, g_run.textures[g_run.texture]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, g_run.row, g_size, rows, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+        frame_bytes += bytes;
+        g_run.row += rows;
+        if (g_run.row == g_size) {
+            g_run.row = 0;
+            g_run.texture += 1;
+        }
+    }
+    if (Mode::Pbo == g_mode) {
+        g_ring->submit();
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    g_run.bytes += frame_bytes;
+    return g_run.texture < g_run.textures.size();
+}
+
+} // namespace
+
+void App::Create()
+{
+    const auto &arguments{Framework::options().arguments};
+    if (!arguments.empty()) {
+        g_size = parse_argument<GLsizei>(arguments[0]);
+    }
+    if (arguments.size() > 1) {
+        g_count = parse_argument<size_t>(arguments[1]);
+    }
+
+    if (!SDL_Init(SDL_INIT_VIDEO)) {
+        throw std::runtime_error{"SDL init failed"};
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
+    SDL_GL_SetAttribute(SDL_GL_RED_SIZE,   8);
+    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE,  8);
+    SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    Framework::set_context_attributes();
+
+    window_ = SDL::Meta<SDL_Window>::create(
+        "upload bench", 640, 480, Framework::window_flags(SDL_WINDOW_OPENGL));
+    gl_context_ = SDL::Meta<SDL::SDL_GLContext>::create(window_.get());
+
+    SDL_GL_MakeCurrent(window_.get(), gl_context_.get());
+    SDL_GL_SetSwapInterval(0);
+    Framework::load_gl(window_.get());
+
+    // 每张纹理内容相同，行内填充渐变避免驱动对常量数据走捷径
+    g_pixels.resize(static_cast<size_t>(g_size) * static_cast<size_t>(g_size) * 4);
+    for (size_t i{}; i < g_pixels.size(); ++i) {
+        g_pixels[i] = static_cast<uint8_t>(i * 7 + i / 4096);
+    }
+    g_ring = std::make_unique<GL::UploadRing>();
+    SDL_Log("%s", std::format("upload bench: {} x {}x{} RGBA8 ({:.1f} MB), {} MB per frame, ring {} MB",
+        g_count, g_size, g_size, static_cast<double>(g_pixels.size() * g_count) / (1024.0 * 1024.0),
+        FRAME_BYTES >> 20, g_ring->size() >> 20).c_str());
+    begin_run();
+}
+
+void App::Destory()
+{
+    if (!g_run.textures.empty()) {
+        glDeleteTextures(static_cast<GLsizei>(g_run.textures.size()), g_run.textures.data());
+    }
+    g_ring.reset();
+    gl_context_.reset();
+    window_.reset();
+
+    SDL_Quit();
+}
+
+void App::Render()
+{
+    if (Mode::Done == g_mode) {
+        return;
+    }
+    const auto frame_start{Clock::now()};
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    const auto upload_start{Clock::now()};
+    const bool remaining{upload_frame()};
+    g_run.worst_upload_ms = std::max(g_run.worst_upload_ms, elapsed_ms(upload_start));
+
+    Framework::before_swap(window_.get());
+    SDL_GL_SwapWindow(window_.get());
+    g_run.worst_frame_ms = std::max(g_run.worst_frame_ms, elapsed_ms(frame_start));
+    g_run.frames += 1;
+
+    if (!remaining) {
+        end_run();
+        g_mode = Mode::Client == g_mode ? Mode::Pbo : Mode::Done;
+        if (Mode::Done == g_mode) {
+            Framework::request_quit(SDL_APP_SUCCESS);
+            return;
+        }
+        begin_run();
+    }
+}
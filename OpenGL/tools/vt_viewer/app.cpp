@@ -0,0 +1,203 @@
+#include "app.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+#include <glm/ext.hpp>
+#include <glm/glm.hpp>
+
+#include "framework.hpp"
+#include "opengl/gl.hpp"
+#include "opengl/gl_virtual_texture.hpp"
+
+/**
+ * 虚拟纹理查看器：GL::VirtualTexture 的反馈 -> 按需加载 -> 采样
+ *   vt_viewer <file.vtex> [cache_pages]
+ * .vtex 由 mip_convert --virtual 生成；cache_pages 为物理缓存每边的页数（默认 16，即 256 页）。
+ * 相机贴着平面移动并不断拉近拉远，每帧先以 1/8 分辨率绘制反馈，再用已驻留的页绘制画面；
+ * 缺页时回退到更粗的一级。--headless 时绘制 600 帧后退出，退出时输出驻留与抖动统计。
+ */
+
+namespace {
+
+constexpr uint64_t HEADLESS_FRAMES{600};
+
+using Clock = std::chrono::steady_clock;
+
+std::shared_ptr<SDL_Window> window_;
+std::shared_ptr<SDL::SDL_GLContext> gl_context_;
+
+std::unique_ptr<GL::VirtualTexture> g_texture;
+std::unique_ptr<GL::ShaderProgram> g_program;
+std::unique_ptr<GL::ShaderProgram> g_feedback_program;
+GLuint g_vao{};
+GLuint g_vbo{};
+float g_aspect{1.0f};           // 原图宽高比，平面按此缩放
+Clock::time_point g_start{};
+uint64_t g_frames{};
+double g_worst_frame_ms{};
+
+uint32_t parse_cache_pages(std::string_view text)
+{
+    uint32_t value{};
+    const auto [ptr, ec]{std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (ec != std::errc{} || ptr != text.data() + text.size() || value < 2) {
+        throw std::runtime_error{std::format("ERROR::VT_VIEWER what:invalid cache pages '{}'", text)};
+    }
+    return value;
+}
+
+std::unique_ptr<GL::ShaderProgram> make_program(const char *fragment_path)
+{
+    const GL::Shader vertex{GL_VERTEX_SHADER, std::filesystem::path{"shader/vertex.glsl"}};
+    const GL::Shader fragment{GL_FRAGMENT_SHADER,
+        GL::ShaderSource{GL::with_virtual_texture_glsl(GL::read_shader_file(fragment_path))}};
+    return std::make_unique<GL::ShaderProgram>(vertex, fragment);
+}
+
+// 平面位于 z = 0，相机在其上方低空绕行，高度周期变化，覆盖从整体到最细一级的过渡
+glm::mat4 camera(float seconds, int width, int height)
+{
+    const glm::vec3 target{0.6f * g_aspect * std::sin(seconds * 0.21f), 0.6f * std::sin(seconds * 0.13f), 0.0f};
+    const float altitude{0.03f + 1.2f * (0.5f + 0.5f * std::cos(seconds * 0.35f))};
+    const glm::vec3 eye{target + glm::vec3{0.0f, -1.5f * altitude, altitude}};
+    const glm::mat4 view{glm::lookAt(eye, target, glm::vec3{0.0f, 0.0f, 1.0f})};
+    const glm::mat4 projection{glm::perspective(glm::radians(60.0f),
+        static_cast<float>(width) / static_cast<float>(std::max(height, 1)), 0.005f, 10.0f)};
+    return projection * view;
+}
+
+void draw(const GL::ShaderProgram &program, const glm::mat4 &mvp, bool feedback)
+{
+    program.use();
+    g_texture->bind(program, 0, 1, feedback);
+    glUniformMatrix4fv(program.getUniformLocation("u_mvp_mat"), 1, GL_FALSE, glm::value_ptr(mvp));
+    glBindVertexArray(g_vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+}
+
+} // namespace
+
+void App::Create()
+{
+    const auto &arguments{Framework::options().arguments};
+    if (arguments.empty()) {
+        throw std::runtime_error{"ERROR::VT_VIEWER what:usage: vt_viewer <file.vtex> [cache_pages]"};
+    }
+    const uint32_t cache_pages{arguments.size() > 1 ? parse_cache_pages(arguments[1]) : 16};
+
+    if (!SDL_Init(SDL_INIT_VIDEO)) {
+        throw std::runtime_error{"SDL init failed"};
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
+    SDL_GL_SetAttribute(SDL_GL_RED_SIZE,   8);
+    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE,  8);
+    SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    Framework::set_context_attributes();
+
+    window_ = SDL::Meta<SDL_Window>::create(
+        "virtual texture viewer", 1280, 720, Framework::window_flags(SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE));
+    gl_context_ = SDL::Meta<SDL::SDL_GLContext>::create(window_.get());
+
+    SDL_GL_MakeCurrent(window_.get(), gl_context_.get());
+    SDL_GL_SetSwapInterval(Framework::options().max_speed ? 0 : 1);
+    Framework::load_gl(window_.get());
+
+    g_texture = std::make_unique<GL::VirtualTexture>(arguments[0], cache_pages);
+    g_program = make_program("shader/fragment.glsl");
+    g_feedback_program = make_program("shader/feedback.glsl");
+    const auto &file{g_texture->file()};
+    g_aspect = static_cast<float>(file.width()) / static_cast<float>(file.height());
+
+    // 纹理坐标 [0, 1] 对应原图，vt_sample 负责换算到虚拟空间
+    const std::array vertex{
+        -g_aspect, -1.0f, 0.0f,  0.0f, 0.0f,
+         g_aspect, -1.0f, 0.0f,  1.0f, 0.0f,
+        -g_aspect,  1.0f, 0.0f,  0.0f, 1.0f,
+         g_aspect,  1.0f, 0.0f,  1.0f, 1.0f,
+    };
+    glGenVertexArrays(1, &g_vao);
+    glGenBuffers(1, &g_vbo);
+    glBindVertexArray(g_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertex), vertex.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5*sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5*sizeof(float), reinterpret_cast<void *>(3*sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glEnable(GL_DEPTH_TEST);
+
+    SDL_Log("%s", std::format("virtual texture: {}x{} in {}^2 virtual space, {} levels of {} px pages, cache {} pages",
+        file.width(), file.height(), file.virtual_size(), file.level_count(), file.page_size(), g_texture->cache_pages()).c_str());
+    g_start = Clock::now();
+}
+
+void App::Destory()
+{
+    if (nullptr != g_texture) {
+        SDL_Log("%s", std::format("{} frames, worst frame {:.3f} ms, {} pages resident",
+            g_frames, g_worst_frame_ms, g_texture->resident_pages()).c_str());
+        SDL_Log("virtual texture: %s", g_texture->stats().to_string().c_str());
+    }
+    glDeleteBuffers(1, &g_vbo);
+    glDeleteVertexArrays(1, &g_vao);
+    g_feedback_program.reset();
+    g_program.reset();
+    g_texture.reset();
+    gl_context_.reset();
+    window_.reset();
+
+    SDL_Quit();
+}
+
+void App::Render()
+{
+    if (Framework::options().headless && g_frames >= HEADLESS_FRAMES) {
+        Framework::request_quit(SDL_APP_SUCCESS);
+        return;
+    }
+    const auto frame_start{Clock::now()};
+
+    int width{};
+    int height{};
+    SDL_GetWindowSizeInPixels(window_.get(), &width, &height);
+    // --max-speed 时按帧推进，每次运行的相机路径一致
+    const float seconds{Framework::options().max_speed ? static_cast<float>(g_frames) / 60.0f
+        : std::chrono::duration<float>(frame_start - g_start).count()};
+    const glm::mat4 mvp{camera(seconds, width, height)};
+
+    // 先处理之前帧的反馈，本帧就能用上已上传的页
+    g_texture->update();
+
+    g_texture->begin_feedback(width, height);
+    draw(*g_feedback_program, mvp, true);
+    g_texture->end_feedback();
+
+    glViewport(0, 0, width, height);
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    draw(*g_program, mvp, false);
+
+    Framework::before_swap(window_.get());
+    SDL_GL_SwapWindow(window_.get());
+    g_frames += 1;
+    g_worst_frame_ms = std::max(g_worst_frame_ms, std::chrono::duration<double, std::milli>(Clock::now() - frame_start).count());
+}
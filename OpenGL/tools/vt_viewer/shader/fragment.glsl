@@ -0,0 +1,11 @@
+#version 460 core
+
+layout (location = 0) in  vec2 v_tex_coord;
+layout (location = 0) out vec4 f_color;
+
+// vt_sample 由 GL::with_virtual_texture_glsl 插入
+
+void main()
+{
+    f_color = vt_sample(v_tex_coord);
+}
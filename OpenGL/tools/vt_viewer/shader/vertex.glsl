@@ -0,0 +1,13 @@
+#version 460 core
+
+layout (location = 0) in  vec3 a_pos;
+layout (location = 1) in  vec2 a_tex_coord;
+layout (location = 0) out vec2 v_tex_coord;
+
+uniform mat4 u_mvp_mat;
+
+void main()
+{
+    gl_Position = u_mvp_mat * vec4(a_pos, 1.0);
+    v_tex_coord = a_tex_coord;
+}
@@ -70,4 +70,149 @@ function(enable_thread_sanitizer target_name)
         -fsanitize=thread
         -fno-omit-frame-pointer)
     target_link_libraries(${target_name} PRIVATE -fsanitize=thread)
-endfunction()
\ No newline at end of file
+endfunction()
+
+# 以 headless 模式运行 demo，在固定帧与 golden/<target>.tga 比对
+# 基准图须经人工确认后提交：<target> --headless --golden golden/<target>.tga --golden-update
+# 基准图不存在时测试照常注册，demo 无法读取 golden image 而失败，不会由被测的构建自动生成
+function(add_golden_test target_name)
+    if(NOT BUILD_GOLDEN_TESTS)
+        return()
+    endif()
+    set(GOLDEN_IMAGE ${CMAKE_CURRENT_SOURCE_DIR}/golden/${target_name}.tga)
+    if(NOT EXISTS ${GOLDEN_IMAGE})
+        message(WARNING "golden image not found, golden.${target_name} will fail: ${GOLDEN_IMAGE}")
+    endif()
+    add_test(NAME golden.${target_name}
+        COMMAND ${target_name} --headless --golden ${GOLDEN_IMAGE}
+        WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR})
+endfunction()
+
+# 单元测试：同目录的 <test_name>.cpp 编译为可执行文件，以 unit.<test_name> 注册到 ctest，其余参数为链接的库
+# 测试程序不依赖测试框架，检查失败时抛出异常、返回非 0
+function(add_unit_test test_name)
+    if(NOT BUILD_TESTS)
+        return()
+    endif()
+    add_executable(${test_name} ${test_name}.cpp)
+    target_link_libraries(${test_name} PRIVATE ${ARGN})
+    enable_compile_option(${test_name})
+    if(NOT CMAKE_SYSTEM_NAME MATCHES "Windows")
+        enable_addr_sanitizer(${test_name})
+    endif()
+    add_test(NAME unit.${test_name} COMMAND ${test_name})
+endfunction()
+
+# 把程序运行时读取的资源（相对源码目录的文件或目录）打包为可执行文件旁的 <target>.pak
+# MIP_CHAIN 之后的图片在构建时由 mip_convert 转换为同名 .mipc，与原图一起打包，GL::TextureCache 从包中加载 .mipc，不再解码原图
+# 运行：<target> --asset-pack <target>.pak；不存在的输入跳过，源码目录中的文件修改后重新转换、打包
+# 有 golden 测试的 target 另外注册 golden.<target>.asset_pack，从包中加载全部资源
+function(add_asset_pack target_name)
+    cmake_parse_arguments(PARSE_ARGV 1 ARG "" "" "MIP_CHAIN")
+    set(ASSETS)
+    set(DEPENDS)
+    foreach(ASSET IN LISTS ARG_UNPARSED_ARGUMENTS ARG_MIP_CHAIN)
+        set(ASSET_PATH ${CMAKE_CURRENT_SOURCE_DIR}/${ASSET})
+        if(IS_DIRECTORY ${ASSET_PATH})
+            file(GLOB_RECURSE ASSET_FILES CONFIGURE_DEPENDS ${ASSET_PATH}/*)
+            list(APPEND DEPENDS ${ASSET_FILES})
+        elseif(EXISTS ${ASSET_PATH})
+            list(APPEND DEPENDS ${ASSET_PATH})
+        else()
+            message(STATUS "asset not found, not packed: ${ASSET_PATH}")
+            continue()
+        endif()
+        list(APPEND ASSETS ${ASSET})
+    endforeach()
+    if(NOT ASSETS)
+        return()
+    endif()
+
+    # .mipc 生成在构建目录，包内名字与原图同目录
+    set(MIP_CHAIN_DIR ${CMAKE_CURRENT_BINARY_DIR}/${target_name}_mipc)
+    set(MIP_CHAINS)
+    foreach(IMAGE IN LISTS ARG_MIP_CHAIN)
+        if(NOT IMAGE IN_LIST ASSETS)
+            continue()
+        endif()
+        cmake_path(GET IMAGE PARENT_PATH IMAGE_DIR)
+        cmake_path(REPLACE_EXTENSION IMAGE LAST_ONLY .mipc OUTPUT_VARIABLE MIP_CHAIN)
+        add_custom_command(OUTPUT ${MIP_CHAIN_DIR}/${MIP_CHAIN}
+            COMMAND mip_convert --output-dir ${MIP_CHAIN_DIR}/${IMAGE_DIR} ${CMAKE_CURRENT_SOURCE_DIR}/${IMAGE}
+            DEPENDS mip_convert ${CMAKE_CURRENT_SOURCE_DIR}/${IMAGE}
+            COMMENT "Converting ${IMAGE} to a mip chain"
+            VERBATIM)
+        list(APPEND MIP_CHAINS ${MIP_CHAIN})
+        list(APPEND DEPENDS ${MIP_CHAIN_DIR}/${MIP_CHAIN})
+    endforeach()
+    if(MIP_CHAINS)
+        list(PREPEND MIP_CHAINS -C ${MIP_CHAIN_DIR})
+    endif()
+
+    set(PACK ${CMAKE_CURRENT_BINARY_DIR}/${target_name}.pak)
+    add_custom_command(OUTPUT ${PACK}
+        COMMAND asset_pack -o ${PACK} -C ${CMAKE_CURRENT_SOURCE_DIR} ${ASSETS} ${MIP_CHAINS}
+        DEPENDS asset_pack ${DEPENDS}
+        COMMENT "Packing assets of ${target_name}"
+        VERBATIM)
+    add_custom_target(${target_name}_assets DEPENDS ${PACK})
+    add_dependencies(${target_name} ${target_name}_assets)
+
+    # 已注册 golden 测试时（须先调用 add_golden_test）再以资源包运行一次，与同一基准图比对
+    # 在构建目录运行，源码目录的散文件不可见，缺少的资源直接失败，不会回退到散文件
+    if(BUILD_GOLDEN_TESTS AND TEST golden.${target_name})
+        add_test(NAME golden.${target_name}.asset_pack
+            COMMAND ${target_name} --headless --golden ${CMAKE_CURRENT_SOURCE_DIR}/golden/${target_name}.tga --asset-pack ${PACK}
+            WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR})
+    endif()
+endfunction()
+
+# 从 glad.h 提取全部 GL 入口函数，生成 X-macro 列表：GL_FUNCTION(glXxx)
+function(generate_gl_function_list glad_header output_file)
+    file(STRINGS ${glad_header} GLAD_DECLS REGEX "^GLAPI PFN[A-Z0-9_]+PROC glad_gl[A-Za-z0-9_]+;$")
+    set(CONTENT "// generated from glad.h by generate_gl_function_list(), do not edit\n")
+    foreach(DECL IN LISTS GLAD_DECLS)
+        string(REGEX REPLACE "^GLAPI PFN[A-Z0-9_]+PROC glad_(gl[A-Za-z0-9_]+);$" "GL_FUNCTION(\\1)\n" LINE "${DECL}")
+        string(APPEND CONTENT "${LINE}")
+    endforeach()
+    file(CONFIGURE OUTPUT ${output_file} CONTENT "${CONTENT}" @ONLY)
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${glad_header})
+endfunction()
+
+# 扫描 source_dirs 下源码中调用的 glXxx(，与 function_list（generate_gl_function_list 的输出）取交集
+# 结果供 GL::Loader 在启动时只解析这些入口；源码修改后 cmake 会自动重新生成
+function(generate_gl_used_function_list function_list output_file)
+    file(STRINGS ${function_list} ALL_FUNCTIONS REGEX "^GL_FUNCTION\\(")
+    list(TRANSFORM ALL_FUNCTIONS REPLACE "^GL_FUNCTION\\((gl[A-Za-z0-9_]+)\\)$" "\\1")
+
+    set(SOURCES)
+    foreach(DIR IN LISTS ARGN)
+        file(GLOB_RECURSE DIR_SOURCES CONFIGURE_DEPENDS ${DIR}/*.cpp ${DIR}/*.hpp ${DIR}/*.h)
+        list(APPEND SOURCES ${DIR_SOURCES})
+    endforeach()
+
+    set(CALLED)
+    foreach(SOURCE IN LISTS SOURCES)
+        file(STRINGS ${SOURCE} LINES REGEX "gl[A-Z][A-Za-z0-9_]*[ \t]*\\(")
+        foreach(LINE IN LISTS LINES)
+            string(REGEX MATCHALL "gl[A-Z][A-Za-z0-9_]*[ \t]*\\(" MATCHES "${LINE}")
+            list(TRANSFORM MATCHES REPLACE "[ \t]*\\($" "")
+            list(APPEND CALLED ${MATCHES})
+        endforeach()
+    endforeach()
+    list(REMOVE_DUPLICATES CALLED)
+
+    set(CONTENT "// generated by generate_gl_used_function_list(), do not edit\n")
+    set(COUNT 0)
+    foreach(FUNCTION IN LISTS ALL_FUNCTIONS)
+        if(FUNCTION IN_LIST CALLED)
+            string(APPEND CONTENT "GL_FUNCTION(${FUNCTION})\n")
+            math(EXPR COUNT "${COUNT} + 1")
+        endif()
+    endforeach()
+    file(CONFIGURE OUTPUT ${output_file} CONTENT "${CONTENT}" @ONLY)
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${SOURCES})
+
+    list(LENGTH ALL_FUNCTIONS TOTAL)
+    message(STATUS "GL loader: ${COUNT} of ${TOTAL} entry points resolved at startup")
+endfunction()
@@ -0,0 +1,486 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "lz_block.hpp"
+#include "mapped_file.hpp"
+
+/**
+ * 资源包（.pak）：把一个程序运行时读取的着色器、图片等打成一个文件，启动时只打开、映射一次
+ *
+ * 文件布局（小端）：
+ *   PackHeader
+ *   PackEntry[entry_count]，按 (hash, 名字) 排序，查找时二分
+ *   名字字符串，紧密排列，不含结尾的 0
+ *   各条目的数据，每个都从 4096 对齐处开始，按打包时的顺序排列（启动时顺序读取）
+ * 名字是相对程序工作目录的路径，经 asset_name() 规范化：分隔符统一为 '/'，去掉开头的 "./"。
+ *
+ * 未压缩的条目可以直接使用映射内存，不复制；.mipc 等文件内部的对齐在包内保持不变。
+ * 压缩的条目按 chunk_bytes 切成互相独立的块，分别以 LZ4 块格式压缩，数据开头是各块的压缩大小表
+ * （最高位为 1 表示该块未压缩），较大的条目解压时多个块在多个线程上并行。
+ */
+namespace Image {
+
+struct PackHeader
+{
+    std::array<char, 4> magic{'A', 'P', 'A', 'K'};
+    uint32_t version{1};
+    uint32_t entry_count{};
+    uint32_t chunk_bytes{};
+    uint64_t index_offset{};
+    uint64_t names_offset{};
+    uint64_t names_bytes{};
+    uint64_t data_offset{};
+};
+
+static_assert(sizeof(PackHeader) == 48);
+
+enum class PackCompression : uint8_t { None, Lz };
+
+struct PackEntry
+{
+    uint64_t hash{};            // asset_hash(名字)
+    uint64_t offset{};          // 数据在文件中的偏移
+    uint64_t stored_bytes{};    // 文件中占用的字节数（压缩时含块大小表）
+    uint64_t size{};            // 原始大小
+    uint32_t name_offset{};     // 相对名字区
+    uint16_t name_bytes{};
+    PackCompression compression{PackCompression::None};
+    uint8_t reserved{};
+};
+
+static_assert(sizeof(PackEntry) == 40);
+
+inline constexpr std::array<char, 4> PACK_MAGIC{'A', 'P', 'A', 'K'};
+inline constexpr uint64_t PACK_ENTRY_ALIGNMENT{4096};
+inline constexpr uint32_t PACK_DEFAULT_CHUNK_BYTES{64 * 1024};
+inline constexpr uint32_t PACK_RAW_CHUNK{0x8000'0000u};
+
+// "./shader\\vertex.glsl" -> "shader/vertex.glsl"
+inline std::string asset_name(std::string_view path)
+{
+    std::string name{path};
+    std::ranges::replace(name, '\\', '/');
+    name = std::filesystem::path{name}.lexically_normal().generic_string();
+    while (name.starts_with("./")) {
+        name.erase(0, 2);
+    }
+    return name;
+}
+
+// FNV-1a，名字须已规范化
+constexpr uint64_t asset_hash(std::string_view name)
+{
+    uint64_t hash{0xCBF29CE484222325ull};
+    for (const char c : name) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+namespace detail {
+
+/**
+ * 按块切分到多个线程，fn(first_chunk, last_chunk)
+ * 线程为每次调用创建，创建与 join 约 15 us；每个线程至少分到 min_bytes_per_thread（默认 1 MiB，
+ * 处理需 1 ms 以上），不足两份时在调用线程上依次处理，着色器等小条目不创建线程
+ */
+template <class Fn>
+void for_pack_chunks(size_t chunk_count, uint32_t chunk_bytes, Fn &&fn, size_t min_bytes_per_thread = 1024 * 1024)
+{
+    const size_t min_chunks_per_thread{std::max<size_t>(1, min_bytes_per_thread / chunk_bytes)};
+    const size_t n_threads{std::clamp<size_t>(
+        chunk_count / min_chunks_per_thread, 1, std::max(1u, std::thread::hardware_concurrency()))};
+    if (1 == n_threads) {
+        fn(size_t{}, chunk_count);
+        return;
+    }
+    std::vector<std::jthread> workers;
+    workers.reserve(n_threads);
+    const size_t chunks_per_thread{(chunk_count + n_threads - 1) / n_threads};
+    for (size_t t{}; t < n_threads; ++t) {
+        const size_t first{std::min(t * chunks_per_thread, chunk_count)};
+        const size_t last{std::min(first + chunks_per_thread, chunk_count)};
+        workers.emplace_back([&fn, first, last] { fn(first, last); });
+    }
+}
+
+} // namespace detail
+
+/**
+ * 一个资源的内容：指向包的映射内存（未压缩条目），或持有解压 / 从磁盘读入的副本
+ * 指向映射内存时不能比 AssetPack 活得更久
+ */
+class AssetBytes
+{
+public:
+    AssetBytes() = default;
+    explicit AssetBytes(std::span<const std::byte> mapped) : view_{mapped} {}
+    explicit AssetBytes(std::vector<std::byte> owned) : owned_{std::move(owned)}, view_{owned_} {}
+    // 接管未初始化分配后读入的缓冲区（如 IoBuffer::release()），不再复制
+    AssetBytes(std::unique_ptr<std::byte[]> buffer, size_t size) : buffer_{std::move(buffer)}, view_{buffer_.get(), size} {}
+    // vector 与 unique_ptr 移动时缓冲区不变，view_ 仍然有效
+    AssetBytes(AssetBytes &&) = default;
+    AssetBytes &operator=(AssetBytes &&) = default;
+    AssetBytes(const AssetBytes &) = delete;
+    AssetBytes &operator=(const AssetBytes &) = delete;
+
+    std::span<const std::byte> bytes() const { return view_; }
+    const std::byte *data() const { return view_.data(); }
+    size_t size() const { return view_.size(); }
+    std::string_view text() const { return {reinterpret_cast<const char *>(view_.data()), view_.size()}; }
+    bool mapped() const { return owned_.empty() && nullptr == buffer_ && !view_.empty(); }
+
+private:
+    std::vector<std::byte> owned_{};
+    std::unique_ptr<std::byte[]> buffer_{};
+    std::span<const std::byte> view_{};
+};
+
+/**
+ * 只读映射 .pak 文件
+ * 打开时把索引复制出来并校验全部条目的范围，之后的查找与读取不再访问文件头；可在多个线程同时读取
+ */
+class AssetPack
+{
+public:
+    explicit AssetPack(const std::filesystem::path &path)
+        : file_{path, MapAccess::Sequential}
+    {
+        const auto fail = [&](std::string_view what) {
+            return std::runtime_error{std::format("ERROR::IMAGE::ASSET_PACK what:{} {}", path.string(), what)};
+        };
+        if (file_.size() < sizeof(PackHeader) || 0 != std::memcmp(file_.data(), PACK_MAGIC.data(), PACK_MAGIC.size())) {
+            throw fail("is not an asset pack");
+        }
+        std::memcpy(&header_, file_.data(), sizeof(header_));
+        if (1 != header_.version) {
+            throw fail(std::format("has unsupported version {}", header_.version));
+        }
+        if (0 == header_.chunk_bytes || header_.chunk_bytes >= PACK_RAW_CHUNK
+            || header_.index_offset > file_.size()
+            || header_.entry_count > (file_.size() - header_.index_offset) / sizeof(PackEntry)
+            || header_.names_offset > file_.size() || header_.names_bytes > file_.size() - header_.names_offset) {
+            throw fail("has a truncated index");
+        }
+
+        entries_.resize(header_.entry_count);
+        std::memcpy(entries_.data(), file_.data() + header_.index_offset, sizeof(PackEntry) * entries_.size());
+        for (size_t i{}; i < entries_.size(); ++i) {
+            const auto &entry{entries_[i]};
+            if (uint64_t{entry.name_offset} + entry.name_bytes > header_.names_bytes) {
+                throw fail(std::format("entry {} has an invalid name", i));
+            }
+            const auto entry_name{name(entry)};
+            if (asset_hash(entry_name) != entry.hash
+                || (i > 0 && std::pair{entries_[i - 1].hash, name(entries_[i - 1])} >= std::pair{entry.hash, entry_name})) {
+                throw fail(std::format("index is corrupted at {}", entry_name));
+            }
+            if (entry.offset % PACK_ENTRY_ALIGNMENT != 0 || entry.offset > file_.size()
+                || entry.stored_bytes > file_.size() - entry.offset) {
+                throw fail(std::format("{} is out of range", entry_name));
+            }
+            const bool valid{PackCompression::None == entry.compression ? entry.stored_bytes == entry.size
+                : PackCompression::Lz == entry.compression && chunk_count(entry) <= entry.stored_bytes / sizeof(uint32_t)};
+            if (!valid) {
+                throw fail(std::format("{} has an invalid encoding", entry_name));
+            }
+        }
+    }
+
+    size_t size() const { return entries_.size(); }
+    std::span<const PackEntry> entries() const { return entries_; }
+    uint32_t chunk_bytes() const { return header_.chunk_bytes; }
+
+    std::string_view name(const PackEntry &entry) const {
+        return {reinterpret_cast<const char *>(file_.data() + header_.names_offset + entry.name_offset), entry.name_bytes};
+    }
+
+    // path 不必规范化；未找到时返回 nullptr
+    const PackEntry *find(std::string_view path) const {
+        const auto key{asset_name(path)};
+        const uint64_t hash{asset_hash(key)};
+        auto it{std::ranges::lower_bound(entries_, hash, {}, &PackEntry::hash)};
+        for (; entries_.end() != it && hash == it->hash; ++it) {
+            if (name(*it) == key) {
+                return &*it;
+            }
+        }
+        return nullptr;
+    }
+
+    bool contains(std::string_view path) const { return nullptr != find(path); }
+
+    // 条目在文件中的原始数据；未压缩时即内容本身
+    std::span<const std::byte> stored(const PackEntry &entry) const {
+        return {reinterpret_cast<const std::byte *>(file_.data() + entry.offset), static_cast<size_t>(entry.stored_bytes)};
+    }
+
+    // 未压缩的条目不复制，直接指向映射内存
+    AssetBytes load(const PackEntry &entry) const {
+        if (PackCompression::None == entry.compression) {
+            return AssetBytes{stored(entry)};
+        }
+        std::vector<std::byte> bytes(static_cast<size_t>(entry.size));
+        decompress(entry, bytes);
+        return AssetBytes{std::move(bytes)};
+    }
+
+    std::optional<AssetBytes> load(std::string_view path) const {
+        const auto *entry{find(path)};
+        if (nullptr == entry) {
+            return std::nullopt;
+        }
+        return load(*entry);
+    }
+
+    // out.size() 须等于 entry.size；2 MiB 以上的条目各块在多个线程上并行解压
+    void decompress(const PackEntry &entry, std::span<std::byte> out) const {
+        if (out.size() != entry.size) {
+            throw std::runtime_error{std::format("ERROR::IMAGE::ASSET_PACK what:{} needs {} bytes, got {}", name(entry), entry.size, out.size())};
+        }
+        const auto data{stored(entry)};
+        if (PackCompression::None == entry.compression) {
+            std::ranges::copy(data, out.begin());
+            return;
+        }
+
+        const size_t n_chunks{chunk_count(entry)};
+        std::vector<uint32_t> sizes(n_chunks);
+        std::memcpy(sizes.data(), data.data(), sizeof(uint32_t) * n_chunks);
+        std::vector<size_t> offsets(n_chunks + 1, sizeof(uint32_t) * n_chunks);
+        for (size_t i{}; i < n_chunks; ++i) {
+            offsets[i + 1] = offsets[i] + (sizes[i] & ~PACK_RAW_CHUNK);
+        }
+        if (offsets.back() != data.size()) {
+            throw std::runtime_error{std::format("ERROR::IMAGE::ASSET_PACK what:{} has a corrupted chunk table", name(entry))};
+        }
+
+        std::atomic<bool> corrupted{false};
+        detail::for_pack_chunks(n_chunks, header_.chunk_bytes, [&](size_t first, size_t last) {
+            for (size_t i{first}; i < last; ++i) {
+                const size_t begin{i * header_.chunk_bytes};
+                const auto output{std::span{reinterpret_cast<uint8_t *>(out.data()) + begin,
+                    std::min<size_t>(header_.chunk_bytes, out.size() - begin)}};
+                const auto input{std::span{reinterpret_cast<const uint8_t *>(data.data()) + offsets[i], offsets[i + 1] - offsets[i]}};
+                if (0 != (sizes[i] & PACK_RAW_CHUNK)) {
+                    if (input.size() != output.size()) {
+                        corrupted = true;
+                        return;
+                    }
+                    std::ranges::copy(input, output.begin());
+                }
+                else if (!lz_decompress(input, output)) {
+                    corrupted = true;
+                    return;
+                }
+            }
+        });
+        if (corrupted) {
+            throw std::runtime_error{std::format("ERROR::IMAGE::ASSET_PACK what:{} is corrupted", name(entry))};
+        }
+    }
+
+private:
+    size_t chunk_count(const PackEntry &entry) const {
+        return static_cast<size_t>((entry.size + header_.chunk_bytes - 1) / header_.chunk_bytes);
+    }
+
+    MappedFile file_;
+    PackHeader header_{};
+    std::vector<PackEntry> entries_{};
+};
+
+// 从磁盘读入整个文件，不存在或读取失败时抛出异常
+inline AssetBytes read_asset_file(const std::filesystem::path &path)
+{
+    std::ifstream file{path, std::ios::binary | std::ios::ate};
+    if (!file) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::ASSET what:can not open {}", path.string())};
+    }
+    std::vector<std::byte> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::ASSET what:read {} failed", path.string())};
+    }
+    return AssetBytes{std::move(bytes)};
+}
+
+// 包中有该资源时从包中读取，否则读取同名的文件（pack 可以为 nullptr）
+inline AssetBytes load_asset(const AssetPack *pack, std::string_view path)
+{
+    if (nullptr != pack) {
+        if (auto bytes{pack->load(path)}) {
+            return std::move(*bytes);
+        }
+    }
+    return read_asset_file(std::filesystem::path{path});
+}
+
+struct AssetPackOptions
+{
+    bool compress{true};
+    uint32_t chunk_bytes{PACK_DEFAULT_CHUNK_BYTES};
+    // 压缩后至少省下这一比例才保存为压缩条目，否则原样存放以便直接映射
+    double min_saving{0.125};
+};
+
+struct AssetPackSummary
+{
+    size_t entries{};
+    size_t compressed{};
+    uint64_t raw_bytes{};
+    uint64_t stored_bytes{};
+    uint64_t file_bytes{};
+};
+
+struct AssetSource
+{
+    std::string name;               // 包内名字，写入前规范化
+    std::filesystem::path file;     // 磁盘上的文件
+};
+
+// 按 sources 的顺序写入数据；名字重复时抛出异常
+inline AssetPackSummary write_asset_pack(const std::filesystem::path &path, std::span<const AssetSource> sources, const AssetPackOptions &options = {})
+{
+    if (0 == options.chunk_bytes || options.chunk_bytes >= PACK_RAW_CHUNK) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::ASSET_PACK what:invalid chunk size {}", options.chunk_bytes)};
+    }
+
+    struct Pending
+    {
+        std::string name;
+        PackEntry entry;
+        std::vector<uint8_t> data;  // 写入文件的内容
+    };
+    std::vector<Pending> pending;
+    pending.reserve(sources.size());
+    std::string names;
+    AssetPackSummary summary{};
+
+    for (const auto &source : sources) {
+        auto name{asset_name(source.name)};
+        if (name.empty() || name.size() > UINT16_MAX || names.size() + name.size() > UINT32_MAX) {
+            throw std::runtime_error{std::format("ERROR::IMAGE::ASSET_PACK what:invalid asset name '{}'", source.name)};
+        }
+        const auto bytes{read_asset_file(source.file)};
+        const std::span raw{reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size()};
+
+        Pending item{.name = name, .entry = {}, .data = {}};
+        item.entry.hash = asset_hash(name);
+        item.entry.size = raw.size();
+        item.entry.name_offset = static_cast<uint32_t>(names.size());
+        item.entry.name_bytes = static_cast<uint16_t>(name.size());
+        names += name;
+
+        if (options.compress && !raw.empty()) {
+            const size_t n_chunks{(raw.size() + options.chunk_bytes - 1) / options.chunk_bytes};
+            std::vector<std::vector<uint8_t>> chunks(n_chunks);
+            std::vector<uint32_t> sizes(n_chunks);
+            detail::for_pack_chunks(n_chunks, options.chunk_bytes, [&](size_t first, size_t last) {
+                for (size_t i{first}; i < last; ++i) {
+                    const auto input{raw.subspan(i * options.chunk_bytes, std::min<size_t>(options.chunk_bytes, raw.size() - i * options.chunk_bytes))};
+                    chunks[i] = lz_compress(input);
+                    if (chunks[i].size() >= input.size()) {
+                        chunks[i].assign(input.begin(), input.end());
+                        sizes[i] = static_cast<uint32_t>(input.size()) | PACK_RAW_CHUNK;
+                    }
+                    else {
+                        sizes[i] = static_cast<uint32_t>(chunks[i].size());
+                    }
+                }
+            });
+            size_t compressed_bytes{sizeof(uint32_t) * n_chunks};
+            for (const auto &chunk : chunks) {
+                compressed_bytes += chunk.size();
+            }
+            if (static_cast<double>(compressed_bytes) <= static_cast<double>(raw.size()) * (1.0 - options.min_saving)) {
+                item.entry.compression = PackCompression::Lz;
+                item.data.resize(sizeof(uint32_t) * n_chunks);
+                std::memcpy(item.data.data(), sizes.data(), item.data.size());
+                for (const auto &chunk : chunks) {
+                    item.data.insert(item.data.end(), chunk.begin(), chunk.end());
+                }
+                summary.compressed += 1;
+            }
+        }
+        if (PackCompression::None == item.entry.compression) {
+            item.data.assign(raw.begin(), raw.end());
+        }
+        item.entry.stored_bytes = item.data.size();
+        summary.raw_bytes += item.entry.size;
+        summary.stored_bytes += item.entry.stored_bytes;
+        pending.push_back(std::move(item));
+    }
+
+    const auto align = [](uint64_t offset) { return (offset + PACK_ENTRY_ALIGNMENT - 1) / PACK_ENTRY_ALIGNMENT * PACK_ENTRY_ALIGNMENT; };
+    PackHeader header{};
+    header.entry_count  = static_cast<uint32_t>(pending.size());
+    header.chunk_bytes  = options.chunk_bytes;
+    header.index_offset = sizeof(PackHeader);
+    header.names_offset = header.index_offset + sizeof(PackEntry) * pending.size();
+    header.names_bytes  = names.size();
+    header.data_offset  = align(header.names_offset + header.names_bytes);
+    uint64_t offset{header.data_offset};
+    for (auto &item : pending) {
+        item.entry.offset = offset;
+        offset = align(offset + item.entry.stored_bytes);
+    }
+
+    std::vector<PackEntry> index;
+    index.reserve(pending.size());
+    for (const auto &item : pending) {
+        index.push_back(item.entry);
+    }
+    const auto name_of = [&names](const PackEntry &entry) { return std::string_view{names}.substr(entry.name_offset, entry.name_bytes); };
+    std::ranges::sort(index, [&](const PackEntry &a, const PackEntry &b) {
+        return std::pair{a.hash, name_of(a)} < std::pair{b.hash, name_of(b)};
+    });
+    if (const auto it{std::ranges::adjacent_find(index, [&](const PackEntry &a, const PackEntry &b) {
+            return a.hash == b.hash && name_of(a) == name_of(b); })}; index.end() != it) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::ASSET_PACK what:duplicate asset {}", name_of(*it))};
+    }
+
+    std::ofstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::ASSET_PACK what:can not open {}", path.string())};
+    }
+    const auto pad_to = [&file](uint64_t target) {
+        static constexpr std::array<char, PACK_ENTRY_ALIGNMENT> PADDING{};
+        const auto position{static_cast<uint64_t>(file.tellp())};
+        file.write(PADDING.data(), static_cast<std::streamsize>(target - position));
+    };
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(index.data()), static_cast<std::streamsize>(sizeof(PackEntry) * index.size()));
+    file.write(names.data(), static_cast<std::streamsize>(names.size()));
+    for (const auto &item : pending) {
+        pad_to(item.entry.offset);
+        file.write(reinterpret_cast<const char *>(item.data.data()), static_cast<std::streamsize>(item.data.size()));
+    }
+    if (!file) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::ASSET_PACK what:write {} failed", path.string())};
+    }
+    summary.entries = pending.size();
+    summary.file_bytes = static_cast<uint64_t>(file.tellp());
+    return summary;
+}
+
+} // namespace Image
@@ -0,0 +1,774 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * BC1 / BC3 / BC7 块压缩编码
+ *
+ * 每个 4x4 块独立编码：先取端点（Fast 为包围盒，Normal/High 为主成分方向），量化后生成调色板，
+ * 为每个像素选择最近的调色板项（SSE2/NEON 一次处理 4 个像素），再按选中的索引用最小二乘修正端点并重试，
+ * 保留误差最小的结果。大图按块行切分到多个线程。
+ *   BC1  RGB + 1 位 alpha，8 字节/块；存在 alpha < 128 的像素时使用 3 色 + 透明模式
+ *   BC3  BC1 颜色块 + BC4 alpha 块，16 字节/块
+ *   BC7  只使用 mode 6（单分区 RGBA，7 位端点 + p 位，4 位索引），16 字节/块
+ * 输入为紧密排列的 RGBA8，尺寸不是 4 的倍数时边缘块重复最后一行/列。
+ */
+namespace Image {
+
+enum class BcFormat : uint8_t { Bc1, Bc3, Bc7 };
+
+// Fast: 包围盒端点，不修正；Normal: 主成分端点，修正 1 次；High: 修正 4 次，BC7 尝试全部 p 位组合
+enum class BcQuality : uint8_t { Fast, Normal, High };
+
+constexpr std::string_view bc_format_name(BcFormat format)
+{
+    switch (format) {
+        case BcFormat::Bc1: return "bc1";
+        case BcFormat::Bc3: return "bc3";
+        case BcFormat::Bc7: return "bc7";
+    }
+    return "unknown";
+}
+
+constexpr std::string_view bc_quality_name(BcQuality quality)
+{
+    switch (quality) {
+        case BcQuality::Fast:   return "fast";
+        case BcQuality::Normal: return "normal";
+        case BcQuality::High:   return "high";
+    }
+    return "unknown";
+}
+
+constexpr size_t bc_block_bytes(BcFormat format)
+{
+    return BcFormat::Bc1 == format ? 8 : 16;
+}
+
+constexpr size_t bc_image_bytes(BcFormat format, uint32_t width, uint32_t height)
+{
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * bc_block_bytes(format);
+}
+
+namespace detail {
+
+// 一个块的像素，按通道分开存放便于 SIMD
+struct BcBlock
+{
+    alignas(16) std::array<std::array<float, 16>, 4> channel{};
+};
+
+using BcColor = std::array<float, 4>;
+
+inline BcBlock load_block(const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y)
+{
+    BcBlock block{};
+    for (uint32_t y{}; y < 4; ++y) {
+        const uint32_t sy{std::min(block_y * 4 + y, height - 1)};
+        for (uint32_t x{}; x < 4; ++x) {
+            const uint32_t sx{std::min(block_x * 4 + x, width - 1)};
+            const uint8_t *pixel{rgba + (static_cast<size_t>(sy) * width + sx) * 4};
+            for (size_t c{}; c < 4; ++c) {
+                block.channel[c][y * 4 + x] = pixel[c];
+            }
+        }
+    }
+    return block;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+// 为每个像素选择最近的调色板项，返回平方误差之和；channels 为 3 时忽略 alpha
+inline float select_indices(const BcBlock &block, const BcColor *palette, size_t n, size_t channels, uint8_t *indices)
+{
+    float error{};
+    for (size_t p{}; p < 16; p += 4) {
+        const __m128 r{_mm_load_ps(block.channel[0].data() + p)};
+        const __m128 g{_mm_load_ps(block.channel[1].data() + p)};
+        const __m128 b{_mm_load_ps(block.channel[2].data() + p)};
+        const __m128 a{_mm_load_ps(block.channel[3].data() + p)};
+        __m128 best{_mm_set1_ps(std::numeric_limits<float>::max())};
+        __m128i best_index{_mm_setzero_si128()};
+        for (size_t k{}; k < n; ++k) {
+            const __m128 dr{_mm_sub_ps(r, _mm_set1_ps(palette[k][0]))};
+            const __m128 dg{_mm_sub_ps(g, _mm_set1_ps(palette[k][1]))};
+            const __m128 db{_mm_sub_ps(b, _mm_set1_ps(palette[k][2]))};
+            __m128 distance{_mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db))};
+            if (4 == channels) {
+                const __m128 da{_mm_sub_ps(a, _mm_set1_ps(palette[k][3]))};
+                distance = _mm_add_ps(distance, _mm_mul_ps(da, da));
+            }
+            const __m128i closer{_mm_castps_si128(_mm_cmplt_ps(distance, best))};
+            best = _mm_min_ps(distance, best);
+            best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(k))), _mm_andnot_si128(closer, best_index));
+        }
+        alignas(16) std::array<int32_t, 4> lanes{};
+        alignas(16) std::array<float, 4> errors{};
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes.data()), best_index);
+        _mm_store_ps(errors.data(), best);
+        for (size_t i{}; i < 4; ++i) {
+            indices[p + i] = static_cast<uint8_t>(lanes[i]);
+            error += errors[i];
+        }
+    }
+    return error;
+}
+
+#elif defined(__ARM_NEON)
+
+inline float select_indices(const BcBlock &block, const BcColor *palette, size_t n, size_t channels, uint8_t *indices)
+{
+    float error{};
+    for (size_t p{}; p < 16; p += 4) {
+        const float32x4_t r{vld1q_f32(block.channel[0].data() + p)};
+        const float32x4_t g{vld1q_f32(block.channel[1].data() + p)};
+        const float32x4_t b{vld1q_f32(block.channel[2].data() + p)};
+        const float32x4_t a{vld1q_f32(block.channel[3].data() + p)};
+        float32x4_t best{vdupq_n_f32(std::numeric_limits<float>::max())};
+        uint32x4_t best_index{vdupq_n_u32(0)};
+        for (size_t k{}; k < n; ++k) {
+            const float32x4_t dr{vsubq_f32(r, vdupq_n_f32(palette[k][0]))};
+            const float32x4_t dg{vsubq_f32(g, vdupq_n_f32(palette[k][1]))};
+            const float32x4_t db{vsubq_f32(b, vdupq_n_f32(palette[k][2]))};
+            float32x4_t distance{vmlaq_f32(vmlaq_f32(vmulq_f32(dr, dr), dg, dg), db, db)};
+            if (4 == channels) {
+                const float32x4_t da{vsubq_f32(a, vdupq_n_f32(palette[k][3]))};
+                distance = vmlaq_f32(distance, da, da);
+            }
+            const uint32x4_t closer{vcltq_f32(distance, best)};
+            best = vminq_f32(distance, best);
+            best_index = vbslq_u32(closer, vdupq_n_u32(static_cast<uint32_t>(k)), best_index);
+        }
+        std::array<uint32_t, 4> lanes{};
+        vst1q_u32(lanes.data(), best_index);
+        for (size_t i{}; i < 4; ++i) {
+            indices[p + i] = static_cast<uint8_t>(lanes[i]);
+        }
+        error += vaddvq_f32(best);
+    }
+    return error;
+}
+
+#else
+
+inline float select_indices(const BcBlock &block, const BcColor *palette, size_t n, size_t channels, uint8_t *indices)
+{
+    float error{};
+    for (size_t p{}; p < 16; ++p) {
+        float best{std::numeric_limits<float>::max()};
+        for (size_t k{}; k < n; ++k) {
+            float distance{};
+            for (size_t c{}; c < channels; ++c) {
+                const float d{block.channel[c][p] - palette[k][c]};
+                distance += d * d;
+            }
+            if (distance < best) {
+                best = distance;
+                indices[p] = static_cast<uint8_t>(k);
+            }
+        }
+        error += best;
+    }
+    return error;
+}
+
+#endif
+
+/**
+ * 初始端点：principal 为 false 时取各通道包围盒并向内收缩 1/16，
+ * 否则沿协方差矩阵的主方向（幂迭代）取投影的最小、最大值
+ */
+inline void initial_endpoints(const BcBlock &block, size_t channels, bool principal, BcColor &e0, BcColor &e1)
+{
+    BcColor low{255.0f, 255.0f, 255.0f, 255.0f};
+    BcColor high{};
+    BcColor mean{};
+    for (size_t c{}; c < channels; ++c) {
+        for (const float v : block.channel[c]) {
+            low[c] = std::min(low[c], v);
+            high[c] = std::max(high[c], v);
+            mean[c] += v / 16.0f;
+        }
+    }
+    if (!principal) {
+        for (size_t c{}; c < channels; ++c) {
+            const float inset{(high[c] - low[c]) / 16.0f};
+            e0[c] = high[c] - inset;
+            e1[c] = low[c] + inset;
+        }
+        return;
+    }
+
+    std::array<std::array<float, 4>, 4> covariance{};
+    for (size_t p{}; p < 16; ++p) {
+        for (size_t i{}; i < channels; ++i) {
+            for (size_t j{i}; j < channels; ++j) {
+                covariance[i][j] += (block.channel[i][p] - mean[i]) * (block.channel[j][p] - mean[j]);
+            }
+        }
+    }
+    BcColor axis{};
+    for (size_t i{}; i < channels; ++i) {
+        for (size_t j{}; j < i; ++j) {
+            covariance[i][j] = covariance[j][i];
+        }
+        axis[i] = high[i] - low[i];
+    }
+    for (int iteration{}; iteration < 8; ++iteration) {
+        BcColor next{};
+        float length{};
+        for (size_t i{}; i < channels; ++i) {
+            for (size_t j{}; j < channels; ++j) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+            length = std::max(length, std::abs(next[i]));
+        }
+        if (length < 1e-6f) {
+            break;
+        }
+        for (size_t i{}; i < channels; ++i) {
+            axis[i] = next[i] / length;
+        }
+    }
+
+    float length_squared{};
+    for (size_t c{}; c < channels; ++c) {
+        length_squared += axis[c] * axis[c];
+    }
+    if (length_squared < 1e-6f) {
+        e0 = high;      // 单色块
+        e1 = low;
+        return;
+    }
+    float t_min{std::numeric_limits<float>::max()};
+    float t_max{std::numeric_limits<float>::lowest()};
+    for (size_t p{}; p < 16; ++p) {
+        float t{};
+        for (size_t c{}; c < channels; ++c) {
+            t += (block.channel[c][p] - mean[c]) * axis[c];
+        }
+        t_min = std::min(t_min, t / length_squared);
+        t_max = std::max(t_max, t / length_squared);
+    }
+    for (size_t c{}; c < channels; ++c) {
+        e0[c] = std::clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+        e1[c] = std::clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+    }
+}
+
+/**
+ * 固定索引，求使 sum |(1 - w) e0 + w e1 - p|^2 最小的端点
+ * weights[index] 为调色板项相对 e0 -> e1 的插值位置；所有像素落在同一项时无解，返回 false
+ */
+inline bool refine_endpoints(const BcBlock &block, size_t channels, const uint8_t *indices, const float *weights, BcColor &e0, BcColor &e1)
+{
+    float alpha{};
+    float beta{};
+    float gamma{};
+    BcColor x{};
+    BcColor y{};
+    for (size_t p{}; p < 16; ++p) {
+        const float w{weights[indices[p]]};
+        alpha += (1.0f - w) * (1.0f - w);
+        beta  += w * (1.0f - w);
+        gamma += w * w;
+        for (size_t c{}; c < channels; ++c) {
+            x[c] += (1.0f - w) * block.channel[c][p];
+            y[c] += w * block.channel[c][p];
+        }
+    }
+    const float determinant{alpha * gamma - beta * beta};
+    if (std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+    for (size_t c{}; c < channels; ++c) {
+        e0[c] = std::clamp((gamma * x[c] - beta * y[c]) / determinant, 0.0f, 255.0f);
+        e1[c] = std::clamp((alpha * y[c] - beta * x[c]) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+constexpr int refine_iterations(BcQuality quality)
+{
+    switch (quality) {
+        case BcQuality::Fast:   return 0;
+        case BcQuality::Normal: return 1;
+        case BcQuality::High:   return 4;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------- BC1
+
+inline uint16_t to_565(const BcColor &color)
+{
+    const auto r{static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f))};
+    const auto g{static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f))};
+    const auto b{static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f))};
+    return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+inline BcColor from_565(uint16_t value)
+{
+    const uint32_t r{value >> 11 & 31u};
+    const uint32_t g{value >> 5 & 63u};
+    const uint32_t b{value & 31u};
+    return {static_cast<float>(r << 3 | r >> 2), static_cast<float>(g << 2 | g >> 4), static_cast<float>(b << 3 | b >> 2), 255.0f};
+}
+
+// 由 565 端点生成调色板，与解码一致；c0 > c1 为 4 色模式，否则为 3 色 + 透明
+inline std::array<BcColor, 4> bc1_palette(uint16_t c0, uint16_t c1)
+{
+    const BcColor p0{from_565(c0)};
+    const BcColor p1{from_565(c1)};
+    std::array<BcColor, 4> palette{p0, p1, {}, {}};
+    for (size_t c{}; c < 3; ++c) {
+        const auto v0{static_cast<uint32_t>(p0[c])};
+        const auto v1{static_cast<uint32_t>(p1[c])};
+        if (c0 > c1) {
+            palette[2][c] = static_cast<float>((2 * v0 + v1) / 3);
+            palette[3][c] = static_cast<float>((v0 + 2 * v1) / 3);
+        }
+        else {
+            palette[2][c] = static_cast<float>((v0 + v1) / 2);
+        }
+    }
+    palette[2][3] = 255.0f;
+    palette[3][3] = c0 > c1 ? 255.0f : 0.0f;
+    return palette;
+}
+
+struct Bc1Result
+{
+    float error{std::numeric_limits<float>::max()};
+    uint16_t c0{};
+    uint16_t c1{};
+    std::array<uint8_t, 16> indices{};
+};
+
+// transparent 为 true 时使用 3 色模式，alpha < 128 的像素固定为索引 3
+inline Bc1Result bc1_try(const BcBlock &block, const BcColor &e0, const BcColor &e1, bool transparent)
+{
+    Bc1Result result{};
+    result.c0 = to_565(e0);
+    result.c1 = to_565(e1);
+    if (transparent ? result.c0 > result.c1 : result.c0 < result.c1) {
+        std::swap(result.c0, result.c1);
+    }
+    if (!transparent && result.c0 == result.c1) {
+        result.indices.fill(0);     // 4 色模式要求 c0 > c1，单色块全部使用 c0
+        const auto palette{bc1_palette(result.c0, result.c1)};
+        result.error = select_indices(block, palette.data(), 1, 3, result.indices.data());
+        return result;
+    }
+    const auto palette{bc1_palette(result.c0, result.c1)};
+    result.error = select_indices(block, palette.data(), transparent ? 3 : 4, 3, result.indices.data());
+    if (transparent) {
+        for (size_t p{}; p < 16; ++p) {
+            if (block.channel[3][p] < 128.0f) {
+                result.indices[p] = 3;
+            }
+        }
+    }
+    return result;
+}
+
+inline void encode_bc1_color(const BcBlock &block, BcQuality quality, bool allow_transparent, uint8_t *out)
+{
+    const bool transparent{allow_transparent
+        && std::ranges::any_of(block.channel[3], [](float alpha) { return alpha < 128.0f; })};
+    BcColor e0{};
+    BcColor e1{};
+    initial_endpoints(block, 3, BcQuality::Fast != quality, e0, e1);
+    auto best{bc1_try(block, e0, e1, transparent)};
+
+    // 索引 -> 插值位置（相对 c0 -> c1）
+    constexpr std::array<float, 4> OPAQUE_WEIGHTS{0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+    constexpr std::array<float, 4> TRANSPARENT_WEIGHTS{0.0f, 1.0f, 0.5f, 0.5f};
+    for (int iteration{}; iteration < refine_iterations(quality); ++iteration) {
+        auto indices{best.indices};
+        if (transparent) {
+            // 透明像素不参与拟合：替换为与 c0 相同，权重为 0 的项不影响 e1
+            for (size_t p{}; p < 16; ++p) {
+                indices[p] = 3 == indices[p] ? 0 : indices[p];
+            }
+        }
+        BcColor r0{from_565(best.c0)};
+        BcColor r1{from_565(best.c1)};
+        if (!refine_endpoints(block, 3, indices.data(), (transparent ? TRANSPARENT_WEIGHTS : OPAQUE_WEIGHTS).data(), r0, r1)) {
+            break;
+        }
+        const auto candidate{bc1_try(block, r0, r1, transparent)};
+        if (candidate.error >= best.error) {
+            break;
+        }
+        best = candidate;
+    }
+
+    uint32_t bits{};
+    for (size_t p{}; p < 16; ++p) {
+        bits |= static_cast<uint32_t>(best.indices[p]) << (p * 2);
+    }
+    std::memcpy(out, &best.c0, 2);
+    std::memcpy(out + 2, &best.c1, 2);
+    std::memcpy(out + 4, &bits, 4);
+}
+
+// ---------------------------------------------------------------- BC4（BC3 的 alpha）
+
+inline void encode_bc4_alpha(const BcBlock &block, uint8_t *out)
+{
+    const auto [low, high]{std::ranges::minmax(block.channel[3])};
+    const auto a0{static_cast<uint8_t>(std::lround(high))};
+    const auto a1{static_cast<uint8_t>(std::lround(low))};
+    uint64_t bits{static_cast<uint64_t>(a0) | static_cast<uint64_t>(a1) << 8};
+    if (a0 > a1) {
+        // 8 值模式：索引 0、1 为端点，2..7 为 a0 -> a1 的 6 个插值
+        std::array<BcColor, 8> palette{};
+        palette[0][3] = a0;
+        palette[1][3] = a1;
+        for (uint32_t i{1}; i < 7; ++i) {
+            palette[i + 1][3] = static_cast<float>(((7 - i) * a0 + i * a1) / 7);
+        }
+        BcBlock alpha{};
+        alpha.channel[0] = block.channel[3];
+        for (auto &entry : palette) {
+            entry[0] = entry[3];
+        }
+        std::array<uint8_t, 16> indices{};
+        select_indices(alpha, palette.data(), palette.size(), 1, indices.data());
+        for (size_t p{}; p < 16; ++p) {
+            bits |= static_cast<uint64_t>(indices[p]) << (16 + p * 3);
+        }
+    }
+    std::memcpy(out, &bits, 8);
+}
+
+// ---------------------------------------------------------------- BC7 mode 6
+
+inline constexpr std::array<uint32_t, 16> BC7_WEIGHTS_4{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// 7 位端点 + 共享 p 位：返回量化后的 8 位值
+struct Bc7Endpoint
+{
+    std::array<uint8_t, 4> value{};     // 7 位
+    uint8_t p{};
+};
+
+inline Bc7Endpoint bc7_quantize(const BcColor &color, uint8_t p)
+{
+    Bc7Endpoint endpoint{{}, p};
+    for (size_t c{}; c < 4; ++c) {
+        endpoint.value[c] = static_cast<uint8_t>(std::clamp(std::lround((color[c] - p) / 2.0f), 0l, 127l));
+    }
+    return endpoint;
+}
+
+inline BcColor bc7_expand(const Bc7Endpoint &endpoint)
+{
+    BcColor color{};
+    for (size_t c{}; c < 4; ++c) {
+        color[c] = static_cast<float>(endpoint.value[c] << 1 | endpoint.p);
+    }
+    return color;
+}
+
+inline float quantization_error(const BcColor &color, const Bc7Endpoint &endpoint)
+{
+    const BcColor expanded{bc7_expand(endpoint)};
+    float error{};
+    for (size_t c{}; c < 4; ++c) {
+        error += (color[c] - expanded[c]) * (color[c] - expanded[c]);
+    }
+    return error;
+}
+
+struct Bc7Result
+{
+    float error{std::numeric_limits<float>::max()};
+    Bc7Endpoint e0{};
+    Bc7Endpoint e1{};
+    std::array<uint8_t, 16> indices{};
+};
+
+inline Bc7Result bc7_try(const BcBlock &block, const Bc7Endpoint &q0, const Bc7Endpoint &q1)
+{
+    Bc7Result result{};
+    result.e0 = q0;
+    result.e1 = q1;
+    const BcColor v0{bc7_expand(q0)};
+    const BcColor v1{bc7_expand(q1)};
+    std::array<BcColor, 16> palette{};
+    for (size_t k{}; k < 16; ++k) {
+        for (size_t c{}; c < 4; ++c) {
+            const auto a{static_cast<uint32_t>(v0[c])};
+            const auto b{static_cast<uint32_t>(v1[c])};
+            palette[k][c] = static_cast<float>(((64 - BC7_WEIGHTS_4[k]) * a + BC7_WEIGHTS_4[k] * b + 32) >> 6);
+        }
+    }
+    result.error = select_indices(block, palette.data(), palette.size(), 4, result.indices.data());
+    return result;
+}
+
+// Normal 只取量化误差最小的 p 位，High 尝试 4 种组合
+inline Bc7Result bc7_fit(const BcBlock &block, const BcColor &e0, const BcColor &e1, BcQuality quality)
+{
+    Bc7Result best{};
+    if (BcQuality::High == quality) {
+        for (uint8_t p0{}; p0 < 2; ++p0) {
+            for (uint8_t p1{}; p1 < 2; ++p1) {
+                const auto candidate{bc7_try(block, bc7_quantize(e0, p0), bc7_quantize(e1, p1))};
+                best = candidate.error < best.error ? candidate : best;
+            }
+        }
+        return best;
+    }
+    const auto pick = [](const BcColor &color) {
+        const auto q0{bc7_quantize(color, 0)};
+        const auto q1{bc7_quantize(color, 1)};
+        return quantization_error(color, q0) <= quantization_error(color, q1) ? q0 : q1;
+    };
+    return bc7_try(block, pick(e0), pick(e1));
+}
+
+// 按位从低到高写入
+struct BitWriter
+{
+    std::array<uint8_t, 16> bytes{};
+    size_t position{};
+
+    void write(uint32_t value, size_t count) {
+        for (size_t i{}; i < count; ++i, ++position) {
+            bytes[position / 8] = static_cast<uint8_t>(bytes[position / 8] | ((value >> i) & 1u) << (position % 8));
+        }
+    }
+};
+
+inline void encode_bc7_mode6(const BcBlock &block, BcQuality quality, uint8_t *out)
+{
+    BcColor e0{};
+    BcColor e1{};
+    initial_endpoints(block, 4, BcQuality::Fast != quality, e0, e1);
+    auto best{bc7_fit(block, e0, e1, quality)};
+
+    std::array<float, 16> weights{};
+    for (size_t k{}; k < 16; ++k) {
+        weights[k] = static_cast<float>(BC7_WEIGHTS_4[k]) / 64.0f;
+    }
+    for (int iteration{}; iteration < refine_iterations(quality); ++iteration) {
+        BcColor r0{bc7_expand(best.e0)};
+        BcColor r1{bc7_expand(best.e1)};
+        if (!refine_endpoints(block, 4, best.indices.data(), weights.data(), r0, r1)) {
+            break;
+        }
+        const auto candidate{bc7_fit(block, r0, r1, quality)};
+        if (candidate.error >= best.error) {
+            break;
+        }
+        best = candidate;
+    }
+
+    // 第一个像素的索引最高位隐含为 0，否则交换端点并反转索引
+    if (best.indices[0] >= 8) {
+        std::swap(best.e0, best.e1);
+        for (auto &index : best.indices) {
+            index = static_cast<uint8_t>(15 - index);
+        }
+    }
+
+    BitWriter writer{};
+    writer.write(1u << 6, 7);   // mode 6
+    for (size_t c{}; c < 4; ++c) {
+        writer.write(best.e0.value[c], 7);
+        writer.write(best.e1.value[c], 7);
+    }
+    writer.write(best.e0.p, 1);
+    writer.write(best.e1.p, 1);
+    writer.write(best.indices[0], 3);
+    for (size_t p{1}; p < 16; ++p) {
+        writer.write(best.indices[p], 4);
+    }
+    std::memcpy(out, writer.bytes.data(), writer.bytes.size());
+}
+
+inline void encode_block(const BcBlock &block, BcFormat format, BcQuality quality, uint8_t *out)
+{
+    switch (format) {
+        case BcFormat::Bc1:
+            encode_bc1_color(block, quality, true, out);
+            break;
+        case BcFormat::Bc3:
+            encode_bc4_alpha(block, out);
+            encode_bc1_color(block, quality, false, out + 8);
+            break;
+        case BcFormat::Bc7:
+            encode_bc7_mode6(block, quality, out);
+            break;
+    }
+}
+
+// ---------------------------------------------------------------- 解码（用于统计 PSNR）
+
+// BC3 的颜色块由编码器保证 c0 > c1 或单色，alpha 随后被 BC4 覆盖
+inline void decode_bc1_color(const uint8_t *in, uint8_t *pixels)
+{
+    uint16_t c0{};
+    uint16_t c1{};
+    uint32_t bits{};
+    std::memcpy(&c0, in, 2);
+    std::memcpy(&c1, in + 2, 2);
+    std::memcpy(&bits, in + 4, 4);
+    const auto palette{bc1_palette(c0, c1)};
+    for (size_t p{}; p < 16; ++p) {
+        const auto &color{palette[bits >> (p * 2) & 3u]};
+        for (size_t c{}; c < 4; ++c) {
+            pixels[p * 4 + c] = static_cast<uint8_t>(color[c]);
+        }
+    }
+}
+
+inline void decode_bc4_alpha(const uint8_t *in, uint8_t *pixels)
+{
+    uint64_t bits{};
+    std::memcpy(&bits, in, 8);
+    const auto a0{static_cast<uint32_t>(bits & 0xFF)};
+    const auto a1{static_cast<uint32_t>(bits >> 8 & 0xFF)};
+    std::array<uint8_t, 8> palette{static_cast<uint8_t>(a0), static_cast<uint8_t>(a1)};
+    for (uint32_t i{1}; i < 7; ++i) {
+        palette[i + 1] = a0 > a1 ? static_cast<uint8_t>(((7 - i) * a0 + i * a1) / 7)
+            : i < 5 ? static_cast<uint8_t>(((5 - i) * a0 + i * a1) / 5)
+            : static_cast<uint8_t>(5 == i ? 0 : 255);
+    }
+    for (size_t p{}; p < 16; ++p) {
+        pixels[p * 4 + 3] = palette[bits >> (16 + p * 3) & 7u];
+    }
+}
+
+inline void decode_bc7_mode6(const uint8_t *in, uint8_t *pixels)
+{
+    size_t position{};
+    const auto read = [&](size_t count) {
+        uint32_t value{};
+        for (size_t i{}; i < count; ++i, ++position) {
+            value |= static_cast<uint32_t>(in[position / 8] >> (position % 8) & 1u) << i;
+        }
+        return value;
+    };
+    if (1u << 6 != read(7)) {
+        throw std::runtime_error{"ERROR::IMAGE::BC what:only BC7 mode 6 blocks can be decoded"};
+    }
+    std::array<Bc7Endpoint, 2> endpoints{};
+    for (size_t c{}; c < 4; ++c) {
+        endpoints[0].value[c] = static_cast<uint8_t>(read(7));
+        endpoints[1].value[c] = static_cast<uint8_t>(read(7));
+    }
+    endpoints[0].p = static_cast<uint8_t>(read(1));
+    endpoints[1].p = static_cast<uint8_t>(read(1));
+    const BcColor v0{bc7_expand(endpoints[0])};
+    const BcColor v1{bc7_expand(endpoints[1])};
+    for (size_t p{}; p < 16; ++p) {
+        const uint32_t weight{BC7_WEIGHTS_4[read(0 == p ? 3 : 4)]};
+        for (size_t c{}; c < 4; ++c) {
+            pixels[p * 4 + c] = static_cast<uint8_t>(((64 - weight) * static_cast<uint32_t>(v0[c]) + weight * static_cast<uint32_t>(v1[c]) + 32) >> 6);
+        }
+    }
+}
+
+// 按块行切分到多个线程，fn(first_block_row, last_block_row)
+template <class Fn>
+void for_block_rows(uint32_t block_rows, size_t blocks_per_row, Fn &&fn)
+{
+    constexpr size_t MIN_BLOCKS_PER_THREAD{1024};
+    const auto n_threads{static_cast<uint32_t>(std::clamp<size_t>(
+        block_rows * blocks_per_row / MIN_BLOCKS_PER_THREAD, 1, std::max(1u, std::thread::hardware_concurrency())))};
+    if (1 == n_threads) {
+        fn(0u, block_rows);
+        return;
+    }
+    std::vector<std::jthread> workers;
+    workers.reserve(n_threads);
+    const uint32_t rows_per_thread{(block_rows + n_threads - 1) / n_threads};
+    for (uint32_t t{}; t < n_threads; ++t) {
+        const uint32_t first{std::min(t * rows_per_thread, block_rows)};
+        const uint32_t last{std::min(first + rows_per_thread, block_rows)};
+        workers.emplace_back([&fn, first, last] { fn(first, last); });
+    }
+}
+
+} // namespace detail
+
+// rgba: width x height 紧密排列的 RGBA8；返回按块行排列的压缩数据
+inline std::vector<uint8_t> bc_encode(std::span<const uint8_t> rgba, uint32_t width, uint32_t height, BcFormat format, BcQuality quality = BcQuality::Normal)
+{
+    if (0 == width || 0 == height || rgba.size() < static_cast<size_t>(width) * height * 4) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::BC what:buffer too small for {}x{}", width, height)};
+    }
+    const uint32_t blocks_x{(width + 3) / 4};
+    const uint32_t blocks_y{(height + 3) / 4};
+    const size_t block_bytes{bc_block_bytes(format)};
+    std::vector<uint8_t> blocks(bc_image_bytes(format, width, height));
+    detail::for_block_rows(blocks_y, blocks_x, [&](uint32_t first, uint32_t last) {
+        for (uint32_t by{first}; by < last; ++by) {
+            for (uint32_t bx{}; bx < blocks_x; ++bx) {
+                detail::encode_block(detail::load_block(rgba.data(), width, height, bx, by), format, quality,
+                    blocks.data() + (static_cast<size_t>(by) * blocks_x + bx) * block_bytes);
+            }
+        }
+    });
+    return blocks;
+}
+
+// 解码为 RGBA8；BC7 只支持 mode 6（bc_encode 的输出）
+inline std::vector<uint8_t> bc_decode(std::span<const uint8_t> blocks, uint32_t width, uint32_t height, BcFormat format)
+{
+    if (blocks.size() < bc_image_bytes(format, width, height)) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::BC what:buffer too small for {}x{}", width, height)};
+    }
+    const uint32_t blocks_x{(width + 3) / 4};
+    const uint32_t blocks_y{(height + 3) / 4};
+    const size_t block_bytes{bc_block_bytes(format)};
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+    std::array<uint8_t, 64> pixels{};
+    for (uint32_t by{}; by < blocks_y; ++by) {
+        for (uint32_t bx{}; bx < blocks_x; ++bx) {
+            const uint8_t *in{blocks.data() + (static_cast<size_t>(by) * blocks_x + bx) * block_bytes};
+            switch (format) {
+                case BcFormat::Bc1:
+                    detail::decode_bc1_color(in, pixels.data());
+                    break;
+                case BcFormat::Bc3:
+                    detail::decode_bc1_color(in + 8, pixels.data());
+                    detail::decode_bc4_alpha(in, pixels.data());
+                    break;
+                case BcFormat::Bc7:
+                    detail::decode_bc7_mode6(in, pixels.data());
+                    break;
+            }
+            for (uint32_t y{}; y < 4 && by * 4 + y < height; ++y) {
+                for (uint32_t x{}; x < 4 && bx * 4 + x < width; ++x) {
+                    std::memcpy(rgba.data() + ((static_cast<size_t>(by) * 4 + y) * width + bx * 4 + x) * 4, pixels.data() + (y * 4 + x) * 4, 4);
+                }
+            }
+        }
+    }
+    return rgba;
+}
+
+} // namespace Image
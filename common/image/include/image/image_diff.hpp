@@ -0,0 +1,364 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace Image {
+
+struct DiffOptions
+{
+    uint8_t channel_tolerance{2};       // 单通道允许的最大绝对误差
+    double perceptual_threshold{0.01};  // YIQ 感知误差阈值，归一化到 [0, 1]
+    double max_mismatch_ratio{0.0};     // 允许感知误差超标的像素比例
+};
+
+struct DiffResult
+{
+    uint64_t pixel_count{};
+    uint64_t over_tolerance_pixels{};       // 任一通道超出 channel_tolerance
+    uint64_t perceptual_mismatch_pixels{};  // 超出 channel_tolerance 且感知误差超标
+    uint32_t max_channel_delta{};
+    double max_perceptual_delta{};
+    double psnr{std::numeric_limits<double>::infinity()};
+
+    bool passed(const DiffOptions &options) const {
+        return static_cast<double>(perceptual_mismatch_pixels)
+            <= options.max_mismatch_ratio * static_cast<double>(pixel_count);
+    }
+};
+
+/**
+ * pixelmatch 的 YIQ 色差，先按 alpha 混合到白色背景，结果归一化到 [0, 1]
+ */
+inline double perceptual_delta(const uint8_t *lhs, const uint8_t *rhs)
+{
+    const auto blend = [](const uint8_t *px, int channel) {
+        const double alpha{px[3] / 255.0};
+        return 255.0 + (px[channel] - 255.0) * alpha;
+    };
+    const double r1{blend(lhs, 0)}, g1{blend(lhs, 1)}, b1{blend(lhs, 2)};
+    const double r2{blend(rhs, 0)}, g2{blend(rhs, 1)}, b2{blend(rhs, 2)};
+
+    const double y{(r1 - r2) * 0.29889531 + (g1 - g2) * 0.58662247 + (b1 - b2) * 0.11448223};
+    const double i{(r1 - r2) * 0.59597799 - (g1 - g2) * 0.27417610 - (b1 - b2) * 0.32180189};
+    const double q{(r1 - r2) * 0.21147017 - (g1 - g2) * 0.52261711 + (b1 - b2) * 0.31114694};
+
+    constexpr double MAX_DELTA{35215.0};
+    return (0.5053 * y * y + 0.299 * i * i + 0.1957 * q * q) / MAX_DELTA;
+}
+
+namespace detail {
+
+struct DiffAccum
+{
+    uint64_t over_tolerance{};
+    uint64_t perceptual_mismatch{};
+    uint64_t squared_sum{};
+    uint8_t max_delta{};
+    double max_perceptual{};
+
+    void merge(const DiffAccum &other) {
+        over_tolerance      += other.over_tolerance;
+        perceptual_mismatch += other.perceptual_mismatch;
+        squared_sum         += other.squared_sum;
+        max_delta      = std::max(max_delta, other.max_delta);
+        max_perceptual = std::max(max_perceptual, other.max_perceptual);
+    }
+};
+
+// 超出通道容差的像素很少，逐个走标量路径计算感知误差
+inline void diff_flagged_pixel(const uint8_t *lhs, const uint8_t *rhs, const DiffOptions &options, DiffAccum &acc)
+{
+    const double delta{perceptual_delta(lhs, rhs)};
+    acc.over_tolerance += 1;
+    acc.max_perceptual = std::max(acc.max_perceptual, delta);
+    if (delta > options.perceptual_threshold) {
+        acc.perceptual_mismatch += 1;
+    }
+}
+
+inline void diff_scalar(const uint8_t *lhs, const uint8_t *rhs, size_t n_pixels, const DiffOptions &options, DiffAccum &acc)
+{
+    for (size_t p{}; p < n_pixels; ++p, lhs += 4, rhs += 4) {
+        bool over{false};
+        for (int c{}; c < 4; ++c) {
+            const auto delta{static_cast<uint8_t>(lhs[c] > rhs[c] ? lhs[c] - rhs[c] : rhs[c] - lhs[c])};
+            acc.squared_sum += static_cast<uint64_t>(delta) * delta;
+            acc.max_delta = std::max(acc.max_delta, delta);
+            over |= delta > options.channel_tolerance;
+        }
+        if (over) {
+            diff_flagged_pixel(lhs, rhs, options, acc);
+        }
+    }
+}
+
+#if defined(__AVX2__)
+
+constexpr size_t SIMD_PIXELS{8};
+
+inline void diff_simd(const uint8_t *lhs, const uint8_t *rhs, size_t n_blocks, const DiffOptions &options, DiffAccum &acc)
+{
+    const __m256i tolerance{_mm256_set1_epi8(static_cast<char>(options.channel_tolerance))};
+    const __m256i zero{_mm256_setzero_si256()};
+    __m256i max_delta{zero};
+
+    // 每 2048 个块把 32 位平方和归并到 64 位，避免溢出
+    constexpr size_t FLUSH_BLOCKS{2048};
+    for (size_t begin{}; begin < n_blocks; begin += FLUSH_BLOCKS) {
+        const size_t end{std::min(n_blocks, begin + FLUSH_BLOCKS)};
+        __m256i squared{zero};
+        for (size_t block{begin}; block < end; ++block) {
+            const auto *pa{lhs + block * 32};
+            const auto *pb{rhs + block * 32};
+            const __m256i a{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa))};
+            const __m256i b{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(pb))};
+            const __m256i delta{_mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a))};
+            max_delta = _mm256_max_epu8(max_delta, delta);
+
+            const __m256i lo{_mm256_unpacklo_epi8(delta, zero)};
+            const __m256i hi{_mm256_unpackhi_epi8(delta, zero)};
+            squared = _mm256_add_epi32(squared, _mm256_madd_epi16(lo, lo));
+            squared = _mm256_add_epi32(squared, _mm256_madd_epi16(hi, hi));
+
+            const __m256i over{_mm256_subs_epu8(delta, tolerance)};
+            auto flagged{~static_cast<uint32_t>(_mm256_movemask_ps(
+                _mm256_castsi256_ps(_mm256_cmpeq_epi32(over, zero)))) & 0xFFu};
+            while (0 != flagged) {
+                const auto lane{static_cast<size_t>(std::countr_zero(flagged))};
+                diff_flagged_pixel(pa + lane * 4, pb + lane * 4, options, acc);
+                flagged &= flagged - 1;
+            }
+        }
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), squared);
+        for (auto lane : lanes) { acc.squared_sum += lane; }
+    }
+
+    alignas(32) uint8_t bytes[32];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(bytes), max_delta);
+    acc.max_delta = std::max(acc.max_delta, *std::max_element(std::begin(bytes), std::end(bytes)));
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+constexpr size_t SIMD_PIXELS{4};
+
+inline void diff_simd(const uint8_t *lhs, const uint8_t *rhs, size_t n_blocks, const DiffOptions &options, DiffAccum &acc)
+{
+    const __m128i tolerance{_mm_set1_epi8(static_cast<char>(options.channel_tolerance))};
+    const __m128i zero{_mm_setzero_si128()};
+    __m128i max_delta{zero};
+
+    // 每 4096 个块把 32 位平方和归并到 64 位，避免溢出
+    constexpr size_t FLUSH_BLOCKS{4096};
+    for (size_t begin{}; begin < n_blocks; begin += FLUSH_BLOCKS) {
+        const size_t end{std::min(n_blocks, begin + FLUSH_BLOCKS)};
+        __m128i squared{zero};
+        for (size_t block{begin}; block < end; ++block) {
+            const auto *pa{lhs + block * 16};
+            const auto *pb{rhs + block * 16};
+            const __m128i a{_mm_loadu_si128(reinterpret_cast<const __m128i *>(pa))};
+            const __m128i b{_mm_loadu_si128(reinterpret_cast<const __m128i *>(pb))};
+            const __m128i delta{_mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a))};
+            max_delta = _mm_max_epu8(max_delta, delta);
+
+            const __m128i lo{_mm_unpacklo_epi8(delta, zero)};
+            const __m128i hi{_mm_unpackhi_epi8(delta, zero)};
+            squared = _mm_add_epi32(squared, _mm_madd_epi16(lo, lo));
+            squared = _mm_add_epi32(squared, _mm_madd_epi16(hi, hi));
+
+            const __m128i over{_mm_subs_epu8(delta, tolerance)};
+            auto flagged{~static_cast<uint32_t>(_mm_movemask_ps(
+                _mm_castsi128_ps(_mm_cmpeq_epi32(over, zero)))) & 0xFu};
+            while (0 != flagged) {
+                const auto lane{static_cast<size_t>(std::countr_zero(flagged))};
+                diff_flagged_pixel(pa + lane * 4, pb + lane * 4, options, acc);
+                flagged &= flagged - 1;
+            }
+        }
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), squared);
+        for (auto lane : lanes) { acc.squared_sum += lane; }
+    }
+
+    alignas(16) uint8_t bytes[16];
+    _mm_store_si128(reinterpret_cast<__m128i *>(bytes), max_delta);
+    acc.max_delta = std::max(acc.max_delta, *std::max_element(std::begin(bytes), std::end(bytes)));
+}
+
+#elif defined(__ARM_NEON)
+
+constexpr size_t SIMD_PIXELS{4};
+
+inline void diff_simd(const uint8_t *lhs, const uint8_t *rhs, size_t n_blocks, const DiffOptions &options, DiffAccum &acc)
+{
+    const uint8x16_t tolerance{vdupq_n_u8(options.channel_tolerance)};
+    uint8x16_t max_delta{vdupq_n_u8(0)};
+    uint64x2_t squared{vdupq_n_u64(0)};
+
+    for (size_t block{}; block < n_blocks; ++block) {
+        const auto *pa{lhs + block * 16};
+        const auto *pb{rhs + block * 16};
+        const uint8x16_t delta{vabdq_u8(vld1q_u8(pa), vld1q_u8(pb))};
+        max_delta = vmaxq_u8(max_delta, delta);
+
+        const uint16x8_t lo{vmull_u8(vget_low_u8(delta), vget_low_u8(delta))};
+        const uint16x8_t hi{vmull_u8(vget_high_u8(delta), vget_high_u8(delta))};
+        squared = vpadalq_u32(squared, vaddq_u32(vpaddlq_u16(lo), vpaddlq_u16(hi)));
+
+        const uint32x4_t ok{vceqq_u32(vreinterpretq_u32_u8(vqsubq_u8(delta, tolerance)), vdupq_n_u32(0))};
+        if (0 != vminvq_u32(ok)) {
+            continue;
+        }
+        alignas(16) uint32_t lanes[4];
+        vst1q_u32(lanes, ok);
+        for (size_t lane{}; lane < 4; ++lane) {
+            if (0 == lanes[lane]) {
+                diff_flagged_pixel(pa + lane * 4, pb + lane * 4, options, acc);
+            }
+        }
+    }
+
+    acc.squared_sum += vgetq_lane_u64(squared, 0) + vgetq_lane_u64(squared, 1);
+    acc.max_delta = std::max(acc.max_delta, vmaxvq_u8(max_delta));
+}
+
+#else
+
+constexpr size_t SIMD_PIXELS{1};
+
+inline void diff_simd(const uint8_t *lhs, const uint8_t *rhs, size_t n_blocks, const DiffOptions &options, DiffAccum &acc)
+{
+    diff_scalar(lhs, rhs, n_blocks, options, acc);
+}
+
+#endif
+
+inline DiffAccum diff_range(const uint8_t *lhs, const uint8_t *rhs, size_t n_pixels, const DiffOptions &options)
+{
+    DiffAccum acc{};
+    const size_t n_blocks{n_pixels / SIMD_PIXELS};
+    diff_simd(lhs, rhs, n_blocks, options, acc);
+
+    const size_t done{n_blocks * SIMD_PIXELS};
+    diff_scalar(lhs + done * 4, rhs + done * 4, n_pixels - done, options, acc);
+    return acc;
+}
+
+} // namespace detail
+
+/**
+ * 比较两幅紧密排列的 RGBA8 图像
+ * 大图按行切分到多个线程，每个线程内部走 SIMD 路径
+ */
+inline DiffResult diff_rgba8(
+    std::span<const uint8_t> lhs,
+    std::span<const uint8_t> rhs,
+    uint32_t width,
+    uint32_t height,
+    const DiffOptions &options = {})
+{
+    const size_t n_pixels{static_cast<size_t>(width) * height};
+    if (lhs.size() < n_pixels * 4 || rhs.size() < n_pixels * 4) {
+        throw std::runtime_error{std::format(
+            "ERROR::IMAGE::DIFF what:buffer too small for {}x{}", width, height)};
+    }
+
+    constexpr size_t MIN_PIXELS_PER_THREAD{1 << 18};
+    const size_t n_threads{std::clamp<size_t>(
+        n_pixels / MIN_PIXELS_PER_THREAD, 1, std::max(1u, std::thread::hardware_concurrency()))};
+
+    detail::DiffAccum total{};
+    if (1 == n_threads) {
+        total = detail::diff_range(lhs.data(), rhs.data(), n_pixels, options);
+    }
+    else {
+        std::vector<detail::DiffAccum> partial(n_threads);
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(n_threads);
+            const size_t rows_per_thread{(height + n_threads - 1) / n_threads};
+            for (size_t t{}; t < n_threads; ++t) {
+                const size_t first_row{std::min<size_t>(t * rows_per_thread, height)};
+                const size_t last_row{std::min<size_t>(first_row + rows_per_thread, height)};
+                const size_t offset{first_row * width * 4};
+                const size_t count{(last_row - first_row) * width};
+                workers.emplace_back([&, t, offset, count] {
+                    partial[t] = detail::diff_range(lhs.data() + offset, rhs.data() + offset, count, options);
+                });
+            }
+        }
+        for (const auto &acc : partial) {
+            total.merge(acc);
+        }
+    }
+
+    DiffResult result{};
+    result.pixel_count                = n_pixels;
+    result.over_tolerance_pixels      = total.over_tolerance;
+    result.perceptual_mismatch_pixels = total.perceptual_mismatch;
+    result.max_channel_delta          = total.max_delta;
+    result.max_perceptual_delta       = total.max_perceptual;
+    if (0 != total.squared_sum && 0 != n_pixels) {
+        const double mse{static_cast<double>(total.squared_sum) / static_cast<double>(n_pixels * 4)};
+        result.psnr = 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+    return result;
+}
+
+/**
+ * 生成差异图：一致的像素淡化为灰度，超出通道容差的标黄，感知误差超标的标红
+ */
+inline std::vector<uint8_t> make_diff_image(
+    std::span<const uint8_t> lhs,
+    std::span<const uint8_t> rhs,
+    uint32_t width,
+    uint32_t height,
+    const DiffOptions &options = {})
+{
+    const size_t n_pixels{static_cast<size_t>(width) * height};
+    std::vector<uint8_t> diff(n_pixels * 4);
+    for (size_t p{}; p < n_pixels; ++p) {
+        const uint8_t *a{lhs.data() + p * 4};
+        const uint8_t *b{rhs.data() + p * 4};
+        uint8_t *out{diff.data() + p * 4};
+
+        bool over{false};
+        for (int c{}; c < 4; ++c) {
+            over |= std::abs(a[c] - b[c]) > options.channel_tolerance;
+        }
+
+        if (!over) {
+            const double luma{0.299 * a[0] + 0.587 * a[1] + 0.114 * a[2]};
+            const auto gray{static_cast<uint8_t>(255.0 - (255.0 - luma) * 0.1)};
+            out[0] = out[1] = out[2] = gray;
+        }
+        else if (perceptual_delta(a, b) > options.perceptual_threshold) {
+            out[0] = 255; out[1] = 0; out[2] = 0;
+        }
+        else {
+            out[0] = 255; out[1] = 255; out[2] = 0;
+        }
+        out[3] = 255;
+    }
+    return diff;
+}
+
+} // namespace Image
@@ -0,0 +1,899 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define IMAGE_IO_URING 1
+#else
+#define IMAGE_IO_URING 0
+#endif
+
+/**
+ * 异步文件读取调度器
+ *
+ * read() 可在任意线程调用，立即返回；请求按 (优先级, 截止时间, 提交顺序) 排队，
+ * 同一时刻最多 queue_depth 个请求在读取，其余在队列中等待，高优先级的新请求排在已排队的低优先级请求之前。
+ * 读完的结果由 poll()（通常每帧在主循环中调用一次）在调用线程上交给回调，回调不在 I/O 线程上执行。
+ *
+ * IoBackend::Uring（Linux）：一个 I/O 线程通过 io_uring 一次提交一批读请求（一次 io_uring_enter），
+ *   等待任意一个完成后再补充新的请求，线程不会阻塞在单个 read 上；不依赖 liburing，直接使用系统调用。
+ * IoBackend::Threads：线程池，每个线程以 pread（Windows 为带偏移的 ReadFile）同步读取；
+ *   io_uring 不可用（旧内核、容器禁用、非 Linux）时 Auto 选择它。
+ *
+ * cancel() 之后回调不会再被调用：还在队列中的请求直接移除，不再读取；正在读取的请求，
+ * io_uring 后端提交 IORING_OP_ASYNC_CANCEL 中止（已经开始复制数据的读取可能仍会读完），线程池后端读完后丢弃结果。
+ * 截止时间只用于同一优先级内的排序（先到期的先读）与统计，过期的请求照常读取。
+ */
+namespace Image {
+
+enum class IoBackend : uint8_t { Auto, Uring, Threads };
+
+constexpr std::string_view io_backend_name(IoBackend backend)
+{
+    switch (backend) {
+        case IoBackend::Auto:    return "auto";
+        case IoBackend::Uring:   return "io_uring";
+        case IoBackend::Threads: return "threads";
+    }
+    return "unknown";
+}
+
+enum class IoPriority : uint8_t { High, Normal, Low };
+
+using IoRequestId = uint64_t;
+using IoClock = std::chrono::steady_clock;
+
+inline constexpr IoClock::time_point IO_NO_DEADLINE{IoClock::time_point::max()};
+
+/**
+ * 读取的目标缓冲区：分配时不初始化，随后整个被读取覆盖，省下一遍清零（大文件时与读取本身相当）
+ * 短读后 truncate() 只缩小 size()，不重新分配
+ */
+class IoBuffer
+{
+public:
+    IoBuffer() = default;
+    explicit IoBuffer(size_t size) : bytes_{std::make_unique_for_overwrite<std::byte[]>(size)}, size_{size} {}
+    ~IoBuffer() = default;
+    IoBuffer(IoBuffer &&other) noexcept : bytes_{std::move(other.bytes_)}, size_{std::exchange(other.size_, 0)} {}
+    IoBuffer &operator=(IoBuffer &&other) noexcept {
+        bytes_ = std::move(other.bytes_);
+        size_ = std::exchange(other.size_, 0);
+        return *this;
+    }
+    IoBuffer(const IoBuffer &) = delete;
+    IoBuffer &operator=(const IoBuffer &) = delete;
+
+    std::byte *data() { return bytes_.get(); }
+    const std::byte *data() const { return bytes_.get(); }
+    size_t size() const { return size_; }
+    bool empty() const { return 0 == size_; }
+    std::span<std::byte> bytes() { return {bytes_.get(), size_}; }
+    std::span<const std::byte> bytes() const { return {bytes_.get(), size_}; }
+
+    void truncate(size_t size) { size_ = std::min(size_, size); }
+
+    // 交出存储（长度为 size()），之后为空
+    std::unique_ptr<std::byte[]> release() {
+        size_ = 0;
+        return std::move(bytes_);
+    }
+
+private:
+    std::unique_ptr<std::byte[]> bytes_{};
+    size_t size_{};
+};
+
+struct IoResult
+{
+    IoRequestId id{};
+    int error{};                    // errno，0 表示成功
+    IoBuffer data{};                // 读到文件末尾时比请求的短
+    double latency_ms{};            // 从 read() 到读完
+    bool late{};                    // 读完时已过截止时间
+};
+
+struct IoStats
+{
+    uint64_t requests{};
+    uint64_t completed{};
+    uint64_t failed{};
+    uint64_t cancelled{};           // 读取前取消
+    uint64_t discarded{};           // 开始读取后取消，结果丢弃（已读完的同时计入 completed）
+    uint64_t aborted{};             // discarded 中经 IORING_OP_ASYNC_CANCEL 中止、没有读完的
+    uint64_t late{};
+    uint64_t batches{};             // 提交次数（io_uring_enter / 线程池为单个读取）
+    uint64_t submissions{};
+    uint64_t bytes{};
+    size_t max_in_flight{};
+    double total_latency_ms{};
+    double max_latency_ms{};
+
+    std::string to_string() const {
+        const double batch{0 == batches ? 0.0 : static_cast<double>(submissions) / static_cast<double>(batches)};
+        const double latency{0 == completed ? 0.0 : total_latency_ms / static_cast<double>(completed)};
+        return std::format("{} requests, {} completed ({} failed, {} late), {} cancelled, {} discarded ({} aborted), {:.1f} MB, "
+            "{:.1f} reads per submit, max {} in flight, latency avg {:.3f} ms max {:.3f} ms",
+            requests, completed, failed, late, cancelled, discarded, aborted, static_cast<double>(bytes) / (1024.0 * 1024.0),
+            batch, max_in_flight, latency, max_latency_ms);
+    }
+};
+
+struct IoSchedulerOptions
+{
+    IoBackend backend{IoBackend::Auto};
+    uint32_t queue_depth{64};       // 同时在读取的请求数上限
+    size_t threads{4};              // Threads 后端的线程数
+};
+
+// 只读打开的文件，请求持有 shared_ptr，最后一个请求完成后才关闭
+class IoFile
+{
+public:
+    explicit IoFile(const std::filesystem::path &path) : path_{path} {
+#if defined(_WIN32)
+        handle_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+        LARGE_INTEGER size{};
+        if (INVALID_HANDLE_VALUE == handle_ || !GetFileSizeEx(handle_, &size)) {
+            if (INVALID_HANDLE_VALUE != handle_) {
+                CloseHandle(handle_);
+            }
+            throw std::runtime_error{std::format("ERROR::IMAGE::IO what:can not open {}", path.string())};
+        }
+        size_ = static_cast<uint64_t>(size.QuadPart);
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info{};
+        if (fd_ < 0 || 0 != ::fstat(fd_, &info)) {
+            if (fd_ >= 0) {
+                ::close(fd_);
+            }
+            throw std::runtime_error{std::format("ERROR::IMAGE::IO what:can not open {}", path.string())};
+        }
+        size_ = static_cast<uint64_t>(info.st_size);
+#endif
+    }
+    ~IoFile() {
+#if defined(_WIN32)
+        CloseHandle(handle_);
+#else
+        ::close(fd_);
+#endif
+    }
+    IoFile(const IoFile &) = delete;
+    IoFile(IoFile &&) = delete;
+    IoFile &operator=(const IoFile &) = delete;
+    IoFile &operator=(IoFile &&) = delete;
+
+    uint64_t size() const { return size_; }
+    const std::filesystem::path &path() const { return path_; }
+
+    // 同步读取 offset 处最多 out.size() 字节，返回读到的字节数；失败时返回 -errno
+    int64_t read_at(uint64_t offset, std::span<std::byte> out) const {
+#if defined(_WIN32)
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD read{};
+        const auto length{static_cast<DWORD>(std::min<size_t>(out.size(), std::numeric_limits<DWORD>::max()))};
+        if (!ReadFile(handle_, out.data(), length, &read, &overlapped)) {
+            return ERROR_HANDLE_EOF == GetLastError() ? 0 : -EIO;
+        }
+        return read;
+#else
+        const ssize_t read{::pread(fd_, out.data(), out.size(), static_cast<off_t>(offset))};
+        return read < 0 ? -errno : read;
+#endif
+    }
+
+#if !defined(_WIN32)
+    int fd() const { return fd_; }
+#endif
+
+private:
+    std::filesystem::path path_;
+    uint64_t size_{};
+#if defined(_WIN32)
+    HANDLE handle_{INVALID_HANDLE_VALUE};
+#else
+    int fd_{-1};
+#endif
+};
+
+#if IMAGE_IO_URING
+namespace detail {
+
+/**
+ * 最小的 io_uring 封装：只有一个提交线程，环的头尾指针按内核约定以 acquire / release 访问
+ * 需要 IORING_OP_READ（5.6），内核不支持或被禁用时 create() 返回 nullptr；
+ * 取消读取另外用到 IORING_OP_ASYNC_CANCEL 与 IORING_OP_POLL_ADD，由 supports() 查询
+ */
+class IoUring
+{
+public:
+    static std::unique_ptr<IoUring> create(uint32_t entries) {
+        io_uring_params params{};
+        const auto fd{static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params))};
+        if (fd < 0) {
+            return nullptr;
+        }
+        std::unique_ptr<IoUring> ring{new IoUring{fd}};
+        if (!ring->map(params) || !ring->probe() || !ring->supports(IORING_OP_READ)) {
+            return nullptr;
+        }
+        return ring;
+    }
+    ~IoUring() {
+        if (nullptr != sqes_) {
+            ::munmap(sqes_, sqes_bytes_);
+        }
+        if (nullptr != cq_ring_ && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_bytes_);
+        }
+        if (nullptr != sq_ring_) {
+            ::munmap(sq_ring_, sq_ring_bytes_);
+        }
+        ::close(fd_);
+    }
+    IoUring(const IoUring &) = delete;
+    IoUring(IoUring &&) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+    IoUring &operator=(IoUring &&) = delete;
+
+    uint32_t entries() const { return sq_entries_; }
+    bool supports(uint8_t op) const { return op < supported_.size() && supported_[op]; }
+
+    // 写入一个 SQE，io_uring_enter 之前内核不会看到；SQ 已满时返回 false
+    bool push_read(int fd, std::span<std::byte> buffer, uint64_t offset, uint64_t user_data) {
+        return push([&](io_uring_sqe &sqe) {
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<uint64_t>(buffer.data());
+            sqe.len = static_cast<uint32_t>(buffer.size());
+            sqe.off = offset;
+            sqe.user_data = user_data;
+        });
+    }
+
+    // 取消 user_data 为 target 的请求；被取消的请求以 -ECANCELED（或 -EINTR）完成
+    bool push_cancel(uint64_t target, uint64_t user_data) {
+        return push([&](io_uring_sqe &sqe) {
+            sqe.opcode = IORING_OP_ASYNC_CANCEL;
+            sqe.fd = -1;
+            sqe.addr = target;
+            sqe.user_data = user_data;
+        });
+    }
+
+    // fd 可读时完成一次
+    bool push_poll(int fd, uint64_t user_data) {
+        return push([&](io_uring_sqe &sqe) {
+            sqe.opcode = IORING_OP_POLL_ADD;
+            sqe.fd = fd;
+            sqe.poll_events = POLLIN;
+            sqe.user_data = user_data;
+        });
+    }
+
+    // 提交全部未提交的 SQE，并至少等到 wait 个完成；返回 -errno 或提交的个数
+    int submit(uint32_t wait) {
+        const int submitted{enter(unsubmitted_, wait)};
+        if (submitted >= 0) {
+            unsubmitted_ -= static_cast<uint32_t>(submitted);
+            submitted_ += static_cast<uint32_t>(submitted);
+        }
+        return submitted;
+    }
+
+    // 不提交，等到至少 count 个完成；返回 -errno 或 0
+    int wait(uint32_t count) {
+        const int result{enter(0, count)};
+        return result < 0 ? result : 0;
+    }
+
+    uint32_t unsubmitted() const { return unsubmitted_; }
+    // 已交给内核、尚未取走完成的个数
+    uint32_t in_kernel() const { return submitted_ - completed_; }
+
+    // fn(user_data, res)，返回处理的完成个数
+    template <class Fn>
+    size_t reap(Fn &&fn) {
+        uint32_t head{*cq_head_};
+        const uint32_t tail{std::atomic_ref{*cq_tail_}.load(std::memory_order_acquire)};
+        size_t count{};
+        for (; head != tail; ++head, ++count) {
+            const io_uring_cqe &cqe{cqes_[head & cq_mask_]};
+            fn(cqe.user_data, cqe.res);
+        }
+        std::atomic_ref{*cq_head_}.store(head, std::memory_order_release);
+        completed_ += static_cast<uint32_t>(count);
+        return count;
+    }
+
+private:
+    explicit IoUring(int fd) : fd_{fd} {}
+
+    template <class Fill>
+    bool push(Fill &&fill) {
+        const uint32_t head{std::atomic_ref{*sq_head_}.load(std::memory_order_acquire)};
+        if (sq_tail_local_ - head >= sq_entries_) {
+            return false;
+        }
+        const uint32_t index{sq_tail_local_ & sq_mask_};
+        io_uring_sqe &sqe{sqes_[index]};
+        std::memset(&sqe, 0, sizeof(sqe));
+        fill(sqe);
+        sq_array_[index] = index;
+        sq_tail_local_ += 1;
+        std::atomic_ref{*sq_tail_}.store(sq_tail_local_, std::memory_order_release);
+        unsubmitted_ += 1;
+        return true;
+    }
+
+    int enter(uint32_t to_submit, uint32_t wait) const {
+        while (true) {
+            const auto result{static_cast<int>(::syscall(__NR_io_uring_enter, fd_, to_submit, wait,
+                0 == wait ? 0u : IORING_ENTER_GETEVENTS, nullptr, 0))};
+            if (result >= 0) {
+                return result;
+            }
+            if (EINTR != errno) {
+                return -errno;
+            }
+        }
+    }
+
+    bool map(const io_uring_params &params) {
+        sq_ring_bytes_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cq_ring_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single{0 != (params.features & IORING_FEAT_SINGLE_MMAP)};
+        if (single) {
+            sq_ring_bytes_ = cq_ring_bytes_ = std::max(sq_ring_bytes_, cq_ring_bytes_);
+        }
+        sq_ring_ = mmap_ring(sq_ring_bytes_, IORING_OFF_SQ_RING);
+        if (nullptr == sq_ring_) {
+            return false;
+        }
+        cq_ring_ = single ? sq_ring_ : mmap_ring(cq_ring_bytes_, IORING_OFF_CQ_RING);
+        sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe *>(mmap_ring(sqes_bytes_, IORING_OFF_SQES));
+        if (nullptr == cq_ring_ || nullptr == sqes_) {
+            return false;
+        }
+
+        auto *sq{static_cast<std::byte *>(sq_ring_)};
+        auto *cq{static_cast<std::byte *>(cq_ring_)};
+        sq_head_  = reinterpret_cast<uint32_t *>(sq + params.sq_off.head);
+        sq_tail_  = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+        sq_array_ = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+        sq_mask_  = *reinterpret_cast<const uint32_t *>(sq + params.sq_off.ring_mask);
+        cq_head_  = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+        cq_tail_  = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+        cqes_     = reinterpret_cast<const io_uring_cqe *>(cq + params.cq_off.cqes);
+        cq_mask_  = *reinterpret_cast<const uint32_t *>(cq + params.cq_off.ring_mask);
+        sq_entries_ = params.sq_entries;
+        sq_tail_local_ = *sq_tail_;
+        return true;
+    }
+
+    void *mmap_ring(size_t bytes, off_t offset) const {
+        void *data{::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset)};
+        return MAP_FAILED == data ? nullptr : data;
+    }
+
+    // IORING_REGISTER_PROBE 本身需要 5.6，失败时视为全部不支持
+    bool probe() {
+        constexpr size_t N_OPS{64};
+        std::vector<uint64_t> storage((sizeof(io_uring_probe) + N_OPS * sizeof(io_uring_probe_op) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        auto *probe{reinterpret_cast<io_uring_probe *>(storage.data())};
+        if (0 != ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, N_OPS)) {
+            return false;
+        }
+        supported_.assign(std::min<size_t>(probe->last_op + 1u, N_OPS), false);
+        for (size_t op{}; op < supported_.size(); ++op) {
+            supported_[op] = 0 != (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+        }
+        return true;
+    }
+
+    int fd_{-1};
+    void *sq_ring_{};
+    void *cq_ring_{};
+    io_uring_sqe *sqes_{};
+    size_t sq_ring_bytes_{};
+    size_t cq_ring_bytes_{};
+    size_t sqes_bytes_{};
+    uint32_t *sq_head_{};
+    uint32_t *sq_tail_{};
+    uint32_t *sq_array_{};
+    uint32_t sq_mask_{};
+    uint32_t sq_entries_{};
+    uint32_t sq_tail_local_{};
+    uint32_t unsubmitted_{};
+    uint32_t submitted_{};
+    uint32_t completed_{};
+    uint32_t *cq_head_{};
+    uint32_t *cq_tail_{};
+    const io_uring_cqe *cqes_{};
+    uint32_t cq_mask_{};
+    std::vector<bool> supported_{};     // 按 opcode
+};
+
+} // namespace detail
+#endif
+
+class IoScheduler
+{
+public:
+    using Callback = std::function<void(IoResult &&)>;
+
+    explicit IoScheduler(const IoSchedulerOptions &options = {})
+        : depth_{std::max<uint32_t>(options.queue_depth, 1)}
+    {
+#if IMAGE_IO_URING
+        if (IoBackend::Threads != options.backend) {
+            ring_ = detail::IoUring::create(depth_);
+        }
+        // 内核不支持时取消读取中的请求只丢弃结果
+        if (nullptr != ring_ && ring_->supports(IORING_OP_ASYNC_CANCEL) && ring_->supports(IORING_OP_POLL_ADD)) {
+            wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        }
+#endif
+        if (IoBackend::Uring == options.backend && nullptr == ring_) {
+            throw std::runtime_error{"ERROR::IMAGE::IO what:io_uring is not available"};
+        }
+        if (nullptr != ring_) {
+            backend_ = IoBackend::Uring;
+            threads_.emplace_back([this](std::stop_token token) { uring_loop(token); });
+        }
+        else {
+            backend_ = IoBackend::Threads;
+            for (size_t i{}; i < std::max<size_t>(options.threads, 1); ++i) {
+                threads_.emplace_back([this](std::stop_token token) { thread_loop(token); });
+            }
+        }
+    }
+    // 等待正在读取的请求结束（内核仍在写入它们的缓冲区，io_uring 后端先取消它们），丢弃队列中与未交付的结果
+    ~IoScheduler() {
+        for (auto &thread : threads_) {
+            thread.request_stop();
+        }
+        tasks_cv_.notify_all();
+#if IMAGE_IO_URING
+        if (wake_fd_ >= 0) {
+            wake();
+        }
+#endif
+        threads_.clear();
+#if IMAGE_IO_URING
+        if (wake_fd_ >= 0) {
+            ::close(wake_fd_);
+        }
+#endif
+    }
+    IoScheduler(const IoScheduler &) = delete;
+    IoScheduler(IoScheduler &&) = delete;
+    IoScheduler &operator=(const IoScheduler &) = delete;
+    IoScheduler &operator=(IoScheduler &&) = delete;
+
+    IoBackend backend() const { return backend_; }
+
+    // 读取 [offset, offset + size)；size 为 0 时读到文件末尾
+    IoRequestId read(std::shared_ptr<const IoFile> file, uint64_t offset, size_t size, Callback callback,
+        IoPriority priority = IoPriority::Normal, IoClock::time_point deadline = IO_NO_DEADLINE) {
+        if (nullptr == file || nullptr == callback) {
+            throw std::runtime_error{"ERROR::IMAGE::IO what:read needs a file and a callback"};
+        }
+        if (0 == size) {
+            size = static_cast<size_t>(file->size() - std::min(offset, file->size()));
+        }
+        std::unique_lock lock{mutex_};
+        const IoRequestId id{++last_id_};
+        const Key key{priority, deadline, id};
+        queue_.emplace(key, Request{.id = id, .file = std::move(file), .offset = offset, .size = size,
+            .priority = priority, .deadline = deadline, .submitted = IoClock::now(), .callback = std::move(callback)});
+        queued_.emplace(id, key);
+        stats_.requests += 1;
+        lock.unlock();
+        tasks_cv_.notify_one();
+        return id;
+    }
+
+    // 整个文件，普通优先级
+    IoRequestId read(const std::filesystem::path &path, Callback callback, IoPriority priority = IoPriority::Normal,
+        IoClock::time_point deadline = IO_NO_DEADLINE) {
+        return read(std::make_shared<const IoFile>(path), 0, 0, std::move(callback), priority, deadline);
+    }
+
+    /**
+     * 之后不会再为该请求调用回调（须与 poll() 在同一线程调用，否则可能正在回调中）
+     * 返回 true 表示请求尚未开始读取，I/O 被省下；io_uring 后端正在读取的请求也会被中止
+     */
+    bool cancel(IoRequestId id) {
+        std::unique_lock lock{mutex_};
+        if (const auto it{queued_.find(id)}; queued_.end() != it) {
+            queue_.erase(it->second);
+            queued_.erase(it);
+            stats_.cancelled += 1;
+            return true;
+        }
+        if (in_flight_.contains(id)) {
+            cancelled_.insert(id);
+#if IMAGE_IO_URING
+            // I/O 线程可能阻塞在等待完成上，经 eventfd 唤醒它提交取消
+            if (wake_fd_ >= 0 && IoBackend::Uring == backend_) {
+                aborts_.push_back(id);
+                lock.unlock();
+                wake();
+            }
+#endif
+            return false;
+        }
+        const auto [first, last]{std::ranges::remove_if(completed_, [id](const Request &request) { return id == request.id; })};
+        stats_.discarded += static_cast<uint64_t>(last - first);
+        completed_.erase(first, last);
+        return false;
+    }
+
+    // 在调用线程上按完成顺序交付结果，返回调用的回调个数
+    size_t poll() {
+        std::deque<Request> completed;
+        {
+            const std::lock_guard lock{mutex_};
+            completed.swap(completed_);
+        }
+        for (auto &request : completed) {
+            request.callback(std::move(request.result));
+        }
+        return completed.size();
+    }
+
+    // 阻塞到目前提交的请求全部读完，然后 poll()
+    size_t finish() {
+        {
+            std::unique_lock lock{mutex_};
+            idle_cv_.wait(lock, [this] { return queue_.empty() && in_flight_.empty(); });
+        }
+        return poll();
+    }
+
+    // 排队中与读取中的请求数
+    size_t pending() const {
+        const std::lock_guard lock{mutex_};
+        return queue_.size() + in_flight_.size();
+    }
+
+    IoStats stats() const {
+        const std::lock_guard lock{mutex_};
+        return stats_;
+    }
+
+private:
+    using Key = std::tuple<IoPriority, IoClock::time_point, IoRequestId>;
+
+    struct Request
+    {
+        IoRequestId id{};
+        std::shared_ptr<const IoFile> file{};
+        uint64_t offset{};
+        size_t size{};
+        IoPriority priority{};
+        IoClock::time_point deadline{};
+        IoClock::time_point submitted{};
+        Callback callback{};
+        IoResult result{};
+        size_t done{};              // 已读到的字节数，短读时从这里继续
+    };
+
+    // 调用时持有 mutex_：取出队首的请求，缓冲区在解锁后分配
+    Request take_locked() {
+        auto node{queue_.extract(queue_.begin())};
+        Request request{std::move(node.mapped())};
+        queued_.erase(request.id);
+        in_flight_.insert(request.id);
+        stats_.max_in_flight = std::max(stats_.max_in_flight, in_flight_.size());
+        request.result.id = request.id;
+        return request;
+    }
+
+    // 调用时持有 mutex_
+    void complete_locked(Request &&request) {
+        in_flight_.erase(request.id);
+        if (cancelled_.erase(request.id) > 0) {
+            stats_.discarded += 1;
+            stats_.aborted += request.done < request.size && 0 != request.result.error ? 1 : 0;
+        }
+        else {
+            auto &result{request.result};
+            result.data.truncate(request.done);
+            const auto now{IoClock::now()};
+            result.latency_ms = std::chrono::duration<double, std::milli>(now - request.submitted).count();
+            result.late = now > request.deadline;
+            stats_.completed += 1;
+            stats_.failed += 0 != result.error ? 1 : 0;
+            stats_.late += result.late ? 1 : 0;
+            stats_.bytes += request.done;
+            stats_.total_latency_ms += result.latency_ms;
+            stats_.max_latency_ms = std::max(stats_.max_latency_ms, result.latency_ms);
+            completed_.push_back(std::move(request));
+        }
+        if (queue_.empty() && in_flight_.empty()) {
+            idle_cv_.notify_all();
+        }
+    }
+
+    // 调用时持有 mutex_：尚未读完的请求放回队列，已读到的部分保留
+    void requeue_locked(Request &&request) {
+        in_flight_.erase(request.id);
+        if (cancelled_.erase(request.id) > 0) {
+            stats_.discarded += 1;
+            return;
+        }
+        const Key key{request.priority, request.deadline, request.id};
+        queued_.emplace(request.id, key);
+        queue_.emplace(key, std::move(request));
+    }
+
+    void thread_loop(std::stop_token token) {
+        std::unique_lock lock{mutex_};
+        while (tasks_cv_.wait(lock, token, [this] { return !queue_.empty() && in_flight_.size() < depth_; })) {
+            auto request{take_locked()};
+            stats_.batches += 1;
+            stats_.submissions += 1;
+            lock.unlock();
+            request.result.data = IoBuffer{request.size};
+            while (request.done < request.size) {
+                const auto read{request.file->read_at(request.offset + request.done,
+                    request.result.data.bytes().subspan(request.done))};
+                if (read <= 0) {
+                    request.result.error = static_cast<int>(-read);
+                    break;
+                }
+                request.done += static_cast<size_t>(read);
+            }
+            lock.lock();
+            complete_locked(std::move(request));
+            // 占满 depth 时其他线程在等待
+            tasks_cv_.notify_one();
+        }
+    }
+
+#if IMAGE_IO_URING
+    void uring_loop(std::stop_token token) {
+        // 单个 SQE 的长度上限，超过的部分按短读继续
+        constexpr size_t MAX_READ{size_t{1} << 30};
+        // 提交失败后等待的时间，内核暂时没有资源且没有可等待的完成时使用
+        constexpr auto BUSY_BACKOFF{std::chrono::milliseconds{1}};
+        // 读取的 user_data 是请求 id（从 1 递增），取消与唤醒用最高位区分
+        constexpr uint64_t CANCEL_USER_DATA{uint64_t{1} << 63};
+        constexpr uint64_t WAKE_USER_DATA{~uint64_t{0}};
+        std::unordered_map<IoRequestId, Request> flying;
+        std::vector<IoRequestId> resubmit;          // 下一轮需要重新放入 SQ 的请求
+        std::unordered_set<IoRequestId> aborting;   // 已提交 IORING_OP_ASYNC_CANCEL
+        std::vector<Request> finished;
+        // wake_fd_ 上的 POLL_ADD：阻塞在等待完成时由 cancel() 唤醒
+        enum class Wake : uint8_t { Idle, Pushed, Armed } wake{Wake::Idle};
+        uint32_t reads{};                           // 本轮放入 SQ 的读取，只统计这些
+
+        const auto push = [&](IoRequestId id) {
+            auto &request{flying.at(id)};
+            const auto buffer{request.result.data.bytes().subspan(request.done)};
+            if (ring_->push_read(request.file->fd(), buffer.first(std::min(buffer.size(), MAX_READ)), request.offset + request.done, id)) {
+                reads += 1;
+            }
+            else {
+                // SQ 已满（上次提交未被内核接受的 SQE 仍在环中），下一轮再放入
+                resubmit.push_back(id);
+            }
+        };
+        const auto finish = [&](IoRequestId id, int error) {
+            auto &request{flying.at(id)};
+            request.result.error = error;
+            finished.push_back(std::move(request));
+            flying.erase(id);
+        };
+        // 唤醒的 POLL_ADD 与取消也占用内核中的位置
+        const auto reads_in_kernel = [&] { return ring_->in_kernel() - (Wake::Armed == wake ? 1u : 0u); };
+
+        while (true) {
+            std::vector<Request> taken;
+            std::vector<IoRequestId> aborts;
+            {
+                std::unique_lock lock{mutex_};
+                if (flying.empty()) {
+                    tasks_cv_.wait(lock, token, [this] { return !queue_.empty(); });
+                }
+                if (token.stop_requested() && flying.empty()) {
+                    break;
+                }
+                while (!token.stop_requested() && !queue_.empty() && flying.size() + taken.size() < ring_->entries()) {
+                    taken.push_back(take_locked());
+                }
+                aborts.swap(aborts_);
+                // 停止时不再等正在读取的请求读完
+                if (token.stop_requested() && wake_fd_ >= 0) {
+                    for (const auto &[id, request] : flying) {
+                        aborts.push_back(id);
+                    }
+                }
+            }
+
+            std::vector<IoRequestId> retry;
+            retry.swap(resubmit);
+            reads = 0;
+            for (auto &request : taken) {
+                request.result.data = IoBuffer{request.size};
+                if (0 == request.size) {
+                    finished.push_back(std::move(request));
+                    continue;
+                }
+                const auto id{request.id};
+                flying.emplace(id, std::move(request));
+                push(id);
+            }
+            for (const auto id : retry) {
+                push(id);
+            }
+            for (const auto id : aborts) {
+                if (!flying.contains(id) || aborting.contains(id)) {
+                    continue;
+                }
+                if (const auto it{std::ranges::find(resubmit, id)}; resubmit.end() != it) {
+                    // 不在内核中，直接结束
+                    resubmit.erase(it);
+                    finish(id, ECANCELED);
+                }
+                else if (ring_->push_cancel(id, CANCEL_USER_DATA | id)) {
+                    aborting.insert(id);
+                }
+                // SQ 已满时不取消，读完后丢弃
+            }
+            if (wake_fd_ >= 0 && Wake::Idle == wake && !flying.empty() && ring_->push_poll(wake_fd_, WAKE_USER_DATA)) {
+                wake = Wake::Pushed;
+            }
+
+            // 没有读取在进行时不等待完成，否则会一直阻塞（唤醒的 POLL_ADD 可能一直不完成）
+            const int submitted{ring_->submit(flying.empty() ? 0 : 1)};
+            if (submitted >= 0 && Wake::Pushed == wake && 0 == ring_->unsubmitted()) {
+                wake = Wake::Armed;
+            }
+            if (submitted < 0 && -EBUSY != submitted && -EAGAIN != submitted && 0 == reads_in_kernel()) {
+                // 无法提交（例如 io_uring_enter 被 seccomp 拒绝）：环中的请求都没有交给内核，
+                // 放回队列（已读到的部分保留），不再使用这个环，本线程改为同步读取
+                std::unique_lock lock{mutex_};
+                for (auto &[id, request] : flying) {
+                    requeue_locked(std::move(request));
+                }
+                for (auto &request : finished) {
+                    complete_locked(std::move(request));
+                }
+                backend_ = IoBackend::Threads;
+                aborts_.clear();
+                lock.unlock();
+                thread_loop(token);
+                return;
+            }
+            if (-EBUSY == submitted || -EAGAIN == submitted) {
+                // 内核暂时不接受新的 SQE：有读取在进行时等它完成（释放 CQ 空间），否则稍后重试
+                if (reads_in_kernel() > 0) {
+                    ring_->wait(1);
+                }
+                else {
+                    std::this_thread::sleep_for(BUSY_BACKOFF);
+                }
+            }
+
+            ring_->reap([&](uint64_t user_data, int32_t res) {
+                if (WAKE_USER_DATA == user_data) {
+                    uint64_t count{};
+                    [[maybe_unused]] const auto drained{::read(wake_fd_, &count, sizeof(count))};
+                    wake = Wake::Idle;
+                    return;
+                }
+                if (0 != (user_data & CANCEL_USER_DATA)) {
+                    // 取消本身的结果（-ENOENT 已读完、-EALREADY 正在读取）不用处理，被取消的读取另有完成
+                    return;
+                }
+                const IoRequestId id{user_data};
+                auto &request{flying.at(id)};
+                const bool aborted{aborting.erase(id) > 0};
+                if (!aborted && (-EINTR == res || -EAGAIN == res)) {
+                    resubmit.push_back(id);
+                    return;
+                }
+                if (res > 0) {
+                    request.done += static_cast<size_t>(res);
+                    if (!aborted && request.done < request.size) {
+                        resubmit.push_back(id);
+                        return;
+                    }
+                }
+                finish(id, res < 0 ? -res : 0);
+            });
+
+            std::lock_guard lock{mutex_};
+            if (reads > 0 && submitted > 0) {
+                stats_.batches += 1;
+                stats_.submissions += std::min<uint64_t>(reads, static_cast<uint64_t>(submitted));
+            }
+            for (auto &request : finished) {
+                complete_locked(std::move(request));
+            }
+            finished.clear();
+        }
+    }
+
+    // 可在任意线程调用
+    void wake() const {
+        const uint64_t one{1};
+        [[maybe_unused]] const auto written{::write(wake_fd_, &one, sizeof(one))};
+    }
+#endif
+
+    const uint32_t depth_;
+    std::atomic<IoBackend> backend_{IoBackend::Threads};
+#if IMAGE_IO_URING
+    std::unique_ptr<detail::IoUring> ring_{};
+    int wake_fd_{-1};                               // eventfd，cancel() 唤醒 I/O 线程；内核不支持取消时为 -1
+    std::vector<IoRequestId> aborts_{};             // 待 I/O 线程提交 IORING_OP_ASYNC_CANCEL 的请求
+#else
+    std::nullptr_t ring_{};
+#endif
+
+    mutable std::mutex mutex_{};
+    std::condition_variable_any tasks_cv_{};
+    std::condition_variable idle_cv_{};
+    std::map<Key, Request> queue_{};
+    std::unordered_map<IoRequestId, Key> queued_{};
+    std::unordered_set<IoRequestId> in_flight_{};
+    std::unordered_set<IoRequestId> cancelled_{};   // 读取中被取消
+    std::deque<Request> completed_{};
+    IoRequestId last_id_{};
+    IoStats stats_{};
+
+    // 最后声明，析构时先停止
+    std::vector<std::jthread> threads_{};
+};
+
+} // namespace Image
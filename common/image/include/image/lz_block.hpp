@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <vector>
+
+/**
+ * LZ4 块格式（只有块，不含 frame 头）的压缩与解压
+ *
+ * 每个序列：token（高 4 位字面量长度、低 4 位匹配长度 - 4，15 表示后面还有 255 累加的长度字节）、
+ * 字面量、2 字节小端偏移、扩展的匹配长度；最后一个序列只有字面量。
+ * 与 lz4 的约定相同：最后 5 字节总是字面量，最后一个匹配在结尾前 12 字节之前开始，
+ * 因此输出可由标准 LZ4_decompress_safe 解压。
+ * 压缩端是单个哈希表的贪心匹配，速度优先；解压端检查全部边界，损坏的数据返回 false 而不会越界。
+ */
+namespace Image {
+
+// 最坏情况（不可压缩）的输出大小
+constexpr size_t lz_compress_bound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+namespace detail {
+
+inline constexpr size_t LZ_MIN_MATCH{4};
+inline constexpr size_t LZ_LAST_LITERALS{5};
+inline constexpr size_t LZ_MATCH_FIND_LIMIT{12};
+inline constexpr size_t LZ_MAX_OFFSET{65535};
+inline constexpr uint32_t LZ_HASH_BITS{12};
+
+inline uint32_t lz_load32(const uint8_t *data)
+{
+    uint32_t value{};
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline uint32_t lz_hash(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+inline void lz_write_length(std::vector<uint8_t> &out, size_t length)
+{
+    for (; length >= 255; length -= 255) {
+        out.push_back(255);
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+// match_length 为 0 表示最后一个只有字面量的序列
+inline void lz_write_sequence(std::vector<uint8_t> &out, std::span<const uint8_t> literals, size_t offset, size_t match_length)
+{
+    const size_t token_position{out.size()};
+    out.push_back(static_cast<uint8_t>(std::min<size_t>(literals.size(), 15) << 4));
+    if (literals.size() >= 15) {
+        lz_write_length(out, literals.size() - 15);
+    }
+    out.insert(out.end(), literals.begin(), literals.end());
+    if (0 == match_length) {
+        return;
+    }
+    out.push_back(static_cast<uint8_t>(offset & 0xFF));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    const size_t length{match_length - LZ_MIN_MATCH};
+    out[token_position] |= static_cast<uint8_t>(std::min<size_t>(length, 15));
+    if (length >= 15) {
+        lz_write_length(out, length - 15);
+    }
+}
+
+// 读取 token 之后的扩展长度，越界时返回 false
+inline bool lz_read_length(std::span<const uint8_t> in, size_t &position, size_t &length)
+{
+    uint8_t byte{};
+    do {
+        if (position >= in.size()) {
+            return false;
+        }
+        byte = in[position++];
+        length += byte;
+    } while (255 == byte);
+    return true;
+}
+
+} // namespace detail
+
+inline std::vector<uint8_t> lz_compress(std::span<const uint8_t> in)
+{
+    using namespace detail;
+    std::vector<uint8_t> out;
+    out.reserve(lz_compress_bound(in.size()));
+
+    size_t anchor{};
+    if (in.size() > LZ_MATCH_FIND_LIMIT) {
+        // 表中存的是位置，初值 0 也可能命中，匹配前都会比较实际字节
+        std::array<uint32_t, size_t{1} << LZ_HASH_BITS> table{};
+        const size_t last_start{in.size() - LZ_MATCH_FIND_LIMIT};
+        const size_t match_end{in.size() - LZ_LAST_LITERALS};
+        size_t position{1};
+        while (position < last_start) {
+            const uint32_t sequence{lz_load32(in.data() + position)};
+            const uint32_t hash{lz_hash(sequence)};
+            size_t candidate{table[hash]};
+            table[hash] = static_cast<uint32_t>(position);
+            if (position - candidate > LZ_MAX_OFFSET || sequence != lz_load32(in.data() + candidate)) {
+                // 连续未命中时加大步长，不可压缩的数据（jpg 等）很快扫过
+                position += 1 + ((position - anchor) >> 6);
+                continue;
+            }
+
+            size_t length{LZ_MIN_MATCH};
+            while (position + length < match_end && in[candidate + length] == in[position + length]) {
+                length += 1;
+            }
+            while (position > anchor && candidate > 0 && in[position - 1] == in[candidate - 1]) {
+                position -= 1;
+                candidate -= 1;
+                length += 1;
+            }
+            lz_write_sequence(out, in.subspan(anchor, position - anchor), position - candidate, length);
+            position += length;
+            anchor = position;
+        }
+    }
+    lz_write_sequence(out, in.subspan(anchor), 0, 0);
+    return out;
+}
+
+// out 的大小须等于原始数据大小；数据损坏或大小不符时返回 false
+inline bool lz_decompress(std::span<const uint8_t> in, std::span<uint8_t> out)
+{
+    using namespace detail;
+    size_t in_position{};
+    size_t out_position{};
+    while (in_position < in.size()) {
+        const uint8_t token{in[in_position++]};
+
+        size_t literals{static_cast<size_t>(token >> 4)};
+        if (15 == literals && !lz_read_length(in, in_position, literals)) {
+            return false;
+        }
+        if (literals > in.size() - in_position || literals > out.size() - out_position) {
+            return false;
+        }
+        if (literals > 0) {
+            std::memcpy(out.data() + out_position, in.data() + in_position, literals);
+        }
+        in_position += literals;
+        out_position += literals;
+        if (in.size() == in_position) {
+            break;
+        }
+
+        if (in.size() - in_position < 2) {
+            return false;
+        }
+        const size_t offset{static_cast<size_t>(in[in_position]) | static_cast<size_t>(in[in_position + 1]) << 8};
+        in_position += 2;
+        size_t length{static_cast<size_t>(token & 0x0F)};
+        if (15 == length && !lz_read_length(in, in_position, length)) {
+            return false;
+        }
+        length += LZ_MIN_MATCH;
+        if (0 == offset || offset > out_position || length > out.size() - out_position) {
+            return false;
+        }
+        uint8_t *dst{out.data() + out_position};
+        const uint8_t *src{dst - offset};
+        if (offset >= length) {
+            std::memcpy(dst, src, length);
+        }
+        else {
+            // 重叠的匹配（偏移小于长度）必须逐字节复制，重复前面刚写出的内容
+            for (size_t i{}; i < length; ++i) {
+                dst[i] = src[i];
+            }
+        }
+        out_position += length;
+    }
+    return out.size() == out_position;
+}
+
+} // namespace Image
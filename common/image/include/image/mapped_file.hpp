@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <span>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Image {
+
+// Sequential：打开时提示内核预读整个文件；Random：按需读取访问到的页（只用到文件中一小部分时）
+enum class MapAccess : uint8_t { Sequential, Random };
+
+// 只读映射整个文件；空文件视为打开失败
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path &path, MapAccess access = MapAccess::Sequential) {
+        map(path, access);
+    }
+    ~MappedFile() { unmap(); }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(MappedFile &&) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile &operator=(MappedFile &&) = delete;
+
+    const uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+    std::span<const std::byte> bytes() const { return {reinterpret_cast<const std::byte *>(data_), size_}; }
+
+private:
+#if defined(_WIN32)
+    void map(const std::filesystem::path &path, MapAccess access) {
+        file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            MapAccess::Random == access ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER size{};
+        if (INVALID_HANDLE_VALUE == file_ || !GetFileSizeEx(file_, &size) || 0 == size.QuadPart) {
+            unmap();
+            throw std::runtime_error{std::format("ERROR::IMAGE::MAPPED_FILE what:can not open {}", path.string())};
+        }
+        size_ = static_cast<size_t>(size.QuadPart);
+        mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data_ = nullptr == mapping_ ? nullptr : static_cast<const uint8_t *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (nullptr == data_) {
+            unmap();
+            throw std::runtime_error{std::format("ERROR::IMAGE::MAPPED_FILE what:can not map {}", path.string())};
+        }
+    }
+
+    void unmap() {
+        if (nullptr != data_) {
+            UnmapViewOfFile(data_);
+        }
+        if (nullptr != mapping_) {
+            CloseHandle(mapping_);
+        }
+        if (INVALID_HANDLE_VALUE != file_) {
+            CloseHandle(file_);
+        }
+        data_ = nullptr;
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+    }
+
+    HANDLE file_{INVALID_HANDLE_VALUE};
+    HANDLE mapping_{nullptr};
+#else
+    void map(const std::filesystem::path &path, MapAccess access) {
+        const int fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+        struct stat info{};
+        if (fd < 0 || 0 != ::fstat(fd, &info) || 0 == info.st_size) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            throw std::runtime_error{std::format("ERROR::IMAGE::MAPPED_FILE what:can not open {}", path.string())};
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        void *data{::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0)};
+        ::close(fd);    // 映射保持有效
+        if (MAP_FAILED == data) {
+            throw std::runtime_error{std::format("ERROR::IMAGE::MAPPED_FILE what:can not map {}", path.string())};
+        }
+        data_ = static_cast<const uint8_t *>(data);
+        ::madvise(data, size_, MapAccess::Random == access ? MADV_RANDOM : MADV_WILLNEED);
+    }
+
+    void unmap() {
+        if (nullptr != data_) {
+            ::munmap(const_cast<uint8_t *>(data_), size_);
+        }
+        data_ = nullptr;
+    }
+#endif
+
+    const uint8_t *data_{};
+    size_t size_{};
+};
+
+} // namespace Image
@@ -0,0 +1,448 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "asset_pack.hpp"
+#include "bc_encode.hpp"
+#include "mapped_file.hpp"
+
+/**
+ * 预生成 mip 链的纹理容器（.mipc）
+ *
+ * 离线由 mip_convert 从 JPEG/PNG 生成，运行时 MappedMipChain 直接 mmap 文件，各级像素不经解码即可上传。
+ * 文件布局（小端）：
+ *   MipFileHeader
+ *   MipFileLevel[level_count]   level 0 为原图
+ *   各级 RGBA8 像素或 BC 压缩块（按块行排列），紧密排列，起始偏移按 LEVEL_ALIGNMENT 对齐
+ * 行顺序与写入时相同，mip_convert 默认按 OpenGL 约定自下而上存储。
+ */
+namespace Image {
+
+static_assert(std::endian::little == std::endian::native, "mip chain files are little endian");
+
+enum class MipFormat : uint32_t
+{
+    Rgba8 = 0, Srgb8Alpha8 = 1,
+    Bc1 = 2, Bc1Srgb = 3,
+    Bc3 = 4, Bc3Srgb = 5,
+    Bc7 = 6, Bc7Srgb = 7,
+};
+
+constexpr bool is_valid(MipFormat format)
+{
+    return static_cast<uint32_t>(format) <= static_cast<uint32_t>(MipFormat::Bc7Srgb);
+}
+
+// 偶数为线性格式，奇数为对应的 sRGB 格式
+constexpr bool is_srgb(MipFormat format)
+{
+    return 1 == (static_cast<uint32_t>(format) & 1);
+}
+
+constexpr std::optional<BcFormat> bc_format(MipFormat format)
+{
+    switch (format) {
+        case MipFormat::Bc1: case MipFormat::Bc1Srgb: return BcFormat::Bc1;
+        case MipFormat::Bc3: case MipFormat::Bc3Srgb: return BcFormat::Bc3;
+        case MipFormat::Bc7: case MipFormat::Bc7Srgb: return BcFormat::Bc7;
+        case MipFormat::Rgba8: case MipFormat::Srgb8Alpha8: break;
+    }
+    return std::nullopt;
+}
+
+constexpr MipFormat compressed_format(BcFormat format, bool srgb)
+{
+    const uint32_t base{BcFormat::Bc1 == format ? 2u : BcFormat::Bc3 == format ? 4u : 6u};
+    return static_cast<MipFormat>(base + (srgb ? 1u : 0u));
+}
+
+// 一级的数据大小
+constexpr uint64_t mip_level_bytes(MipFormat format, uint32_t width, uint32_t height)
+{
+    const auto bc{bc_format(format)};
+    return bc.has_value() ? bc_image_bytes(*bc, width, height) : static_cast<uint64_t>(width) * height * 4;
+}
+
+struct MipFileHeader
+{
+    std::array<char, 4> magic{'M', 'I', 'P', 'C'};
+    uint32_t version{1};
+    MipFormat format{MipFormat::Rgba8};
+    uint32_t width{};
+    uint32_t height{};
+    uint32_t level_count{};
+};
+
+struct MipFileLevel
+{
+    uint64_t offset{};
+    uint64_t size{};
+    uint32_t width{};
+    uint32_t height{};
+};
+
+static_assert(sizeof(MipFileHeader) == 24 && sizeof(MipFileLevel) == 24);
+
+inline constexpr std::array<char, 4> MIP_FILE_MAGIC{'M', 'I', 'P', 'C'};
+inline constexpr uint64_t LEVEL_ALIGNMENT{64};
+
+struct MipImage
+{
+    uint32_t width{};
+    uint32_t height{};
+    std::vector<uint8_t> pixels{};
+};
+
+struct MipChain
+{
+    MipFormat format{MipFormat::Rgba8};
+    std::vector<MipImage> levels{};
+};
+
+namespace detail {
+
+// sRGB 与 16 位线性值互转，在线性空间平均可避免缩小后图像偏暗
+struct SrgbTables
+{
+    std::array<uint16_t, 256> to_linear{};
+    std::array<uint8_t, 4096> to_srgb{};     // 以线性值的高 12 位索引
+
+    SrgbTables() {
+        for (size_t i{}; i < to_linear.size(); ++i) {
+            const double c{static_cast<double>(i) / 255.0};
+            const double linear{c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4)};
+            to_linear[i] = static_cast<uint16_t>(std::lround(linear * 65535.0));
+        }
+        for (size_t i{}; i < to_srgb.size(); ++i) {
+            const double linear{(static_cast<double>(i) + 0.5) / static_cast<double>(to_srgb.size())};
+            const double c{linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055};
+            to_srgb[i] = static_cast<uint8_t>(std::lround(std::clamp(c, 0.0, 1.0) * 255.0));
+        }
+    }
+};
+
+inline const SrgbTables &srgb_tables()
+{
+    static const SrgbTables tables{};
+    return tables;
+}
+
+inline void downsample_pixel(const uint8_t *a, const uint8_t *b, const uint8_t *c, const uint8_t *d, uint8_t *out, bool srgb)
+{
+    if (srgb) {
+        const auto &tables{srgb_tables()};
+        for (int ch{}; ch < 3; ++ch) {
+            const uint32_t sum{static_cast<uint32_t>(tables.to_linear[a[ch]]) + tables.to_linear[b[ch]]
+                + tables.to_linear[c[ch]] + tables.to_linear[d[ch]]};
+            out[ch] = tables.to_srgb[(sum + 2) / 4 >> 4];
+        }
+        out[3] = static_cast<uint8_t>((a[3] + b[3] + c[3] + d[3] + 2) / 4);
+        return;
+    }
+    for (int ch{}; ch < 4; ++ch) {
+        out[ch] = static_cast<uint8_t>((a[ch] + b[ch] + c[ch] + d[ch] + 2) / 4);
+    }
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+constexpr uint32_t SIMD_OUTPUT_PIXELS{2};
+
+// 两行各 4 个像素 -> 2 个像素，结果与标量路径一致（四舍五入）
+inline void downsample_simd(const uint8_t *row0, const uint8_t *row1, uint8_t *out, uint32_t n_blocks)
+{
+    const __m128i zero{_mm_setzero_si128()};
+    const __m128i round{_mm_set1_epi16(2)};
+    for (uint32_t block{}; block < n_blocks; ++block) {
+        const __m128i a{_mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + block * 16))};
+        const __m128i b{_mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + block * 16))};
+        const __m128i lo{_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero))};
+        const __m128i hi{_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero))};
+        __m128i sum{_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi))};
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + block * 8), _mm_packus_epi16(sum, sum));
+    }
+}
+
+#elif defined(__ARM_NEON)
+
+constexpr uint32_t SIMD_OUTPUT_PIXELS{2};
+
+inline void downsample_simd(const uint8_t *row0, const uint8_t *row1, uint8_t *out, uint32_t n_blocks)
+{
+    for (uint32_t block{}; block < n_blocks; ++block) {
+        const uint8x16_t a{vld1q_u8(row0 + block * 16)};
+        const uint8x16_t b{vld1q_u8(row1 + block * 16)};
+        const uint16x8_t lo{vaddl_u8(vget_low_u8(a), vget_low_u8(b))};
+        const uint16x8_t hi{vaddl_u8(vget_high_u8(a), vget_high_u8(b))};
+        const uint16x8_t sum{vcombine_u16(
+            vadd_u16(vget_low_u16(lo), vget_high_u16(lo)),
+            vadd_u16(vget_low_u16(hi), vget_high_u16(hi)))};
+        vst1_u8(out + block * 8, vrshrn_n_u16(sum, 2));
+    }
+}
+
+#else
+
+constexpr uint32_t SIMD_OUTPUT_PIXELS{1};
+
+inline void downsample_simd(const uint8_t *row0, const uint8_t *row1, uint8_t *out, uint32_t n_blocks)
+{
+    for (uint32_t block{}; block < n_blocks; ++block) {
+        downsample_pixel(row0 + block * 8, row0 + block * 8 + 4, row1 + block * 8, row1 + block * 8 + 4, out + block * 4, false);
+    }
+}
+
+#endif
+
+// 2x2 box filter，生成 dst 的 [first_row, last_row)；奇数尺寸时边缘按钳位取样
+inline void downsample_rows(const MipImage &src, MipImage &dst, uint32_t first_row, uint32_t last_row, bool srgb)
+{
+    const size_t src_stride{static_cast<size_t>(src.width) * 4};
+    const size_t dst_stride{static_cast<size_t>(dst.width) * 4};
+    for (uint32_t y{first_row}; y < last_row; ++y) {
+        const uint8_t *row0{src.pixels.data() + std::min(2 * y, src.height - 1) * src_stride};
+        const uint8_t *row1{src.pixels.data() + std::min(2 * y + 1, src.height - 1) * src_stride};
+        uint8_t *out{dst.pixels.data() + y * dst_stride};
+
+        uint32_t x{};
+        if (!srgb && src.width >= 2) {
+            // 源像素 2x+1 不越界的部分走 SIMD
+            const uint32_t n_blocks{std::min(dst.width, src.width / 2) / SIMD_OUTPUT_PIXELS};
+            downsample_simd(row0, row1, out, n_blocks);
+            x = n_blocks * SIMD_OUTPUT_PIXELS;
+        }
+        for (; x < dst.width; ++x) {
+            const size_t x0{std::min(2 * x, src.width - 1) * size_t{4}};
+            const size_t x1{std::min(2 * x + 1, src.width - 1) * size_t{4}};
+            downsample_pixel(row0 + x0, row0 + x1, row1 + x0, row1 + x1, out + x * 4, srgb);
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ * 生成下一级 mip（宽高减半，最小为 1）
+ * 大图按行切分到多个线程
+ */
+inline MipImage downsample(const MipImage &src, MipFormat format)
+{
+    MipImage dst{std::max(1u, src.width / 2), std::max(1u, src.height / 2), {}};
+    dst.pixels.resize(static_cast<size_t>(dst.width) * dst.height * 4);
+    const bool srgb{is_srgb(format)};
+
+    constexpr size_t MIN_PIXELS_PER_THREAD{1 << 16};
+    const auto n_threads{static_cast<uint32_t>(std::clamp<size_t>(
+        dst.pixels.size() / 4 / MIN_PIXELS_PER_THREAD, 1, std::max(1u, std::thread::hardware_concurrency())))};
+    if (1 == n_threads) {
+        detail::downsample_rows(src, dst, 0, dst.height, srgb);
+        return dst;
+    }
+
+    std::vector<std::jthread> workers;
+    workers.reserve(n_threads);
+    const uint32_t rows_per_thread{(dst.height + n_threads - 1) / n_threads};
+    for (uint32_t t{}; t < n_threads; ++t) {
+        const uint32_t first_row{std::min(t * rows_per_thread, dst.height)};
+        const uint32_t last_row{std::min(first_row + rows_per_thread, dst.height)};
+        workers.emplace_back([&, first_row, last_row] { detail::downsample_rows(src, dst, first_row, last_row, srgb); });
+    }
+    workers.clear();
+    return dst;
+}
+
+// level 0 为 rgba（width x height，紧密排列的 RGBA8），一直生成到 1x1
+inline MipChain build_mip_chain(std::span<const uint8_t> rgba, uint32_t width, uint32_t height, MipFormat format)
+{
+    if (0 == width || 0 == height || rgba.size() < static_cast<size_t>(width) * height * 4) {
+        throw std::runtime_error{std::format(
+            "ERROR::IMAGE::MIP_CHAIN what:buffer too small for {}x{}", width, height)};
+    }
+    MipChain chain{format, {}};
+    chain.levels.reserve(static_cast<size_t>(std::bit_width(std::max(width, height))));
+    chain.levels.push_back({width, height, {rgba.begin(), rgba.begin() + static_cast<std::ptrdiff_t>(width) * height * 4}});
+    while (chain.levels.back().width > 1 || chain.levels.back().height > 1) {
+        chain.levels.push_back(downsample(chain.levels.back(), format));
+    }
+    return chain;
+}
+
+/**
+ * 逐级压缩为 BC 块，保留线性/sRGB 属性；每级内部按块行多线程编码
+ * chain 须为未压缩的 RGBA8 链
+ */
+inline MipChain compress_mip_chain(const MipChain &chain, BcFormat format, BcQuality quality = BcQuality::Normal)
+{
+    if (bc_format(chain.format).has_value()) {
+        throw std::runtime_error{"ERROR::IMAGE::MIP_CHAIN what:mip chain is already compressed"};
+    }
+    MipChain compressed{compressed_format(format, is_srgb(chain.format)), {}};
+    compressed.levels.reserve(chain.levels.size());
+    for (const auto &level : chain.levels) {
+        compressed.levels.push_back({level.width, level.height, bc_encode(level.pixels, level.width, level.height, format, quality)});
+    }
+    return compressed;
+}
+
+inline void write_mip_chain(const std::filesystem::path &path, const MipChain &chain)
+{
+    if (chain.levels.empty()) {
+        throw std::runtime_error{"ERROR::IMAGE::MIP_CHAIN what:empty mip chain"};
+    }
+    MipFileHeader header{};
+    header.format      = chain.format;
+    header.width       = chain.levels.front().width;
+    header.height      = chain.levels.front().height;
+    header.level_count = static_cast<uint32_t>(chain.levels.size());
+
+    std::vector<MipFileLevel> table(chain.levels.size());
+    uint64_t offset{sizeof(MipFileHeader) + sizeof(MipFileLevel) * table.size()};
+    for (size_t i{}; i < table.size(); ++i) {
+        offset = (offset + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT;
+        const auto &level{chain.levels[i]};
+        table[i] = {offset, level.pixels.size(), level.width, level.height};
+        offset += level.pixels.size();
+    }
+
+    std::ofstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::MIP_CHAIN what:can not open {}", path.string())};
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(table.data()), static_cast<std::streamsize>(sizeof(MipFileLevel) * table.size()));
+    constexpr std::array<char, LEVEL_ALIGNMENT> PADDING{};
+    for (size_t i{}; i < table.size(); ++i) {
+        const auto position{static_cast<uint64_t>(file.tellp())};
+        file.write(PADDING.data(), static_cast<std::streamsize>(table[i].offset - position));
+        file.write(reinterpret_cast<const char *>(chain.levels[i].pixels.data()), static_cast<std::streamsize>(table[i].size));
+    }
+    if (!file) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::MIP_CHAIN what:write {} failed", path.string())};
+    }
+}
+
+// 只读取文件头判断是否为 .mipc，不检查扩展名
+inline bool is_mip_chain(std::span<const std::byte> bytes)
+{
+    return bytes.size() >= sizeof(MipFileHeader) && 0 == std::memcmp(bytes.data(), MIP_FILE_MAGIC.data(), MIP_FILE_MAGIC.size());
+}
+
+/**
+ * 只读映射 .mipc 文件，level() 直接指向映射内存
+ * 也可以取资源包中的条目：未压缩的条目同样指向包的映射内存（包须比它活得长），压缩的条目持有解压后的数据
+ * 打开时校验文件头与各级的偏移、尺寸，之后的访问不再检查
+ */
+class MappedMipChain
+{
+public:
+    struct Level
+    {
+        uint32_t width{};
+        uint32_t height{};
+        std::span<const uint8_t> pixels{};
+    };
+
+    // 上传会顺序读取全部内容，打开时即预读
+    explicit MappedMipChain(const std::filesystem::path &path)
+        : file_{std::in_place, path, MapAccess::Sequential}, data_{file_->data()}, size_{file_->size()}
+    {
+        validate(path.string());
+    }
+    // name 只用于错误信息
+    MappedMipChain(AssetBytes bytes, std::string_view name)
+        : bytes_{std::move(bytes)}, data_{reinterpret_cast<const uint8_t *>(bytes_.data())}, size_{bytes_.size()}
+    {
+        validate(name);
+    }
+    MappedMipChain(const MappedMipChain &) = delete;
+    MappedMipChain(MappedMipChain &&) = delete;
+    MappedMipChain &operator=(const MappedMipChain &) = delete;
+    MappedMipChain &operator=(MappedMipChain &&) = delete;
+
+    MipFormat format() const { return header().format; }
+    uint32_t width() const { return header().width; }
+    uint32_t height() const { return header().height; }
+    size_t level_count() const { return header().level_count; }
+
+    Level level(size_t index) const {
+        MipFileLevel entry{};
+        std::memcpy(&entry, data_ + sizeof(MipFileHeader) + index * sizeof(MipFileLevel), sizeof(entry));
+        return {entry.width, entry.height, {data_ + entry.offset, static_cast<size_t>(entry.size)}};
+    }
+
+    // 整个文件，用于计算内容哈希
+    std::span<const std::byte> bytes() const { return {reinterpret_cast<const std::byte *>(data_), size_}; }
+
+private:
+    MipFileHeader header() const {
+        MipFileHeader header{};
+        std::memcpy(&header, data_, sizeof(header));
+        return header;
+    }
+
+    void validate(std::string_view name) const {
+        const auto fail = [&](std::string_view what) {
+            return std::runtime_error{std::format("ERROR::IMAGE::MIP_CHAIN what:{} {}", name, what)};
+        };
+        if (!is_mip_chain(bytes())) {
+            throw fail("is not a mip chain file");
+        }
+        const auto info{header()};
+        if (1 != info.version) {
+            throw fail(std::format("has unsupported version {}", info.version));
+        }
+        if (!is_valid(info.format)) {
+            throw fail("has unknown pixel format");
+        }
+        if (0 == info.width || 0 == info.height) {
+            throw fail("has an empty base level");
+        }
+        // 完整的 mip 链到 1x1 为止，不能比它更长
+        if (0 == info.level_count || info.level_count > static_cast<uint32_t>(std::bit_width(std::max(info.width, info.height)))
+            || size_ < sizeof(MipFileHeader) + sizeof(MipFileLevel) * info.level_count) {
+            throw fail("has a truncated level table");
+        }
+        for (size_t i{}; i < info.level_count; ++i) {
+            MipFileLevel entry{};
+            std::memcpy(&entry, data_ + sizeof(MipFileHeader) + i * sizeof(MipFileLevel), sizeof(entry));
+            // 上传时按 level 的尺寸分配存储，与 glTexStorage2D 推算的尺寸不同时会越界或留下未定义的内容
+            if (entry.width != std::max(1u, info.width >> i) || entry.height != std::max(1u, info.height >> i)) {
+                throw fail(std::format("level {} is {}x{}, expected {}x{}", i, entry.width, entry.height,
+                    std::max(1u, info.width >> i), std::max(1u, info.height >> i)));
+            }
+            if (entry.size != mip_level_bytes(info.format, entry.width, entry.height)
+                || entry.offset > size_ || entry.size > size_ - entry.offset) {
+                throw fail(std::format("level {} is out of range", i));
+            }
+        }
+    }
+
+    std::optional<MappedFile> file_{};
+    AssetBytes bytes_{};
+    const uint8_t *data_{};
+    size_t size_{};
+};
+
+} // namespace Image
@@ -0,0 +1,425 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// 单独以某个指令集编译一个函数，不需要 -mavx2 等全局选项；MSVC 不需要
+#if defined(__GNUC__)
+#define IMAGE_TARGET(features) [[gnu::target(features)]]
+#else
+#define IMAGE_TARGET(features)
+#endif
+
+/**
+ * 上传前的像素转换：扩展为 RGBA8、上下翻转、sRGB 转线性、预乘 alpha
+ *
+ * 按行融合为一次遍历：每行读入后依次扩展、查表、预乘，数据仍在 L1 中，不再为每个步骤各扫一遍整幅图。
+ * 3 通道统一扩展为 RGBA，上传时不需要驱动重排，也不受 GL_UNPACK_ALIGNMENT 影响。
+ * 扩展与预乘有 AVX2 / SSSE3 / SSE2 / NEON 路径，x86 上按运行时检测的 CPU 选择（simd_path()）；sRGB 转线性为逐字节查表。
+ */
+namespace Image {
+
+struct PixelConvert
+{
+    bool flip_vertically{};
+    bool srgb_to_linear{};      // 只转换 RGB，8 位线性值
+    bool premultiply_alpha{};   // 在 sRGB 转线性之后进行
+};
+
+// 扩展与预乘使用的指令集，由高到低
+enum class SimdPath : uint8_t { Scalar, Sse2, Ssse3, Avx2, Neon };
+
+constexpr std::string_view simd_path_name(SimdPath path)
+{
+    switch (path) {
+        case SimdPath::Scalar: return "scalar";
+        case SimdPath::Sse2:   return "sse2";
+        case SimdPath::Ssse3:  return "ssse3";
+        case SimdPath::Avx2:   return "avx2";
+        case SimdPath::Neon:   return "neon";
+    }
+    return "unknown";
+}
+
+// 当前 CPU 可用的最快路径，第一次调用时检测
+inline SimdPath simd_path();
+
+// 当前 CPU 能否执行 path（x86 上不高于 simd_path() 的都可以）
+inline bool simd_path_supported(SimdPath path)
+{
+    const SimdPath best{simd_path()};
+    if (SimdPath::Scalar == path || best == path) {
+        return true;
+    }
+    return SimdPath::Neon != best && SimdPath::Neon != path && path < best;
+}
+
+namespace detail {
+
+inline const std::array<uint8_t, 256> &srgb_to_linear_table()
+{
+    static const std::array<uint8_t, 256> table{[] {
+        std::array<uint8_t, 256> values{};
+        for (size_t i{}; i < values.size(); ++i) {
+            const double c{static_cast<double>(i) / 255.0};
+            const double linear{c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4)};
+            values[i] = static_cast<uint8_t>(std::lround(linear * 255.0));
+        }
+        return values;
+    }()};
+    return table;
+}
+
+// c * a / 255，四舍五入，与 SIMD 路径结果一致
+constexpr uint8_t multiply_255(uint32_t c, uint32_t a)
+{
+    const uint32_t t{c * a + 128};
+    return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+inline void expand_rgb_scalar(const uint8_t *src, uint8_t *dst, size_t n_pixels)
+{
+    for (size_t p{}; p < n_pixels; ++p, src += 3, dst += 4) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = 255;
+    }
+}
+
+// 1 通道为灰度，2 通道为灰度 + alpha
+inline void expand_gray_scalar(const uint8_t *src, uint8_t *dst, size_t n_pixels, size_t channels)
+{
+    for (size_t p{}; p < n_pixels; ++p, src += channels, dst += 4) {
+        dst[0] = dst[1] = dst[2] = src[0];
+        dst[3] = 2 == channels ? src[1] : 255;
+    }
+}
+
+inline void premultiply_scalar(uint8_t *rgba, size_t n_pixels)
+{
+    for (size_t p{}; p < n_pixels; ++p, rgba += 4) {
+        rgba[0] = multiply_255(rgba[0], rgba[3]);
+        rgba[1] = multiply_255(rgba[1], rgba[3]);
+        rgba[2] = multiply_255(rgba[2], rgba[3]);
+    }
+}
+
+inline void srgb_to_linear_scalar(uint8_t *rgba, size_t n_pixels)
+{
+    const auto &table{srgb_to_linear_table()};
+    for (size_t p{}; p < n_pixels; ++p, rgba += 4) {
+        rgba[0] = table[rgba[0]];
+        rgba[1] = table[rgba[1]];
+        rgba[2] = table[rgba[2]];
+    }
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+// 每块读取 16 字节，只使用其中 12 字节；src 之后不足 4 字节的像素留给标量路径
+IMAGE_TARGET("ssse3")
+inline size_t expand_rgb_ssse3(const uint8_t *src, uint8_t *dst, size_t n_pixels)
+{
+    const size_t n_blocks{(n_pixels * 3 - std::min<size_t>(n_pixels * 3, 4)) / 12};
+    const __m128i shuffle{_mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1)};
+    const __m128i alpha{_mm_set1_epi32(static_cast<int>(0xFF000000u))};
+    for (size_t block{}; block < n_blocks; ++block, src += 12, dst += 16) {
+        const __m128i rgb{_mm_loadu_si128(reinterpret_cast<const __m128i *>(src))};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+    }
+    return n_blocks * 4;
+}
+
+// 每块读取 28 字节，只使用其中 24 字节
+IMAGE_TARGET("avx2")
+inline size_t expand_rgb_avx2(const uint8_t *src, uint8_t *dst, size_t n_pixels)
+{
+    const size_t n_blocks{(n_pixels * 3 - std::min<size_t>(n_pixels * 3, 4)) / 24};
+    const __m256i shuffle{_mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1)};
+    const __m256i alpha{_mm256_set1_epi32(static_cast<int>(0xFF000000u))};
+    for (size_t block{}; block < n_blocks; ++block, src += 24, dst += 32) {
+        const __m128i lo{_mm_loadu_si128(reinterpret_cast<const __m128i *>(src))};
+        const __m128i hi{_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 12))};
+        const __m256i rgb{_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1)};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle), alpha));
+    }
+    return n_blocks * 8;
+}
+
+// 16 位通道乘以各自像素的 alpha；alpha 通道乘以 255，结果不变
+inline __m128i premultiply_sse2_half(__m128i pixels)
+{
+    const __m128i keep_alpha{_mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0)};
+    const __m128i rgb_mask{_mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1)};
+    __m128i factor{_mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0xFF), 0xFF)};
+    factor = _mm_or_si128(_mm_and_si128(factor, rgb_mask), keep_alpha);
+    const __m128i t{_mm_add_epi16(_mm_mullo_epi16(pixels, factor), _mm_set1_epi16(128))};
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// SSE2 是 x86-64 的基线，不需要检测
+inline size_t premultiply_sse2(uint8_t *rgba, size_t n_pixels)
+{
+    const size_t n_blocks{n_pixels / 4};
+    const __m128i zero{_mm_setzero_si128()};
+    for (size_t block{}; block < n_blocks; ++block, rgba += 16) {
+        const __m128i pixels{_mm_loadu_si128(reinterpret_cast<const __m128i *>(rgba))};
+        const __m128i lo{premultiply_sse2_half(_mm_unpacklo_epi8(pixels, zero))};
+        const __m128i hi{premultiply_sse2_half(_mm_unpackhi_epi8(pixels, zero))};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(rgba), _mm_packus_epi16(lo, hi));
+    }
+    return n_blocks * 4;
+}
+
+IMAGE_TARGET("avx2")
+inline __m256i premultiply_avx2_half(__m256i pixels)
+{
+    const __m256i keep_alpha{_mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0)};
+    const __m256i rgb_mask{_mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1)};
+    __m256i factor{_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels, 0xFF), 0xFF)};
+    factor = _mm256_or_si256(_mm256_and_si256(factor, rgb_mask), keep_alpha);
+    const __m256i t{_mm256_add_epi16(_mm256_mullo_epi16(pixels, factor), _mm256_set1_epi16(128))};
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+IMAGE_TARGET("avx2")
+inline size_t premultiply_avx2(uint8_t *rgba, size_t n_pixels)
+{
+    const size_t n_blocks{n_pixels / 8};
+    const __m256i zero{_mm256_setzero_si256()};
+    for (size_t block{}; block < n_blocks; ++block, rgba += 32) {
+        const __m256i pixels{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(rgba))};
+        const __m256i lo{premultiply_avx2_half(_mm256_unpacklo_epi8(pixels, zero))};
+        const __m256i hi{premultiply_avx2_half(_mm256_unpackhi_epi8(pixels, zero))};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(rgba), _mm256_packus_epi16(lo, hi));
+    }
+    return n_blocks * 8;
+}
+
+#elif defined(__ARM_NEON)
+
+inline size_t expand_rgb_neon(const uint8_t *src, uint8_t *dst, size_t n_pixels)
+{
+    const size_t n_blocks{n_pixels / 16};
+    for (size_t block{}; block < n_blocks; ++block, src += 48, dst += 64) {
+        const uint8x16x3_t rgb{vld3q_u8(src)};
+        vst4q_u8(dst, uint8x16x4_t{{rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(255)}});
+    }
+    return n_blocks * 16;
+}
+
+inline uint8x16_t premultiply_neon_channel(uint8x16_t c, uint8x16_t a)
+{
+    const uint16x8_t lo{vaddq_u16(vmull_u8(vget_low_u8(c), vget_low_u8(a)), vdupq_n_u16(128))};
+    const uint16x8_t hi{vaddq_u16(vmull_u8(vget_high_u8(c), vget_high_u8(a)), vdupq_n_u16(128))};
+    return vcombine_u8(vshrn_n_u16(vsraq_n_u16(lo, lo, 8), 8), vshrn_n_u16(vsraq_n_u16(hi, hi, 8), 8));
+}
+
+inline size_t premultiply_neon(uint8_t *rgba, size_t n_pixels)
+{
+    const size_t n_blocks{n_pixels / 16};
+    for (size_t block{}; block < n_blocks; ++block, rgba += 64) {
+        uint8x16x4_t pixels{vld4q_u8(rgba)};
+        pixels.val[0] = premultiply_neon_channel(pixels.val[0], pixels.val[3]);
+        pixels.val[1] = premultiply_neon_channel(pixels.val[1], pixels.val[3]);
+        pixels.val[2] = premultiply_neon_channel(pixels.val[2], pixels.val[3]);
+        vst4q_u8(rgba, pixels);
+    }
+    return n_blocks * 16;
+}
+
+#endif
+
+inline SimdPath detect_simd_path()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(__GNUC__)
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdPath::Avx2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return SimdPath::Ssse3;
+    }
+#else
+    std::array<int, 4> info{};
+    __cpuid(info.data(), 0);
+    const int max_leaf{info[0]};
+    __cpuid(info.data(), 1);
+    const bool ssse3{0 != (info[2] & (1 << 9))};
+    // AVX 还需要操作系统保存 YMM 寄存器（OSXSAVE 与 XCR0 的 bit 1、2）
+    const bool os_avx{0 != (info[2] & (1 << 27)) && 0 != (info[2] & (1 << 28)) && 6 == (_xgetbv(0) & 6)};
+    if (max_leaf >= 7 && os_avx) {
+        __cpuidex(info.data(), 7, 0);
+        if (0 != (info[1] & (1 << 5))) {
+            return SimdPath::Avx2;
+        }
+    }
+    if (ssse3) {
+        return SimdPath::Ssse3;
+    }
+#endif
+    return SimdPath::Sse2;
+#elif defined(__ARM_NEON)
+    return SimdPath::Neon;
+#else
+    return SimdPath::Scalar;
+#endif
+}
+
+// 按块走 path 的 SIMD 路径，余下的像素走标量路径；SSE2 没有字节重排指令，扩展走标量路径
+inline void expand_rgb(const uint8_t *src, uint8_t *dst, size_t n_pixels, SimdPath path = simd_path())
+{
+    size_t done{};
+    switch (path) {
+#if defined(__x86_64__) || defined(_M_X64)
+        case SimdPath::Avx2:  done = expand_rgb_avx2(src, dst, n_pixels); break;
+        case SimdPath::Ssse3: done = expand_rgb_ssse3(src, dst, n_pixels); break;
+#elif defined(__ARM_NEON)
+        case SimdPath::Neon:  done = expand_rgb_neon(src, dst, n_pixels); break;
+#endif
+        default: break;
+    }
+    expand_rgb_scalar(src + done * 3, dst + done * 4, n_pixels - done);
+}
+
+inline void premultiply(uint8_t *rgba, size_t n_pixels, SimdPath path = simd_path())
+{
+    size_t done{};
+    switch (path) {
+#if defined(__x86_64__) || defined(_M_X64)
+        case SimdPath::Avx2:  done = premultiply_avx2(rgba, n_pixels); break;
+        case SimdPath::Ssse3:
+        case SimdPath::Sse2:  done = premultiply_sse2(rgba, n_pixels); break;
+#elif defined(__ARM_NEON)
+        case SimdPath::Neon:  done = premultiply_neon(rgba, n_pixels); break;
+#endif
+        default: break;
+    }
+    premultiply_scalar(rgba + done * 4, n_pixels - done);
+}
+
+// 经栈上的小缓冲区分段交换，memcpy 比逐字节 std::swap_ranges 快得多
+inline void swap_rows(uint8_t *a, uint8_t *b, size_t n_bytes)
+{
+    std::array<uint8_t, 1024> chunk{};
+    for (size_t offset{}; offset < n_bytes; offset += chunk.size()) {
+        const size_t n{std::min(chunk.size(), n_bytes - offset)};
+        std::memcpy(chunk.data(), a + offset, n);
+        std::memcpy(a + offset, b + offset, n);
+        std::memcpy(b + offset, chunk.data(), n);
+    }
+}
+
+// 把一行扩展到 dst（RGBA8）并完成逐像素转换
+inline void convert_row(const uint8_t *src, size_t channels, uint8_t *dst, size_t n_pixels, const PixelConvert &options)
+{
+    switch (channels) {
+        case 3:
+            expand_rgb(src, dst, n_pixels);
+            break;
+        case 4:
+            if (src != dst) {
+                std::memcpy(dst, src, n_pixels * 4);
+            }
+            break;
+        default:
+            expand_gray_scalar(src, dst, n_pixels, channels);
+            break;
+    }
+    if (options.srgb_to_linear) {
+        srgb_to_linear_scalar(dst, n_pixels);
+    }
+    // 1、3 通道的 alpha 恒为 255，预乘不改变结果
+    if (options.premultiply_alpha && (2 == channels || 4 == channels)) {
+        premultiply(dst, n_pixels);
+    }
+}
+
+} // namespace detail
+
+inline SimdPath simd_path()
+{
+    static const SimdPath path{detail::detect_simd_path()};
+    return path;
+}
+
+/**
+ * src: width x height，每像素 channels（1~4）字节，紧密排列；dst: width x height 的 RGBA8
+ * src 与 dst 不能重叠，4 通道原地转换使用 convert_rgba8_in_place
+ */
+inline void convert_to_rgba8(std::span<const uint8_t> src, size_t channels, uint32_t width, uint32_t height,
+    std::span<uint8_t> dst, const PixelConvert &options = {})
+{
+    const size_t n_pixels{static_cast<size_t>(width) * height};
+    if (channels < 1 || channels > 4 || src.size() < n_pixels * channels || dst.size() < n_pixels * 4) {
+        throw std::runtime_error{std::format(
+            "ERROR::IMAGE::CONVERT what:buffer too small for {}x{} with {} channels", width, height, channels)};
+    }
+    const size_t src_stride{static_cast<size_t>(width) * channels};
+    const size_t dst_stride{static_cast<size_t>(width) * 4};
+    for (uint32_t y{}; y < height; ++y) {
+        const uint32_t src_y{options.flip_vertically ? height - 1 - y : y};
+        detail::convert_row(src.data() + src_y * src_stride, channels, dst.data() + y * dst_stride, width, options);
+    }
+}
+
+// 4 通道原地转换：翻转时成对处理上下两行后交换，每行只读写一次
+inline void convert_rgba8_in_place(std::span<uint8_t> rgba, uint32_t width, uint32_t height, const PixelConvert &options = {})
+{
+    const size_t stride{static_cast<size_t>(width) * 4};
+    if (rgba.size() < stride * height) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::CONVERT what:buffer too small for {}x{}", width, height)};
+    }
+    const bool per_pixel{options.srgb_to_linear || options.premultiply_alpha};
+    if (!options.flip_vertically) {
+        for (uint32_t y{}; per_pixel && y < height; ++y) {
+            detail::convert_row(rgba.data() + y * stride, 4, rgba.data() + y * stride, width, options);
+        }
+        return;
+    }
+    for (uint32_t y{}; y < height / 2; ++y) {
+        uint8_t *top{rgba.data() + y * stride};
+        uint8_t *bottom{rgba.data() + (height - 1 - y) * stride};
+        if (per_pixel) {
+            detail::convert_row(top, 4, top, width, options);
+            detail::convert_row(bottom, 4, bottom, width, options);
+        }
+        detail::swap_rows(top, bottom, stride);
+    }
+    if (per_pixel && 1 == height % 2) {
+        uint8_t *middle{rgba.data() + height / 2 * stride};
+        detail::convert_row(middle, 4, middle, width, options);
+    }
+}
+
+// 任意每行字节数的原地上下翻转（1、2 通道等不扩展的数据）
+inline void flip_vertically(std::span<uint8_t> pixels, size_t row_bytes, uint32_t height)
+{
+    if (pixels.size() < row_bytes * height) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::CONVERT what:buffer too small for {} rows of {} bytes", height, row_bytes)};
+    }
+    for (uint32_t y{}; y < height / 2; ++y) {
+        detail::swap_rows(pixels.data() + y * row_bytes, pixels.data() + (height - 1 - y) * row_bytes, row_bytes);
+    }
+}
+
+} // namespace Image
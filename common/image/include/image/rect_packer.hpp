@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <limits>
+#include <optional>
+#include <vector>
+
+/**
+ * MaxRects 矩形装箱（best short side fit）
+ *
+ * 维护一组可能互相重叠的最大空闲矩形，放入时选择放下后短边剩余最小的位置，再把与之相交的空闲矩形切分，
+ * 并删除被其他空闲矩形包含的部分。可随时增量放入，不需要预先知道全部尺寸，也不会移动已放入的矩形。
+ * release() 把矩形归还为空闲区域，但不与相邻空闲区域合并，频繁释放后会产生碎片。
+ */
+namespace Image {
+
+struct PackRect
+{
+    uint32_t x{};
+    uint32_t y{};
+    uint32_t width{};
+    uint32_t height{};
+};
+
+class MaxRectsPacker
+{
+public:
+    MaxRectsPacker(uint32_t width, uint32_t height)
+        : width_{width}, height_{height}, free_{{0, 0, width, height}}
+    {}
+
+    // 放不下时返回 std::nullopt
+    std::optional<PackRect> insert(uint32_t width, uint32_t height) {
+        if (0 == width || 0 == height) {
+            return std::nullopt;
+        }
+        const PackRect *best{};
+        uint32_t best_short{std::numeric_limits<uint32_t>::max()};
+        uint32_t best_long{std::numeric_limits<uint32_t>::max()};
+        for (const auto &rect : free_) {
+            if (rect.width < width || rect.height < height) {
+                continue;
+            }
+            const uint32_t dx{rect.width - width};
+            const uint32_t dy{rect.height - height};
+            const uint32_t short_side{std::min(dx, dy)};
+            const uint32_t long_side{std::max(dx, dy)};
+            if (short_side < best_short || (short_side == best_short && long_side < best_long)) {
+                best = &rect;
+                best_short = short_side;
+                best_long = long_side;
+            }
+        }
+        if (nullptr == best) {
+            return std::nullopt;
+        }
+        const PackRect placed{best->x, best->y, width, height};
+        split(placed);
+        used_area_ += static_cast<uint64_t>(width) * height;
+        return placed;
+    }
+
+    void release(const PackRect &rect) {
+        used_area_ -= std::min(used_area_, static_cast<uint64_t>(rect.width) * rect.height);
+        free_.push_back(rect);
+        prune();
+    }
+
+    // 已使用面积占比
+    double occupancy() const {
+        return static_cast<double>(used_area_) / (static_cast<double>(width_) * height_);
+    }
+
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+
+private:
+    static bool contains(const PackRect &outer, const PackRect &inner) {
+        return inner.x >= outer.x && inner.y >= outer.y
+            && inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+    }
+
+    static bool intersects(const PackRect &a, const PackRect &b) {
+        return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+    }
+
+    // 与 placed 相交的空闲矩形替换为其四周剩余的最多 4 个矩形
+    void split(const PackRect &placed) {
+        std::vector<PackRect> next;
+        next.reserve(free_.size() + 4);
+        for (const auto &rect : free_) {
+            if (!intersects(rect, placed)) {
+                next.push_back(rect);
+                continue;
+            }
+            if (placed.x > rect.x) {
+                next.push_back({rect.x, rect.y, placed.x - rect.x, rect.height});
+            }
+            if (placed.x + placed.width < rect.x + rect.width) {
+                next.push_back({placed.x + placed.width, rect.y, rect.x + rect.width - placed.x - placed.width, rect.height});
+            }
+            if (placed.y > rect.y) {
+                next.push_back({rect.x, rect.y, rect.width, placed.y - rect.y});
+            }
+            if (placed.y + placed.height < rect.y + rect.height) {
+                next.push_back({rect.x, placed.y + placed.height, rect.width, rect.y + rect.height - placed.y - placed.height});
+            }
+        }
+        free_.swap(next);
+        prune();
+    }
+
+    // 删除被其他空闲矩形包含的矩形（完全相同的只保留一个）
+    void prune() {
+        for (size_t i{}; i < free_.size(); ++i) {
+            for (size_t j{i + 1}; j < free_.size();) {
+                if (contains(free_[i], free_[j])) {
+                    free_.erase(free_.begin() + static_cast<std::ptrdiff_t>(j));
+                    continue;
+                }
+                if (contains(free_[j], free_[i])) {
+                    free_.erase(free_.begin() + static_cast<std::ptrdiff_t>(i));
+                    j = i + 1;
+                    if (i >= free_.size()) {
+                        break;
+                    }
+                    continue;
+                }
+                ++j;
+            }
+        }
+    }
+
+private:
+    uint32_t width_{};
+    uint32_t height_{};
+    std::vector<PackRect> free_{};
+    uint64_t used_area_{};
+};
+
+} // namespace Image
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace Image {
+
+/**
+ * 写出未压缩 32 位 TGA（左上角为原点），stb_image 可直接读回
+ * rgba: 自上而下的 RGBA8 像素
+ */
+inline void write_tga(
+    const std::filesystem::path &path,
+    uint32_t width,
+    uint32_t height,
+    std::span<const uint8_t> rgba)
+{
+    if (rgba.size() < static_cast<size_t>(width) * height * 4) {
+        throw std::runtime_error{std::format(
+            "ERROR::IMAGE::TGA what:buffer too small for {}x{}", width, height)};
+    }
+
+    std::array<uint8_t, 18> header{};
+    header[2]  = 2; // uncompressed true-color
+    header[12] = static_cast<uint8_t>(width & 0xFF);
+    header[13] = static_cast<uint8_t>((width >> 8) & 0xFF);
+    header[14] = static_cast<uint8_t>(height & 0xFF);
+    header[15] = static_cast<uint8_t>((height >> 8) & 0xFF);
+    header[16] = 32;
+    header[17] = 0x28; // 8 alpha bits | top-left origin
+
+    std::vector<uint8_t> bgra(rgba.begin(), rgba.begin() + static_cast<std::ptrdiff_t>(width) * height * 4);
+    for (size_t i{}; i < bgra.size(); i += 4) {
+        std::swap(bgra[i], bgra[i + 2]);
+    }
+
+    std::ofstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error{std::format(
+            "ERROR::IMAGE::TGA what:can not open {}", path.string())};
+    }
+    file.write(reinterpret_cast<const char *>(header.data()), header.size());
+    file.write(reinterpret_cast<const char *>(bgra.data()), static_cast<std::streamsize>(bgra.size()));
+}
+
+} // namespace Image
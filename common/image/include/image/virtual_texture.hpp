@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cinttypes>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "mip_chain.hpp"
+
+/**
+ * 虚拟纹理的分页文件（.vtex）
+ *
+ * 原图放在边长 V = page_size * 2^(level_count - 1) 的正方形虚拟空间左下角，超出原图的部分按边缘钳位；
+ * 第 level 级每边 2^(level_count - 1 - level) 页，最后一级只有 1 页。
+ * 每页在 page_size 之外四周各多存 border 个像素（取自相邻页），物理缓存中的双线性过滤不会采到别的页。
+ * 文件布局（小端）：
+ *   VirtualTextureHeader
+ *   各页 RGBA8 像素，边长 tile_size = page_size + 2 * border，从 data_offset 起紧密排列；
+ *   按级从细到粗、每级内按行（y 再 x）排列，页号即可算出偏移
+ * 运行时 MappedVirtualTexture 按需读取访问到的页，文件可以远大于内存。
+ */
+namespace Image {
+
+struct VirtualTextureHeader
+{
+    std::array<char, 4> magic{'V', 'T', 'E', 'X'};
+    uint32_t version{1};
+    MipFormat format{MipFormat::Rgba8};
+    uint32_t width{};           // 原图尺寸
+    uint32_t height{};
+    uint32_t page_size{};
+    uint32_t border{};
+    uint32_t level_count{};
+    uint64_t data_offset{};
+};
+
+static_assert(sizeof(VirtualTextureHeader) == 40);
+
+inline constexpr std::array<char, 4> VIRTUAL_TEXTURE_MAGIC{'V', 'T', 'E', 'X'};
+inline constexpr uint64_t PAGE_DATA_ALIGNMENT{4096};
+// 页坐标在反馈缓冲与页表中以 8 位存储
+inline constexpr uint32_t MAX_VIRTUAL_TEXTURE_LEVELS{9};
+
+// level 之前各级的总页数
+constexpr uint64_t first_page(uint32_t level_count, uint32_t level)
+{
+    uint64_t pages{};
+    for (uint32_t l{}; l < level; ++l) {
+        const uint64_t side{uint64_t{1} << (level_count - 1 - l)};
+        pages += side * side;
+    }
+    return pages;
+}
+
+/**
+ * chain 为未压缩的 RGBA8 mip 链（通常由 build_mip_chain 生成，行顺序已按 GL 约定）
+ * page_size 须为 2 的幂
+ */
+inline void write_virtual_texture(const std::filesystem::path &path, const MipChain &chain, uint32_t page_size = 128, uint32_t border = 4)
+{
+    if (chain.levels.empty() || bc_format(chain.format).has_value()) {
+        throw std::runtime_error{"ERROR::IMAGE::VIRTUAL_TEXTURE what:requires an uncompressed mip chain"};
+    }
+    if (0 == page_size || !std::has_single_bit(page_size) || border >= page_size) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::VIRTUAL_TEXTURE what:invalid page size {} with border {}", page_size, border)};
+    }
+    const auto &base{chain.levels.front()};
+    uint32_t level_count{1};
+    while ((uint64_t{page_size} << (level_count - 1)) < std::max(base.width, base.height)) {
+        level_count += 1;
+    }
+    if (level_count > MAX_VIRTUAL_TEXTURE_LEVELS) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::VIRTUAL_TEXTURE what:{}x{} needs {} levels of {} pages, at most {}",
+            base.width, base.height, level_count, page_size, MAX_VIRTUAL_TEXTURE_LEVELS)};
+    }
+
+    VirtualTextureHeader header{};
+    header.format      = chain.format;
+    header.width       = base.width;
+    header.height      = base.height;
+    header.page_size   = page_size;
+    header.border      = border;
+    header.level_count = level_count;
+    header.data_offset = (sizeof(VirtualTextureHeader) + PAGE_DATA_ALIGNMENT - 1) / PAGE_DATA_ALIGNMENT * PAGE_DATA_ALIGNMENT;
+
+    std::ofstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::VIRTUAL_TEXTURE what:can not open {}", path.string())};
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    const std::vector<char> padding(static_cast<size_t>(header.data_offset - sizeof(header)));
+    file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+    // mip 链比虚拟空间的级数多；原图相对虚拟空间的位置在各级保持不变
+    const uint32_t tile{page_size + 2 * border};
+    std::vector<uint8_t> pixels(static_cast<size_t>(tile) * tile * 4);
+    for (uint32_t level{}; level < level_count; ++level) {
+        const auto &source{chain.levels[std::min<size_t>(level, chain.levels.size() - 1)]};
+        const uint32_t side{1u << (level_count - 1 - level)};
+        for (uint32_t page_y{}; page_y < side; ++page_y) {
+            for (uint32_t page_x{}; page_x < side; ++page_x) {
+                for (uint32_t y{}; y < tile; ++y) {
+                    const auto source_y{static_cast<uint32_t>(std::clamp<int64_t>(
+                        int64_t{page_y} * page_size + y - border, 0, source.height - 1))};
+                    const uint8_t *row{source.pixels.data() + static_cast<size_t>(source_y) * source.width * 4};
+                    uint8_t *out{pixels.data() + static_cast<size_t>(y) * tile * 4};
+                    for (uint32_t x{}; x < tile; ++x) {
+                        const auto source_x{static_cast<uint32_t>(std::clamp<int64_t>(
+                            int64_t{page_x} * page_size + x - border, 0, source.width - 1))};
+                        std::memcpy(out + static_cast<size_t>(x) * 4, row + static_cast<size_t>(source_x) * 4, 4);
+                    }
+                }
+                file.write(reinterpret_cast<const char *>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+            }
+        }
+    }
+    if (!file) {
+        throw std::runtime_error{std::format("ERROR::IMAGE::VIRTUAL_TEXTURE what:write {} failed", path.string())};
+    }
+}
+
+/**
+ * 只读映射 .vtex 文件，page() 直接指向映射内存，首次访问时才从磁盘读取
+ * 打开时校验文件头与文件大小
+ */
+class MappedVirtualTexture
+{
+public:
+    explicit MappedVirtualTexture(const std::filesystem::path &path)
+        : file_{path, MapAccess::Random}
+    {
+        const auto fail = [&](std::string_view what) {
+            return std::runtime_error{std::format("ERROR::IMAGE::VIRTUAL_TEXTURE what:{} {}", path.string(), what)};
+        };
+        if (file_.size() < sizeof(VirtualTextureHeader)
+            || 0 != std::memcmp(file_.data(), VIRTUAL_TEXTURE_MAGIC.data(), VIRTUAL_TEXTURE_MAGIC.size())) {
+            throw fail("is not a virtual texture file");
+        }
+        std::memcpy(&header_, file_.data(), sizeof(header_));
+        if (1 != header_.version) {
+            throw fail(std::format("has unsupported version {}", header_.version));
+        }
+        if (MipFormat::Rgba8 != header_.format && MipFormat::Srgb8Alpha8 != header_.format) {
+            throw fail("has unsupported pixel format");
+        }
+        if (0 == header_.page_size || !std::has_single_bit(header_.page_size) || header_.border >= header_.page_size
+            || 0 == header_.level_count || header_.level_count > MAX_VIRTUAL_TEXTURE_LEVELS) {
+            throw fail("has an invalid page layout");
+        }
+        const uint64_t data_bytes{first_page(header_.level_count, header_.level_count) * tile_bytes()};
+        if (header_.data_offset > file_.size() || data_bytes > file_.size() - header_.data_offset) {
+            throw fail("is truncated");
+        }
+    }
+
+    MipFormat format() const { return header_.format; }
+    uint32_t width() const { return header_.width; }
+    uint32_t height() const { return header_.height; }
+    uint32_t page_size() const { return header_.page_size; }
+    uint32_t border() const { return header_.border; }
+    uint32_t tile_size() const { return header_.page_size + 2 * header_.border; }
+    size_t tile_bytes() const { return static_cast<size_t>(tile_size()) * tile_size() * 4; }
+    uint32_t level_count() const { return header_.level_count; }
+    uint32_t virtual_size() const { return header_.page_size << (header_.level_count - 1); }
+    uint32_t pages_per_side(uint32_t level) const { return 1u << (header_.level_count - 1 - level); }
+    uint64_t page_count() const { return first_page(header_.level_count, header_.level_count); }
+
+    // tile_size x tile_size 的 RGBA8，含边框
+    std::span<const uint8_t> page(uint32_t level, uint32_t x, uint32_t y) const {
+        const uint64_t index{first_page(header_.level_count, level) + static_cast<uint64_t>(y) * pages_per_side(level) + x};
+        return {file_.data() + header_.data_offset + index * tile_bytes(), tile_bytes()};
+    }
+
+private:
+    MappedFile file_;
+    VirtualTextureHeader header_{};
+};
+
+} // namespace Image
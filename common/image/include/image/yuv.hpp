@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace Image {
+
+struct Yuv420View
+{
+    uint8_t *y{};
+    uint8_t *u{};
+    uint8_t *v{};
+};
+
+namespace detail {
+
+inline uint8_t rgb_to_y(int r, int g, int b) {
+    return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+inline uint8_t rgb_to_u(int r, int g, int b) {
+    return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+inline uint8_t rgb_to_v(int r, int g, int b) {
+    return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+// 处理一对像素行中 [x_begin, x_end) 的像素，x_begin 需为偶数
+inline void rgba_to_yuv420_rows_scalar(
+    const uint8_t *row0, const uint8_t *row1,
+    uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+    size_t x_begin, size_t x_end)
+{
+    for (size_t x{x_begin}; x < x_end; x += 2) {
+        const uint8_t *p00{row0 + x * 4};
+        const uint8_t *p01{p00 + 4};
+        const uint8_t *p10{row1 + x * 4};
+        const uint8_t *p11{p10 + 4};
+        y0[x]     = rgb_to_y(p00[0], p00[1], p00[2]);
+        y0[x + 1] = rgb_to_y(p01[0], p01[1], p01[2]);
+        y1[x]     = rgb_to_y(p10[0], p10[1], p10[2]);
+        y1[x + 1] = rgb_to_y(p11[0], p11[1], p11[2]);
+
+        const int r{(p00[0] + p01[0] + p10[0] + p11[0] + 2) >> 2};
+        const int g{(p00[1] + p01[1] + p10[1] + p11[1] + 2) >> 2};
+        const int b{(p00[2] + p01[2] + p10[2] + p11[2] + 2) >> 2};
+        u[x / 2] = rgb_to_u(r, g, b);
+        v[x / 2] = rgb_to_v(r, g, b);
+    }
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+// madd 得到每个像素的两个部分和，按奇偶 lane 收拢后相加
+inline __m128i sse2_dot_rgba(__m128i lo, __m128i hi, __m128i coef)
+{
+    const __m128 a{_mm_castsi128_ps(_mm_madd_epi16(lo, coef))};
+    const __m128 b{_mm_castsi128_ps(_mm_madd_epi16(hi, coef))};
+    const __m128i even{_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)))};
+    const __m128i odd{_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)))};
+    return _mm_add_epi32(even, odd);
+}
+
+// 4 个像素 -> 4 个 Y (int32)
+inline __m128i sse2_luma(__m128i px)
+{
+    const __m128i zero{_mm_setzero_si128()};
+    const __m128i coef{_mm_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0)};
+    __m128i y{sse2_dot_rgba(_mm_unpacklo_epi8(px, zero), _mm_unpackhi_epi8(px, zero), coef)};
+    y = _mm_srai_epi32(_mm_add_epi32(y, _mm_set1_epi32(128)), 8);
+    return _mm_add_epi32(y, _mm_set1_epi32(16));
+}
+
+// 两行各 4 个像素 -> 2 个 2x2 块的平均 RGBA (int16, 两个像素)
+inline __m128i sse2_box_2x2(__m128i px0, __m128i px1)
+{
+    const __m128i zero{_mm_setzero_si128()};
+    const __m128i lo{_mm_add_epi16(_mm_unpacklo_epi8(px0, zero), _mm_unpacklo_epi8(px1, zero))};
+    const __m128i hi{_mm_add_epi16(_mm_unpackhi_epi8(px0, zero), _mm_unpackhi_epi8(px1, zero))};
+    const __m128i lo_sum{_mm_add_epi16(lo, _mm_srli_si128(lo, 8))};
+    const __m128i hi_sum{_mm_add_epi16(hi, _mm_srli_si128(hi, 8))};
+    const __m128i sum{_mm_unpacklo_epi64(lo_sum, hi_sum)};
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+inline void rgba_to_yuv420_rows(
+    const uint8_t *row0, const uint8_t *row1,
+    uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+    size_t width)
+{
+    const __m128i bias_uv{_mm_set1_epi32(128)};
+    const __m128i coef_u{_mm_setr_epi16(-38, -74, 112, 0, -38, -74, 112, 0)};
+    const __m128i coef_v{_mm_setr_epi16(112, -94, -18, 0, 112, -94, -18, 0)};
+
+    // 每次处理 8 列：2 x 4 像素的两组，输出 8+8 个 Y、4 个 U/V
+    size_t x{};
+    for (; x + 8 <= width; x += 8) {
+        const __m128i a0{_mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 4))};
+        const __m128i a1{_mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 4 + 16))};
+        const __m128i b0{_mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 4))};
+        const __m128i b1{_mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 4 + 16))};
+
+        const __m128i ya{_mm_packs_epi32(sse2_luma(a0), sse2_luma(a1))};
+        const __m128i yb{_mm_packs_epi32(sse2_luma(b0), sse2_luma(b1))};
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(y0 + x), _mm_packus_epi16(ya, ya));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(y1 + x), _mm_packus_epi16(yb, yb));
+
+        const __m128i avg0{sse2_box_2x2(a0, b0)};
+        const __m128i avg1{sse2_box_2x2(a1, b1)};
+        __m128i cu{sse2_dot_rgba(avg0, avg1, coef_u)};
+        __m128i cv{sse2_dot_rgba(avg0, avg1, coef_v)};
+        cu = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(cu, bias_uv), 8), bias_uv);
+        cv = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(cv, bias_uv), 8), bias_uv);
+        const __m128i cu16{_mm_packs_epi32(cu, cu)};
+        const __m128i cv16{_mm_packs_epi32(cv, cv)};
+        const __m128i cu8{_mm_packus_epi16(cu16, cu16)};
+        const __m128i cv8{_mm_packus_epi16(cv16, cv16)};
+        const auto u_bits{static_cast<uint32_t>(_mm_cvtsi128_si32(cu8))};
+        const auto v_bits{static_cast<uint32_t>(_mm_cvtsi128_si32(cv8))};
+        for (size_t i{}; i < 4; ++i) {
+            u[x / 2 + i] = static_cast<uint8_t>(u_bits >> (i * 8));
+            v[x / 2 + i] = static_cast<uint8_t>(v_bits >> (i * 8));
+        }
+    }
+    rgba_to_yuv420_rows_scalar(row0, row1, y0, y1, u, v, x, width);
+}
+
+#else
+
+inline void rgba_to_yuv420_rows(
+    const uint8_t *row0, const uint8_t *row1,
+    uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+    size_t width)
+{
+    rgba_to_yuv420_rows_scalar(row0, row1, y0, y1, u, v, 0, width);
+}
+
+#endif
+
+} // namespace detail
+
+/**
+ * RGBA8 -> YUV420 planar (BT.601 limited range)，色度取 2x2 块平均
+ * src_stride 可以为负数，用于直接转换 OpenGL 自下而上的回读数据
+ * width / height 需为偶数
+ */
+inline void rgba_to_yuv420(
+    const uint8_t *src,
+    std::ptrdiff_t src_stride,
+    size_t width,
+    size_t height,
+    const Yuv420View &dst)
+{
+    for (size_t row{}; row + 1 < height; row += 2) {
+        const uint8_t *row0{src + static_cast<std::ptrdiff_t>(row) * src_stride};
+        const uint8_t *row1{row0 + src_stride};
+        detail::rgba_to_yuv420_rows(
+            row0, row1,
+            dst.y + row * width,
+            dst.y + (row + 1) * width,
+            dst.u + row / 2 * (width / 2),
+            dst.v + row / 2 * (width / 2),
+            width);
+    }
+}
+
+} // namespace Image
@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "image/asset_pack.hpp"
+
+/**
+ * Image::write_asset_pack 写出的包由 Image::AssetPack 读回，内容逐字节一致：
+ * 空文件、随机（不可压缩）、可压缩、恰好 4096 / 块大小整数倍的条目，压缩与不压缩两种方式
+ */
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr size_t PACK_CHUNK_BYTES{Image::PACK_DEFAULT_CHUNK_BYTES};
+
+void check(bool condition, std::string_view what)
+{
+    if (!condition) {
+        throw std::runtime_error{std::format("ERROR::ASSET_PACK_TEST what:{}", what)};
+    }
+}
+
+std::vector<std::byte> random_bytes(size_t size, uint32_t seed)
+{
+    std::mt19937 random{seed};
+    std::vector<std::byte> bytes(size);
+    for (auto &byte : bytes) {
+        byte = static_cast<std::byte>(random());
+    }
+    return bytes;
+}
+
+std::vector<std::byte> compressible_bytes(size_t size, uint32_t seed)
+{
+    std::mt19937 random{seed};
+    std::vector<std::byte> bytes(size);
+    for (size_t i{}; i < size; ++i) {
+        bytes[i] = static_cast<std::byte>(i / 13 % 40 + (0 == random() % 8 ? random() % 100 : 0));
+    }
+    return bytes;
+}
+
+// 测试期间的临时目录，结束时删除
+class TempDir
+{
+public:
+    TempDir() : path_{fs::temp_directory_path() / std::format("asset_pack_test_{}", std::random_device{}())} {
+        fs::create_directories(path_);
+    }
+    ~TempDir() {
+        std::error_code error;
+        fs::remove_all(path_, error);
+    }
+    TempDir(const TempDir &) = delete;
+    TempDir(TempDir &&) = delete;
+    TempDir &operator=(const TempDir &) = delete;
+    TempDir &operator=(TempDir &&) = delete;
+
+    const fs::path &path() const { return path_; }
+
+private:
+    fs::path path_;
+};
+
+struct Asset
+{
+    std::string name;
+    std::vector<std::byte> bytes;
+};
+
+std::vector<Asset> make_assets()
+{
+    std::vector<Asset> assets;
+    assets.push_back({"empty.bin", {}});
+    assets.push_back({"one.bin", random_bytes(1, 1)});
+    assets.push_back({"shader/vertex.glsl", compressible_bytes(3'000, 2)});
+    assets.push_back({"random.bin", random_bytes(100'003, 3)});
+    assets.push_back({"aligned/page.bin", compressible_bytes(4096, 4)});
+    assets.push_back({"aligned/random_page.bin", random_bytes(4096, 5)});
+    assets.push_back({"aligned/chunk.bin", compressible_bytes(PACK_CHUNK_BYTES, 6)});
+    assets.push_back({"aligned/chunks.bin", compressible_bytes(4 * PACK_CHUNK_BYTES, 7)});
+    assets.push_back({"chunks_plus_one.bin", compressible_bytes(3 * PACK_CHUNK_BYTES + 1, 8)});
+    // 2 MiB 以上的条目并行解压
+    assets.push_back({"large.bin", compressible_bytes(5 * 1024 * 1024, 9)});
+    return assets;
+}
+
+void write_file(const fs::path &path, std::span<const std::byte> bytes)
+{
+    fs::create_directories(path.parent_path());
+    std::ofstream file{path, std::ios::binary};
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    check(static_cast<bool>(file), std::format("write {}", path.string()));
+}
+
+void round_trip(const TempDir &dir, const std::vector<Asset> &assets, const Image::AssetPackOptions &options, std::string_view what)
+{
+    std::vector<Image::AssetSource> sources;
+    for (const auto &asset : assets) {
+        const auto file{dir.path() / "input" / asset.name};
+        write_file(file, asset.bytes);
+        sources.push_back({asset.name, file});
+    }
+    const auto pack_path{dir.path() / std::format("{}.pak", what)};
+    const auto summary{Image::write_asset_pack(pack_path, sources, options)};
+    check(assets.size() == summary.entries, std::format("{}: every asset is written", what));
+    check(options.compress || 0 == summary.compressed, std::format("{}: nothing is compressed when disabled", what));
+    check(fs::file_size(pack_path) == summary.file_bytes, std::format("{}: summary matches the file size", what));
+
+    const Image::AssetPack pack{pack_path};
+    check(assets.size() == pack.size(), std::format("{}: entry count", what));
+    for (const auto &asset : assets) {
+        const auto *entry{pack.find(asset.name)};
+        check(nullptr != entry, std::format("{}: {} is found", what, asset.name));
+        check(0 == entry->offset % Image::PACK_ENTRY_ALIGNMENT, std::format("{}: {} starts on a page", what, asset.name));
+
+        const auto bytes{pack.load(*entry)};
+        check(std::ranges::equal(bytes.bytes(), asset.bytes), std::format("{}: {} round trips", what, asset.name));
+        if (Image::PackCompression::None == entry->compression) {
+            // 映射从页边界开始，未压缩条目直接指向映射内存，对齐保持不变
+            check(asset.bytes.empty() || bytes.mapped(), std::format("{}: {} is not copied", what, asset.name));
+            check(0 == reinterpret_cast<std::uintptr_t>(bytes.data()) % Image::PACK_ENTRY_ALIGNMENT || asset.bytes.empty(),
+                std::format("{}: {} is page aligned in memory", what, asset.name));
+        }
+
+        std::vector<std::byte> out(asset.bytes.size());
+        pack.decompress(*entry, out);
+        check(std::ranges::equal(out, asset.bytes), std::format("{}: {} decompresses into a caller buffer", what, asset.name));
+    }
+
+    // 名字在查找前规范化
+    check(pack.contains("./shader\\vertex.glsl"), std::format("{}: lookup normalizes the path", what));
+    check(!pack.contains("missing.bin") && !pack.load("missing.bin"), std::format("{}: missing asset", what));
+    std::vector<std::byte> wrong(1);
+    check(!assets[3].bytes.empty(), "random asset is not empty");
+    bool rejected{false};
+    try {
+        pack.decompress(*pack.find(assets[3].name), wrong);
+    }
+    catch (const std::runtime_error &) {
+        rejected = true;
+    }
+    check(rejected, std::format("{}: wrong output size is rejected", what));
+}
+
+void compressed_pack(const TempDir &dir)
+{
+    const auto assets{make_assets()};
+    round_trip(dir, assets, {}, "compressed");
+
+    const Image::AssetPack pack{dir.path() / "compressed.pak"};
+    check(Image::PackCompression::None == pack.find("random.bin")->compression, "incompressible data is stored raw");
+    check(Image::PackCompression::Lz == pack.find("aligned/chunks.bin")->compression, "compressible data is compressed");
+    check(Image::PackCompression::Lz == pack.find("large.bin")->compression, "large data is compressed");
+}
+
+void small_chunks(const TempDir &dir)
+{
+    // 块大小 4096：页大小的条目恰好一块，随机数据的块原样存放
+    auto assets{make_assets()};
+    auto mixed{compressible_bytes(8 * 4096, 10)};
+    const auto noise{random_bytes(4096, 11)};
+    std::ranges::copy(noise, mixed.begin() + 3 * 4096);
+    assets.push_back({"mixed.bin", std::move(mixed)});
+    round_trip(dir, assets, {.compress = true, .chunk_bytes = 4096, .min_saving = 0.0}, "small_chunks");
+}
+
+void uncompressed_pack(const TempDir &dir)
+{
+    round_trip(dir, make_assets(), {.compress = false}, "uncompressed");
+}
+
+void invalid_packs(const TempDir &dir)
+{
+    const auto expect_error = [](auto &&fn, std::string_view what) {
+        try {
+            fn();
+        }
+        catch (const std::runtime_error &) {
+            return;
+        }
+        check(false, what);
+    };
+
+    const auto file{dir.path() / "input" / "one.bin"};
+    const std::vector<Image::AssetSource> duplicate{{"a/one.bin", file}, {"./a/one.bin", file}};
+    expect_error([&] { Image::write_asset_pack(dir.path() / "duplicate.pak", duplicate); }, "duplicate names are rejected");
+
+    // 截断的包在打开时失败
+    const auto pack_path{dir.path() / "compressed.pak"};
+    const auto truncated{dir.path() / "truncated.pak"};
+    fs::copy_file(pack_path, truncated, fs::copy_options::overwrite_existing);
+    fs::resize_file(truncated, fs::file_size(pack_path) / 2);
+    expect_error([&] { Image::AssetPack{truncated}; }, "truncated pack is rejected");
+
+    const auto not_pack{dir.path() / "not_pack.pak"};
+    write_file(not_pack, random_bytes(100, 12));
+    expect_error([&] { Image::AssetPack{not_pack}; }, "random file is rejected");
+}
+
+} // namespace
+
+int main()
+{
+    try {
+        const TempDir dir;
+        compressed_pack(dir);
+        small_chunks(dir);
+        uncompressed_pack(dir);
+        invalid_packs(dir);
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    std::printf("asset_pack_test: passed\n");
+    return 0;
+}
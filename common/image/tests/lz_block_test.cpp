@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <format>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "image/lz_block.hpp"
+
+/**
+ * Image::lz_compress / lz_decompress 往返：空输入、随机（不可压缩）、重复（重叠匹配）、按 4096 对齐的大小，
+ * 以及损坏或大小不符的输入返回 false
+ */
+
+namespace {
+
+void check(bool condition, std::string_view what)
+{
+    if (!condition) {
+        throw std::runtime_error{std::format("ERROR::LZ_BLOCK_TEST what:{}", what)};
+    }
+}
+
+std::vector<uint8_t> random_bytes(size_t size, uint32_t seed)
+{
+    std::mt19937 random{seed};
+    std::vector<uint8_t> bytes(size);
+    for (auto &byte : bytes) {
+        byte = static_cast<uint8_t>(random());
+    }
+    return bytes;
+}
+
+// 短重复加少量噪声，与图片、网格数据类似
+std::vector<uint8_t> compressible_bytes(size_t size, uint32_t seed)
+{
+    std::mt19937 random{seed};
+    std::vector<uint8_t> bytes(size);
+    for (size_t i{}; i < size; ++i) {
+        bytes[i] = static_cast<uint8_t>(i / 7 % 50 + (0 == random() % 4 ? random() % 200 : 0));
+    }
+    return bytes;
+}
+
+void round_trip(std::span<const uint8_t> raw, std::string_view what)
+{
+    const auto compressed{Image::lz_compress(raw)};
+    check(compressed.size() <= Image::lz_compress_bound(raw.size()), std::format("{} ({} bytes) fits the bound", what, raw.size()));
+    std::vector<uint8_t> out(raw.size(), 0xCD);
+    check(Image::lz_decompress(compressed, out), std::format("{} ({} bytes) decompresses", what, raw.size()));
+    check(std::ranges::equal(raw, out), std::format("{} ({} bytes) round trips", what, raw.size()));
+}
+
+void empty_input()
+{
+    const auto compressed{Image::lz_compress({})};
+    check(!compressed.empty(), "empty input still has a token");
+    check(Image::lz_decompress(compressed, {}), "empty input decompresses");
+    std::vector<uint8_t> out(1);
+    check(!Image::lz_decompress(compressed, out), "size mismatch is rejected");
+}
+
+// 小于最小匹配与结尾字面量约定的长度
+void short_inputs()
+{
+    for (size_t size{1}; size <= 64; ++size) {
+        round_trip(random_bytes(size, static_cast<uint32_t>(size)), "short random");
+        round_trip(std::vector<uint8_t>(size, 0x5A), "short run");
+    }
+}
+
+void incompressible()
+{
+    for (const size_t size : {size_t{100}, size_t{4095}, size_t{65'537}, size_t{1 << 20}}) {
+        const auto raw{random_bytes(size, 7)};
+        round_trip(raw, "random");
+        check(Image::lz_compress(raw).size() > raw.size(), "random data does not shrink");
+    }
+}
+
+void compressible()
+{
+    for (const size_t size : {size_t{13}, size_t{1000}, size_t{70'001}, size_t{1 << 20}}) {
+        const auto raw{compressible_bytes(size, 11)};
+        round_trip(raw, "compressible");
+    }
+    // 偏移 1、长度很长的匹配需要逐字节复制，并用到多个 255 的长度扩展字节
+    const std::vector<uint8_t> zeros(300'000, 0);
+    round_trip(zeros, "zeros");
+    check(Image::lz_compress(zeros).size() < 2'000, "zeros compress well");
+    // 超过 65535 的偏移不能引用
+    auto far{random_bytes(70'000, 3)};
+    far.insert(far.end(), far.begin(), far.begin() + 70'000);
+    round_trip(far, "repeat beyond the maximum offset");
+}
+
+// 恰好是 4096 / 64 KiB（资源包的块大小）的整数倍
+void aligned_sizes()
+{
+    for (const size_t size : {size_t{4096}, size_t{8192}, size_t{64 * 1024}, size_t{256 * 1024}}) {
+        round_trip(random_bytes(size, 5), "aligned random");
+        round_trip(compressible_bytes(size, 5), "aligned compressible");
+        round_trip(std::vector<uint8_t>(size, 0xFF), "aligned run");
+    }
+}
+
+void corrupted_input()
+{
+    const auto raw{compressible_bytes(10'000, 13)};
+    const auto compressed{Image::lz_compress(raw)};
+    std::vector<uint8_t> out(raw.size());
+    for (size_t cut{}; cut < compressed.size(); cut += 97) {
+        check(!Image::lz_decompress(std::span{compressed}.first(cut), out), std::format("input truncated to {} is rejected", cut));
+    }
+    std::vector<uint8_t> small(raw.size() - 1);
+    check(!Image::lz_decompress(compressed, small), "too small output is rejected");
+    std::vector<uint8_t> large(raw.size() + 1);
+    check(!Image::lz_decompress(compressed, large), "too large output is rejected");
+
+    // 随机改写的字节不能导致越界（在 ASan 下运行），结果可以是 true 或 false
+    std::mt19937 random{17};
+    for (int round{}; round < 2'000; ++round) {
+        auto damaged{compressed};
+        damaged[random() % damaged.size()] = static_cast<uint8_t>(random());
+        static_cast<void>(Image::lz_decompress(damaged, out));
+    }
+}
+
+} // namespace
+
+int main()
+{
+    try {
+        empty_input();
+        short_inputs();
+        incompressible();
+        compressible();
+        aligned_sizes();
+        corrupted_input();
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    std::printf("lz_block_test: passed\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace Jobs {
+
+inline constexpr size_t CACHE_LINE{64};
+
+/**
+ * Chase-Lev 工作窃取双端队列（Lê et al. 2013 的 C11 内存序版本）
+ *
+ * 只有所有者线程调用 push() / pop()，从底部进出（后进先出，缓存局部性好）；
+ * 其他线程调用 steal() 从顶部取（先进先出，偷走的多是较大的任务）。
+ * 满时所有者把环形数组扩大一倍；旧数组保留到队列销毁，窃取者可能仍在读取它。
+ * T 须可平凡复制（通常是指针）。
+ */
+template <class T>
+class ChaseLevDeque
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    explicit ChaseLevDeque(size_t capacity = 256) {
+        size_t size{1};
+        while (size < capacity) {
+            size <<= 1;
+        }
+        arrays_.push_back(std::make_unique<Array>(size));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+    ~ChaseLevDeque() = default;
+    ChaseLevDeque(const ChaseLevDeque &) = delete;
+    ChaseLevDeque(ChaseLevDeque &&) = delete;
+    ChaseLevDeque &operator=(const ChaseLevDeque &) = delete;
+    ChaseLevDeque &operator=(ChaseLevDeque &&) = delete;
+
+    // 所有者线程
+    void push(T value) {
+        const int64_t bottom{bottom_.load(std::memory_order_relaxed)};
+        const int64_t top{top_.load(std::memory_order_acquire)};
+        Array *array{array_.load(std::memory_order_relaxed)};
+        if (bottom - top >= array->capacity()) {
+            array = grow(array, top, bottom);
+        }
+        array->store(bottom, value);
+        // release 使元素（以及它指向的内容）对 steal() 中 acquire 读到新 bottom 的线程可见
+        bottom_.store(bottom + 1, std::memory_order_release);
+    }
+
+    // 所有者线程
+    std::optional<T> pop() {
+        const int64_t bottom{bottom_.load(std::memory_order_relaxed) - 1};
+        Array *array{array_.load(std::memory_order_relaxed)};
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top{top_.load(std::memory_order_relaxed)};
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        const T value{array->load(bottom)};
+        if (top == bottom) {
+            // 只剩最后一个，与窃取者竞争
+            const bool won{top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)};
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            if (!won) {
+                return std::nullopt;
+            }
+        }
+        return value;
+    }
+
+    // 任意线程；与其他窃取者或所有者竞争失败时返回空
+    std::optional<T> steal() {
+        int64_t top{top_.load(std::memory_order_acquire)};
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom{bottom_.load(std::memory_order_acquire)};
+        if (top >= bottom) {
+            return std::nullopt;
+        }
+        const Array *array{array_.load(std::memory_order_acquire)};
+        const T value{array->load(top)};
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    // 近似值，只用于统计与调度提示
+    size_t size() const {
+        const int64_t bottom{bottom_.load(std::memory_order_relaxed)};
+        const int64_t top{top_.load(std::memory_order_relaxed)};
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+private:
+    class Array
+    {
+    public:
+        explicit Array(size_t capacity) : mask_{capacity - 1}, slots_{std::make_unique<std::atomic<T>[]>(capacity)} {}
+
+        int64_t capacity() const { return static_cast<int64_t>(mask_ + 1); }
+        T load(int64_t index) const { return slots_[static_cast<size_t>(index) & mask_].load(std::memory_order_relaxed); }
+        void store(int64_t index, T value) { slots_[static_cast<size_t>(index) & mask_].store(value, std::memory_order_relaxed); }
+
+    private:
+        size_t mask_;
+        std::unique_ptr<std::atomic<T>[]> slots_;
+    };
+
+    Array *grow(const Array *old, int64_t top, int64_t bottom) {
+        auto array{std::make_unique<Array>(static_cast<size_t>(old->capacity()) * 2)};
+        for (int64_t i{top}; i < bottom; ++i) {
+            array->store(i, old->load(i));
+        }
+        arrays_.push_back(std::move(array));
+        array_.store(arrays_.back().get(), std::memory_order_release);
+        return arrays_.back().get();
+    }
+
+    alignas(CACHE_LINE) std::atomic<int64_t> top_{0};
+    alignas(CACHE_LINE) std::atomic<int64_t> bottom_{0};
+    alignas(CACHE_LINE) std::atomic<Array *> array_{nullptr};
+    std::vector<std::unique_ptr<Array>> arrays_{};      // 仅所有者线程修改
+};
+
+} // namespace Jobs
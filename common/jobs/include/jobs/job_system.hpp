@@ -0,0 +1,448 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#include "jobs/chase_lev_deque.hpp"
+#include "profiler/profiler.hpp"
+
+namespace Jobs {
+
+class JobSystem;
+
+/**
+ * 一组任务的完成计数
+ * JobSystem::wait() 在计数归零前帮助执行任务，有任务抛出异常时在 wait() 中重新抛出第一个，之后可以复用
+ */
+class Counter
+{
+public:
+    Counter() = default;
+    ~Counter() = default;
+    Counter(const Counter &) = delete;
+    Counter(Counter &&) = delete;
+    Counter &operator=(const Counter &) = delete;
+    Counter &operator=(Counter &&) = delete;
+
+    bool done() const { return 0 == pending_.load(std::memory_order_acquire); }
+
+private:
+    friend class JobSystem;
+
+    void fail(std::exception_ptr error) {
+        bool expected{false};
+        // error_ 在 complete() 的 release 之前写入，wait() 读到 0 之后可见
+        if (failed_.compare_exchange_strong(expected, true, std::memory_order_relaxed)) {
+            error_ = std::move(error);
+        }
+    }
+
+    std::atomic<size_t> pending_{0};
+    std::atomic<bool> failed_{false};
+    std::exception_ptr error_{};
+};
+
+/**
+ * 一个任务，执行前后不移动；name 必须是字符串常量（PROFILE_SCOPE 的 zone 名）
+ * 由调用者持有的 Job 可以反复提交（TaskGraph、parallel_for），每帧不再分配；
+ * 执行不修改 Job，同一个 Job 也可以同时提交多次，此时 work 须可并发调用
+ */
+struct Job
+{
+    const char *name{};
+    std::function<void()> work{};
+    Counter *counter{};
+    bool owned{false};              // 由 JobSystem 分配，执行后释放
+};
+
+struct JobSystemStats
+{
+    uint64_t executed{};
+    uint64_t stolen{};              // 从其他线程的队列中取得
+    uint64_t injected{};            // 由不属于 JobSystem 的线程提交
+    uint64_t sleeps{};              // 工作线程找不到任务而休眠的次数
+
+    std::string to_string() const {
+        return std::format("{} executed, {} stolen, {} injected, {} sleeps", executed, stolen, injected, sleeps);
+    }
+};
+
+/**
+ * 工作窃取任务系统
+ *
+ * 每个线程（构造它的线程与各工作线程）有一个 ChaseLevDeque：新任务压入自己队列的底部，
+ * 执行时先从自己的底部取（刚产生的数据还在缓存里），没有时从随机一个其他线程的顶部窃取。
+ * 其他线程（如加载线程）提交的任务进入一个加锁的注入队列。
+ * 构造的线程不常驻执行任务，只在 wait() 中参与，因此工作线程默认比硬件线程少一个。
+ * 工作线程空闲时先自旋，再在原子量上休眠，有新任务时唤醒。
+ */
+class JobSystem
+{
+public:
+    // workers 为 0 时使用 hardware_concurrency - 1 个工作线程
+    explicit JobSystem(size_t workers = 0) {
+        if (0 == workers) {
+            workers = std::max<size_t>(1, std::thread::hardware_concurrency()) - 1;
+        }
+        for (size_t i{}; i <= workers; ++i) {
+            threads_.push_back(std::make_unique<ThreadState>());
+        }
+        current() = {this, 0};
+        for (size_t i{1}; i <= workers; ++i) {
+            workers_.emplace_back([this, i](std::stop_token token) { worker_loop(i, token); });
+        }
+    }
+    ~JobSystem() {
+        for (auto &worker : workers_) {
+            worker.request_stop();
+        }
+        epoch_.fetch_add(1, std::memory_order_release);
+        epoch_.notify_all();
+        workers_.clear();
+        if (this == current().system) {
+            current() = {};
+        }
+        // 未执行的任务直接丢弃
+        for (auto &thread : threads_) {
+            while (const auto job{thread->deque.pop()}) {
+                release(**job);
+            }
+        }
+        for (Job *job : injected_) {
+            release(*job);
+        }
+    }
+    JobSystem(const JobSystem &) = delete;
+    JobSystem(JobSystem &&) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+    JobSystem &operator=(JobSystem &&) = delete;
+
+    // 包括构造的线程
+    size_t thread_count() const { return threads_.size(); }
+
+    // 提交 job，执行完之前它须保持有效；可在任意线程调用
+    void run(Job &job) {
+        job.counter->pending_.fetch_add(1, std::memory_order_relaxed);
+        push(&job);
+    }
+
+    // 提交一个由 JobSystem 分配的任务，name 必须是字符串常量
+    void run(const char *name, std::function<void()> work, Counter &counter) {
+        run(*new Job{name, std::move(work), &counter, true});
+    }
+
+    // 执行其他任务直到 counter 归零，之后重新抛出其中第一个异常
+    void wait(Counter &counter) {
+        const size_t index{current_index()};
+        uint32_t idle{};
+        while (!counter.done()) {
+            if (Job *job{find(index)}; nullptr != job) {
+                execute(*job, index);
+                idle = 0;
+                continue;
+            }
+            backoff(idle);
+        }
+        if (counter.failed_.exchange(false, std::memory_order_relaxed)) {
+            std::rethrow_exception(std::exchange(counter.error_, nullptr));
+        }
+    }
+
+    // 执行一个排队的任务，没有任务时返回 false；没有工作线程时调用者借此推进不等待计数的任务
+    bool help() {
+        const size_t index{current_index()};
+        if (Job *job{find(index)}; nullptr != job) {
+            execute(*job, index);
+            return true;
+        }
+        return false;
+    }
+
+    JobSystemStats stats() const {
+        JobSystemStats stats{};
+        for (const auto &thread : threads_) {
+            stats.executed += thread->executed.load(std::memory_order_relaxed);
+            stats.stolen += thread->stolen.load(std::memory_order_relaxed);
+        }
+        stats.executed += external_executed_.load(std::memory_order_relaxed);
+        stats.injected = injected_total_.load(std::memory_order_relaxed);
+        stats.sleeps = sleeps_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    static constexpr size_t NO_THREAD{static_cast<size_t>(-1)};
+    static constexpr uint32_t SPIN_ROUNDS{64};
+
+    struct ThreadState
+    {
+        ChaseLevDeque<Job *> deque{};
+        // 只由所属线程写入
+        alignas(CACHE_LINE) std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+    };
+
+    struct Binding
+    {
+        JobSystem *system{};
+        size_t index{};
+    };
+
+    static Binding &current() {
+        thread_local Binding binding{};
+        return binding;
+    }
+
+    size_t current_index() const {
+        const auto &binding{current()};
+        return this == binding.system ? binding.index : NO_THREAD;
+    }
+
+    static uint32_t random() {
+        thread_local uint32_t state{static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1u};
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    static void pause() {
+#if defined(__x86_64__) || defined(_M_X64)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    static void backoff(uint32_t &idle) {
+        if (++idle < SPIN_ROUNDS) {
+            pause();
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+
+    static void release(Job &job) {
+        if (job.owned) {
+            delete &job;
+        }
+    }
+
+    void push(Job *job) {
+        if (const size_t index{current_index()}; NO_THREAD != index) {
+            threads_[index]->deque.push(job);
+        }
+        else {
+            const std::lock_guard lock{injected_mutex_};
+            injected_.push_back(job);
+            injected_size_.fetch_add(1, std::memory_order_release);
+            injected_total_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // 与 worker_loop 中休眠前的检查配对：要么这里看到休眠的线程并唤醒它，要么它在休眠前找到这个任务
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed) > 0) {
+            epoch_.fetch_add(1, std::memory_order_release);
+            epoch_.notify_one();
+        }
+    }
+
+    Job *find(size_t index) {
+        if (NO_THREAD != index) {
+            if (const auto job{threads_[index]->deque.pop()}) {
+                return *job;
+            }
+        }
+        if (injected_size_.load(std::memory_order_acquire) > 0) {
+            const std::lock_guard lock{injected_mutex_};
+            if (!injected_.empty()) {
+                Job *job{injected_.front()};
+                injected_.pop_front();
+                injected_size_.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+        // 从随机位置开始依次尝试，避免所有线程同时窃取同一个队列
+        const size_t count{threads_.size()};
+        const size_t start{random() % count};
+        for (size_t i{}; i < count; ++i) {
+            const size_t victim{(start + i) % count};
+            if (victim == index) {
+                continue;
+            }
+            if (const auto job{threads_[victim]->deque.steal()}) {
+                if (NO_THREAD != index) {
+                    threads_[index]->stolen.fetch_add(1, std::memory_order_relaxed);
+                }
+                return *job;
+            }
+        }
+        return nullptr;
+    }
+
+    void execute(Job &job, size_t index) {
+        // complete 之后 job 可能已被提交者销毁或重新提交，先取出需要的字段
+        Counter &counter{*job.counter};
+        try {
+            PROFILE_SCOPE(job.name);
+            job.work();
+        }
+        catch (...) {
+            counter.fail(std::current_exception());
+        }
+        release(job);
+        if (NO_THREAD != index) {
+            threads_[index]->executed.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            external_executed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        counter.pending_.fetch_sub(1, std::memory_order_release);
+    }
+
+    void worker_loop(size_t index, std::stop_token token) {
+        PROFILE_THREAD_NAME("job worker");
+        current() = {this, index};
+        uint32_t idle{};
+        while (!token.stop_requested()) {
+            if (Job *job{find(index)}; nullptr != job) {
+                execute(*job, index);
+                idle = 0;
+                continue;
+            }
+            if (++idle < SPIN_ROUNDS) {
+                pause();
+                continue;
+            }
+            sleeping_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto epoch{epoch_.load(std::memory_order_acquire)};
+            Job *job{find(index)};
+            if (nullptr == job && !token.stop_requested()) {
+                sleeps_.fetch_add(1, std::memory_order_relaxed);
+                epoch_.wait(epoch, std::memory_order_acquire);
+            }
+            sleeping_.fetch_sub(1, std::memory_order_relaxed);
+            if (nullptr != job) {
+                execute(*job, index);
+            }
+            idle = 0;
+        }
+    }
+
+    std::vector<std::unique_ptr<ThreadState>> threads_{};
+    std::mutex injected_mutex_{};
+    std::deque<Job *> injected_{};
+    alignas(CACHE_LINE) std::atomic<size_t> injected_size_{0};
+    std::atomic<uint64_t> injected_total_{0};
+    std::atomic<uint64_t> external_executed_{0};
+    alignas(CACHE_LINE) std::atomic<uint32_t> sleeping_{0};
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint64_t> sleeps_{0};
+    std::vector<std::jthread> workers_{};       // 最后声明，析构时先停止
+};
+
+/**
+ * 把 [0, count) 按 grain 个一块，fn(begin, end) 在调用线程与工作线程上并行执行，返回时全部完成
+ * 参与的线程从共享的原子下标领取下一块，快的线程多做；只有一块时直接在调用线程执行。
+ * fn 抛出异常时仍等待其余块结束，再抛出第一个异常
+ */
+template <class Fn>
+void parallel_for(JobSystem &jobs, const char *name, size_t count, size_t grain, Fn &&fn)
+{
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks{count / grain + (0 == count % grain ? 0 : 1)};
+    if (chunks <= 1 || 1 == jobs.thread_count()) {
+        if (count > 0) {
+            PROFILE_SCOPE(name);
+            fn(size_t{0}, count);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    const auto drain{[&] {
+        for (size_t begin{next.fetch_add(grain, std::memory_order_relaxed)}; begin < count;
+             begin = next.fetch_add(grain, std::memory_order_relaxed)) {
+            fn(begin, std::min(begin + grain, count));
+        }
+    }};
+    Counter counter;
+    // 同一个栈上的 Job 提交给每个参与的线程，只捕获一个引用，std::function 不需要分配
+    Job helper{name, [&drain] { drain(); }, &counter};
+    for (size_t i{1}; i < std::min(chunks, jobs.thread_count()); ++i) {
+        jobs.run(helper);
+    }
+
+    std::exception_ptr error;
+    try {
+        PROFILE_SCOPE(name);
+        drain();
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    // helpers 与 drain 引用本函数的栈，须等它们结束
+    jobs.wait(counter);
+    if (nullptr != error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * 按缓存行切分 items 后并行执行 fn(std::span<T> chunk, size_t first)，first 为 chunk 在 items 中的下标
+ * 除首尾两块外，每块起止都在缓存行边界上，不同线程写入的元素不会落在同一缓存行（伪共享）；
+ * 块数约为线程数的 4 倍以平衡负载，每块至少 min_bytes，总量不足两块时直接在调用线程执行
+ */
+template <class T, class Fn>
+void parallel_for(JobSystem &jobs, const char *name, std::span<T> items, Fn &&fn, size_t min_bytes = 16 * 1024)
+{
+    if (items.empty()) {
+        return;
+    }
+    // 块的元素数是 unit 的整数倍时，块的字节数是缓存行的整数倍
+    const size_t unit{CACHE_LINE / std::gcd(CACHE_LINE, sizeof(T))};
+    // 第一个起始于缓存行边界的元素，之前的元素并入第一块
+    const auto address{reinterpret_cast<std::uintptr_t>(items.data())};
+    size_t head{};
+    while (head < unit && head < items.size() && 0 != (address + head * sizeof(T)) % CACHE_LINE) {
+        ++head;
+    }
+    if (unit == head) {
+        head = 0;
+    }
+
+    const size_t target{jobs.thread_count() * 4};
+    size_t grain{std::max((items.size() + target - 1) / target, (min_bytes + sizeof(T) - 1) / sizeof(T))};
+    grain = (grain + unit - 1) / unit * unit;
+    if (items.size() - head <= grain) {
+        PROFILE_SCOPE(name);
+        fn(items, size_t{0});
+        return;
+    }
+    parallel_for(jobs, name, items.size() - head, grain, [&](size_t begin, size_t end) {
+        const size_t first{0 == begin ? 0 : head + begin};
+        fn(items.subspan(first, head + end - first), first);
+    });
+}
+
+} // namespace Jobs
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <format>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "jobs/job_system.hpp"
+
+namespace Jobs {
+
+/**
+ * 可重复执行的任务依赖图
+ *
+ * add() 声明节点与依赖，run() 把无依赖的节点交给 JobSystem；节点结束时，依赖已全部完成的后继压入
+ * 执行它的线程自己的队列，接着在同一线程执行（前驱写入的数据还在缓存里），调用线程参与执行直到全部完成。
+ * 图构建一次后可每帧 run()，不再分配；场景结构变化时 clear() 后重新构建。
+ *
+ * name 必须是字符串常量；任一节点抛出异常后其余节点不再执行，run() 结束时重新抛出第一个异常。
+ */
+class TaskGraph
+{
+public:
+    using NodeId = size_t;
+
+    TaskGraph() = default;
+    ~TaskGraph() = default;
+    TaskGraph(const TaskGraph &) = delete;
+    TaskGraph(TaskGraph &&) = delete;
+    TaskGraph &operator=(const TaskGraph &) = delete;
+    TaskGraph &operator=(TaskGraph &&) = delete;
+
+    // dependencies 只能是已添加的节点，因此图中不会有环
+    NodeId add(const char *name, std::function<void()> work, std::vector<NodeId> dependencies = {}) {
+        const NodeId id{nodes_.size()};
+        for (const NodeId dependency : dependencies) {
+            if (dependency >= id) {
+                throw std::runtime_error{std::format("ERROR::JOBS what:{} depends on unknown node {}", name, dependency)};
+            }
+        }
+        auto &node{nodes_.emplace_back()};
+        node.work = std::move(work);
+        node.dependencies = dependencies.size();
+        node.job = Job{name, [this, id] { execute(id); }, &counter_};
+        for (const NodeId dependency : dependencies) {
+            nodes_[dependency].dependents.push_back(id);
+        }
+        return id;
+    }
+
+    void clear() { nodes_.clear(); }
+    size_t size() const { return nodes_.size(); }
+
+    // 不能与同一个图的另一次 run() 同时进行
+    void run(JobSystem &jobs) {
+        if (nodes_.empty()) {
+            return;
+        }
+        jobs_ = &jobs;
+        failed_.store(false, std::memory_order_relaxed);
+        for (auto &node : nodes_) {
+            node.pending.store(node.dependencies, std::memory_order_relaxed);
+        }
+        for (auto &node : nodes_) {
+            if (0 == node.dependencies) {
+                jobs.run(node.job);
+            }
+        }
+        jobs.wait(counter_);
+    }
+
+private:
+    struct Node
+    {
+        std::function<void()> work{};
+        std::vector<NodeId> dependents{};
+        size_t dependencies{};
+        std::atomic<size_t> pending{0};     // 本次 run() 中未完成的依赖数
+        Job job{};
+    };
+
+    void execute(NodeId id) {
+        auto &node{nodes_[id]};
+        // 出错后只释放后继，保证计数归零
+        if (!failed_.load(std::memory_order_relaxed)) {
+            try {
+                node.work();
+            }
+            catch (...) {
+                failed_.store(true, std::memory_order_relaxed);
+                // 由 JobSystem 记录在 counter_ 中，wait() 时重新抛出
+                release_dependents(node);
+                throw;
+            }
+        }
+        release_dependents(node);
+    }
+
+    void release_dependents(Node &node) {
+        for (const NodeId dependent : node.dependents) {
+            if (1 == nodes_[dependent].pending.fetch_sub(1, std::memory_order_acq_rel)) {
+                jobs_->run(nodes_[dependent].job);
+            }
+        }
+    }
+
+    std::deque<Node> nodes_{};      // 添加节点时已有元素的地址不变，Job 指向其中
+    Counter counter_{};
+    std::atomic<bool> failed_{false};
+    JobSystem *jobs_{};
+};
+
+} // namespace Jobs
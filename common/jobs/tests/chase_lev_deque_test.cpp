@@ -0,0 +1,100 @@
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "jobs/chase_lev_deque.hpp"
+
+/**
+ * Jobs::ChaseLevDeque 在所有者 push / pop 与多个窃取者 steal 同时进行时，每个元素恰好被取出一次
+ */
+
+namespace {
+
+void check(bool condition, std::string_view what)
+{
+    if (!condition) {
+        throw std::runtime_error{std::format("ERROR::CHASE_LEV_DEQUE_TEST what:{}", what)};
+    }
+}
+
+// 单线程：底部后进先出，顶部先进先出，扩容后元素不丢失
+void owner_and_steal_order()
+{
+    Jobs::ChaseLevDeque<size_t> deque{2};
+    check(!deque.pop() && !deque.steal(), "empty deque returns nothing");
+    for (size_t i{}; i < 100; ++i) {
+        deque.push(i);
+    }
+    check(100 == deque.size(), "growth keeps every element");
+    check(99 == deque.pop(), "pop takes the newest");
+    check(0 == deque.steal(), "steal takes the oldest");
+    for (size_t i{98}; i >= 1; --i) {
+        check(i == deque.pop(), "pop order after growth");
+    }
+    check(!deque.pop() && !deque.steal(), "drained deque returns nothing");
+}
+
+// 所有者持续 push、间或 pop，三个窃取者同时 steal；容量很小，其间多次扩容
+void concurrent_take_exactly_once()
+{
+    constexpr size_t COUNT{200'000};
+    constexpr size_t THIEVES{3};
+    Jobs::ChaseLevDeque<size_t> deque{4};
+    std::vector<std::atomic<int>> taken(COUNT);
+    std::atomic<bool> done{false};
+    std::vector<std::jthread> thieves;
+    for (size_t t{}; t < THIEVES; ++t) {
+        thieves.emplace_back([&] {
+            while (!done.load(std::memory_order_acquire)) {
+                if (const auto value{deque.steal()}) {
+                    taken[*value].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    for (size_t i{}; i < COUNT; ++i) {
+        deque.push(i);
+        if (0 == i % 3) {
+            if (const auto value{deque.pop()}) {
+                taken[*value].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    while (const auto value{deque.pop()}) {
+        taken[*value].fetch_add(1, std::memory_order_relaxed);
+    }
+    // pop 与窃取者争最后一个失败时返回空，等窃取者取完
+    while (deque.size() > 0) {
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    thieves.clear();
+
+    for (size_t i{}; i < COUNT; ++i) {
+        check(1 == taken[i].load(std::memory_order_relaxed), std::format("element {} taken {} times", i, taken[i].load()));
+    }
+}
+
+} // namespace
+
+int main()
+{
+    try {
+        owner_and_steal_order();
+        for (int round{}; round < 4; ++round) {
+            concurrent_take_exactly_once();
+        }
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    std::printf("chase_lev_deque_test: passed\n");
+    return 0;
+}
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <format>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "jobs/job_system.hpp"
+#include "jobs/task_graph.hpp"
+
+/**
+ * Jobs::JobSystem、parallel_for 与 TaskGraph：结果与单线程一致、依赖顺序、异常传播与之后的复用
+ * 固定 3 个工作线程，单核机器上也有窃取与并发
+ */
+
+namespace {
+
+constexpr size_t WORKERS{3};
+
+void check(bool condition, std::string_view what)
+{
+    if (!condition) {
+        throw std::runtime_error{std::format("ERROR::JOB_SYSTEM_TEST what:{}", what)};
+    }
+}
+
+// 期望 fn 抛出 std::runtime_error，返回其 what()
+template <class Fn>
+std::string expect_error(Fn &&fn, std::string_view what)
+{
+    try {
+        fn();
+    }
+    catch (const std::runtime_error &error) {
+        return error.what();
+    }
+    check(false, what);
+    return {};
+}
+
+// 每个下标恰好处理一次，与单线程结果相同
+void parallel_for_matches_serial(Jobs::JobSystem &jobs)
+{
+    for (const size_t count : {size_t{0}, size_t{1}, size_t{7}, size_t{1000}, size_t{100'003}}) {
+        for (const size_t grain : {size_t{1}, size_t{10}, size_t{4096}}) {
+            std::vector<std::atomic<int>> hits(count);
+            Jobs::parallel_for(jobs, "test", count, grain, [&](size_t begin, size_t end) {
+                check(begin < end && end <= count && end - begin <= grain, "chunk bounds");
+                for (size_t i{begin}; i < end; ++i) {
+                    hits[i].fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+            for (size_t i{}; i < count; ++i) {
+                check(1 == hits[i].load(std::memory_order_relaxed), std::format("index {} of {} grain {}", i, count, grain));
+            }
+        }
+    }
+
+    // 元素大小不整除缓存行、起始不在缓存行边界上
+    struct Item
+    {
+        uint32_t value[3]{};
+    };
+    std::vector<Item> items(100'001);
+    for (const size_t offset : {size_t{0}, size_t{1}, size_t{5}}) {
+        for (const size_t min_bytes : {size_t{1}, size_t{1024}, size_t{16 * 1024}}) {
+            for (auto &item : items) {
+                item = {};
+            }
+            const auto span{std::span<Item>{items}.subspan(offset)};
+            Jobs::parallel_for(jobs, "test", span, [&](std::span<Item> chunk, size_t first) {
+                check(chunk.data() == span.data() + first, "chunk starts at first");
+                for (size_t i{}; i < chunk.size(); ++i) {
+                    chunk[i].value[0] += 1;
+                    chunk[i].value[1] = static_cast<uint32_t>(first + i);
+                }
+            }, min_bytes);
+            for (size_t i{}; i < span.size(); ++i) {
+                check(1 == span[i].value[0] && i == span[i].value[1], std::format("item {} offset {} min_bytes {}", i, offset, min_bytes));
+            }
+        }
+    }
+}
+
+// 一块抛出异常时等其余块结束后重新抛出；计数可以复用
+void parallel_for_exception(Jobs::JobSystem &jobs)
+{
+    for (int round{}; round < 100; ++round) {
+        std::atomic<size_t> done{0};
+        const auto what{expect_error([&] {
+            Jobs::parallel_for(jobs, "test", 1000, 10, [&](size_t begin, size_t) {
+                if (500 == begin) {
+                    throw std::runtime_error{"chunk failed"};
+                }
+                done.fetch_add(1, std::memory_order_relaxed);
+            });
+        }, "parallel_for rethrows")};
+        check("chunk failed" == what, "first exception is rethrown");
+        check(99 == done.load(std::memory_order_relaxed), "other chunks still run");
+    }
+
+    Jobs::Counter counter;
+    for (int round{}; round < 100; ++round) {
+        std::atomic<int> ran{0};
+        for (int i{}; i < 16; ++i) {
+            jobs.run("test", [&ran, i] {
+                ran.fetch_add(1, std::memory_order_relaxed);
+                if (3 == i) {
+                    throw std::runtime_error{"job failed"};
+                }
+            }, counter);
+        }
+        expect_error([&] { jobs.wait(counter); }, "wait rethrows");
+        check(16 == ran.load(std::memory_order_relaxed), "every job runs");
+        // 抛出后计数恢复，下一次 wait 不再抛出
+        jobs.run("test", [] {}, counter);
+        jobs.wait(counter);
+    }
+}
+
+// 其他线程提交的任务经注入队列执行
+void injected_jobs(Jobs::JobSystem &jobs)
+{
+    std::atomic<int> ran{0};
+    std::vector<std::jthread> threads;
+    for (int t{}; t < 3; ++t) {
+        threads.emplace_back([&] {
+            Jobs::Counter counter;
+            for (int i{}; i < 1000; ++i) {
+                jobs.run("test", [&ran] { ran.fetch_add(1, std::memory_order_relaxed); }, counter);
+            }
+            jobs.wait(counter);
+        });
+    }
+    threads.clear();
+    check(3000 == ran.load(std::memory_order_relaxed), "injected jobs run");
+}
+
+// 随机生成的图：节点执行时它的依赖在本帧都已结束，每帧每个节点执行一次
+void graph_dependency_order(Jobs::JobSystem &jobs)
+{
+    std::mt19937 random{20240601};
+    for (int shape{}; shape < 20; ++shape) {
+        const size_t count{std::uniform_int_distribution<size_t>{1, 200}(random)};
+        std::vector<std::atomic<uint64_t>> finished(count);
+        std::vector<std::vector<Jobs::TaskGraph::NodeId>> dependencies(count);
+        std::atomic<uint64_t> frame{0};
+        std::atomic<bool> ordered{true};
+
+        Jobs::TaskGraph graph;
+        for (size_t id{}; id < count; ++id) {
+            if (id > 0) {
+                const size_t edges{std::uniform_int_distribution<size_t>{0, std::min<size_t>(id, 4)}(random)};
+                for (size_t e{}; e < edges; ++e) {
+                    dependencies[id].push_back(std::uniform_int_distribution<size_t>{0, id - 1}(random));
+                }
+            }
+            graph.add("test", [&, id] {
+                const uint64_t current{frame.load(std::memory_order_relaxed)};
+                for (const auto dependency : dependencies[id]) {
+                    if (current != finished[dependency].load(std::memory_order_acquire)) {
+                        ordered.store(false, std::memory_order_relaxed);
+                    }
+                }
+                if (current - 1 != finished[id].load(std::memory_order_relaxed)) {
+                    ordered.store(false, std::memory_order_relaxed);
+                }
+                finished[id].store(current, std::memory_order_release);
+            }, dependencies[id]);
+        }
+
+        for (uint64_t i{1}; i <= 200; ++i) {
+            frame.store(i, std::memory_order_relaxed);
+            graph.run(jobs);
+            check(ordered.load(std::memory_order_relaxed), std::format("dependency order in graph {} frame {}", shape, i));
+        }
+        for (size_t id{}; id < count; ++id) {
+            check(200 == finished[id].load(std::memory_order_relaxed), "every node runs every frame");
+        }
+    }
+}
+
+// 节点抛出异常后其后继不执行，run() 重新抛出；之后图可以照常执行
+void graph_exception(Jobs::JobSystem &jobs)
+{
+    Jobs::TaskGraph graph;
+    std::atomic<int> ran{0};
+    std::atomic<bool> dependent_ran{false};
+    bool fail{true};
+    const auto first{graph.add("fail", [&] {
+        if (fail) {
+            throw std::runtime_error{"node failed"};
+        }
+        ran.fetch_add(1, std::memory_order_relaxed);
+    })};
+    graph.add("dependent", [&] {
+        dependent_ran.store(true, std::memory_order_relaxed);
+        ran.fetch_add(1, std::memory_order_relaxed);
+    }, {first});
+    for (int i{}; i < 32; ++i) {
+        graph.add("independent", [&] { ran.fetch_add(1, std::memory_order_relaxed); });
+    }
+
+    for (int round{}; round < 50; ++round) {
+        dependent_ran.store(false, std::memory_order_relaxed);
+        check("node failed" == expect_error([&] { graph.run(jobs); }, "graph run rethrows"), "node exception is rethrown");
+        check(!dependent_ran.load(std::memory_order_relaxed), "dependent of a failed node does not run");
+    }
+
+    fail = false;
+    ran.store(0, std::memory_order_relaxed);
+    graph.run(jobs);
+    check(34 == ran.load(std::memory_order_relaxed), "graph runs fully after a failure");
+
+    expect_error([&] { graph.add("unknown", [] {}, {graph.size()}); }, "unknown dependency is rejected");
+}
+
+// 图节点中嵌套 parallel_for
+void nested_parallel_for(Jobs::JobSystem &jobs)
+{
+    std::vector<double> data(300'000);
+    Jobs::TaskGraph graph;
+    graph.add("outer", [&] {
+        Jobs::parallel_for(jobs, "inner", std::span<double>{data}, [](std::span<double> chunk, size_t first) {
+            for (size_t i{}; i < chunk.size(); ++i) {
+                chunk[i] += static_cast<double>(first + i);
+            }
+        });
+    });
+    for (int i{}; i < 20; ++i) {
+        graph.run(jobs);
+    }
+    for (size_t i{}; i < data.size(); ++i) {
+        check(20.0 * static_cast<double>(i) == data[i], std::format("nested result {}", i));
+    }
+}
+
+} // namespace
+
+int main()
+{
+    try {
+        Jobs::JobSystem jobs{WORKERS};
+        check(WORKERS + 1 == jobs.thread_count(), "thread count includes the constructing thread");
+        parallel_for_matches_serial(jobs);
+        parallel_for_exception(jobs);
+        injected_jobs(jobs);
+        graph_dependency_order(jobs);
+        graph_exception(jobs);
+        nested_parallel_for(jobs);
+
+        // 析构时丢弃未执行的任务；counter 须比 JobSystem 活得久
+        {
+            Jobs::Counter counter;
+            Jobs::JobSystem pending{2};
+            for (int i{}; i < 100; ++i) {
+                pending.run("test", [] {}, counter);
+            }
+        }
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    std::printf("job_system_test: passed\n");
+    return 0;
+}
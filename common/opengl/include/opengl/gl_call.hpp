@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdio>
+#include <source_location>
+#include <type_traits>
+
+#include <glad/glad.h>
+
+#include "gl_error.hpp"
+#include "gl_hook.hpp"
+
+/**
+ * 带检查的 GL 调用
+ *
+ * GL::Call::glXxx(...) 与 glXxx(...) 用法相同，每个入口函数由 gl_functions.inc 生成一个对象：
+ *   - GL_CHECK_CALLS 为 1 时，调用后立即 glGetError，出错时输出错误名、函数名与调用处（std::source_location）
+ *   - GL_CHECK_CALLS 为 0 时，GL::Call::glXxx 就是 glad 函数指针 glad_glXxx 的引用，生成的代码与直接调用相同
+ *
+ * GL_CHECK_CALLS 未定义时跟随 NDEBUG。可以在单个 .cpp 中先 #define GL_CHECK_CALLS 1 再包含本文件，
+ * 只对该模块打开检查而不拖慢其他模块；两种实现位于不同的 inline namespace，混用不会违反 ODR。
+ * 因此只在 .cpp 中使用 GL::Call，不要在头文件的 inline 函数中使用。
+ *
+ * 通过 Hook::Entry 调用当前的函数指针，trace / stats 等拦截层依然有效。
+ */
+
+#if !defined(GL_CHECK_CALLS)
+#if defined(NDEBUG)
+#define GL_CHECK_CALLS 0
+#else
+#define GL_CHECK_CALLS 1
+#endif
+#endif
+
+namespace GL::Call {
+
+namespace detail {
+
+inline void report_error(std::string_view function, GLenum error, const std::source_location &where)
+{
+    std::fprintf(stderr, "GL %s after %.*s | %s (%s:%u)\n",
+        error_name(error), static_cast<int>(function.size()), function.data(),
+        where.file_name(), where.function_name(), static_cast<unsigned>(where.line()));
+}
+
+template <Hook::FunctionId Id, class Fn = Hook::Pointer<Id>>
+struct Checked;
+
+template <Hook::FunctionId Id, class R, class ...Args>
+struct Checked<Id, R (APIENTRYP)(Args...)>
+{
+    R operator()(Args... args, const std::source_location where = std::source_location::current()) const {
+        if constexpr (std::is_void_v<R>) {
+            Hook::Entry<Id>::pointer(args...);
+            check(where);
+        }
+        else {
+            R result{Hook::Entry<Id>::pointer(args...)};
+            check(where);
+            return result;
+        }
+    }
+
+    static void check(const std::source_location &where) {
+        // glGetError 本身不能再检查，否则会吞掉调用者要读取的错误
+        if constexpr (Hook::FunctionId::glGetError != Id) {
+            for (GLenum error{glGetError()}; GL_NO_ERROR != error; error = glGetError()) {
+                report_error(Hook::function_name(Id), error, where);
+            }
+        }
+    }
+};
+
+} // namespace detail
+
+#if GL_CHECK_CALLS
+inline namespace checked {
+#define GL_FUNCTION(name) inline constexpr detail::Checked<Hook::FunctionId::name> name{};
+#include "opengl/gl_functions.inc"
+#undef GL_FUNCTION
+} // namespace checked
+#else
+inline namespace unchecked {
+#define GL_FUNCTION(name) inline constexpr auto &name{::name};
+#include "opengl/gl_functions.inc"
+#undef GL_FUNCTION
+} // namespace unchecked
+#endif
+
+} // namespace GL::Call
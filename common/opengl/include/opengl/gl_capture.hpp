@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "image/yuv.hpp"
+
+namespace GL {
+
+/**
+ * 连续录制默认帧缓冲到 Y4M 文件
+ *
+ * glReadPixels 写入持久映射的 GL_PIXEL_PACK_BUFFER 环，每帧插入 fence；
+ * GL 线程只做非阻塞的 fence 轮询，已完成的槽交给工作线程转换 YUV420 并顺序写盘。
+ * 环满时丢弃当前帧而不是等待 GPU，保证录制本身不改变帧时序。
+ */
+class FrameCapture
+{
+public:
+    FrameCapture(const std::filesystem::path &path, GLsizei width, GLsizei height, uint32_t fps = 60, size_t ring_size = 4)
+        : width_{width & ~1}, height_{height & ~1}, slots_(ring_size)
+    {
+        file_.reset(std::fopen(path.string().c_str(), "wb"));
+        if (nullptr == file_) {
+            throw std::runtime_error{std::format("ERROR::CAPTURE what:can not open {}", path.string())};
+        }
+        file_buffer_.resize(FILE_BUFFER_SIZE);
+        std::setvbuf(file_.get(), file_buffer_.data(), _IOFBF, file_buffer_.size());
+        const auto header{std::format("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C420jpeg\n", width_, height_, fps)};
+        if (header.size() != std::fwrite(header.data(), 1, header.size(), file_.get())) {
+            throw std::runtime_error{std::format("ERROR::CAPTURE what:write {} failed", path.string())};
+        }
+
+        const auto frame_bytes{static_cast<GLsizeiptr>(width_) * height_ * 4};
+        constexpr GLbitfield MAP_FLAGS{GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+        for (auto &slot : slots_) {
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glBufferStorage(GL_PIXEL_PACK_BUFFER, frame_bytes, nullptr, MAP_FLAGS);
+            slot.mapped = static_cast<const uint8_t *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame_bytes, MAP_FLAGS));
+            if (nullptr == slot.mapped) {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                release_buffers();
+                throw std::runtime_error{"ERROR::CAPTURE what:map pixel pack buffer failed"};
+            }
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        worker_ = std::jthread{[this](std::stop_token token) { worker_loop(token); }};
+    }
+
+    ~FrameCapture() {
+        finish();
+    }
+    FrameCapture(const FrameCapture &) = delete;
+    FrameCapture(FrameCapture &&) = delete;
+    FrameCapture &operator=(const FrameCapture &) = delete;
+    FrameCapture &operator=(FrameCapture &&) = delete;
+
+    // 在 SDL_GL_SwapWindow 之前调用，回读当前读帧缓冲
+    void capture() {
+        poll();
+
+        const auto it{std::ranges::find_if(slots_, [](const Slot &slot) {
+            return SlotState::Free == slot.state.load(std::memory_order_acquire);
+        })};
+        if (it == slots_.end()) {
+            dropped_frames_ += 1;
+            return;
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, it->pbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        it->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        it->state.store(SlotState::Pending, std::memory_order_relaxed);
+        pending_.push_back(static_cast<size_t>(it - slots_.begin()));
+    }
+
+    /**
+     * 等待已提交的回读完成并写盘，之后不能再调用 capture()；析构时自动调用
+     * 等待总时长不超过 FINISH_TIMEOUT，驱动异常时未完成的帧计入 dropped_frames()
+     */
+    void finish() {
+        if (!worker_.joinable()) {
+            return;
+        }
+        using Clock = std::chrono::steady_clock;
+        const auto deadline{Clock::now() + FINISH_TIMEOUT};
+        while (!pending_.empty()) {
+            const auto left{std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now())};
+            if (left.count() <= 0) {
+                break;
+            }
+            auto &slot{slots_[pending_.front()]};
+            const GLenum status{glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, static_cast<GLuint64>(left.count()))};
+            if (GL_TIMEOUT_EXPIRED == status || GL_WAIT_FAILED == status) {
+                break;
+            }
+            poll();
+        }
+        // 放弃的槽的 fence 在 release_buffers() 中删除
+        dropped_frames_ += pending_.size();
+        pending_.clear();
+        {
+            std::lock_guard lock{queue_mutex_};
+            worker_.request_stop();
+        }
+        queue_cv_.notify_all();
+        worker_.join();
+        release_buffers();
+    }
+
+    uint64_t captured_frames() const { return written_frames_.load(std::memory_order_relaxed); }
+    uint64_t dropped_frames() const { return dropped_frames_; }
+    // 写盘失败后不再写入之后的帧，文件不完整
+    bool write_failed() const { return write_failed_.load(std::memory_order_relaxed); }
+
+private:
+    enum class SlotState : uint8_t { Free, Pending, Converting };
+
+    struct Slot
+    {
+        GLuint pbo{};
+        const uint8_t *mapped{};
+        GLsync fence{};
+        std::atomic<SlotState> state{SlotState::Free};
+    };
+
+    struct FileCloser
+    {
+        void operator()(std::FILE *file) const { std::fclose(file); }
+    };
+
+    static constexpr size_t FILE_BUFFER_SIZE{8 << 20};
+    static constexpr std::chrono::seconds FINISH_TIMEOUT{2};
+
+    // 按提交顺序检查 fence，已完成的槽交给工作线程，遇到未完成的即停止
+    void poll() {
+        while (!pending_.empty()) {
+            auto &slot{slots_[pending_.front()]};
+            const GLenum status{glClientWaitSync(slot.fence, 0, 0)};
+            if (GL_TIMEOUT_EXPIRED == status) {
+                break;
+            }
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+            slot.state.store(SlotState::Converting, std::memory_order_release);
+            {
+                std::lock_guard lock{queue_mutex_};
+                ready_.push_back(pending_.front());
+            }
+            queue_cv_.notify_one();
+            pending_.pop_front();
+        }
+    }
+
+    void worker_loop(std::stop_token token) {
+        const auto width{static_cast<size_t>(width_)};
+        const auto height{static_cast<size_t>(height_)};
+        std::vector<uint8_t> yuv(width * height * 3 / 2);
+        const Image::Yuv420View view{
+            yuv.data(),
+            yuv.data() + width * height,
+            yuv.data() + width * height + width * height / 4};
+        const auto stride{static_cast<std::ptrdiff_t>(width * 4)};
+
+        while (true) {
+            size_t index{};
+            {
+                std::unique_lock lock{queue_mutex_};
+                queue_cv_.wait(lock, [&] { return !ready_.empty() || token.stop_requested(); });
+                if (ready_.empty()) {
+                    break;
+                }
+                index = ready_.front();
+                ready_.pop_front();
+            }
+
+            auto &slot{slots_[index]};
+            if (write_failed_.load(std::memory_order_relaxed)) {
+                slot.state.store(SlotState::Free, std::memory_order_release);
+                continue;
+            }
+            // 回读结果自下而上，从最后一行开始以负步长转换
+            Image::rgba_to_yuv420(slot.mapped + (height - 1) * width * 4, -stride, width, height, view);
+            slot.state.store(SlotState::Free, std::memory_order_release);
+
+            constexpr char FRAME_TAG[]{"FRAME\n"};
+            if (sizeof(FRAME_TAG) - 1 != std::fwrite(FRAME_TAG, 1, sizeof(FRAME_TAG) - 1, file_.get())
+                || yuv.size() != std::fwrite(yuv.data(), 1, yuv.size(), file_.get())) {
+                write_failed_.store(true, std::memory_order_relaxed);
+                continue;
+            }
+            written_frames_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (0 != std::fflush(file_.get())) {
+            write_failed_.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    void release_buffers() {
+        for (auto &slot : slots_) {
+            if (nullptr != slot.fence) {
+                glDeleteSync(slot.fence);
+            }
+            if (0 != slot.pbo) {
+                if (nullptr != slot.mapped) {
+                    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+                    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                }
+                glDeleteBuffers(1, &slot.pbo);
+            }
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+private:
+    GLsizei width_{};
+    GLsizei height_{};
+    std::vector<Slot> slots_;
+    std::deque<size_t> pending_{};  // 仅 GL 线程访问
+
+    std::mutex queue_mutex_{};
+    std::condition_variable queue_cv_{};
+    std::deque<size_t> ready_{};
+
+    std::vector<char> file_buffer_{};
+    std::unique_ptr<std::FILE, FileCloser> file_{};
+    std::atomic<uint64_t> written_frames_{};
+    std::atomic<bool> write_failed_{false};
+    uint64_t dropped_frames_{};
+
+    std::jthread worker_{};
+};
+
+} // namespace GL
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+namespace GL {
+
+namespace detail {
+
+constexpr std::string_view debug_source_name(GLenum source)
+{
+    switch (source) {
+        case GL_DEBUG_SOURCE_API:             return "API";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "Window System";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "Shader Compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY:     return "Third Party";
+        case GL_DEBUG_SOURCE_APPLICATION:     return "Application";
+        default:                              return "Other";
+    }
+}
+
+constexpr std::string_view debug_type_name(GLenum type)
+{
+    switch (type) {
+        case GL_DEBUG_TYPE_ERROR:               return "Error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated Behaviour";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "Undefined Behaviour";
+        case GL_DEBUG_TYPE_PORTABILITY:         return "Portability";
+        case GL_DEBUG_TYPE_PERFORMANCE:         return "Performance";
+        case GL_DEBUG_TYPE_MARKER:              return "Marker";
+        case GL_DEBUG_TYPE_PUSH_GROUP:          return "Push Group";
+        case GL_DEBUG_TYPE_POP_GROUP:           return "Pop Group";
+        default:                                return "Other";
+    }
+}
+
+constexpr std::string_view debug_severity_name(GLenum severity)
+{
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH:         return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM:       return "medium";
+        case GL_DEBUG_SEVERITY_LOW:          return "low";
+        default:                             return "notification";
+    }
+}
+
+} // namespace detail
+
+/**
+ * GL debug message 日志
+ *
+ * 回调只做两件事：在无锁哈希表中按 (source, type, id) 计数；首次出现的消息复制进无锁环形队列。
+ * 格式化与写 stderr 放在帧末 drain() 或后台线程中完成，重复消息只在退出时汇总一次次数，
+ * 回调内不再有 std::cerr / std::endl 造成的 flush。
+ *
+ * 异步模式下关闭 GL_DEBUG_OUTPUT_SYNCHRONOUS，驱动可能在自己的线程中回调，因此队列与计数表均支持多生产者。
+ */
+class DebugLog
+{
+public:
+    DebugLog() = default;
+    ~DebugLog() {
+        stop_background_thread();
+    }
+    DebugLog(const DebugLog &) = delete;
+    DebugLog(DebugLog &&) = delete;
+    DebugLog &operator=(const DebugLog &) = delete;
+    DebugLog &operator=(DebugLog &&) = delete;
+
+    /**
+     * 注册回调，需在当前上下文为 debug context 时调用
+     * synchronous 为 false 时驱动可异步回调，并启动后台线程输出日志
+     */
+    void install(bool synchronous) {
+        glEnable(GL_DEBUG_OUTPUT);
+        if (synchronous) {
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        }
+        else {
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            start_background_thread();
+        }
+        glDebugMessageCallback(&DebugLog::callback, this);
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+        installed_ = true;
+    }
+
+    // 在上下文销毁之前调用；输出剩余消息与重复次数汇总，之后不会再有回调
+    void uninstall() {
+        if (!installed_) {
+            return;
+        }
+        glDebugMessageCallback(nullptr, nullptr);
+        glDisable(GL_DEBUG_OUTPUT);
+        installed_ = false;
+        stop_background_thread();
+        report_repeats();
+    }
+
+    // 同步模式下在帧末调用，输出队列中的新消息；异步模式由后台线程输出，这里什么也不做
+    size_t drain() {
+        return background_.joinable() ? 0 : drain_queue();
+    }
+
+    uint64_t dropped_messages() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    // 格式化队列中的消息，整批写入 stderr
+    size_t drain_queue() {
+        std::string text;
+        size_t count{};
+        Message message{};
+        while (pop(message)) {
+            const std::string_view body{message.text.data(), message.length};
+            text += std::format("GL [{}] {} {} ({}): {}\n",
+                detail::debug_severity_name(message.severity),
+                detail::debug_source_name(message.source),
+                detail::debug_type_name(message.type),
+                message.id, body);
+            first_messages_.try_emplace(message.key, body);
+            count += 1;
+        }
+        if (!text.empty()) {
+            std::fwrite(text.data(), 1, text.size(), stderr);
+        }
+        return count;
+    }
+
+    // 输出剩余消息，以及重复出现的消息与次数
+    void report_repeats() {
+        drain_queue();
+        std::string text;
+        for (size_t i{}; i < TABLE_SIZE; ++i) {
+            const auto key{seen_[i].key.load(std::memory_order_acquire)};
+            const auto count{seen_[i].count.load(std::memory_order_relaxed)};
+            if (0 != key && count > 1) {
+                const auto it{first_messages_.find(key)};
+                text += std::format("GL message {} repeated {} times: {}\n",
+                    static_cast<uint32_t>(key), count, it == first_messages_.end() ? std::string{} : it->second);
+            }
+        }
+        const auto dropped{dropped_.load(std::memory_order_relaxed)};
+        if (0 != dropped) {
+            text += std::format("GL debug log: {} messages dropped (queue full)\n", dropped);
+        }
+        if (!text.empty()) {
+            std::fwrite(text.data(), 1, text.size(), stderr);
+        }
+    }
+
+    static constexpr size_t QUEUE_SIZE{256};            // 2 的幂
+    static constexpr size_t TABLE_SIZE{1024};           // 2 的幂
+    static constexpr size_t MAX_MESSAGE_LENGTH{512};
+
+    struct Message
+    {
+        uint64_t key{};
+        GLenum source{};
+        GLenum type{};
+        GLuint id{};
+        GLenum severity{};
+        size_t length{};
+        std::array<char, MAX_MESSAGE_LENGTH> text{};
+    };
+
+    // Vyukov 有界 MPMC 队列的单元
+    struct Cell
+    {
+        std::atomic<size_t> sequence{};
+        Message message{};
+    };
+
+    struct SeenSlot
+    {
+        std::atomic<uint64_t> key{0};
+        std::atomic<uint32_t> count{0};
+    };
+
+    static void APIENTRY callback(
+        GLenum source,
+        GLenum type,
+        GLuint id,
+        GLenum severity,
+        GLsizei length,
+        const GLchar *message,
+        const void *user_param)
+    {
+        // 忽略无意义的驱动通知（NVIDIA 的 buffer 放置位置、纹理状态等）
+        if (id == 131169 || id == 131185 || id == 131218 || id == 131204) {
+            return;
+        }
+        auto *self{static_cast<DebugLog *>(const_cast<void *>(user_param))};
+        const uint64_t key{(static_cast<uint64_t>(source & 0xFFFF) << 48)
+            | (static_cast<uint64_t>(type & 0xFFFF) << 32) | id};
+        if (self->count_occurrence(key)) {
+            self->push(key, source, type, id, severity,
+                length >= 0 ? static_cast<size_t>(length) : std::strlen(message), message);
+        }
+    }
+
+    // 返回 true 表示首次出现
+    bool count_occurrence(uint64_t key) {
+        size_t index{static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 54) & (TABLE_SIZE - 1)};
+        for (size_t probe{}; probe < TABLE_SIZE; ++probe, index = (index + 1) & (TABLE_SIZE - 1)) {
+            auto &slot{seen_[index]};
+            uint64_t current{slot.key.load(std::memory_order_acquire)};
+            if (0 == current && slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                slot.count.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (current == key) {
+                slot.count.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void push(uint64_t key, GLenum source, GLenum type, GLuint id, GLenum severity, size_t length, const GLchar *text) {
+        size_t position{enqueue_position_.load(std::memory_order_relaxed)};
+        Cell *cell{};
+        while (true) {
+            cell = &queue_[position & (QUEUE_SIZE - 1)];
+            const size_t sequence{cell->sequence.load(std::memory_order_acquire)};
+            const auto diff{static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position)};
+            if (0 == diff) {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+
+        auto &message{cell->message};
+        message.key = key;
+        message.source = source;
+        message.type = type;
+        message.id = id;
+        message.severity = severity;
+        message.length = std::min(length, MAX_MESSAGE_LENGTH);
+        std::memcpy(message.text.data(), text, message.length);
+        cell->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    // 只有一个消费者（drain 在 GL 线程或后台线程之一执行）
+    bool pop(Message &message) {
+        const size_t position{dequeue_position_.load(std::memory_order_relaxed)};
+        auto &cell{queue_[position & (QUEUE_SIZE - 1)]};
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+        message = cell.message;
+        cell.sequence.store(position + QUEUE_SIZE, std::memory_order_release);
+        dequeue_position_.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void start_background_thread() {
+        if (background_.joinable()) {
+            return;
+        }
+        background_ = std::jthread{[this](std::stop_token token) {
+            while (!token.stop_requested()) {
+                drain_queue();
+                std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            }
+            drain_queue();
+        }};
+    }
+
+    void stop_background_thread() {
+        if (background_.joinable()) {
+            background_.request_stop();
+            background_.join();
+        }
+    }
+
+    static std::unique_ptr<Cell[]> make_queue() {
+        auto cells{std::make_unique<Cell[]>(QUEUE_SIZE)};
+        for (size_t i{}; i < QUEUE_SIZE; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        return cells;
+    }
+
+private:
+    std::unique_ptr<Cell[]> queue_{make_queue()};
+    alignas(64) std::atomic<size_t> enqueue_position_{0};
+    alignas(64) std::atomic<size_t> dequeue_position_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::unique_ptr<SeenSlot[]> seen_{std::make_unique<SeenSlot[]>(TABLE_SIZE)};
+
+    // 仅消费者访问
+    std::unordered_map<uint64_t, std::string> first_messages_{};
+
+    bool installed_{false};
+    std::jthread background_{};
+};
+
+} // namespace GL
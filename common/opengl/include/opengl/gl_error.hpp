@@ -2,7 +2,6 @@
 
 #include <iostream>
 #include <stdexcept>
-#include <string>
 
 #include <glad/glad.h>
 
@@ -10,76 +9,30 @@ namespace GL {
 
 constexpr int g_DEFAULT_ERROR_LOG_SIZZE{512};
 
+constexpr const char *error_name(GLenum error)
+{
+    switch (error)
+    {
+        case GL_INVALID_ENUM:                  return "INVALID_ENUM";
+        case GL_INVALID_VALUE:                 return "INVALID_VALUE";
+        case GL_INVALID_OPERATION:             return "INVALID_OPERATION";
+        case GL_STACK_OVERFLOW:                return "STACK_OVERFLOW";
+        case GL_STACK_UNDERFLOW:               return "STACK_UNDERFLOW";
+        case GL_OUT_OF_MEMORY:                 return "OUT_OF_MEMORY";
+        case GL_INVALID_FRAMEBUFFER_OPERATION: return "INVALID_FRAMEBUFFER_OPERATION";
+        default:                               return "UNKNOWN_ERROR";
+    }
+}
+
 inline GLenum glCheckError_(const char *file, const char *function, int line)
 {
     GLenum errorCode{GL_NO_ERROR};
     while ((errorCode = glGetError()) != GL_NO_ERROR)
     {
-        std::string error;
-        switch (errorCode)
-        {
-            case GL_INVALID_ENUM:                  error = "INVALID_ENUM"; break;
-            case GL_INVALID_VALUE:                 error = "INVALID_VALUE"; break;
-            case GL_INVALID_OPERATION:             error = "INVALID_OPERATION"; break;
-            case GL_STACK_OVERFLOW:                error = "STACK_OVERFLOW"; break;
-            case GL_STACK_UNDERFLOW:               error = "STACK_UNDERFLOW"; break;
-            case GL_OUT_OF_MEMORY:                 error = "OUT_OF_MEMORY"; break;
-            case GL_INVALID_FRAMEBUFFER_OPERATION: error = "INVALID_FRAMEBUFFER_OPERATION"; break;
-        }
-        std::cerr << error << " | " << file << " (" << function << ':' << line << ")" << std::endl;
+        std::cerr << error_name(errorCode) << " | " << file << " (" << function << ':' << line << ")" << std::endl;
     }
     return errorCode;
 }
 #define glCheckError() glCheckError_(__FILE__, __PRETTY_FUNCTION__, __LINE__)
 
-inline void APIENTRY glDebugOutput(
-    GLenum source,
-    GLenum type,
-    unsigned int id,
-    GLenum severity,
-    GLsizei length,
-    const char *message,
-    const void *userParam)
-{
-    (void)length;
-    (void)userParam;
-
-    if(id == 131169 || id == 131185 || id == 131218 || id == 131204) return; // ignore these non-significant error codes
-
-    std::cerr << "---------------" << std::endl;
-    std::cerr << "Debug message (" << id << "): " <<  message << std::endl;
-
-    switch (source)
-    {
-        case GL_DEBUG_SOURCE_API:             std::cerr << "Source: API"; break;
-        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   std::cerr << "Source: Window System"; break;
-        case GL_DEBUG_SOURCE_SHADER_COMPILER: std::cerr << "Source: Shader Compiler"; break;
-        case GL_DEBUG_SOURCE_THIRD_PARTY:     std::cerr << "Source: Third Party"; break;
-        case GL_DEBUG_SOURCE_APPLICATION:     std::cerr << "Source: Application"; break;
-        case GL_DEBUG_SOURCE_OTHER:           std::cerr << "Source: Other"; break;
-    } std::cerr << std::endl;
-
-    switch (type)
-    {
-        case GL_DEBUG_TYPE_ERROR:               std::cerr << "Type: Error"; break;
-        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: std::cerr << "Type: Deprecated Behaviour"; break;
-        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  std::cerr << "Type: Undefined Behaviour"; break;
-        case GL_DEBUG_TYPE_PORTABILITY:         std::cerr << "Type: Portability"; break;
-        case GL_DEBUG_TYPE_PERFORMANCE:         std::cerr << "Type: Performance"; break;
-        case GL_DEBUG_TYPE_MARKER:              std::cerr << "Type: Marker"; break;
-        case GL_DEBUG_TYPE_PUSH_GROUP:          std::cerr << "Type: Push Group"; break;
-        case GL_DEBUG_TYPE_POP_GROUP:           std::cerr << "Type: Pop Group"; break;
-        case GL_DEBUG_TYPE_OTHER:               std::cerr << "Type: Other"; break;
-    } std::cerr << std::endl;
-
-    switch (severity)
-    {
-        case GL_DEBUG_SEVERITY_HIGH:         std::cerr << "Severity: high"; break;
-        case GL_DEBUG_SEVERITY_MEDIUM:       std::cerr << "Severity: medium"; break;
-        case GL_DEBUG_SEVERITY_LOW:          std::cerr << "Severity: low"; break;
-        case GL_DEBUG_SEVERITY_NOTIFICATION: std::cerr << "Severity: notification"; break;
-    } std::cerr << std::endl;
-    std::cerr << std::endl;
-}
-
 } // namespace GL
\ No newline at end of file
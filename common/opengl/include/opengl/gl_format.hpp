@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+// glad 只生成了核心 API，S3TC（EXT_texture_compression_s3tc / EXT_texture_sRGB）的枚举在此补上，桌面驱动均支持
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace GL {
+
+inline size_t pixel_components(GLenum format)
+{
+    switch (format) {
+        case GL_RED: case GL_GREEN: case GL_BLUE: case GL_RED_INTEGER: case GL_GREEN_INTEGER: case GL_BLUE_INTEGER:
+        case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX:
+            return 1;
+        case GL_RG: case GL_RG_INTEGER: case GL_DEPTH_STENCIL:
+            return 2;
+        case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: case GL_BGR_INTEGER:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+// glTexImage / glReadPixels 中 format + type 对应的单个像素字节数
+inline size_t pixel_bytes(GLenum format, GLenum type)
+{
+    const size_t components{pixel_components(format)};
+    switch (type) {
+        case GL_UNSIGNED_BYTE: case GL_BYTE:
+            return components;
+        case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT:
+            return components * 2;
+        case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT:
+            return components * 4;
+        case GL_UNSIGNED_BYTE_3_3_2: case GL_UNSIGNED_BYTE_2_3_3_REV:
+            return 1;
+        case GL_UNSIGNED_SHORT_5_6_5: case GL_UNSIGNED_SHORT_5_6_5_REV:
+        case GL_UNSIGNED_SHORT_4_4_4_4: case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+        case GL_UNSIGNED_SHORT_5_5_5_1: case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+            return 2;
+        case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+// 最后一行不补齐到对齐边界，与驱动实际读取的字节数一致
+inline size_t image_bytes(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, GLint alignment)
+{
+    if (width <= 0 || height <= 0 || depth <= 0) {
+        return 0;
+    }
+    const size_t row{static_cast<size_t>(width) * pixel_bytes(format, type)};
+    const auto align{static_cast<size_t>(std::max(alignment, 1))};
+    const size_t stride{(row + align - 1) / align * align};
+    return stride * (static_cast<size_t>(height) * static_cast<size_t>(depth) - 1) + row;
+}
+
+// 纹理内部格式的存储单元：压缩格式为 4x4 块，其余为单个像素
+struct TexelBlock
+{
+    size_t bytes{4};
+    GLsizei size{1};
+};
+
+// 驱动的实际布局不可查询，这里按常见实现估算：3 通道格式补齐到 4 通道，未指定位宽的格式按 8 位计
+constexpr TexelBlock texel_block(GLenum internal_format)
+{
+    switch (internal_format) {
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RED_RGTC1: case GL_COMPRESSED_SIGNED_RED_RGTC1:
+        case GL_COMPRESSED_RGB8_ETC2: case GL_COMPRESSED_SRGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2: case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_R11_EAC: case GL_COMPRESSED_SIGNED_R11_EAC:
+            return {8, 4};
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RG_RGTC2: case GL_COMPRESSED_SIGNED_RG_RGTC2:
+        case GL_COMPRESSED_RGBA_BPTC_UNORM: case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT: case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC: case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+        case GL_COMPRESSED_RG11_EAC: case GL_COMPRESSED_SIGNED_RG11_EAC:
+            return {16, 4};
+        case GL_R8: case GL_R8_SNORM: case GL_R8I: case GL_R8UI: case GL_RED: case GL_STENCIL_INDEX8:
+            return {1};
+        case GL_R16: case GL_R16_SNORM: case GL_R16F: case GL_R16I: case GL_R16UI:
+        case GL_RG8: case GL_RG8_SNORM: case GL_RG8I: case GL_RG8UI: case GL_RG:
+        case GL_RGB565: case GL_RGB5_A1: case GL_RGBA4: case GL_DEPTH_COMPONENT16:
+            return {2};
+        case GL_RG16: case GL_RG16_SNORM: case GL_RG16F: case GL_RG16I: case GL_RG16UI:
+        case GL_R32F: case GL_R32I: case GL_R32UI:
+            return {4};
+        case GL_RGB16: case GL_RGB16_SNORM: case GL_RGB16F: case GL_RGB16I: case GL_RGB16UI:
+        case GL_RGBA16: case GL_RGBA16_SNORM: case GL_RGBA16F: case GL_RGBA16I: case GL_RGBA16UI:
+        case GL_RG32F: case GL_RG32I: case GL_RG32UI: case GL_DEPTH32F_STENCIL8:
+            return {8};
+        case GL_RGB32F: case GL_RGB32I: case GL_RGB32UI:
+            return {12};
+        case GL_RGBA32F: case GL_RGBA32I: case GL_RGBA32UI:
+            return {16};
+        default:    // RGBA8、sRGB、RGB10_A2、R11F_G11F_B10F、24/32 位深度等
+            return {4};
+    }
+}
+
+// width x height x depth 的一个 mip level（depth 为 3D 纹理的深度或数组层数）
+constexpr uint64_t texture_image_bytes(GLenum internal_format, GLsizei width, GLsizei height, GLsizei depth)
+{
+    if (width <= 0 || height <= 0 || depth <= 0) {
+        return 0;
+    }
+    const auto block{texel_block(internal_format)};
+    const auto blocks = [&](GLsizei extent) { return static_cast<uint64_t>((extent + block.size - 1) / block.size); };
+    return blocks(width) * blocks(height) * static_cast<uint64_t>(depth) * block.bytes;
+}
+
+} // namespace GL
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <glad/glad.h>
+
+/**
+ * glad 函数指针拦截层
+ *
+ * gl_functions.inc 由 cmake generate_gl_function_list() 从 glad.h 生成，
+ * 每个入口函数对应一项 GL_FUNCTION(glXxx)。glad 把 glXxx 定义为 glad_glXxx 宏，
+ * 因此 FunctionId::glDrawArrays 与 Entry<FunctionId::glDrawArrays>::pointer 可以直接按 GL 函数名书写。
+ */
+namespace GL::Hook {
+
+enum class FunctionId : uint16_t
+{
+#define GL_FUNCTION(name) name,
+#include "opengl/gl_functions.inc"
+#undef GL_FUNCTION
+};
+
+inline constexpr std::array FUNCTION_NAMES{
+#define GL_FUNCTION(name) std::string_view{#name},
+#include "opengl/gl_functions.inc"
+#undef GL_FUNCTION
+};
+
+inline constexpr size_t FUNCTION_COUNT{FUNCTION_NAMES.size()};
+
+constexpr std::string_view function_name(FunctionId id)
+{
+    return FUNCTION_NAMES[static_cast<size_t>(id)];
+}
+
+// 对应的 glad 函数指针变量（glad_glXxx）
+template <FunctionId Id>
+struct Entry;
+
+#define GL_FUNCTION(name) \
+    template <> \
+    struct Entry<FunctionId::name> { \
+        static constexpr auto &pointer{name}; \
+    };
+#include "opengl/gl_functions.inc"
+#undef GL_FUNCTION
+
+template <FunctionId Id>
+using Pointer = std::remove_cvref_t<decltype(Entry<Id>::pointer)>;
+
+/**
+ * 把 glad 函数指针替换为 Layer::invoke<Id>(original, args...)
+ * 多个 Layer 可以叠加，卸载顺序需与安装顺序相反
+ */
+template <class Layer, FunctionId Id, class Fn = Pointer<Id>>
+struct Interceptor;
+
+template <class Layer, FunctionId Id, class R, class ...Args>
+struct Interceptor<Layer, Id, R (APIENTRYP)(Args...)>
+{
+    using Function = R (APIENTRYP)(Args...);
+
+    static inline Function original{nullptr};
+
+    static R APIENTRY hook(Args... args) {
+        return Layer::template invoke<Id>(original, args...);
+    }
+
+    static void install() {
+        auto &entry{Entry<Id>::pointer};
+        if (nullptr != entry && &hook != entry) {
+            original = entry;
+            entry = &hook;
+        }
+    }
+
+    static void uninstall() {
+        auto &entry{Entry<Id>::pointer};
+        if (&hook == entry) {
+            entry = original;
+        }
+    }
+};
+
+// 绕过拦截层直接调用驱动（拦截层内部查询 GL 状态时使用）
+template <class Layer, FunctionId Id, class ...Args>
+decltype(auto) call_original(Args&&... args)
+{
+    auto original{Interceptor<Layer, Id>::original};
+    if (nullptr == original) {
+        original = Entry<Id>::pointer;
+    }
+    return original(std::forward<Args>(args)...);
+}
+
+template <class Layer>
+void install_layer()
+{
+#define GL_FUNCTION(name) Interceptor<Layer, FunctionId::name>::install();
+#include "opengl/gl_functions.inc"
+#undef GL_FUNCTION
+}
+
+template <class Layer>
+void uninstall_layer()
+{
+#define GL_FUNCTION(name) Interceptor<Layer, FunctionId::name>::uninstall();
+#include "opengl/gl_functions.inc"
+#undef GL_FUNCTION
+}
+
+/***************************************************************************************************
+ * 参数布局：录制、统计等拦截层共用的参数下标
+ **************************************************************************************************/
+
+constexpr size_t NONE{~size_t{}};
+
+struct SizeRule
+{
+    size_t data_index{NONE};
+    size_t size_index{NONE};  // 字节数参数
+};
+
+struct PixelRule
+{
+    size_t data_index{NONE};
+    size_t width{NONE};
+    size_t height{NONE};
+    size_t depth{NONE};
+    size_t format{NONE};
+    size_t type{NONE};
+};
+
+constexpr SizeRule size_rule(FunctionId id)
+{
+    switch (id) {
+        case FunctionId::glBufferData:
+        case FunctionId::glBufferStorage:
+        case FunctionId::glNamedBufferData:
+        case FunctionId::glNamedBufferStorage:          return {2, 1};
+        case FunctionId::glBufferSubData:
+        case FunctionId::glNamedBufferSubData:          return {3, 2};
+        case FunctionId::glCompressedTexImage1D:        return {6, 5};
+        case FunctionId::glCompressedTexImage2D:        return {7, 6};
+        case FunctionId::glCompressedTexImage3D:        return {8, 7};
+        case FunctionId::glCompressedTexSubImage1D:
+        case FunctionId::glCompressedTextureSubImage1D: return {6, 5};
+        case FunctionId::glCompressedTexSubImage2D:
+        case FunctionId::glCompressedTextureSubImage2D: return {8, 7};
+        case FunctionId::glCompressedTexSubImage3D:
+        case FunctionId::glCompressedTextureSubImage3D: return {10, 9};
+        case FunctionId::glShaderBinary:                return {3, 4};
+        case FunctionId::glProgramBinary:               return {2, 3};
+        default:                                        return {};
+    }
+}
+
+constexpr PixelRule pixel_rule(FunctionId id)
+{
+    switch (id) {
+        case FunctionId::glTexImage1D:        return {7, 3, NONE, NONE, 5, 6};
+        case FunctionId::glTexImage2D:        return {8, 3, 4, NONE, 6, 7};
+        case FunctionId::glTexImage3D:        return {9, 3, 4, 5, 7, 8};
+        case FunctionId::glTexSubImage1D:
+        case FunctionId::glTextureSubImage1D: return {6, 3, NONE, NONE, 4, 5};
+        case FunctionId::glTexSubImage2D:
+        case FunctionId::glTextureSubImage2D: return {8, 4, 5, NONE, 6, 7};
+        case FunctionId::glTexSubImage3D:
+        case FunctionId::glTextureSubImage3D: return {10, 5, 6, 7, 8, 9};
+        // 清除类函数只读取一个元素
+        case FunctionId::glClearTexImage:           return {4, NONE, NONE, NONE, 2, 3};
+        case FunctionId::glClearTexSubImage:        return {10, NONE, NONE, NONE, 8, 9};
+        case FunctionId::glClearBufferData:
+        case FunctionId::glClearNamedBufferData:    return {4, NONE, NONE, NONE, 2, 3};
+        case FunctionId::glClearBufferSubData:
+        case FunctionId::glClearNamedBufferSubData: return {6, NONE, NONE, NONE, 4, 5};
+        default:                                    return {};
+    }
+}
+
+// glUniform{N}{type}v / glUniformMatrix{N}[x{M}]{type}v 每个 count 包含的元素数
+constexpr size_t uniform_elements(std::string_view name)
+{
+    std::string_view rest;
+    if (name.starts_with("glProgramUniform")) {
+        rest = name.substr(16);
+    }
+    else if (name.starts_with("glUniform")) {
+        rest = name.substr(9);
+    }
+    else {
+        return 0;
+    }
+
+    const auto digit = [](char c) -> size_t { return ('1' <= c && c <= '4') ? static_cast<size_t>(c - '0') : 0; };
+    if (rest.starts_with("Matrix") && rest.size() > 6) {
+        const size_t columns{digit(rest[6])};
+        const size_t rows{(rest.size() > 8 && 'x' == rest[7]) ? digit(rest[8]) : columns};
+        return columns * rows;
+    }
+    return rest.empty() ? 0 : digit(rest[0]);
+}
+
+constexpr bool is_uniform_setter(std::string_view name)
+{
+    return 0 != uniform_elements(name);
+}
+
+constexpr size_t uniform_location_index(std::string_view name)
+{
+    return name.starts_with("glProgramUniform") ? 1 : 0;
+}
+
+} // namespace GL::Hook
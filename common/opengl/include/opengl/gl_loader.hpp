@@ -0,0 +1,202 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cinttypes>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+
+#include <glad/glad.h>
+
+#include "gl_hook.hpp"
+
+/**
+ * 精简的 GL 加载器，替代 gladLoadGLLoader
+ *
+ * gl_used_functions.inc 由 cmake generate_gl_used_function_list() 扫描工程源码中实际调用的 glXxx( 生成，
+ * 只有这些入口在 load() 时通过 SDL_GL_GetProcAddress 解析；其余入口先指向跳板函数，
+ * 首次调用时才解析并把 glad 函数指针替换为驱动地址，之后与直接调用相同。
+ * 扫描结果过期（新代码调用了未列出的函数）只会多一次延迟解析，不影响正确性。
+ *
+ * 注意：未解析的函数指针不再为 nullptr，不能再用 glad_glXxx != nullptr 判断驱动是否支持。
+ * glad 的函数指针是普通全局变量，其他线程（共享上下文的加载线程）开始调用 GL 之前须先 begin_threaded()：
+ * 之后跳板仍在首次调用时解析，但只记录在自己的原子变量中，不再改写 glad 函数指针。
+ */
+namespace GL::Loader {
+
+struct LoadStats
+{
+    size_t eager{};         // load() 时解析的入口
+    size_t deferred{};      // 指向跳板的入口
+    size_t missing{};       // 驱动未提供的常用入口
+};
+
+namespace detail {
+
+inline constexpr auto USED_FUNCTIONS{[] {
+    std::array<bool, Hook::FUNCTION_COUNT> used{};
+#define GL_FUNCTION(name) used[static_cast<size_t>(Hook::FunctionId::name)] = true;
+#include "opengl/gl_used_functions.inc"
+#undef GL_FUNCTION
+    return used;
+}()};
+
+inline std::atomic<GLADloadproc> g_load_proc{nullptr};
+inline std::atomic<size_t> g_lazy_resolved{0};
+// 为 true 后跳板不再改写 glad 函数指针，多个线程可以同时读取它们
+inline std::atomic<bool> g_threaded{false};
+
+template <Hook::FunctionId Id, class Fn = Hook::Pointer<Id>>
+struct Lazy;
+
+template <Hook::FunctionId Id, class R, class ...Args>
+struct Lazy<Id, R (APIENTRYP)(Args...)>
+{
+    using Function = R (APIENTRYP)(Args...);
+
+    // 多个线程同时首次调用时可能重复解析，结果相同
+    static inline std::atomic<Function> resolved{nullptr};
+
+    static Function resolve() {
+        const auto proc{g_load_proc.load(std::memory_order_acquire)};
+        const auto function{nullptr == proc ? nullptr
+            : reinterpret_cast<Function>(proc(Hook::function_name(Id).data()))};
+        if (nullptr == function) {
+            throw std::runtime_error{std::format(
+                "ERROR::GL_LOADER what:{} is not provided by the driver", Hook::function_name(Id))};
+        }
+        return function;
+    }
+
+    static R APIENTRY trampoline(Args... args) {
+        Function function{resolved.load(std::memory_order_acquire)};
+        if (nullptr == function) {
+            function = resolve();
+            resolved.store(function, std::memory_order_release);
+            g_lazy_resolved.fetch_add(1, std::memory_order_relaxed);
+            // 已被拦截层替换时保留拦截层，拦截层的 original 仍指向跳板
+            // 多线程后之后的调用多一次跳转：只有扫描遗漏的入口才走到这里
+            if (!g_threaded.load(std::memory_order_acquire)) {
+                Function expected{&trampoline};
+                std::atomic_ref{Hook::Entry<Id>::pointer}.compare_exchange_strong(expected, function, std::memory_order_release);
+            }
+        }
+        return function(args...);
+    }
+
+    static void load(GLADloadproc proc, LoadStats &stats) {
+        auto &entry{Hook::Entry<Id>::pointer};
+        resolved.store(nullptr, std::memory_order_relaxed);
+        if (USED_FUNCTIONS[static_cast<size_t>(Id)]) {
+            entry = reinterpret_cast<Function>(proc(Hook::function_name(Id).data()));
+            stats.eager += 1;
+            stats.missing += nullptr == entry ? 1 : 0;
+        }
+        else {
+            entry = &trampoline;
+            stats.deferred += 1;
+        }
+    }
+};
+
+// 与 glad 的 find_coreGL 相同：解析 GL_VERSION，设置 GLVersion 与 GLAD_GL_VERSION_X_Y
+inline bool find_core_version()
+{
+    const auto *version{reinterpret_cast<const char *>(glGetString(GL_VERSION))};
+    if (nullptr == version) {
+        return false;
+    }
+    std::string_view text{version};
+    for (const std::string_view prefix : {"OpenGL ES-CM ", "OpenGL ES-CL ", "OpenGL ES "}) {
+        if (text.starts_with(prefix)) {
+            text.remove_prefix(prefix.size());
+            break;
+        }
+    }
+    int major{};
+    int minor{};
+    const auto [end, ec]{std::from_chars(text.data(), text.data() + text.size(), major)};
+    if (ec != std::errc{} || end == text.data() + text.size() || '.' != *end) {
+        return false;
+    }
+    std::from_chars(end + 1, text.data() + text.size(), minor);
+
+    GLVersion.major = major;
+    GLVersion.minor = minor;
+    const auto at_least = [&](int want_major, int want_minor) -> int {
+        return (major == want_major && minor >= want_minor) || major > want_major;
+    };
+    GLAD_GL_VERSION_1_0 = at_least(1, 0);
+    GLAD_GL_VERSION_1_1 = at_least(1, 1);
+    GLAD_GL_VERSION_1_2 = at_least(1, 2);
+    GLAD_GL_VERSION_1_3 = at_least(1, 3);
+    GLAD_GL_VERSION_1_4 = at_least(1, 4);
+    GLAD_GL_VERSION_1_5 = at_least(1, 5);
+    GLAD_GL_VERSION_2_0 = at_least(2, 0);
+    GLAD_GL_VERSION_2_1 = at_least(2, 1);
+    GLAD_GL_VERSION_3_0 = at_least(3, 0);
+    GLAD_GL_VERSION_3_1 = at_least(3, 1);
+    GLAD_GL_VERSION_3_2 = at_least(3, 2);
+    GLAD_GL_VERSION_3_3 = at_least(3, 3);
+    GLAD_GL_VERSION_4_0 = at_least(4, 0);
+    GLAD_GL_VERSION_4_1 = at_least(4, 1);
+    GLAD_GL_VERSION_4_2 = at_least(4, 2);
+    GLAD_GL_VERSION_4_3 = at_least(4, 3);
+    GLAD_GL_VERSION_4_4 = at_least(4, 4);
+    GLAD_GL_VERSION_4_5 = at_least(4, 5);
+    GLAD_GL_VERSION_4_6 = at_least(4, 6);
+    return 0 != major || 0 != minor;
+}
+
+} // namespace detail
+
+constexpr size_t used_function_count()
+{
+    size_t count{};
+    for (const bool used : detail::USED_FUNCTIONS) {
+        count += used ? 1 : 0;
+    }
+    return count;
+}
+
+// 需在 GL 上下文为当前上下文时调用；返回 false 表示无法取得 GL 版本（与 gladLoadGLLoader 返回 0 相同）
+inline bool load(GLADloadproc proc, LoadStats *stats = nullptr)
+{
+    detail::g_load_proc.store(proc, std::memory_order_release);
+    detail::g_lazy_resolved.store(0, std::memory_order_relaxed);
+    detail::g_threaded.store(false, std::memory_order_relaxed);
+
+    glad_glGetString = reinterpret_cast<PFNGLGETSTRINGPROC>(proc("glGetString"));
+    if (nullptr == glad_glGetString || !detail::find_core_version()) {
+        return false;
+    }
+
+    LoadStats result{};
+#define GL_FUNCTION(name) detail::Lazy<Hook::FunctionId::name>::load(proc, result);
+#include "opengl/gl_functions.inc"
+#undef GL_FUNCTION
+    if (nullptr != stats) {
+        *stats = result;
+    }
+    return true;
+}
+
+/**
+ * 在启动第二个调用 GL 的线程之前调用，之后各线程只读 glad 函数指针
+ * 不解析任何入口：仍指向跳板的入口在任一线程首次调用时解析，与单线程时相同
+ */
+inline void begin_threaded()
+{
+    detail::g_threaded.store(true, std::memory_order_release);
+}
+
+// 目前为止经跳板解析的入口数
+inline size_t lazy_resolved()
+{
+    return detail::g_lazy_resolved.load(std::memory_order_relaxed);
+}
+
+} // namespace GL::Loader
@@ -0,0 +1,407 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <format>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "gl_format.hpp"
+#include "gl_hook.hpp"
+
+namespace GL {
+
+enum class MemoryCategory : uint8_t
+{
+    Buffer,
+    Texture,
+    Renderbuffer,
+    Count
+};
+
+constexpr std::string_view memory_category_name(MemoryCategory category)
+{
+    constexpr std::array<std::string_view, static_cast<size_t>(MemoryCategory::Count)> NAMES{
+        "buffer", "texture", "renderbuffer"};
+    return NAMES[static_cast<size_t>(category)];
+}
+
+struct MemoryCounter
+{
+    uint64_t current{};         // 字节
+    uint64_t peak{};
+    uint64_t objects{};         // 当前持有存储的对象数
+    uint64_t allocations{};     // 累计分配（含重新分配）次数
+};
+
+struct MemoryUsage
+{
+    std::array<MemoryCounter, static_cast<size_t>(MemoryCategory::Count)> categories{};
+    MemoryCounter total{};
+
+    const MemoryCounter &category(MemoryCategory category) const { return categories[static_cast<size_t>(category)]; }
+
+    std::string to_string() const {
+        const auto mib = [](uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+        std::string text{std::format("total {:.2f} MiB (peak {:.2f} MiB)", mib(total.current), mib(total.peak))};
+        for (size_t i{}; i < categories.size(); ++i) {
+            const auto &counter{categories[i]};
+            text += std::format(", {} {:.2f} MiB (peak {:.2f} MiB, {} objects, {} allocations)",
+                memory_category_name(static_cast<MemoryCategory>(i)), mib(counter.current), mib(counter.peak),
+                counter.objects, counter.allocations);
+        }
+        return text;
+    }
+};
+
+/**
+ * GPU 内存记录拦截层：按对象记录 glBufferData / glTexImage / glTexStorage / glRenderbufferStorage 等分配的字节数，
+ * glDelete* 时扣除，统计各类别的当前与峰值用量
+ * 纹理按 level（立方体贴图再按面）分别记录，重新指定某一级只替换该级；字节数按内部格式估算（见 texel_block），
+ * 不含驱动的对齐与元数据。非 DSA 的调用通过 glGetIntegerv 查询当前绑定的对象。
+ * 与 Stats 相同，计数器不加锁，只记录 GL 线程的调用；install() 之前已分配的对象不计入。
+ */
+namespace Memory {
+
+namespace detail {
+
+using Hook::FunctionId;
+
+struct Allocation
+{
+    MemoryCategory category{};
+    std::vector<uint64_t> images{};     // 纹理：level * 6 + face；缓冲与渲染缓冲只有一项
+};
+
+inline std::unordered_map<uint64_t, Allocation> g_objects;
+inline MemoryUsage g_usage;
+inline bool g_installed{false};
+
+constexpr uint64_t object_key(MemoryCategory category, GLuint id)
+{
+    return static_cast<uint64_t>(category) << 32 | id;
+}
+
+inline void add(MemoryCounter &counter, uint64_t old_bytes, uint64_t new_bytes)
+{
+    counter.current = counter.current - old_bytes + new_bytes;
+    counter.peak = std::max(counter.peak, counter.current);
+}
+
+// 替换对象的全部（image 为空）或某一个 image 的字节数
+inline void assign(MemoryCategory category, GLuint id, std::vector<uint64_t> images, size_t image = ~size_t{})
+{
+    if (0 == id) {
+        return;
+    }
+    auto &counter{g_usage.categories[static_cast<size_t>(category)]};
+    auto [it, inserted]{g_objects.try_emplace(object_key(category, id), Allocation{category, {}})};
+    auto &allocation{it->second};
+    uint64_t old_bytes{};
+    for (const auto bytes : allocation.images) {
+        old_bytes += bytes;
+    }
+    if (~size_t{} == image) {
+        allocation.images = std::move(images);
+    }
+    else {
+        allocation.images.resize(std::max(allocation.images.size(), image + 1));
+        allocation.images[image] = images.front();
+    }
+    uint64_t new_bytes{};
+    for (const auto bytes : allocation.images) {
+        new_bytes += bytes;
+    }
+    if (inserted) {
+        counter.objects += 1;
+        g_usage.total.objects += 1;
+    }
+    counter.allocations += 1;
+    g_usage.total.allocations += 1;
+    add(counter, old_bytes, new_bytes);
+    add(g_usage.total, old_bytes, new_bytes);
+}
+
+inline void release(MemoryCategory category, GLsizei count, const GLuint *ids)
+{
+    auto &counter{g_usage.categories[static_cast<size_t>(category)]};
+    for (GLsizei i{}; nullptr != ids && i < count; ++i) {
+        const auto it{g_objects.find(object_key(category, ids[i]))};
+        if (g_objects.end() == it) {
+            continue;
+        }
+        uint64_t bytes{};
+        for (const auto image : it->second.images) {
+            bytes += image;
+        }
+        add(counter, bytes, 0);
+        add(g_usage.total, bytes, 0);
+        counter.objects -= 1;
+        g_usage.total.objects -= 1;
+        g_objects.erase(it);
+    }
+}
+
+struct MemoryLayer;
+
+inline GLuint bound(GLenum binding)
+{
+    GLint id{};
+    if (0 != binding) {
+        Hook::call_original<MemoryLayer, FunctionId::glGetIntegerv>(binding, &id);
+    }
+    return static_cast<GLuint>(id);
+}
+
+constexpr GLenum buffer_binding(GLenum target)
+{
+    switch (target) {
+        case GL_ARRAY_BUFFER:              return GL_ARRAY_BUFFER_BINDING;
+        case GL_ELEMENT_ARRAY_BUFFER:      return GL_ELEMENT_ARRAY_BUFFER_BINDING;
+        case GL_PIXEL_PACK_BUFFER:         return GL_PIXEL_PACK_BUFFER_BINDING;
+        case GL_PIXEL_UNPACK_BUFFER:       return GL_PIXEL_UNPACK_BUFFER_BINDING;
+        case GL_UNIFORM_BUFFER:            return GL_UNIFORM_BUFFER_BINDING;
+        case GL_SHADER_STORAGE_BUFFER:     return GL_SHADER_STORAGE_BUFFER_BINDING;
+        case GL_COPY_READ_BUFFER:          return GL_COPY_READ_BUFFER_BINDING;
+        case GL_COPY_WRITE_BUFFER:         return GL_COPY_WRITE_BUFFER_BINDING;
+        case GL_DRAW_INDIRECT_BUFFER:      return GL_DRAW_INDIRECT_BUFFER_BINDING;
+        case GL_DISPATCH_INDIRECT_BUFFER:  return GL_DISPATCH_INDIRECT_BUFFER_BINDING;
+        case GL_TEXTURE_BUFFER:            return GL_TEXTURE_BUFFER_BINDING;
+        case GL_TRANSFORM_FEEDBACK_BUFFER: return GL_TRANSFORM_FEEDBACK_BUFFER_BINDING;
+        case GL_ATOMIC_COUNTER_BUFFER:     return GL_ATOMIC_COUNTER_BUFFER_BINDING;
+        case GL_QUERY_BUFFER:              return GL_QUERY_BUFFER_BINDING;
+        default:                           return 0;
+    }
+}
+
+// proxy 目标不分配存储，返回 0
+constexpr GLenum texture_binding(GLenum target)
+{
+    switch (target) {
+        case GL_TEXTURE_1D:                   return GL_TEXTURE_BINDING_1D;
+        case GL_TEXTURE_2D:                   return GL_TEXTURE_BINDING_2D;
+        case GL_TEXTURE_3D:                   return GL_TEXTURE_BINDING_3D;
+        case GL_TEXTURE_1D_ARRAY:             return GL_TEXTURE_BINDING_1D_ARRAY;
+        case GL_TEXTURE_2D_ARRAY:             return GL_TEXTURE_BINDING_2D_ARRAY;
+        case GL_TEXTURE_RECTANGLE:            return GL_TEXTURE_BINDING_RECTANGLE;
+        case GL_TEXTURE_CUBE_MAP:
+        case GL_TEXTURE_CUBE_MAP_POSITIVE_X:
+        case GL_TEXTURE_CUBE_MAP_NEGATIVE_X:
+        case GL_TEXTURE_CUBE_MAP_POSITIVE_Y:
+        case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
+        case GL_TEXTURE_CUBE_MAP_POSITIVE_Z:
+        case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z:  return GL_TEXTURE_BINDING_CUBE_MAP;
+        case GL_TEXTURE_CUBE_MAP_ARRAY:       return GL_TEXTURE_BINDING_CUBE_MAP_ARRAY;
+        case GL_TEXTURE_2D_MULTISAMPLE:       return GL_TEXTURE_BINDING_2D_MULTISAMPLE;
+        case GL_TEXTURE_2D_MULTISAMPLE_ARRAY: return GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY;
+        default:                              return 0;
+    }
+}
+
+constexpr size_t texture_image(GLenum target, GLint level)
+{
+    const bool face{GL_TEXTURE_CUBE_MAP_POSITIVE_X <= target && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z};
+    return static_cast<size_t>(std::max(level, 0)) * 6 + (face ? target - GL_TEXTURE_CUBE_MAP_POSITIVE_X : 0);
+}
+
+// glTexStorage 一次分配完整的 mip 链；target 未知（DSA）时按 2D / 2D 数组计
+inline std::vector<uint64_t> storage_images(GLenum target, GLsizei levels, GLenum internal_format,
+    GLsizei width, GLsizei height, GLsizei depth, uint64_t samples = 1)
+{
+    const bool cube{GL_TEXTURE_CUBE_MAP == target};
+    std::vector<uint64_t> images(static_cast<size_t>(std::max(levels, 1)) * 6);
+    for (GLsizei level{}; level < std::max(levels, 1); ++level) {
+        const GLsizei w{std::max(width >> level, 1)};
+        const GLsizei h{GL_TEXTURE_1D_ARRAY == target ? height : std::max(height >> level, 1)};
+        const GLsizei d{GL_TEXTURE_3D == target ? std::max(depth >> level, 1) : depth};
+        const uint64_t bytes{texture_image_bytes(internal_format, w, h, d) * samples};
+        for (size_t face{}; face < (cube ? 6u : 1u); ++face) {
+            images[static_cast<size_t>(level) * 6 + face] = bytes;
+        }
+    }
+    return images;
+}
+
+template <class T>
+GLenum as_enum(T value)
+{
+    return static_cast<GLenum>(value);
+}
+
+template <class T>
+uint64_t as_bytes(T value)
+{
+    return value > 0 ? static_cast<uint64_t>(value) : 0;
+}
+
+template <FunctionId Id, class ...Args>
+void record(Args... args)
+{
+    [[maybe_unused]] const std::tuple<Args...> arg{args...};
+    [[maybe_unused]] constexpr auto TEXTURE{MemoryCategory::Texture};
+
+    // 缓冲
+    if constexpr (FunctionId::glBufferData == Id || FunctionId::glBufferStorage == Id) {
+        assign(MemoryCategory::Buffer, bound(buffer_binding(std::get<0>(arg))), {as_bytes(std::get<1>(arg))});
+    }
+    else if constexpr (FunctionId::glNamedBufferData == Id || FunctionId::glNamedBufferStorage == Id) {
+        assign(MemoryCategory::Buffer, std::get<0>(arg), {as_bytes(std::get<1>(arg))});
+    }
+    // 纹理：逐级指定
+    else if constexpr (FunctionId::glTexImage1D == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))),
+            {texture_image_bytes(as_enum(std::get<2>(arg)), std::get<3>(arg), 1, 1)}, texture_image(std::get<0>(arg), std::get<1>(arg)));
+    }
+    else if constexpr (FunctionId::glTexImage2D == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))),
+            {texture_image_bytes(as_enum(std::get<2>(arg)), std::get<3>(arg), std::get<4>(arg), 1)},
+            texture_image(std::get<0>(arg), std::get<1>(arg)));
+    }
+    else if constexpr (FunctionId::glTexImage3D == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))),
+            {texture_image_bytes(as_enum(std::get<2>(arg)), std::get<3>(arg), std::get<4>(arg), std::get<5>(arg))},
+            texture_image(std::get<0>(arg), std::get<1>(arg)));
+    }
+    else if constexpr (FunctionId::glCopyTexImage1D == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))),
+            {texture_image_bytes(std::get<2>(arg), std::get<5>(arg), 1, 1)}, texture_image(std::get<0>(arg), std::get<1>(arg)));
+    }
+    else if constexpr (FunctionId::glCopyTexImage2D == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))),
+            {texture_image_bytes(std::get<2>(arg), std::get<5>(arg), std::get<6>(arg), 1)},
+            texture_image(std::get<0>(arg), std::get<1>(arg)));
+    }
+    else if constexpr (FunctionId::glCompressedTexImage1D == Id || FunctionId::glCompressedTexImage2D == Id
+        || FunctionId::glCompressedTexImage3D == Id) {
+        // 压缩数据的字节数由调用方给出
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))), {as_bytes(std::get<Hook::size_rule(Id).size_index>(arg))},
+            texture_image(std::get<0>(arg), std::get<1>(arg)));
+    }
+    else if constexpr (FunctionId::glTexImage2DMultisample == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))),
+            {texture_image_bytes(std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), 1) * as_bytes(std::get<1>(arg))});
+    }
+    else if constexpr (FunctionId::glTexImage3DMultisample == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))),
+            {texture_image_bytes(std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), std::get<5>(arg)) * as_bytes(std::get<1>(arg))});
+    }
+    // 纹理：不可变存储
+    else if constexpr (FunctionId::glTexStorage1D == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))),
+            storage_images(std::get<0>(arg), std::get<1>(arg), std::get<2>(arg), std::get<3>(arg), 1, 1));
+    }
+    else if constexpr (FunctionId::glTexStorage2D == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))),
+            storage_images(std::get<0>(arg), std::get<1>(arg), std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), 1));
+    }
+    else if constexpr (FunctionId::glTexStorage3D == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))), storage_images(std::get<0>(arg), std::get<1>(arg),
+            std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), std::get<5>(arg)));
+    }
+    else if constexpr (FunctionId::glTexStorage2DMultisample == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))), storage_images(std::get<0>(arg), 1,
+            std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), 1, as_bytes(std::get<1>(arg))));
+    }
+    else if constexpr (FunctionId::glTexStorage3DMultisample == Id) {
+        assign(TEXTURE, bound(texture_binding(std::get<0>(arg))), storage_images(std::get<0>(arg), 1,
+            std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), std::get<5>(arg), as_bytes(std::get<1>(arg))));
+    }
+    else if constexpr (FunctionId::glTextureStorage1D == Id) {
+        assign(TEXTURE, std::get<0>(arg), storage_images(GL_TEXTURE_1D, std::get<1>(arg), std::get<2>(arg), std::get<3>(arg), 1, 1));
+    }
+    else if constexpr (FunctionId::glTextureStorage2D == Id) {
+        assign(TEXTURE, std::get<0>(arg),
+            storage_images(GL_TEXTURE_2D, std::get<1>(arg), std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), 1));
+    }
+    else if constexpr (FunctionId::glTextureStorage3D == Id) {
+        assign(TEXTURE, std::get<0>(arg), storage_images(GL_TEXTURE_2D_ARRAY, std::get<1>(arg),
+            std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), std::get<5>(arg)));
+    }
+    else if constexpr (FunctionId::glTextureStorage2DMultisample == Id) {
+        assign(TEXTURE, std::get<0>(arg), storage_images(GL_TEXTURE_2D_MULTISAMPLE, 1,
+            std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), 1, as_bytes(std::get<1>(arg))));
+    }
+    else if constexpr (FunctionId::glTextureStorage3DMultisample == Id) {
+        assign(TEXTURE, std::get<0>(arg), storage_images(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, 1,
+            std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), std::get<5>(arg), as_bytes(std::get<1>(arg))));
+    }
+    // 渲染缓冲
+    else if constexpr (FunctionId::glRenderbufferStorage == Id) {
+        assign(MemoryCategory::Renderbuffer, bound(GL_RENDERBUFFER_BINDING),
+            {texture_image_bytes(std::get<1>(arg), std::get<2>(arg), std::get<3>(arg), 1)});
+    }
+    else if constexpr (FunctionId::glRenderbufferStorageMultisample == Id) {
+        assign(MemoryCategory::Renderbuffer, bound(GL_RENDERBUFFER_BINDING),
+            {texture_image_bytes(std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), 1) * std::max<uint64_t>(as_bytes(std::get<1>(arg)), 1)});
+    }
+    else if constexpr (FunctionId::glNamedRenderbufferStorage == Id) {
+        assign(MemoryCategory::Renderbuffer, std::get<0>(arg),
+            {texture_image_bytes(std::get<1>(arg), std::get<2>(arg), std::get<3>(arg), 1)});
+    }
+    else if constexpr (FunctionId::glNamedRenderbufferStorageMultisample == Id) {
+        assign(MemoryCategory::Renderbuffer, std::get<0>(arg),
+            {texture_image_bytes(std::get<2>(arg), std::get<3>(arg), std::get<4>(arg), 1) * std::max<uint64_t>(as_bytes(std::get<1>(arg)), 1)});
+    }
+    // 释放
+    else if constexpr (FunctionId::glDeleteBuffers == Id) {
+        release(MemoryCategory::Buffer, std::get<0>(arg), std::get<1>(arg));
+    }
+    else if constexpr (FunctionId::glDeleteTextures == Id) {
+        release(MemoryCategory::Texture, std::get<0>(arg), std::get<1>(arg));
+    }
+    else if constexpr (FunctionId::glDeleteRenderbuffers == Id) {
+        release(MemoryCategory::Renderbuffer, std::get<0>(arg), std::get<1>(arg));
+    }
+}
+
+struct MemoryLayer
+{
+    // 先调用驱动，分配的对象以调用时的绑定为准
+    template <FunctionId Id, class R, class ...Args>
+    static R invoke(R (APIENTRYP original)(Args...), Args... args) {
+        if constexpr (std::is_void_v<R>) {
+            original(args...);
+            record<Id>(args...);
+        }
+        else {
+            return original(args...);
+        }
+    }
+};
+
+} // namespace detail
+
+// 在 GL 函数加载之后调用；与其他拦截层叠加时，卸载顺序需与安装顺序相反
+inline void install()
+{
+    Hook::install_layer<detail::MemoryLayer>();
+    detail::g_installed = true;
+}
+
+inline void uninstall()
+{
+    Hook::uninstall_layer<detail::MemoryLayer>();
+    detail::g_installed = false;
+}
+
+inline bool installed()
+{
+    return detail::g_installed;
+}
+
+inline const MemoryUsage &usage()
+{
+    return detail::g_usage;
+}
+
+} // namespace Memory
+
+} // namespace GL
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <format>
+#include <functional>
+#include <list>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "gl_memory.hpp"
+
+namespace GL {
+
+enum class ResourceKind : uint8_t
+{
+    Texture,
+    Mesh,
+    Count
+};
+
+constexpr std::string_view resource_kind_name(ResourceKind kind)
+{
+    constexpr std::array<std::string_view, static_cast<size_t>(ResourceKind::Count)> NAMES{"texture", "mesh"};
+    return NAMES[static_cast<size_t>(kind)];
+}
+
+struct ResidencyCounter
+{
+    uint64_t resident_bytes{};
+    uint64_t peak_bytes{};
+    uint64_t resident{};        // 已驻留的资源数
+    uint64_t loading{};         // 正在异步加载的资源数
+    uint64_t registered{};
+    uint64_t evictions{};
+    uint64_t reloads{};
+};
+
+struct ResidencyStats
+{
+    std::array<ResidencyCounter, static_cast<size_t>(ResourceKind::Count)> kinds{};
+    uint64_t budget{};
+    uint64_t peak_usage{};          // end_frame 时的最大用量
+    uint64_t over_budget_frames{};  // 可驱逐的资源都已用尽、仍超出预算的帧数
+
+    const ResidencyCounter &kind(ResourceKind kind) const { return kinds[static_cast<size_t>(kind)]; }
+
+    std::string to_string() const {
+        const auto mib = [](uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+        std::string text{std::format("budget {:.2f} MiB, peak usage {:.2f} MiB, {} frames over budget",
+            mib(budget), mib(peak_usage), over_budget_frames)};
+        for (size_t i{}; i < kinds.size(); ++i) {
+            const auto &counter{kinds[i]};
+            text += std::format(", {} {}/{} resident {:.2f} MiB (peak {:.2f} MiB, {} loading, {} evictions, {} reloads)",
+                resource_kind_name(static_cast<ResourceKind>(i)), counter.resident, counter.registered,
+                mib(counter.resident_bytes), mib(counter.peak_bytes), counter.loading, counter.evictions, counter.reloads);
+        }
+        return text;
+    }
+};
+
+using ResourceId = uint64_t;
+
+// 纹理各 level 占用的字节数之和，可作为纹理 Loader 的返回值（GL 线程）；非 immutable 纹理只计 level 0
+inline uint64_t texture_bytes(GLuint texture)
+{
+    GLint levels{};
+    glGetTextureParameteriv(texture, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+    GLint internal_format{};
+    glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_INTERNAL_FORMAT, &internal_format);
+    uint64_t bytes{};
+    for (GLint level{}; level < std::max(levels, 1); ++level) {
+        GLint width{};
+        GLint height{};
+        GLint depth{};
+        glGetTextureLevelParameteriv(texture, level, GL_TEXTURE_WIDTH, &width);
+        glGetTextureLevelParameteriv(texture, level, GL_TEXTURE_HEIGHT, &height);
+        glGetTextureLevelParameteriv(texture, level, GL_TEXTURE_DEPTH, &depth);
+        bytes += texture_image_bytes(static_cast<GLenum>(internal_format), width, height, depth);
+    }
+    return bytes;
+}
+
+/**
+ * GPU 内存预算：登记可重新创建的纹理、网格，超出预算时按 LRU 驱逐，再次使用时重新加载
+ *
+ * 资源以一对回调登记：load 创建 GL 对象并返回占用的字节数，unload 删除这些对象。
+ * load 可以只发起异步加载（如 TextureCache::load）并返回 std::nullopt，之后每次 use() 再调用它，直到返回字节数；
+ * 加载期间 use() 返回 false，调用者绘制替代资源，帧循环不等待加载。
+ * 每帧绘制前对要用到的资源调用 use()；end_frame() 检查预算，从最久未使用的资源开始驱逐，
+ * 本帧用过的资源与 evictable 为 false 的资源不会被驱逐。
+ * 默认在已安装 Memory 拦截层时以其记录的全部 GL 分配（包括未登记的对象）计算用量，否则以登记资源的字节数计算。
+ * unload 可以推迟删除（如 TextureCache 在下一次 update() 时才删除纹理），Memory 的用量在本帧不会下降，
+ * 因此 end_frame() 每驱逐一个资源就从用量中扣除它登记的字节数，而不是重新读取用量，不会一帧驱逐全部资源。
+ * 只能在 GL 线程使用；回调中不能再调用 ResidencyManager。
+ */
+class ResidencyManager
+{
+public:
+    using Loader = std::function<std::optional<uint64_t>()>;
+    using Unloader = std::function<void()>;
+    using Usage = std::function<uint64_t()>;
+
+    // usage 为空时按上面的默认方式计算用量
+    explicit ResidencyManager(uint64_t budget_bytes, Usage usage = {})
+        : usage_{std::move(usage)}
+    {
+        stats_.budget = budget_bytes;
+    }
+    ~ResidencyManager() {
+        for (auto &[id, resource] : resources_) {
+            if (resource.resident || resource.loading) {
+                resource.unload();
+            }
+        }
+    }
+    ResidencyManager(const ResidencyManager &) = delete;
+    ResidencyManager(ResidencyManager &&) = delete;
+    ResidencyManager &operator=(const ResidencyManager &) = delete;
+    ResidencyManager &operator=(ResidencyManager &&) = delete;
+
+    // 只登记，第一次 use() 时才加载
+    ResourceId add(ResourceKind kind, Loader load, Unloader unload, bool evictable = true) {
+        if (nullptr == load || nullptr == unload) {
+            throw std::runtime_error{"ERROR::RESIDENCY what:resource needs both load and unload"};
+        }
+        const ResourceId id{++last_id_};
+        auto &resource{resources_[id]};
+        resource.kind = kind;
+        resource.load = std::move(load);
+        resource.unload = std::move(unload);
+        resource.evictable = evictable;
+        counter(kind).registered += 1;
+        return id;
+    }
+
+    void remove(ResourceId id) {
+        const auto it{resources_.find(id)};
+        if (resources_.end() == it) {
+            return;
+        }
+        if (it->second.resident) {
+            evict(it->second, false);
+        }
+        else if (it->second.loading) {
+            cancel(it->second);
+        }
+        counter(it->second.kind).registered -= 1;
+        resources_.erase(it);
+    }
+
+    // 标记本帧使用；未驻留时调用 load。返回 true 表示已驻留，可以绘制；异步加载未完成或 id 未登记时返回 false
+    bool use(ResourceId id) {
+        const auto it{resources_.find(id)};
+        if (resources_.end() == it) {
+            return false;
+        }
+        auto &resource{it->second};
+        resource.last_used = frame_;
+        if (!resource.resident) {
+            return load(id, resource);
+        }
+        if (resource.evictable) {
+            lru_.splice(lru_.begin(), lru_, resource.lru);
+        }
+        return true;
+    }
+
+    bool resident(ResourceId id) const {
+        const auto it{resources_.find(id)};
+        return resources_.end() != it && it->second.resident;
+    }
+
+    // 每帧结束时调用一次：超出预算时驱逐，然后进入下一帧
+    void end_frame() {
+        uint64_t current{usage()};
+        while (current > stats_.budget && !lru_.empty()) {
+            auto &resource{resources_.at(lru_.back())};
+            if (resource.last_used == frame_) {
+                break;  // 其余资源本帧都用过
+            }
+            const uint64_t freed{resource.bytes};
+            evict(resource);
+            current -= std::min(current, freed);
+        }
+        if (current > stats_.budget) {
+            stats_.over_budget_frames += 1;
+        }
+        stats_.peak_usage = std::max(stats_.peak_usage, current);
+        frame_ += 1;
+    }
+
+    void set_budget(uint64_t budget_bytes) { stats_.budget = budget_bytes; }
+    uint64_t budget() const { return stats_.budget; }
+
+    uint64_t usage() const {
+        if (nullptr != usage_) {
+            return usage_();
+        }
+        if (Memory::installed()) {
+            return Memory::usage().total.current;
+        }
+        uint64_t bytes{};
+        for (const auto &counter : stats_.kinds) {
+            bytes += counter.resident_bytes;
+        }
+        return bytes;
+    }
+
+    const ResidencyStats &stats() const { return stats_; }
+
+private:
+    struct Resource
+    {
+        ResourceKind kind{};
+        Loader load{};
+        Unloader unload{};
+        bool evictable{true};
+        bool resident{};
+        bool loading{};             // load 已返回过 std::nullopt，尚未完成
+        bool loaded_once{};
+        uint64_t bytes{};
+        uint64_t last_used{};
+        std::list<ResourceId>::iterator lru{};
+    };
+
+    ResidencyCounter &counter(ResourceKind kind) { return stats_.kinds[static_cast<size_t>(kind)]; }
+
+    bool load(ResourceId id, Resource &resource) {
+        const auto bytes{resource.load()};
+        auto &kind{counter(resource.kind)};
+        if (!bytes.has_value()) {
+            if (!resource.loading) {
+                resource.loading = true;
+                kind.loading += 1;
+            }
+            return false;
+        }
+        if (resource.loading) {
+            resource.loading = false;
+            kind.loading -= 1;
+        }
+        resource.bytes = *bytes;
+        resource.resident = true;
+        if (resource.loaded_once) {
+            kind.reloads += 1;
+        }
+        resource.loaded_once = true;
+        kind.resident += 1;
+        kind.resident_bytes += resource.bytes;
+        kind.peak_bytes = std::max(kind.peak_bytes, kind.resident_bytes);
+        if (resource.evictable) {
+            resource.lru = lru_.insert(lru_.begin(), id);
+        }
+        return true;
+    }
+
+    // 放弃未完成的异步加载
+    void cancel(Resource &resource) {
+        resource.unload();
+        resource.loading = false;
+        counter(resource.kind).loading -= 1;
+    }
+
+    void evict(Resource &resource, bool count = true) {
+        resource.unload();
+        resource.resident = false;
+        auto &kind{counter(resource.kind)};
+        kind.evictions += count ? 1 : 0;
+        kind.resident -= 1;
+        kind.resident_bytes -= resource.bytes;
+        resource.bytes = 0;
+        if (resource.evictable) {
+            lru_.erase(resource.lru);
+        }
+    }
+
+    Usage usage_{};
+    std::unordered_map<ResourceId, Resource> resources_{};
+    std::list<ResourceId> lru_{};   // 已驻留且可驱逐的资源，最近使用的在前
+    ResourceId last_id_{};
+    uint64_t frame_{};
+    ResidencyStats stats_{};
+};
+
+} // namespace GL
@@ -7,6 +7,7 @@
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include <string>
 
 #include <glad/glad.h>
 
@@ -14,24 +15,26 @@
 
 namespace GL {
 
-inline GLuint make_shader(GLenum shader_type, const std::filesystem::path &shader_code_path)
+inline std::string read_shader_file(const std::filesystem::path &shader_code_path)
 {
     std::ifstream shader_file;
-    std::string shader_code_str;
     shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     try {
         shader_file.open(shader_code_path);
         std::stringstream stream;
         stream << shader_file.rdbuf();
         shader_file.close();
-        shader_code_str = stream.str();
+        return stream.str();
     }
     catch (const std::ifstream::failure &error) {
         throw std::runtime_error{std::format(
             "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ code:{} what:{}",
             error.code().value(), error.what()) };
     }
+}
 
+inline GLuint compile_shader(GLenum shader_type, const std::string &shader_code_str)
+{
     GLuint shader_id{glCreateShader(shader_type)};
     const char *tmp_ptr{shader_code_str.data()};
     glShaderSource(shader_id, 1, &tmp_ptr, nullptr);
@@ -55,6 +58,11 @@ inline GLuint make_shader(GLenum shader_type, const std::filesystem::path &shade
     return shader_id;
 }
 
+inline GLuint make_shader(GLenum shader_type, const std::filesystem::path &shader_code_path)
+{
+    return compile_shader(shader_type, read_shader_file(shader_code_path));
+}
+
 template <class ...Args>
 inline GLuint make_shader_program(Args&&... args)
 {
@@ -80,12 +88,21 @@ inline GLuint make_shader_program(Args&&... args)
     return shader_program_id;
 }
 
+// 已读入内存的着色器源码，文件读取可以放在工作线程，编译留在 GL 线程
+struct ShaderSource
+{
+    std::string code{};
+};
+
 class Shader
 {
 public:
     Shader(GLenum shader_type, const std::filesystem::path &shader_code_path) {
         shader_id_ = make_shader(shader_type, shader_code_path);
     }
+    Shader(GLenum shader_type, const ShaderSource &source) {
+        shader_id_ = compile_shader(shader_type, source.code);
+    }
     ~Shader() {
         if (0 != shader_id_) {
             glDeleteShader(shader_id_);
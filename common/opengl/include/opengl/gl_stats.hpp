@@ -0,0 +1,356 @@
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <format>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include <glad/glad.h>
+
+#if defined(GL_FRAME_STATS)
+#include "gl_format.hpp"
+#include "gl_hook.hpp"
+#endif
+
+namespace GL {
+
+enum class BindTarget : uint8_t
+{
+    Program,        // glUseProgram / glBindProgramPipeline
+    VertexArray,
+    Buffer,         // 含 indexed / vertex buffer 绑定
+    Texture,        // 含 image texture 绑定
+    Sampler,
+    Framebuffer,
+    Renderbuffer,
+    TransformFeedback,
+    Count
+};
+
+constexpr std::string_view bind_target_name(BindTarget target)
+{
+    constexpr std::array<std::string_view, static_cast<size_t>(BindTarget::Count)> NAMES{
+        "program", "vao", "buffer", "texture", "sampler", "framebuffer", "renderbuffer", "xfb"};
+    return NAMES[static_cast<size_t>(target)];
+}
+
+/**
+ * 一帧内经 glad 发出的 GL 调用统计
+ * draw_calls 按 API 调用计数，glMultiDraw* 也只计 1 次；indirect / transform feedback 绘制的图元数未知，不计入 primitives
+ */
+struct FrameStats
+{
+    uint64_t frame{};
+    uint64_t gl_calls{};
+    uint64_t draw_calls{};
+    uint64_t indirect_draw_calls{};
+    uint64_t primitives{};
+    std::array<uint64_t, static_cast<size_t>(BindTarget::Count)> binds{};
+    uint64_t uniform_uploads{};
+    uint64_t buffer_upload_bytes{};
+    uint64_t texture_upload_bytes{};
+    uint64_t get_error_calls{};
+
+    uint64_t bind_count(BindTarget target) const { return binds[static_cast<size_t>(target)]; }
+
+    uint64_t total_binds() const {
+        uint64_t total{};
+        for (const auto count : binds) {
+            total += count;
+        }
+        return total;
+    }
+
+    std::string to_string() const {
+        std::string text{std::format(
+            "frame {}: {} calls, {} draws ({} indirect), {} primitives, {} uniforms, "
+            "upload buffer {} B texture {} B, {} glGetError, binds {}",
+            frame, gl_calls, draw_calls, indirect_draw_calls, primitives, uniform_uploads,
+            buffer_upload_bytes, texture_upload_bytes, get_error_calls, total_binds())};
+        std::string_view separator{" ("};
+        for (size_t i{}; i < binds.size(); ++i) {
+            if (0 != binds[i]) {
+                text += std::format("{}{}={}", separator, bind_target_name(static_cast<BindTarget>(i)), binds[i]);
+                separator = " ";
+            }
+        }
+        if (" " == separator) {
+            text += ')';
+        }
+        return text;
+    }
+};
+
+/**
+ * 帧统计拦截层，定义 GL_FRAME_STATS（cmake -DENABLE_GL_FRAME_STATS=ON）时才编译
+ * 未定义时全部接口为空实现，glad 函数指针保持原样，没有任何额外开销
+ * 计数器不加锁，只统计 GL 线程的调用
+ */
+namespace Stats {
+
+#if defined(GL_FRAME_STATS)
+
+inline constexpr bool ENABLED{true};
+
+namespace detail {
+
+using Hook::FunctionId;
+
+inline FrameStats g_current;
+inline FrameStats g_last;
+// 跟踪的 GL_PIXEL_UNPACK_BUFFER 绑定：非 0 时纹理上传的数据指针是 PBO 中的偏移，偏移 0 也是上传
+inline GLuint g_unpack_buffer{};
+
+constexpr uint64_t primitive_count(GLenum mode, uint64_t vertices)
+{
+    switch (mode) {
+        case GL_POINTS:                   return vertices;
+        case GL_LINES:                    return vertices / 2;
+        case GL_LINE_LOOP:                return vertices > 1 ? vertices : 0;
+        case GL_LINE_STRIP:               return vertices > 1 ? vertices - 1 : 0;
+        case GL_TRIANGLES:                return vertices / 3;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:             return vertices > 2 ? vertices - 2 : 0;
+        case GL_LINES_ADJACENCY:          return vertices / 4;
+        case GL_LINE_STRIP_ADJACENCY:     return vertices > 3 ? vertices - 3 : 0;
+        case GL_TRIANGLES_ADJACENCY:      return vertices / 6;
+        case GL_TRIANGLE_STRIP_ADJACENCY: return vertices > 5 ? vertices / 2 - 2 : 0;
+        default:                          return vertices;  // GL_PATCHES 按顶点数计
+    }
+}
+
+template <class T>
+uint64_t non_negative(T value)
+{
+    if constexpr (std::is_signed_v<T>) {
+        return value > 0 ? static_cast<uint64_t>(value) : 0;
+    }
+    else {
+        return static_cast<uint64_t>(value);
+    }
+}
+
+inline void count_draw(GLenum mode, uint64_t vertices, uint64_t instances)
+{
+    g_current.draw_calls += 1;
+    g_current.primitives += primitive_count(mode, vertices) * instances;
+}
+
+inline void count_multi_draw(GLenum mode, const GLsizei *counts, GLsizei draw_count)
+{
+    g_current.draw_calls += 1;
+    for (GLsizei i{}; nullptr != counts && i < draw_count; ++i) {
+        g_current.primitives += primitive_count(mode, non_negative(counts[i]));
+    }
+}
+
+inline void count_bind(BindTarget target, uint64_t count = 1)
+{
+    g_current.binds[static_cast<size_t>(target)] += count;
+}
+
+constexpr bool is_indirect_draw(std::string_view name)
+{
+    return (name.starts_with("glDraw") || name.starts_with("glMultiDraw"))
+        && (name.contains("Indirect") || name.contains("TransformFeedback"));
+}
+
+template <FunctionId Id, class ...Args>
+void count(Args... args)
+{
+    constexpr auto name{Hook::function_name(Id)};
+    [[maybe_unused]] const std::tuple<Args...> arg{args...};
+    g_current.gl_calls += 1;
+
+    // 绘制
+    if constexpr (FunctionId::glDrawArrays == Id) {
+        count_draw(std::get<0>(arg), non_negative(std::get<2>(arg)), 1);
+    }
+    else if constexpr (FunctionId::glDrawArraysInstanced == Id || FunctionId::glDrawArraysInstancedBaseInstance == Id) {
+        count_draw(std::get<0>(arg), non_negative(std::get<2>(arg)), non_negative(std::get<3>(arg)));
+    }
+    else if constexpr (FunctionId::glDrawElements == Id || FunctionId::glDrawElementsBaseVertex == Id) {
+        count_draw(std::get<0>(arg), non_negative(std::get<1>(arg)), 1);
+    }
+    else if constexpr (FunctionId::glDrawElementsInstanced == Id
+        || FunctionId::glDrawElementsInstancedBaseVertex == Id
+        || FunctionId::glDrawElementsInstancedBaseInstance == Id
+        || FunctionId::glDrawElementsInstancedBaseVertexBaseInstance == Id) {
+        count_draw(std::get<0>(arg), non_negative(std::get<1>(arg)), non_negative(std::get<4>(arg)));
+    }
+    else if constexpr (FunctionId::glDrawRangeElements == Id || FunctionId::glDrawRangeElementsBaseVertex == Id) {
+        count_draw(std::get<0>(arg), non_negative(std::get<3>(arg)), 1);
+    }
+    else if constexpr (FunctionId::glMultiDrawArrays == Id) {
+        count_multi_draw(std::get<0>(arg), std::get<2>(arg), std::get<3>(arg));
+    }
+    else if constexpr (FunctionId::glMultiDrawElements == Id || FunctionId::glMultiDrawElementsBaseVertex == Id) {
+        count_multi_draw(std::get<0>(arg), std::get<1>(arg), std::get<4>(arg));
+    }
+    else if constexpr (is_indirect_draw(name)) {
+        g_current.draw_calls += 1;
+        g_current.indirect_draw_calls += 1;
+    }
+    // 绑定
+    else if constexpr (FunctionId::glUseProgram == Id || FunctionId::glBindProgramPipeline == Id) {
+        count_bind(BindTarget::Program);
+    }
+    else if constexpr (FunctionId::glBindVertexArray == Id) {
+        count_bind(BindTarget::VertexArray);
+    }
+    else if constexpr (FunctionId::glBindBuffer == Id) {
+        count_bind(BindTarget::Buffer);
+        if (GL_PIXEL_UNPACK_BUFFER == std::get<0>(arg)) {
+            g_unpack_buffer = std::get<1>(arg);
+        }
+    }
+    else if constexpr (FunctionId::glBindBufferBase == Id || FunctionId::glBindBufferRange == Id
+        || FunctionId::glBindVertexBuffer == Id) {
+        count_bind(BindTarget::Buffer);
+    }
+    else if constexpr (FunctionId::glBindBuffersBase == Id || FunctionId::glBindBuffersRange == Id) {
+        count_bind(BindTarget::Buffer, non_negative(std::get<2>(arg)));
+    }
+    else if constexpr (FunctionId::glBindVertexBuffers == Id) {
+        count_bind(BindTarget::Buffer, non_negative(std::get<1>(arg)));
+    }
+    else if constexpr (FunctionId::glBindTexture == Id || FunctionId::glBindTextureUnit == Id
+        || FunctionId::glBindImageTexture == Id) {
+        count_bind(BindTarget::Texture);
+    }
+    else if constexpr (FunctionId::glBindTextures == Id || FunctionId::glBindImageTextures == Id) {
+        count_bind(BindTarget::Texture, non_negative(std::get<1>(arg)));
+    }
+    else if constexpr (FunctionId::glBindSampler == Id) {
+        count_bind(BindTarget::Sampler);
+    }
+    else if constexpr (FunctionId::glBindSamplers == Id) {
+        count_bind(BindTarget::Sampler, non_negative(std::get<1>(arg)));
+    }
+    else if constexpr (FunctionId::glBindFramebuffer == Id) {
+        count_bind(BindTarget::Framebuffer);
+    }
+    else if constexpr (FunctionId::glBindRenderbuffer == Id) {
+        count_bind(BindTarget::Renderbuffer);
+    }
+    else if constexpr (FunctionId::glBindTransformFeedback == Id) {
+        count_bind(BindTarget::TransformFeedback);
+    }
+    // 数据上传
+    else if constexpr (Hook::is_uniform_setter(name)) {
+        g_current.uniform_uploads += 1;
+    }
+    else if constexpr (name.contains("Buffer") && Hook::NONE != Hook::size_rule(Id).data_index) {
+        // 不带初始数据的 glBufferData / glBufferStorage 只分配存储
+        constexpr auto rule{Hook::size_rule(Id)};
+        if (nullptr != std::get<rule.data_index>(arg)) {
+            g_current.buffer_upload_bytes += non_negative(std::get<rule.size_index>(arg));
+        }
+    }
+    else if constexpr (name.starts_with("glCompressedTex") && Hook::NONE != Hook::size_rule(Id).data_index) {
+        constexpr auto rule{Hook::size_rule(Id)};
+        if (0 != g_unpack_buffer || nullptr != std::get<rule.data_index>(arg)) {
+            g_current.texture_upload_bytes += non_negative(std::get<rule.size_index>(arg));
+        }
+    }
+    else if constexpr (name.starts_with("glTex") && Hook::NONE != Hook::pixel_rule(Id).data_index) {
+        // 数据指针为空且未绑定 PBO 时只分配存储
+        constexpr auto rule{Hook::pixel_rule(Id)};
+        if (0 != g_unpack_buffer || nullptr != std::get<rule.data_index>(arg)) {
+            const auto dimension = [&]<size_t K>(std::integral_constant<size_t, K>) -> GLsizei {
+                if constexpr (Hook::NONE == K) { return 1; }
+                else { return std::get<K>(arg); }
+            };
+            g_current.texture_upload_bytes += image_bytes(
+                dimension(std::integral_constant<size_t, rule.width>{}),
+                dimension(std::integral_constant<size_t, rule.height>{}),
+                dimension(std::integral_constant<size_t, rule.depth>{}),
+                std::get<rule.format>(arg), std::get<rule.type>(arg), 1);
+        }
+    }
+    else if constexpr (FunctionId::glDeleteBuffers == Id) {
+        // 删除绑定中的缓冲时绑定恢复为 0
+        for (GLsizei i{}; nullptr != std::get<1>(arg) && i < std::get<0>(arg); ++i) {
+            if (0 != g_unpack_buffer && std::get<1>(arg)[i] == g_unpack_buffer) {
+                g_unpack_buffer = 0;
+            }
+        }
+    }
+    else if constexpr (FunctionId::glGetError == Id) {
+        g_current.get_error_calls += 1;
+    }
+}
+
+struct StatsLayer
+{
+    template <FunctionId Id, class R, class ...Args>
+    static R invoke(R (APIENTRYP original)(Args...), Args... args) {
+        count<Id>(args...);
+        return original(args...);
+    }
+};
+
+} // namespace detail
+
+// 在 GL 函数加载之后、GL 线程上调用；与其他拦截层叠加时，卸载顺序需与安装顺序相反
+inline void install()
+{
+    // 之后的绑定由拦截层跟踪，每次上传不再查询
+    GLint unpack_buffer{};
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpack_buffer);
+    detail::g_unpack_buffer = static_cast<GLuint>(unpack_buffer);
+    Hook::install_layer<detail::StatsLayer>();
+}
+
+inline void uninstall()
+{
+    Hook::uninstall_layer<detail::StatsLayer>();
+}
+
+// 在每帧 SwapWindow 之前调用，结束当前帧的统计
+inline void end_frame()
+{
+    const auto frame{detail::g_current.frame};
+    detail::g_last = detail::g_current;
+    detail::g_current = FrameStats{.frame = frame + 1};
+}
+
+// 上一个完整帧的统计
+inline const FrameStats &last_frame()
+{
+    return detail::g_last;
+}
+
+// 当前帧到目前为止的统计
+inline const FrameStats &current_frame()
+{
+    return detail::g_current;
+}
+
+#else
+
+inline constexpr bool ENABLED{false};
+
+inline void install() {}
+inline void uninstall() {}
+inline void end_frame() {}
+
+inline const FrameStats &last_frame()
+{
+    static const FrameStats empty{};
+    return empty;
+}
+
+inline const FrameStats &current_frame()
+{
+    return last_frame();
+}
+
+#endif
+
+} // namespace Stats
+
+} // namespace GL
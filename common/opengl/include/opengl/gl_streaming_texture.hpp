@@ -0,0 +1,448 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+#include <stb/stb_image.h>
+
+#include "gl_upload_ring.hpp"
+#include "image/pixel_convert.hpp"
+
+/**
+ * 每帧变化的纹理：软件绘制的画布、图片序列或 MJPEG 回放
+ *
+ * GL::StreamingTexture 只上传变化的矩形：像素写入自有的 UploadRing（容量为 buffered_frames 帧），
+ * 再以 PBO 偏移 glTexSubImage2D，GPU 读取上一帧时 CPU 已在写下一帧。环已满时 update() 返回 false 而不等待，
+ * 调用方保留脏区下一帧再试，渲染线程不会阻塞在 fence 上。
+ *
+ * GL::ImageSequence 在工作线程中用 stb_image 提前解码当前帧之后的 decode_ahead 帧，
+ * acquire() 只取已解码完成的帧，未完成时返回 nullptr，调用方继续显示上一帧。
+ *
+ * 两者配合使用时 GL 线程每帧只做一次内存拷贝与一次 glTexSubImage2D。
+ * 解码使用 stb_image，需有一个 .cpp 定义 STB_IMAGE_IMPLEMENTATION。
+ */
+namespace GL {
+
+struct TextureRect
+{
+    GLint x{};
+    GLint y{};
+    GLsizei width{};
+    GLsizei height{};
+};
+
+struct StreamingTextureStats
+{
+    uint64_t updates{};
+    uint64_t rects{};
+    uint64_t bytes{};
+    uint64_t ring_full{};       // 上传环已满、留到下一帧的次数
+    double max_update_ms{};
+
+    std::string to_string() const {
+        return std::format("{} updates ({} rects, {:.1f} MB), ring full {}, worst update {:.3f} ms",
+            updates, rects, static_cast<double>(bytes) / (1024.0 * 1024.0), ring_full, max_update_ms);
+    }
+};
+
+// 只能在 GL 线程使用
+class StreamingTexture
+{
+public:
+    StreamingTexture(GLsizei width, GLsizei height, GLenum internal_format = GL_RGBA8, size_t buffered_frames = 3)
+        : width_{width}, height_{height},
+          ring_{static_cast<GLsizeiptr>(frame_bytes(width, height) * std::max<size_t>(buffered_frames, 1))}
+    {
+        GLint previous_texture{};
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+        glGenTextures(1, &texture_);
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, width_, height_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous_texture));
+    }
+    ~StreamingTexture() {
+        glDeleteTextures(1, &texture_);
+    }
+    StreamingTexture(const StreamingTexture &) = delete;
+    StreamingTexture(StreamingTexture &&) = delete;
+    StreamingTexture &operator=(const StreamingTexture &) = delete;
+    StreamingTexture &operator=(StreamingTexture &&) = delete;
+
+    /**
+     * pixels: 整张 RGBA8 画面，每行 stride 字节；dirty 为空时上传整张
+     * 不阻塞：环已满时不上传任何矩形并返回 false
+     */
+    bool update(std::span<const uint8_t> pixels, size_t stride, std::span<const TextureRect> dirty = {}) {
+        const auto start{std::chrono::steady_clock::now()};
+        const TextureRect full{0, 0, width_, height_};
+        std::vector<TextureRect> rects;
+        size_t total{};
+        for (const auto &rect : dirty.empty() ? std::span{&full, 1} : dirty) {
+            const TextureRect clipped{clip(rect)};
+            if (clipped.width > 0 && clipped.height > 0) {
+                rects.push_back(clipped);
+                total += aligned_bytes(clipped);
+            }
+        }
+        // 矩形互相重叠、总量超过整帧时改为上传整张
+        if (total > frame_bytes(width_, height_)) {
+            rects.assign(1, full);
+            total = aligned_bytes(full);
+        }
+        if (rects.empty()) {
+            return true;
+        }
+        if (stride < static_cast<size_t>(width_) * 4 || pixels.size() < stride * static_cast<size_t>(height_ - 1) + static_cast<size_t>(width_) * 4) {
+            throw std::runtime_error{std::format("ERROR::STREAMING_TEXTURE what:buffer too small for {}x{}", width_, height_)};
+        }
+
+        const auto allocation{ring_.try_allocate(total, 16)};
+        if (!allocation.has_value()) {
+            stats_.ring_full += 1;
+            return false;
+        }
+
+        GLint previous_texture{};
+        GLint previous_unpack_buffer{};
+        GLint previous_alignment{};
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+        glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &previous_unpack_buffer);
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_alignment);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring_.buffer());
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        // 各矩形按行紧密写入环中，行长即矩形宽度，不需要 GL_UNPACK_ROW_LENGTH
+        size_t offset{};
+        for (const auto &rect : rects) {
+            const auto row_bytes{static_cast<size_t>(rect.width) * 4};
+            std::byte *out{allocation->data + offset};
+            const uint8_t *in{pixels.data() + static_cast<size_t>(rect.y) * stride + static_cast<size_t>(rect.x) * 4};
+            if (row_bytes == stride) {
+                std::memcpy(out, in, row_bytes * static_cast<size_t>(rect.height));
+            }
+            else {
+                for (GLsizei row{}; row < rect.height; ++row) {
+                    std::memcpy(out + static_cast<size_t>(row) * row_bytes, in + static_cast<size_t>(row) * stride, row_bytes);
+                }
+            }
+            glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                reinterpret_cast<const void *>(allocation->offset + static_cast<GLintptr>(offset)));
+            offset += aligned_bytes(rect);
+            stats_.bytes += row_bytes * static_cast<size_t>(rect.height);
+        }
+        ring_.submit();
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, static_cast<GLuint>(previous_unpack_buffer));
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous_texture));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, previous_alignment);
+
+        stats_.updates += 1;
+        stats_.rects += rects.size();
+        stats_.max_update_ms = std::max(stats_.max_update_ms,
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        return true;
+    }
+
+    GLuint id() const { return texture_; }
+    GLsizei width() const { return width_; }
+    GLsizei height() const { return height_; }
+    const StreamingTextureStats &stats() const { return stats_; }
+    const UploadRingStats &ring_stats() const { return ring_.stats(); }
+
+private:
+    static size_t frame_bytes(GLsizei width, GLsizei height) {
+        if (width <= 0 || height <= 0) {
+            throw std::runtime_error{std::format("ERROR::STREAMING_TEXTURE what:invalid size {}x{}", width, height)};
+        }
+        return static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+    }
+
+    // 每个矩形在环中的起点按 16 字节对齐
+    static size_t aligned_bytes(const TextureRect &rect) {
+        return (static_cast<size_t>(rect.width) * static_cast<size_t>(rect.height) * 4 + 15) / 16 * 16;
+    }
+
+    TextureRect clip(const TextureRect &rect) const {
+        const GLint x0{std::clamp(rect.x, 0, width_)};
+        const GLint y0{std::clamp(rect.y, 0, height_)};
+        const GLint x1{std::clamp(rect.x + rect.width, 0, width_)};
+        const GLint y1{std::clamp(rect.y + rect.height, 0, height_)};
+        return {x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0)};
+    }
+
+private:
+    GLsizei width_{};
+    GLsizei height_{};
+    GLuint texture_{};
+    UploadRing ring_;
+    StreamingTextureStats stats_{};
+};
+
+// 已解码的一帧，RGBA8，行顺序已按 flip_vertically 处理
+struct DecodedFrame
+{
+    size_t index{};
+    uint32_t width{};
+    uint32_t height{};
+    std::vector<uint8_t> rgba{};
+};
+
+struct ImageSequenceStats
+{
+    uint64_t decoded{};
+    uint64_t failed{};
+    uint64_t misses{};          // acquire 时该帧尚未解码完成
+    uint64_t discarded{};       // 解码完成前已移出预读窗口
+    double decode_ms{};         // 工作线程解码总耗时
+
+    std::string to_string() const {
+        return std::format("{} decoded ({:.2f} ms avg), {} failed, {} misses, {} discarded", decoded,
+            decode_ms / static_cast<double>(std::max<uint64_t>(decoded, 1)), failed, misses, discarded);
+    }
+};
+
+/**
+ * 图片序列，来源为按顺序排列的图片文件，或把多张 JPEG 直接拼接的 MJPEG 文件
+ * acquire() 可在任意线程调用，不需要 GL 上下文
+ */
+class ImageSequence
+{
+public:
+    ImageSequence(std::vector<std::filesystem::path> files, size_t decode_ahead = 4, bool flip_vertically = true,
+        size_t threads = std::max(2u, std::thread::hardware_concurrency()) / 2)
+        : files_{std::move(files)}, decode_ahead_{std::max<size_t>(decode_ahead, 1)}, flip_vertically_{flip_vertically}
+    {
+        if (files_.empty()) {
+            throw std::runtime_error{"ERROR::IMAGE_SEQUENCE what:empty sequence"};
+        }
+        start(threads);
+    }
+    ~ImageSequence() {
+        for (auto &worker : workers_) {
+            worker.request_stop();
+        }
+        tasks_cv_.notify_all();
+    }
+    ImageSequence(const ImageSequence &) = delete;
+    ImageSequence(ImageSequence &&) = delete;
+    ImageSequence &operator=(const ImageSequence &) = delete;
+    ImageSequence &operator=(ImageSequence &&) = delete;
+
+    // 目录：按文件名排序的 .jpg/.jpeg/.png/.bmp/.tga；.mjpeg/.mjpg：整个文件读入内存后按 SOI/EOI 标记切分
+    static std::unique_ptr<ImageSequence> open(const std::filesystem::path &path, size_t decode_ahead = 4, bool flip_vertically = true) {
+        if (std::filesystem::is_directory(path)) {
+            std::vector<std::filesystem::path> files;
+            for (const auto &entry : std::filesystem::directory_iterator{path}) {
+                auto extension{entry.path().extension().string()};
+                std::ranges::transform(extension, extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+                if (entry.is_regular_file() && (".jpg" == extension || ".jpeg" == extension || ".png" == extension
+                    || ".bmp" == extension || ".tga" == extension)) {
+                    files.push_back(entry.path());
+                }
+            }
+            std::ranges::sort(files);
+            return std::make_unique<ImageSequence>(std::move(files), decode_ahead, flip_vertically);
+        }
+        std::ifstream file{path, std::ios::binary | std::ios::ate};
+        if (!file) {
+            throw std::runtime_error{std::format("ERROR::IMAGE_SEQUENCE what:can not open {}", path.string())};
+        }
+        std::vector<std::byte> stream(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(stream.data()), static_cast<std::streamsize>(stream.size()));
+        return std::unique_ptr<ImageSequence>{new ImageSequence{std::move(stream), decode_ahead, flip_vertically}};
+    }
+
+    /**
+     * 返回第 index 帧（对帧数取模），尚未解码完成时返回 nullptr
+     * 同时把预读窗口移动到 [index, index + decode_ahead)，窗口外已解码的帧被释放
+     */
+    std::shared_ptr<const DecodedFrame> acquire(size_t index) {
+        index %= frame_count();
+        std::lock_guard lock{mutex_};
+        for (auto it{slots_.begin()}; it != slots_.end();) {
+            if (in_window(it->first, index)) {
+                ++it;
+                continue;
+            }
+            if (nullptr == it->second.frame && !it->second.failed) {
+                stats_.discarded += 1;
+            }
+            it = slots_.erase(it);
+        }
+        for (size_t ahead{}; ahead < decode_ahead_; ++ahead) {
+            const size_t frame{(index + ahead) % frame_count()};
+            if (!slots_.contains(frame)) {
+                slots_.emplace(frame, Slot{});
+                tasks_.push_back(frame);
+            }
+        }
+        tasks_cv_.notify_all();
+
+        const auto &slot{slots_.at(index)};
+        if (nullptr == slot.frame && !slot.failed) {
+            stats_.misses += 1;
+        }
+        return slot.frame;
+    }
+
+    size_t frame_count() const { return files_.empty() ? ranges_.size() : files_.size(); }
+
+    ImageSequenceStats stats() const {
+        std::lock_guard lock{mutex_};
+        return stats_;
+    }
+
+private:
+    struct Slot
+    {
+        std::shared_ptr<const DecodedFrame> frame{};
+        bool in_flight{false};
+        bool failed{false};
+    };
+
+    ImageSequence(std::vector<std::byte> stream, size_t decode_ahead, bool flip_vertically)
+        : stream_{std::move(stream)}, decode_ahead_{std::max<size_t>(decode_ahead, 1)}, flip_vertically_{flip_vertically}
+    {
+        // JPEG 的熵编码数据中 0xFF 后总是跟 0x00 或 RST 标记，不会出现 0xFFD9
+        const auto *bytes{reinterpret_cast<const uint8_t *>(stream_.data())};
+        for (size_t i{}; i + 1 < stream_.size(); ++i) {
+            if (0xFF != bytes[i] || 0xD8 != bytes[i + 1]) {
+                continue;
+            }
+            size_t end{i + 2};
+            while (end + 1 < stream_.size() && !(0xFF == bytes[end] && 0xD9 == bytes[end + 1])) {
+                ++end;
+            }
+            if (end + 1 >= stream_.size()) {
+                break;
+            }
+            ranges_.emplace_back(i, end + 2 - i);
+            i = end + 1;
+        }
+        if (ranges_.empty()) {
+            throw std::runtime_error{"ERROR::IMAGE_SEQUENCE what:no JPEG frames in stream"};
+        }
+        start(std::max(2u, std::thread::hardware_concurrency()) / 2);
+    }
+
+    void start(size_t threads) {
+        workers_.reserve(std::max<size_t>(threads, 1));
+        for (size_t i{}; i < std::max<size_t>(threads, 1); ++i) {
+            workers_.emplace_back([this](std::stop_token token) { worker_loop(token); });
+        }
+    }
+
+    // 窗口可能跨过序列末尾
+    bool in_window(size_t frame, size_t index) const {
+        return (frame + frame_count() - index) % frame_count() < decode_ahead_;
+    }
+
+    void worker_loop(std::stop_token token) {
+        std::unique_lock lock{mutex_};
+        while (tasks_cv_.wait(lock, token, [this] { return !tasks_.empty(); })) {
+            const size_t index{tasks_.front()};
+            tasks_.pop_front();
+            // 排队期间已移出窗口、或重新进入窗口时已有其他线程在解码的帧不再解码
+            const auto queued{slots_.find(index)};
+            if (slots_.end() == queued || queued->second.in_flight || nullptr != queued->second.frame || queued->second.failed) {
+                continue;
+            }
+            queued->second.in_flight = true;
+            lock.unlock();
+            const auto start{std::chrono::steady_clock::now()};
+            auto frame{decode(index)};
+            const double elapsed{std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()};
+            lock.lock();
+
+            (nullptr != frame ? stats_.decoded : stats_.failed) += 1;
+            stats_.decode_ms += elapsed;
+            // 已移出窗口时丢弃（acquire 中已计入 discarded）
+            if (const auto slot{slots_.find(index)}; slots_.end() != slot) {
+                slot->second.in_flight = false;
+                slot->second.failed = nullptr == frame;
+                slot->second.frame = std::move(frame);
+            }
+        }
+    }
+
+    std::shared_ptr<const DecodedFrame> decode(size_t index) const {
+        std::vector<std::byte> file_bytes;
+        std::span<const std::byte> bytes;
+        if (files_.empty()) {
+            const auto [offset, size]{ranges_[index]};
+            bytes = std::span{stream_}.subspan(offset, size);
+        }
+        else if (std::ifstream file{files_[index], std::ios::binary | std::ios::ate}; file) {
+            file_bytes.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(file_bytes.data()), static_cast<std::streamsize>(file_bytes.size()));
+            bytes = file_bytes;
+        }
+        if (bytes.empty()) {
+            return nullptr;
+        }
+
+        int width{};
+        int height{};
+        int channels{};
+        stbi_set_flip_vertically_on_load_thread(0);
+        const std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> decoded{stbi_load_from_memory(
+            reinterpret_cast<const stbi_uc *>(bytes.data()), static_cast<int>(bytes.size()), &width, &height, &channels, 0),
+            &stbi_image_free};
+        if (nullptr == decoded) {
+            return nullptr;
+        }
+        auto frame{std::make_shared<DecodedFrame>()};
+        frame->index = index;
+        frame->width = static_cast<uint32_t>(width);
+        frame->height = static_cast<uint32_t>(height);
+        frame->rgba.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+        Image::convert_to_rgba8({decoded.get(), static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(channels)},
+            static_cast<size_t>(channels), frame->width, frame->height, frame->rgba, {.flip_vertically = flip_vertically_});
+        return frame;
+    }
+
+private:
+    std::vector<std::filesystem::path> files_{};
+    std::vector<std::byte> stream_{};                       // MJPEG 文件内容
+    std::vector<std::pair<size_t, size_t>> ranges_{};       // 每帧在 stream_ 中的 (偏移, 长度)
+    size_t decode_ahead_{};
+    bool flip_vertically_{};
+
+    mutable std::mutex mutex_{};
+    std::condition_variable_any tasks_cv_{};
+    std::deque<size_t> tasks_{};
+    std::unordered_map<size_t, Slot> slots_{};
+    ImageSequenceStats stats_{};
+
+    // 最后声明，析构时先停止工作线程
+    std::vector<std::jthread> workers_{};
+};
+
+} // namespace GL
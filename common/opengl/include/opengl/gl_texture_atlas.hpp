@@ -0,0 +1,375 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cinttypes>
+#include <format>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "image/mip_chain.hpp"
+#include "image/rect_packer.hpp"
+#include "opengl/gl_format.hpp"
+
+/**
+ * 纹理图集：多张图片放入同一个 GL_TEXTURE_2D_ARRAY，每层用 Image::MaxRectsPacker 增量装箱
+ *
+ * 每张图片得到一个索引，查找表 AtlasRegion[] 以 SSBO 提供给着色器（UV 变换 + 层号），
+ * 不同材质的绘制只需绑定一次图集，不再逐个切换纹理。
+ * 所有层都放不下时把数组纹理层数翻倍（不超过 GL_MAX_ARRAY_TEXTURE_LAYERS），旧层由 glCopyImageSubData 在 GPU 上拷贝，
+ * 已有索引与 UV 保持不变。
+ *
+ * 每张图片的起点按 2^(levels - 1) 对齐，各级 mip 可以直接按位移后的坐标写入；四周各留出一个对齐单位的间隙，
+ * 写入后用图片的边缘纹素填充（压缩格式的图集不填充，间隙内容未定义），低分辨率 mip 的双线性过滤不会混入相邻图片。
+ * UV 向内收缩半个纹素，CLAMP_TO_EDGE 行为与单独的纹理一致，但 GL_REPEAT 需要在着色器里先对 uv 取 fract。
+ *
+ * 只能在 GL 线程使用。
+ */
+namespace GL {
+
+// std430：uv_transform 为 (scale.xy, offset.xy)，图集 uv = uv * scale + offset；layer.x 为数组层
+struct AtlasRegion
+{
+    std::array<float, 4> uv_transform{};
+    std::array<float, 4> layer{};
+};
+
+static_assert(sizeof(AtlasRegion) == 32);
+
+class TextureAtlas
+{
+public:
+    explicit TextureAtlas(GLenum internal_format = GL_RGBA8, GLsizei layer_size = 2048, GLsizei levels = 5)
+        : internal_format_{internal_format}, layer_size_{layer_size}, levels_{std::max(levels, 1)}
+    {
+        GLint max_size{};
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers_);
+        if (layer_size_ <= 0 || layer_size_ > max_size || (layer_size_ >> (levels_ - 1)) <= 0) {
+            throw std::runtime_error{std::format("ERROR::TEXTURE_ATLAS what:invalid layer size {} with {} levels", layer_size, levels)};
+        }
+        grow(1);
+    }
+
+    // 放入 width x height 的图片所需的最小层大小（含对齐与间隙）
+    static GLsizei required_layer_size(GLsizei width, GLsizei height, GLsizei levels) {
+        const GLsizei align{GLsizei{1} << (std::max(levels, 1) - 1)};
+        return reserve(std::max(width, height), align);
+    }
+    ~TextureAtlas() {
+        glDeleteTextures(1, &texture_);
+        if (0 != table_buffer_) {
+            glDeleteBuffers(1, &table_buffer_);
+        }
+    }
+    TextureAtlas(const TextureAtlas &) = delete;
+    TextureAtlas(TextureAtlas &&) = delete;
+    TextureAtlas &operator=(const TextureAtlas &) = delete;
+    TextureAtlas &operator=(TextureAtlas &&) = delete;
+
+    /**
+     * 拷贝已有 2D 纹理的各级 mip（glCopyImageSubData）
+     * 源纹理须有完整 mip 链或至少与图集级数相同；小图到 1x1 后其余各级重复 1x1。
+     * 内部格式不能按位拷贝时（如 .mipc 的 BC 格式放入 RGBA8 图集）读回解码后的 RGBA8，按像素路径重新写入。
+     * 超过单层大小或层数已达上限时返回 std::nullopt
+     */
+    std::optional<uint32_t> add(GLuint texture, GLsizei width, GLsizei height, GLsizei source_levels) {
+        const auto full_levels{static_cast<GLsizei>(std::bit_width(static_cast<unsigned>(std::max({width, height, 1}))))};
+        if (source_levels < std::min(levels_, full_levels)) {
+            throw std::runtime_error{std::format("ERROR::TEXTURE_ATLAS what:texture has {} of {} mip levels", source_levels, levels_)};
+        }
+        GLint source_format{};
+        glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_INTERNAL_FORMAT, &source_format);
+        if (!copy_compatible(static_cast<GLenum>(source_format), internal_format_)) {
+            if (GL_RGBA8 != internal_format_ && GL_SRGB8_ALPHA8 != internal_format_) {
+                throw std::runtime_error{std::format("ERROR::TEXTURE_ATLAS what:can not copy format {:#x} into atlas format {:#x}",
+                    source_format, internal_format_)};
+            }
+            return add(read_back(texture, width, height), width, height);
+        }
+        const auto placed{place(width, height)};
+        if (!placed.has_value()) {
+            return std::nullopt;
+        }
+        const auto &[layer, rect]{*placed};
+        const auto origin{image_origin(rect)};
+        for (GLsizei level{}; level < levels_; ++level) {
+            const GLsizei source_level{std::min(level, full_levels - 1)};
+            glCopyImageSubData(
+                texture, GL_TEXTURE_2D, source_level, 0, 0, 0,
+                texture_, GL_TEXTURE_2D_ARRAY, level, origin.first >> level, origin.second >> level, layer,
+                std::max(1, width >> level), std::max(1, height >> level), 1);
+        }
+        pad(layer, rect, width, height);
+        return commit(layer, rect, width, height);
+    }
+
+    // rgba: width x height 紧密排列的 RGBA8，各级 mip 在 CPU 上生成；图集须为 GL_RGBA8 或 GL_SRGB8_ALPHA8
+    std::optional<uint32_t> add(std::span<const uint8_t> rgba, GLsizei width, GLsizei height) {
+        if (GL_RGBA8 != internal_format_ && GL_SRGB8_ALPHA8 != internal_format_) {
+            throw std::runtime_error{"ERROR::TEXTURE_ATLAS what:pixel upload requires an RGBA8 atlas"};
+        }
+        if (width <= 0 || height <= 0 || rgba.size() < static_cast<size_t>(width) * static_cast<size_t>(height) * 4) {
+            throw std::runtime_error{std::format("ERROR::TEXTURE_ATLAS what:buffer too small for {}x{}", width, height)};
+        }
+        const auto placed{place(width, height)};
+        if (!placed.has_value()) {
+            return std::nullopt;
+        }
+        const auto &[layer, rect]{*placed};
+        const auto origin{image_origin(rect)};
+        const auto format{GL_SRGB8_ALPHA8 == internal_format_ ? Image::MipFormat::Srgb8Alpha8 : Image::MipFormat::Rgba8};
+
+        GLint previous_texture{};
+        GLint previous_unpack_buffer{};
+        GLint previous_alignment{};
+        glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &previous_texture);
+        glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &previous_unpack_buffer);
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_alignment);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+
+        Image::MipImage image{static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+            {rgba.begin(), rgba.begin() + static_cast<std::ptrdiff_t>(width) * height * 4}};
+        for (GLsizei level{}; level < levels_; ++level) {
+            if (level > 0 && (image.width > 1 || image.height > 1)) {
+                image = Image::downsample(image, format);
+            }
+            // 1x1 之后的各级重复最后一级
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, origin.first >> level, origin.second >> level, layer,
+                static_cast<GLsizei>(image.width), static_cast<GLsizei>(image.height), 1, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+        }
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, static_cast<GLuint>(previous_texture));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, static_cast<GLuint>(previous_unpack_buffer));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, previous_alignment);
+        pad(layer, rect, width, height);
+        return commit(layer, rect, width, height);
+    }
+
+    // 归还空间，索引不复用；纹理内容保留到被新图片覆盖
+    void remove(uint32_t index) {
+        auto &entry{entries_.at(index)};
+        if (!entry.live) {
+            return;
+        }
+        packers_[static_cast<size_t>(entry.layer)].release(entry.rect);
+        entry.live = false;
+    }
+
+    const AtlasRegion &region(uint32_t index) const { return regions_.at(index); }
+
+    // 查找表有变化时先写入 SSBO，再把数组纹理绑定到 texture_unit、查找表绑定到 table_binding
+    void bind(GLuint texture_unit, GLuint table_binding) {
+        if (table_dirty_) {
+            if (0 == table_buffer_) {
+                glGenBuffers(1, &table_buffer_);
+            }
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, table_buffer_);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(std::max<size_t>(regions_.size(), 1) * sizeof(AtlasRegion)),
+                regions_.empty() ? nullptr : regions_.data(), GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            table_dirty_ = false;
+        }
+        glActiveTexture(GL_TEXTURE0 + texture_unit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, table_binding, table_buffer_);
+    }
+
+    GLuint texture() const { return texture_; }
+    GLsizei layers() const { return static_cast<GLsizei>(packers_.size()); }
+    size_t size() const { return entries_.size(); }
+
+    std::string to_string() const {
+        double occupancy{};
+        for (const auto &packer : packers_) {
+            occupancy += packer.occupancy();
+        }
+        return std::format("{} images in {} layers of {}x{}, {:.1f}% occupied",
+            std::ranges::count_if(entries_, [](const Entry &entry) { return entry.live; }), packers_.size(),
+            layer_size_, layer_size_, occupancy * 100.0 / static_cast<double>(packers_.size()));
+    }
+
+private:
+    struct Entry
+    {
+        GLint layer{};
+        Image::PackRect rect{};
+        bool live{true};
+    };
+
+    GLsizei alignment() const { return GLsizei{1} << (levels_ - 1); }
+
+    // 尺寸向上对齐，再在两侧各加一个对齐单位的间隙
+    static GLsizei reserve(GLsizei size, GLsizei align) { return (size + align - 1) / align * align + 2 * align; }
+
+    // 图片在预留区域中的起点，左、下各空出一个对齐单位
+    std::pair<GLint, GLint> image_origin(const Image::PackRect &rect) const {
+        return {static_cast<GLint>(rect.x) + alignment(), static_cast<GLint>(rect.y) + alignment()};
+    }
+
+    // 依次尝试各层，都放不下时层数翻倍（不超过驱动上限）
+    std::optional<std::pair<GLint, Image::PackRect>> place(GLsizei width, GLsizei height) {
+        const GLsizei align{alignment()};
+        if (width <= 0 || height <= 0 || reserve(width, align) > layer_size_ || reserve(height, align) > layer_size_) {
+            return std::nullopt;
+        }
+        const auto reserved_width{static_cast<uint32_t>(reserve(width, align))};
+        const auto reserved_height{static_cast<uint32_t>(reserve(height, align))};
+        for (size_t layer{}; layer < packers_.size(); ++layer) {
+            if (const auto rect{packers_[layer].insert(reserved_width, reserved_height)}) {
+                return std::pair{static_cast<GLint>(layer), *rect};
+            }
+        }
+        if (packers_.size() >= static_cast<size_t>(max_layers_)) {
+            return std::nullopt;
+        }
+        const auto layer{packers_.size()};
+        grow(std::min(packers_.size() * 2, static_cast<size_t>(max_layers_)));
+        return std::pair{static_cast<GLint>(layer), *packers_[layer].insert(reserved_width, reserved_height)};
+    }
+
+    // glCopyImageSubData 按位拷贝：非压缩格式要求纹素大小相同，压缩格式要求同一种块编码（仅 sRGB 与否不同）
+    static bool copy_compatible(GLenum source, GLenum target) {
+        const auto linear = [](GLenum format) -> GLenum {
+            switch (format) {
+                case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+                case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:    return GL_COMPRESSED_RGBA_BPTC_UNORM;
+                case GL_COMPRESSED_SRGB8_ETC2:               return GL_COMPRESSED_RGB8_ETC2;
+                case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:    return GL_COMPRESSED_RGBA8_ETC2_EAC;
+                default:                                     return format;
+            }
+        };
+        const auto source_block{texel_block(source)};
+        const auto target_block{texel_block(target)};
+        if (1 != source_block.size || 1 != target_block.size) {
+            return linear(source) == linear(target);
+        }
+        return source_block.bytes == target_block.bytes;
+    }
+
+    // 读回源纹理第 0 级，压缩格式由驱动解码为 RGBA8
+    static std::vector<uint8_t> read_back(GLuint texture, GLsizei width, GLsizei height) {
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+        GLint previous_pack_buffer{};
+        GLint previous_alignment{};
+        glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &previous_pack_buffer);
+        glGetIntegerv(GL_PACK_ALIGNMENT, &previous_alignment);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glGetTextureImage(texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(rgba.size()), rgba.data());
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, static_cast<GLuint>(previous_pack_buffer));
+        glPixelStorei(GL_PACK_ALIGNMENT, previous_alignment);
+        return rgba;
+    }
+
+    // 在同一层内把 (x, y) 处宽 1（horizontal）或高 1 的一条纹素向 direction 方向复制 count 次；
+    // 每次以已填充的部分为源，复制次数为 log2(count)
+    void replicate(GLint level, GLint layer, GLint x, GLint y, GLsizei extent, bool horizontal, GLint direction, GLsizei count) {
+        for (GLsizei done{}; done < count;) {
+            const GLsizei n{std::max(1, std::min(done, count - done))};
+            const GLint source{0 == done ? 0 : (direction > 0 ? 1 : -done)};
+            const GLint target{direction > 0 ? 1 + done : -done - n};
+            if (horizontal) {
+                glCopyImageSubData(texture_, GL_TEXTURE_2D_ARRAY, level, x + source, y, layer,
+                    texture_, GL_TEXTURE_2D_ARRAY, level, x + target, y, layer, n, extent, 1);
+            }
+            else {
+                glCopyImageSubData(texture_, GL_TEXTURE_2D_ARRAY, level, x, y + source, layer,
+                    texture_, GL_TEXTURE_2D_ARRAY, level, x, y + target, layer, extent, n, 1);
+            }
+            done += n;
+        }
+    }
+
+    // 用图片的边缘纹素填满预留区域中的间隙：先左右各列，再上下各行（含四角）
+    void pad(GLint layer, const Image::PackRect &rect, GLsizei width, GLsizei height) {
+        // 压缩格式只能按 4x4 块拷贝，无法逐纹素复制
+        if (1 != texel_block(internal_format_).size) {
+            return;
+        }
+        const auto [origin_x, origin_y]{image_origin(rect)};
+        const GLsizei align{alignment()};
+        for (GLsizei level{}; level < levels_; ++level) {
+            const GLint x{origin_x >> level};
+            const GLint y{origin_y >> level};
+            const GLsizei w{std::max(1, width >> level)};
+            const GLsizei h{std::max(1, height >> level)};
+            const GLint left{static_cast<GLint>(rect.x) >> level};
+            const GLint bottom{static_cast<GLint>(rect.y) >> level};
+            const GLint right{static_cast<GLint>(rect.x + static_cast<uint32_t>(reserve(width, align))) >> level};
+            const GLint top{static_cast<GLint>(rect.y + static_cast<uint32_t>(reserve(height, align))) >> level};
+            replicate(level, layer, x, y, h, true, -1, x - left);
+            replicate(level, layer, x + w - 1, y, h, true, 1, right - (x + w));
+            replicate(level, layer, left, y, right - left, false, -1, y - bottom);
+            replicate(level, layer, left, y + h - 1, right - left, false, 1, top - (y + h));
+        }
+    }
+
+    uint32_t commit(GLint layer, const Image::PackRect &rect, GLsizei width, GLsizei height) {
+        const auto size{static_cast<float>(layer_size_)};
+        const auto [origin_x, origin_y]{image_origin(rect)};
+        AtlasRegion region{};
+        region.uv_transform = {
+            static_cast<float>(width - 1) / size, static_cast<float>(height - 1) / size,
+            (static_cast<float>(origin_x) + 0.5f) / size, (static_cast<float>(origin_y) + 0.5f) / size};
+        region.layer[0] = static_cast<float>(layer);
+        entries_.push_back({layer, rect, true});
+        regions_.push_back(region);
+        table_dirty_ = true;
+        return static_cast<uint32_t>(entries_.size() - 1);
+    }
+
+    // 分配 layers 层的新数组纹理，拷贝旧层后替换
+    void grow(size_t layers) {
+        GLint previous_texture{};
+        glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &previous_texture);
+
+        GLuint texture{};
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels_, internal_format_, layer_size_, layer_size_, static_cast<GLsizei>(layers));
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, 1 == levels_ ? GL_LINEAR : GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, static_cast<GLuint>(previous_texture));
+
+        if (0 != texture_) {
+            for (GLsizei level{}; level < levels_; ++level) {
+                const GLsizei size{std::max(1, layer_size_ >> level)};
+                glCopyImageSubData(texture_, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                    texture, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, size, size, static_cast<GLsizei>(packers_.size()));
+            }
+            glDeleteTextures(1, &texture_);
+        }
+        texture_ = texture;
+        while (packers_.size() < layers) {
+            packers_.emplace_back(static_cast<uint32_t>(layer_size_), static_cast<uint32_t>(layer_size_));
+        }
+    }
+
+private:
+    GLenum internal_format_{};
+    GLsizei layer_size_{};
+    GLsizei levels_{};
+    GLint max_layers_{};
+    GLuint texture_{};
+    std::vector<Image::MaxRectsPacker> packers_{};
+
+    std::vector<Entry> entries_{};
+    std::vector<AtlasRegion> regions_{};
+    GLuint table_buffer_{};
+    bool table_dirty_{true};
+};
+
+} // namespace GL
@@ -0,0 +1,742 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+#include <stb/stb_image.h>
+
+#include "gl_format.hpp"
+#include "gl_upload_ring.hpp"
+#include "image/asset_pack.hpp"
+#include "image/bc_encode.hpp"
+#include "image/mip_chain.hpp"
+#include "image/pixel_convert.hpp"
+
+/**
+ * 纹理缓存
+ *
+ * load() 可在任意线程调用，立即返回句柄；读文件、计算内容哈希与解码在线程池中完成。
+ * 同一规范化路径（且选项相同）返回同一个条目，不同路径但文件内容相同的条目共用同一个 GL 纹理，
+ * 且只解码一次。
+ * 解码后在工作线程用 Image::convert_to_rgba8 一次完成翻转、3 通道扩展为 RGBA 与预乘 alpha。
+ * 上传只在 GL 线程的 update() 中进行：先用 glTexStorage2D 分配，再按行分块 glTexSubImage2D，
+ * 每帧耗时超过预算即停止，大图跨多帧上传，单帧不会因解码或上传阻塞太久。
+ * TextureUpload::Pbo（默认）时每块先写入 UploadRing，驱动从 PBO 异步读取；环满时留到下一帧，不等待 GPU。
+ *
+ * 图片旁有 mip_convert 生成的同名 .mipc 时改为 mmap 该文件，按 level 逐级上传预生成的 mip 链，
+ * 不再解码原图，也不调用 glGenerateMipmap；行顺序在转换时已确定，flip_vertically 不再生效。
+ * .mipc 为 BC1/BC3/BC7 时以对应的压缩格式分配，按块行 glCompressedTexSubImage2D 上传。
+ * 设置 TextureOptions::compression 时，普通图片解码后在工作线程生成 mip 链并逐级压缩，同样以压缩格式上传。
+ * set_asset_pack() 之后，包中有的图片直接从包的映射内存解码（未压缩条目不复制），不再打开文件；
+ * 包内有同名 .mipc（add_asset_pack 的 MIP_CHAIN）时同样优先使用，未压缩的 .mipc 直接从包的映射内存上传。
+ *
+ * 句柄按引用计数共享，最后一个句柄释放后纹理在下一次 update() 时删除。
+ * 句柄必须在 TextureCache 之前释放；解码使用 stb_image，需有一个 .cpp 定义 STB_IMAGE_IMPLEMENTATION。
+ */
+namespace GL {
+
+struct TextureOptions
+{
+    GLenum wrap{GL_REPEAT};
+    GLenum min_filter{GL_LINEAR_MIPMAP_LINEAR};
+    GLenum mag_filter{GL_LINEAR};
+    bool mipmaps{true};
+    bool flip_vertically{true};     // OpenGL 纹理坐标原点在左下角
+    bool premultiply_alpha{false};  // 对 .mipc 不生效
+    bool prefer_mip_chain{true};    // 存在同名 .mipc 时加载它而不是解码原图
+    std::optional<Image::BcFormat> compression{};               // 加载时压缩，对 .mipc 不生效
+    Image::BcQuality compression_quality{Image::BcQuality::Fast};
+};
+
+// Client: glTexSubImage2D 直接读取客户端内存，驱动在调用时同步拷贝
+enum class TextureUpload : uint8_t { Client, Pbo };
+
+struct TextureCacheStats
+{
+    uint64_t requests{};
+    uint64_t path_hits{};           // 规范化路径相同，返回已有条目
+    uint64_t content_hits{};        // 路径不同但内容相同，共用纹理
+    uint64_t decoded{};
+    uint64_t packed{};              // 从资源包读取后解码
+    uint64_t mapped{};              // 直接映射的 .mipc
+    uint64_t compressed{};          // 加载时压缩的图片
+    double compress_ms{};           // 加载时压缩的总耗时（工作线程）
+    uint64_t failed{};
+    uint64_t uploaded{};
+    uint64_t uploaded_bytes{};
+    uint64_t ring_full{};           // 上传环已满、留到下一帧的次数
+    double max_update_ms{};         // 单次 update 的最长耗时
+
+    std::string to_string() const {
+        return std::format("{} requests ({} path hits, {} content hits), {} decoded ({} from pack), {} mapped, "
+            "{} compressed ({:.1f} ms), {} failed, {} uploaded ({:.1f} MB, ring full {}), worst update {:.3f} ms",
+            requests, path_hits, content_hits, decoded, packed, mapped, compressed, compress_ms, failed, uploaded,
+            static_cast<double>(uploaded_bytes) / (1024.0 * 1024.0), ring_full, max_update_ms);
+    }
+};
+
+namespace detail {
+
+// GL 纹理对象，内容相同的条目共用
+struct CachedTexture
+{
+    GLuint id{};
+    GLsizei width{};
+    GLsizei height{};
+};
+
+struct TextureEntry
+{
+    std::atomic<bool> failed{false};
+    std::shared_ptr<const CachedTexture> texture{};     // 仅 GL 线程读写
+};
+
+inline uint64_t fnv1a(std::span<const std::byte> bytes, uint64_t hash = 0xCBF29CE484222325ull)
+{
+    for (const auto byte : bytes) {
+        hash = (hash ^ static_cast<uint64_t>(byte)) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+} // namespace detail
+
+class TextureHandle
+{
+public:
+    TextureHandle() = default;
+
+    // 以下均需在 GL 线程调用；上传完成前 id() 为 0
+    GLuint id() const { return ready() ? entry_->texture->id : 0; }
+    GLsizei width() const { return ready() ? entry_->texture->width : 0; }
+    GLsizei height() const { return ready() ? entry_->texture->height : 0; }
+    bool ready() const { return nullptr != entry_ && nullptr != entry_->texture; }
+    bool failed() const { return nullptr != entry_ && entry_->failed.load(std::memory_order_relaxed); }
+
+    explicit operator bool() const { return nullptr != entry_; }
+
+private:
+    friend class TextureCache;
+    explicit TextureHandle(std::shared_ptr<detail::TextureEntry> entry) : entry_{std::move(entry)} {}
+
+    std::shared_ptr<detail::TextureEntry> entry_{};
+};
+
+class TextureCache
+{
+public:
+    explicit TextureCache(TextureUpload upload = TextureUpload::Pbo,
+        size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+        : upload_{upload}
+    {
+        workers_.reserve(threads);
+        for (size_t i{}; i < std::max<size_t>(1, threads); ++i) {
+            workers_.emplace_back([this](std::stop_token token) { worker_loop(token); });
+        }
+    }
+    // GL 线程、上下文仍有效时析构
+    ~TextureCache() {
+        for (auto &worker : workers_) {
+            worker.request_stop();
+        }
+        tasks_cv_.notify_all();
+        workers_.clear();
+        if (nullptr != current_ && 0 != current_->texture) {
+            glDeleteTextures(1, &current_->texture);
+        }
+        links_.clear();     // 释放纹理引用时会加锁写入 released_
+        delete_released();
+    }
+    TextureCache(const TextureCache &) = delete;
+    TextureCache(TextureCache &&) = delete;
+    TextureCache &operator=(const TextureCache &) = delete;
+    TextureCache &operator=(TextureCache &&) = delete;
+
+    // 在第一次 load() 之前调用；包中找不到的图片仍从文件读取（同名 .mipc 优先）
+    void set_asset_pack(std::shared_ptr<const Image::AssetPack> pack) { pack_ = std::move(pack); }
+
+    // 任意线程调用，不需要 GL 上下文
+    TextureHandle load(const std::filesystem::path &path, const TextureOptions &options = {}) {
+        auto mip_chain{path};
+        const bool try_mip_chain{options.prefer_mip_chain && MIP_CHAIN_EXTENSION != path.extension()};
+        if (try_mip_chain) {
+            mip_chain.replace_extension(MIP_CHAIN_EXTENSION);
+        }
+
+        // 包中的图片以包内名字为键，不访问文件系统；包内同名 .mipc 优先
+        const Image::PackEntry *packed{};
+        if (nullptr != pack_) {
+            packed = try_mip_chain ? pack_->find(mip_chain.generic_string()) : nullptr;
+            if (nullptr == packed) {
+                packed = pack_->find(path.generic_string());
+            }
+        }
+        std::filesystem::path canonical;
+        if (nullptr == packed) {
+            auto source{path};
+            std::error_code error;
+            if (try_mip_chain && std::filesystem::is_regular_file(mip_chain, error)) {
+                source = std::move(mip_chain);
+            }
+            canonical = std::filesystem::weakly_canonical(source, error);
+            if (error) {
+                canonical = std::filesystem::absolute(source).lexically_normal();
+            }
+        }
+        const auto location{nullptr != packed ? std::format("pak:{}", pack_->name(*packed)) : canonical.string()};
+        const auto key{std::format("{}|{}|{}|{}|{}|{}|{}|{}", location, options.wrap, options.min_filter,
+            options.mag_filter, options.mipmaps, options.flip_vertically, options.premultiply_alpha, compression_bits(options))};
+
+        std::lock_guard lock{mutex_};
+        stats_.requests += 1;
+        auto &slot{entries_[key]};
+        if (auto entry{slot.lock()}) {
+            stats_.path_hits += 1;
+            return TextureHandle{std::move(entry)};
+        }
+        // 最后一个句柄释放时删除路径映射，只加载一次的纹理不会一直留在表中
+        std::shared_ptr<detail::TextureEntry> entry{new detail::TextureEntry{}, [this, key](detail::TextureEntry *released) {
+            {
+                std::lock_guard lock{mutex_};
+                if (const auto it{entries_.find(key)}; entries_.end() != it && it->second.expired()) {
+                    entries_.erase(it);
+                }
+            }
+            // 条目持有的纹理引用在此释放，其删除器会再次加锁
+            delete released;
+        }};
+        slot = entry;
+        pending_ += 1;
+        tasks_.push_back([this, weak = std::weak_ptr{entry}, canonical, packed, options] { decode(weak, canonical, packed, options); });
+        tasks_cv_.notify_one();
+        return TextureHandle{std::move(entry)};
+    }
+
+    /**
+     * GL 线程每帧调用一次：删除已无句柄引用的纹理，在 budget 内上传已解码的图片
+     * 上传环未满时至少上传一块，保证进度
+     */
+    void update(std::chrono::microseconds budget = std::chrono::microseconds{2000}) {
+        const auto start{std::chrono::steady_clock::now()};
+        delete_released();
+        resolve_links();
+
+        GLint previous_texture{};
+        GLint previous_alignment{};
+        GLint previous_unpack_buffer{};
+        bool touched{false};
+        while (true) {
+            if (nullptr == current_) {
+                std::lock_guard lock{mutex_};
+                if (uploads_.empty()) {
+                    break;
+                }
+                current_ = std::make_unique<UploadJob>(std::move(uploads_.front()));
+                uploads_.pop_front();
+            }
+            if (!touched) {
+                glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+                glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_alignment);
+                glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &previous_unpack_buffer);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                if (TextureUpload::Pbo == upload_) {
+                    if (nullptr == ring_) {
+                        ring_ = std::make_unique<UploadRing>(RING_BYTES);
+                    }
+                    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring_->buffer());
+                }
+                else {
+                    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                }
+                touched = true;
+            }
+            if (!upload_chunk(*current_)) {
+                break;
+            }
+            if (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start) >= budget) {
+                break;
+            }
+        }
+        if (touched) {
+            if (nullptr != ring_) {
+                ring_->submit();
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, static_cast<GLuint>(previous_unpack_buffer));
+            glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous_texture));
+            glPixelStorei(GL_UNPACK_ALIGNMENT, previous_alignment);
+        }
+
+        const double elapsed{std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()};
+        std::lock_guard lock{mutex_};
+        stats_.max_update_ms = std::max(stats_.max_update_ms, elapsed);
+    }
+
+    // GL 线程调用：不限预算，直到全部请求上传完成或失败（启动阶段使用）
+    void finish() {
+        while (true) {
+            update(std::chrono::microseconds::max());
+            std::unique_lock lock{mutex_};
+            if (0 == pending_) {
+                return;
+            }
+            ready_cv_.wait_for(lock, std::chrono::milliseconds{1},
+                [this] { return !uploads_.empty() || !links_.empty() || 0 == pending_; });
+        }
+    }
+
+    // 尚未上传完成（也未失败）的请求数
+    size_t pending() const {
+        std::lock_guard lock{mutex_};
+        return pending_;
+    }
+
+    TextureCacheStats stats() const {
+        std::lock_guard lock{mutex_};
+        return stats_;
+    }
+
+private:
+    static constexpr size_t CHUNK_BYTES{256 * 1024};
+    static constexpr std::string_view MIP_CHAIN_EXTENSION{".mipc"};
+    static constexpr GLsizeiptr RING_BYTES{GLsizeiptr{16} << 20};
+
+    struct Level
+    {
+        const uint8_t *pixels{};
+        GLsizei width{};
+        GLsizei height{};
+    };
+
+    struct UploadJob
+    {
+        std::weak_ptr<detail::TextureEntry> entry{};
+        uint64_t content_key{};
+        TextureOptions options{};
+        std::shared_ptr<const void> storage{};     // stb 解码结果或映射的 .mipc 文件
+        std::vector<Level> levels{};                // 只有 level 0 时由 glGenerateMipmap 生成其余各级
+        std::optional<Image::BcFormat> compression{};   // 各级为压缩块，按块行上传
+        int channels{};
+        GLenum internal_format{};
+        GLenum format{};
+        GLuint texture{};
+        size_t level{};             // 正在上传的 level
+        GLsizei next_row{};
+    };
+
+    // 内容相同、纹理已存在的条目，在 GL 线程上关联到已有纹理
+    struct Link
+    {
+        std::weak_ptr<detail::TextureEntry> entry{};
+        std::shared_ptr<const detail::CachedTexture> texture{};
+    };
+
+    struct ContentSlot
+    {
+        std::weak_ptr<const detail::CachedTexture> texture{};
+        std::vector<std::weak_ptr<detail::TextureEntry>> waiting{};   // 解码中时到达的相同内容
+        bool in_flight{false};
+    };
+
+    void worker_loop(std::stop_token token) {
+        std::unique_lock lock{mutex_};
+        while (tasks_cv_.wait(lock, token, [this] { return !tasks_.empty(); })) {
+            auto task{std::move(tasks_.front())};
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    void decode(const std::weak_ptr<detail::TextureEntry> &weak, const std::filesystem::path &path, const Image::PackEntry *packed,
+        const TextureOptions &options) {
+        auto entry{weak.lock()};
+        if (nullptr == entry) {
+            std::lock_guard lock{mutex_};
+            pending_ -= 1;
+            return;
+        }
+
+        // .mipc 直接映射，各级像素已在文件中；其他格式读入内存后由 stb_image 解码
+        std::shared_ptr<const Image::MappedMipChain> mip_chain;
+        Image::AssetBytes bytes;
+        if (nullptr != packed) {
+            try {
+                bytes = pack_->load(*packed);
+                if (Image::is_mip_chain(bytes.bytes())) {
+                    mip_chain = std::make_shared<const Image::MappedMipChain>(std::move(bytes), pack_->name(*packed));
+                }
+            }
+            catch (const std::runtime_error &) {
+                fail(*entry, {});
+                return;
+            }
+        }
+        else if (MIP_CHAIN_EXTENSION == path.extension()) {
+            try {
+                mip_chain = std::make_shared<const Image::MappedMipChain>(path);
+            }
+            catch (const std::runtime_error &) {
+                fail(*entry, {});
+                return;
+            }
+        }
+        else if (std::ifstream file{path, std::ios::binary | std::ios::ate}; file) {
+            std::vector<std::byte> data(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            bytes = Image::AssetBytes{std::move(data)};
+        }
+        if (nullptr == mip_chain && 0 == bytes.size()) {
+            fail(*entry, {});
+            return;
+        }
+
+        const std::array<uint64_t, 7> option_bits{options.wrap, options.min_filter, options.mag_filter, options.mipmaps ? 1u : 0u,
+            options.flip_vertically ? 1u : 0u, options.premultiply_alpha ? 1u : 0u, compression_bits(options)};
+        const uint64_t content_key{detail::fnv1a(std::as_bytes(std::span{option_bits}),
+            detail::fnv1a(nullptr != mip_chain ? mip_chain->bytes() : bytes.bytes()))};
+        {
+            std::lock_guard lock{mutex_};
+            auto &slot{contents_[content_key]};
+            if (auto texture{slot.texture.lock()}) {
+                stats_.content_hits += 1;
+                links_.push_back({weak, std::move(texture)});
+                ready_cv_.notify_all();
+                return;
+            }
+            if (slot.in_flight) {
+                stats_.content_hits += 1;
+                slot.waiting.push_back(weak);
+                return;
+            }
+            slot.in_flight = true;
+        }
+
+        const bool mapped{nullptr != mip_chain};
+        UploadJob job{.entry = weak, .content_key = content_key, .options = options};
+        if (mapped) {
+            job.channels = 4;
+            job.internal_format = internal_format(mip_chain->format());
+            job.format = GL_RGBA;
+            job.compression = Image::bc_format(mip_chain->format());
+            for (size_t i{}; i < (options.mipmaps ? mip_chain->level_count() : 1); ++i) {
+                const auto level{mip_chain->level(i)};
+                job.levels.push_back({level.pixels.data(), static_cast<GLsizei>(level.width), static_cast<GLsizei>(level.height)});
+            }
+            job.storage = std::move(mip_chain);
+        }
+        else {
+            int width{};
+            int height{};
+            stbi_set_flip_vertically_on_load_thread(0);
+            std::shared_ptr<stbi_uc> decoded{stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(bytes.data()),
+                static_cast<int>(bytes.size()), &width, &height, &job.channels, 0), &stbi_image_free};
+            if (nullptr == decoded) {
+                fail(*entry, content_key);
+                return;
+            }
+            const auto [pixels, storage]{convert(decoded, job.channels, width, height, options)};
+            if (options.compression.has_value()) {
+                compress(job, std::span{pixels, static_cast<size_t>(width) * static_cast<size_t>(height) * 4},
+                    static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+            }
+            else {
+                std::tie(job.internal_format, job.format) = formats(job.channels);
+                job.levels.push_back({pixels, width, height});
+                job.storage = storage;
+            }
+        }
+
+        std::lock_guard lock{mutex_};
+        (mapped ? stats_.mapped : stats_.decoded) += 1;
+        stats_.packed += nullptr != packed ? 1 : 0;
+        uploads_.push_back(std::move(job));
+        ready_cv_.notify_all();
+    }
+
+    /**
+     * 工作线程：3 通道（压缩时 1、2 通道也是）扩展为新的 RGBA 缓冲区，4 通道原地转换，1、2 通道只翻转
+     * channels 更新为转换后的通道数；返回像素与持有它的存储
+     */
+    static std::pair<const uint8_t *, std::shared_ptr<const void>> convert(
+        const std::shared_ptr<stbi_uc> &decoded, int &channels, int width, int height, const TextureOptions &options) {
+        const Image::PixelConvert convert{.flip_vertically = options.flip_vertically, .premultiply_alpha = options.premultiply_alpha};
+        const auto n_pixels{static_cast<size_t>(width) * static_cast<size_t>(height)};
+        const std::span source{decoded.get(), n_pixels * static_cast<size_t>(channels)};
+        if (4 == channels) {
+            Image::convert_rgba8_in_place(source, static_cast<uint32_t>(width), static_cast<uint32_t>(height), convert);
+            return {decoded.get(), decoded};
+        }
+        if (3 == channels || options.compression.has_value()) {
+            auto rgba{std::make_shared<std::vector<uint8_t>>(n_pixels * 4)};
+            Image::convert_to_rgba8(source, static_cast<size_t>(channels), static_cast<uint32_t>(width), static_cast<uint32_t>(height), *rgba, convert);
+            channels = 4;
+            return {rgba->data(), rgba};
+        }
+        if (options.flip_vertically) {
+            Image::flip_vertically(source, static_cast<size_t>(width) * static_cast<size_t>(channels), static_cast<uint32_t>(height));
+        }
+        return {decoded.get(), decoded};
+    }
+
+    // 工作线程：按需生成 mip 链并逐级压缩，压缩结果由 job.storage 持有
+    void compress(UploadJob &job, std::span<const uint8_t> rgba, uint32_t width, uint32_t height) {
+        const auto start{std::chrono::steady_clock::now()};
+        auto chain{std::make_shared<Image::MipChain>()};
+        if (job.options.mipmaps) {
+            *chain = Image::build_mip_chain(rgba, width, height, Image::MipFormat::Rgba8);
+        }
+        else {
+            chain->levels.push_back({width, height, {rgba.begin(), rgba.end()}});
+        }
+        *chain = Image::compress_mip_chain(*chain, *job.options.compression, job.options.compression_quality);
+
+        job.channels = 4;
+        job.internal_format = internal_format(chain->format);
+        job.format = GL_RGBA;
+        job.compression = job.options.compression;
+        for (const auto &level : chain->levels) {
+            job.levels.push_back({level.pixels.data(), static_cast<GLsizei>(level.width), static_cast<GLsizei>(level.height)});
+        }
+        job.storage = std::move(chain);
+
+        const double elapsed{std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()};
+        std::lock_guard lock{mutex_};
+        stats_.compressed += 1;
+        stats_.compress_ms += elapsed;
+    }
+
+    // content_key 非空时，等待同一内容的条目一起失败
+    void fail(detail::TextureEntry &entry, std::optional<uint64_t> content_key) {
+        entry.failed.store(true, std::memory_order_relaxed);
+        // 在锁外析构：可能是条目的最后一个引用，其删除器会加锁
+        std::vector<std::shared_ptr<detail::TextureEntry>> others;
+        {
+            std::lock_guard lock{mutex_};
+            stats_.failed += 1;
+            pending_ -= 1;
+            if (content_key.has_value()) {
+                auto &slot{contents_[*content_key]};
+                for (const auto &waiting : slot.waiting) {
+                    if (auto other{waiting.lock()}) {
+                        other->failed.store(true, std::memory_order_relaxed);
+                        others.push_back(std::move(other));
+                    }
+                }
+                pending_ -= slot.waiting.size();
+                contents_.erase(*content_key);
+            }
+        }
+        ready_cv_.notify_all();
+    }
+
+    /**
+     * 上传环已满时返回 false
+     * 压缩格式以 4 行的块行为单位，行数须为 4 的倍数（最后一块除外）
+     */
+    bool upload_chunk(UploadJob &job) {
+        const auto &level{job.levels[job.level]};
+        const GLsizei row_height{job.compression.has_value() ? 4 : 1};
+        const auto row_bytes{job.compression.has_value()
+            ? Image::bc_image_bytes(*job.compression, static_cast<uint32_t>(level.width), 1)
+            : static_cast<size_t>(level.width) * static_cast<size_t>(job.channels)};
+        const GLsizei rows{std::clamp(static_cast<GLsizei>(CHUNK_BYTES / std::max<size_t>(row_bytes, 1)) * row_height,
+            row_height, level.height - job.next_row + row_height - 1) / row_height * row_height};
+        const GLsizei height{std::min(rows, level.height - job.next_row)};
+        const auto chunk_bytes{static_cast<size_t>(rows / row_height) * row_bytes};
+        const auto *source{level.pixels + static_cast<size_t>(job.next_row / row_height) * row_bytes};
+
+        const void *pixels{source};
+        if (nullptr != ring_) {
+            const auto allocation{ring_->try_allocate(chunk_bytes, 16)};
+            if (!allocation.has_value()) {
+                std::lock_guard lock{mutex_};
+                stats_.ring_full += 1;
+                return false;
+            }
+            std::memcpy(allocation->data, source, chunk_bytes);
+            pixels = reinterpret_cast<const void *>(allocation->offset);
+        }
+
+        const bool generate_mipmaps{job.options.mipmaps && 1 == job.levels.size() && !job.compression.has_value()};
+        const auto &base{job.levels.front()};
+        if (0 == job.texture) {
+            const auto size{static_cast<unsigned>(std::max(base.width, base.height))};
+            const auto levels{generate_mipmaps ? static_cast<GLsizei>(std::bit_width(size)) : static_cast<GLsizei>(job.levels.size())};
+            glGenTextures(1, &job.texture);
+            glBindTexture(GL_TEXTURE_2D, job.texture);
+            glTexStorage2D(GL_TEXTURE_2D, levels, job.internal_format, base.width, base.height);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLint>(job.options.wrap));
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLint>(job.options.wrap));
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(job.options.min_filter));
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(job.options.mag_filter));
+        }
+        else {
+            glBindTexture(GL_TEXTURE_2D, job.texture);
+        }
+
+        if (job.compression.has_value()) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(job.level), 0, job.next_row, level.width, height,
+                job.internal_format, static_cast<GLsizei>(chunk_bytes), pixels);
+        }
+        else {
+            glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(job.level), 0, job.next_row, level.width, height,
+                job.format, GL_UNSIGNED_BYTE, pixels);
+        }
+        job.next_row += height;
+        {
+            std::lock_guard lock{mutex_};
+            stats_.uploaded_bytes += chunk_bytes;
+        }
+        if (job.next_row < level.height) {
+            return true;
+        }
+        job.next_row = 0;
+        job.level += 1;
+        if (job.level < job.levels.size()) {
+            return true;
+        }
+
+        if (generate_mipmaps) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        const std::shared_ptr<const detail::CachedTexture> texture{
+            new detail::CachedTexture{job.texture, base.width, base.height},
+            [this, content_key = job.content_key](const detail::CachedTexture *released) {
+                {
+                    std::lock_guard lock{mutex_};
+                    released_.push_back(released->id);
+                    // 同一内容此后又上传了新纹理时保留
+                    if (const auto it{contents_.find(content_key)}; contents_.end() != it
+                        && it->second.texture.expired() && !it->second.in_flight) {
+                        contents_.erase(it);
+                    }
+                }
+                delete released;
+            }};
+
+        std::vector<std::weak_ptr<detail::TextureEntry>> waiting;
+        {
+            std::lock_guard lock{mutex_};
+            auto &slot{contents_[job.content_key]};
+            slot.texture = texture;
+            slot.in_flight = false;
+            waiting = std::move(slot.waiting);
+            slot.waiting.clear();
+            pending_ -= 1 + waiting.size();
+            stats_.uploaded += 1;
+        }
+        waiting.push_back(job.entry);
+        for (const auto &weak : waiting) {
+            if (auto entry{weak.lock()}) {
+                entry->texture = texture;
+            }
+        }
+        current_.reset();
+        return true;
+    }
+
+    void resolve_links() {
+        std::vector<Link> links;
+        {
+            std::lock_guard lock{mutex_};
+            links.swap(links_);
+            pending_ -= links.size();
+        }
+        for (auto &link : links) {
+            if (auto entry{link.entry.lock()}) {
+                entry->texture = std::move(link.texture);
+            }
+        }
+    }
+
+    void delete_released() {
+        std::vector<GLuint> released;
+        {
+            std::lock_guard lock{mutex_};
+            released.swap(released_);
+        }
+        if (!released.empty()) {
+            glDeleteTextures(static_cast<GLsizei>(released.size()), released.data());
+        }
+    }
+
+    static uint64_t compression_bits(const TextureOptions &options) {
+        return options.compression.has_value()
+            ? 1 + static_cast<uint64_t>(*options.compression) * 4 + static_cast<uint64_t>(options.compression_quality) : 0;
+    }
+
+    // BC7 为核心格式（BPTC），BC1/BC3 依赖 S3TC 扩展
+    static GLenum internal_format(Image::MipFormat format) {
+        switch (format) {
+            case Image::MipFormat::Rgba8:       return GL_RGBA8;
+            case Image::MipFormat::Srgb8Alpha8: return GL_SRGB8_ALPHA8;
+            case Image::MipFormat::Bc1:         return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case Image::MipFormat::Bc1Srgb:     return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+            case Image::MipFormat::Bc3:         return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case Image::MipFormat::Bc3Srgb:     return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+            case Image::MipFormat::Bc7:         return GL_COMPRESSED_RGBA_BPTC_UNORM;
+            case Image::MipFormat::Bc7Srgb:     return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+        }
+        return GL_RGBA8;
+    }
+
+    static std::pair<GLenum, GLenum> formats(int channels) {
+        switch (channels) {
+            case 1:  return {GL_R8, GL_RED};
+            case 2:  return {GL_RG8, GL_RG};
+            case 3:  return {GL_RGB8, GL_RGB};
+            default: return {GL_RGBA8, GL_RGBA};
+        }
+    }
+
+private:
+    mutable std::mutex mutex_{};
+    std::condition_variable_any tasks_cv_{};
+    std::condition_variable ready_cv_{};
+    std::deque<std::function<void()>> tasks_{};
+    std::unordered_map<std::string, std::weak_ptr<detail::TextureEntry>> entries_{};
+    std::unordered_map<uint64_t, ContentSlot> contents_{};
+    std::deque<UploadJob> uploads_{};
+    std::vector<Link> links_{};
+    std::vector<GLuint> released_{};
+    size_t pending_{};
+    TextureCacheStats stats_{};
+
+    std::shared_ptr<const Image::AssetPack> pack_{};    // 第一次 load() 之前设置，之后只读
+
+    // 仅 GL 线程访问
+    TextureUpload upload_{};
+    std::unique_ptr<UploadRing> ring_{};
+    std::unique_ptr<UploadJob> current_{};
+
+    // 最后声明，析构时先停止工作线程
+    std::vector<std::jthread> workers_{};
+};
+
+} // namespace GL
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace GL {
+
+struct GpuZone
+{
+    const char *name{};     // 需为字符串常量或生命周期覆盖整个 profiler 的字符串
+    uint32_t depth{};
+    int64_t begin_ns{};     // 已换算到 CPU steady_clock 时间轴
+    int64_t end_ns{};
+
+    double milliseconds() const { return static_cast<double>(end_ns - begin_ns) / 1e6; }
+};
+
+struct GpuFrame
+{
+    uint64_t frame{};
+    std::vector<GpuZone> zones{};
+};
+
+/**
+ * GPU 计时 zone
+ *
+ * 每个 zone 的开始与结束各写入一个 GL_TIMESTAMP 查询（glQueryCounter），因此 zone 可以嵌套
+ * （GL_TIME_ELAPSED 同一时刻只能有一个活动查询），同时压入 glPushDebugGroup 标签，
+ * RenderDoc / Nsight 中能看到相同的层级。
+ *
+ * 查询对象按帧放入环中，end_frame 只做非阻塞的 GL_QUERY_RESULT_AVAILABLE 检查，
+ * 结果通常在 2~3 帧后可读；环满时丢弃最旧一帧的结果而不是等待 GPU。
+ *
+ * GPU 时间戳通过 glGetInteger64v(GL_TIMESTAMP) 与 steady_clock 定期校准，
+ * 换算后的时间可以与 CPU zone 画在同一条时间轴上。
+ */
+class GpuProfiler
+{
+public:
+    explicit GpuProfiler(size_t frames_in_flight = 4) : slots_(frames_in_flight < 2 ? 2 : frames_in_flight) {
+        calibrate();
+    }
+    ~GpuProfiler() {
+        if (this == current_) {
+            current_ = nullptr;
+        }
+        for (auto &slot : slots_) {
+            if (!slot.queries.empty()) {
+                glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+            }
+        }
+    }
+    GpuProfiler(const GpuProfiler &) = delete;
+    GpuProfiler(GpuProfiler &&) = delete;
+    GpuProfiler &operator=(const GpuProfiler &) = delete;
+    GpuProfiler &operator=(GpuProfiler &&) = delete;
+
+    // GpuScope 使用的全局实例，为空时 GpuScope 不做任何事
+    static GpuProfiler *current() { return current_; }
+    static void set_current(GpuProfiler *profiler) { current_ = profiler; }
+
+    void begin_zone(const char *name) {
+        auto &slot{slots_[write_slot_]};
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+        slot.zones.push_back({name, static_cast<uint32_t>(open_zones_.size()), issue_timestamp(slot), NO_QUERY});
+        open_zones_.push_back(slot.zones.size() - 1);
+    }
+
+    void end_zone() {
+        if (open_zones_.empty()) {
+            return;
+        }
+        auto &slot{slots_[write_slot_]};
+        slot.zones[open_zones_.back()].end_query = issue_timestamp(slot);
+        open_zones_.pop_back();
+        glPopDebugGroup();
+    }
+
+    // 在 SwapWindow 之前调用
+    void end_frame() {
+        while (!open_zones_.empty()) {
+            end_zone();
+        }
+
+        auto &written{slots_[write_slot_]};
+        written.frame = frame_index_++;
+        written.pending = !written.zones.empty();
+        write_slot_ = (write_slot_ + 1) % slots_.size();
+
+        collect();
+
+        // 下一帧要写入的槽仍未完成：丢弃其结果，复用查询对象
+        auto &next{slots_[write_slot_]};
+        if (next.pending) {
+            dropped_frames_ += 1;
+            next.pending = false;
+        }
+        next.zones.clear();
+        next.used_queries = 0;
+
+        if (frame_index_ % CALIBRATE_INTERVAL == 0) {
+            calibrate();
+        }
+    }
+
+    /**
+     * 以 CPU 时间为基准记录 GPU 时钟偏移
+     * glGetInteger64v(GL_TIMESTAMP) 返回 GPU 当前时间，不会等待之前的命令执行完毕
+     */
+    void calibrate() {
+        const int64_t before{cpu_now_ns()};
+        GLint64 gpu{};
+        glGetInteger64v(GL_TIMESTAMP, &gpu);
+        const int64_t after{cpu_now_ns()};
+        offset_ns_ = before + (after - before) / 2 - gpu;
+    }
+
+    int64_t to_cpu_ns(GLuint64 gpu_ns) const { return static_cast<int64_t>(gpu_ns) + offset_ns_; }
+
+    static int64_t cpu_now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 结果可读时在 end_frame 内回调，按帧顺序
+    void set_frame_callback(std::function<void(const GpuFrame &)> callback) { on_frame_ = std::move(callback); }
+
+    const GpuFrame &latest_frame() const { return latest_; }
+    uint64_t dropped_frames() const { return dropped_frames_; }
+
+private:
+    static constexpr size_t NO_QUERY{~size_t{}};
+    static constexpr size_t QUERY_CHUNK{32};
+    static constexpr uint64_t CALIBRATE_INTERVAL{120};
+
+    struct PendingZone
+    {
+        const char *name{};
+        uint32_t depth{};
+        size_t begin_query{NO_QUERY};
+        size_t end_query{NO_QUERY};
+    };
+
+    struct Slot
+    {
+        uint64_t frame{};
+        bool pending{false};
+        std::vector<GLuint> queries{};
+        size_t used_queries{};
+        std::vector<PendingZone> zones{};
+    };
+
+    size_t issue_timestamp(Slot &slot) {
+        if (slot.used_queries == slot.queries.size()) {
+            slot.queries.resize(slot.queries.size() + QUERY_CHUNK);
+            glGenQueries(static_cast<GLsizei>(QUERY_CHUNK), slot.queries.data() + slot.used_queries);
+        }
+        glQueryCounter(slot.queries[slot.used_queries], GL_TIMESTAMP);
+        return slot.used_queries++;
+    }
+
+    // 从最旧的帧开始读取已完成的结果，遇到未完成的帧即停止
+    void collect() {
+        for (size_t i{}; i + 1 < slots_.size(); ++i) {
+            auto &slot{slots_[(write_slot_ + i) % slots_.size()]};
+            if (!slot.pending) {
+                continue;
+            }
+
+            // 查询按提交顺序完成，最后一个可用即全部可用
+            GLint available{};
+            glGetQueryObjectiv(slot.queries[slot.used_queries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (GL_FALSE == available) {
+                break;
+            }
+
+            latest_.frame = slot.frame;
+            latest_.zones.clear();
+            for (const auto &zone : slot.zones) {
+                GLuint64 begin{};
+                GLuint64 end{};
+                glGetQueryObjectui64v(slot.queries[zone.begin_query], GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(slot.queries[zone.end_query], GL_QUERY_RESULT, &end);
+                latest_.zones.push_back({zone.name, zone.depth, to_cpu_ns(begin), to_cpu_ns(end)});
+            }
+            slot.pending = false;
+            if (on_frame_) {
+                on_frame_(latest_);
+            }
+        }
+    }
+
+private:
+    static inline GpuProfiler *current_{nullptr};
+
+    std::vector<Slot> slots_;
+    size_t write_slot_{};
+    std::vector<size_t> open_zones_{};
+    uint64_t frame_index_{};
+    uint64_t dropped_frames_{};
+    int64_t offset_ns_{};
+    GpuFrame latest_{};
+    std::function<void(const GpuFrame &)> on_frame_{};
+};
+
+// 作用域内的 GPU zone，GpuProfiler::current() 为空时不做任何事
+class GpuScope
+{
+public:
+    explicit GpuScope(const char *name) : profiler_{GpuProfiler::current()} {
+        if (nullptr != profiler_) {
+            profiler_->begin_zone(name);
+        }
+    }
+    ~GpuScope() {
+        if (nullptr != profiler_) {
+            profiler_->end_zone();
+        }
+    }
+    GpuScope(const GpuScope &) = delete;
+    GpuScope(GpuScope &&) = delete;
+    GpuScope &operator=(const GpuScope &) = delete;
+    GpuScope &operator=(GpuScope &&) = delete;
+
+private:
+    GpuProfiler *profiler_{};
+};
+
+} // namespace GL
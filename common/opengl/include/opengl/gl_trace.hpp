@@ -0,0 +1,852 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "gl_format.hpp"
+#include "gl_hook.hpp"
+
+/**
+ * GL 调用流录制与回放
+ *
+ * 录制：拦截全部 glad 入口，把函数编号、与上一次调用的时间差以及参数序列化为二进制 trace。
+ * 指针参数按规则处理：已知大小的数据（缓冲数据、像素、uniform 数组、字符串）整体写入；
+ * 绑定了 PBO 或作为缓冲偏移使用的指针只记录数值；输出参数只记录回放时所需的暂存空间大小。
+ *
+ * 回放：按函数名把 trace 中的编号映射到当前构建的 glad 入口，逐帧重新执行。
+ * 计时模式按录制时的调用间隔等待，max speed 模式不等待，只度量驱动开销。
+ *
+ * 限制：对象名（buffer/texture/program ...）假定在新上下文中按相同顺序分配；
+ * 写入映射缓冲的数据、GL_UNPACK_ROW_LENGTH 等像素存储参数不会被记录。
+ */
+namespace GL::Trace {
+
+namespace detail {
+
+using Hook::FunctionId;
+using Hook::NONE;
+using Hook::SizeRule;
+using Hook::PixelRule;
+using Hook::size_rule;
+using Hook::pixel_rule;
+using Hook::uniform_elements;
+using Hook::is_uniform_setter;
+using Hook::uniform_location_index;
+
+constexpr uint32_t TRACE_MAGIC{0x52544C47}; // "GLTR"
+constexpr uint32_t TRACE_VERSION{1};
+constexpr uint16_t FRAME_MARKER{0xFFFF};
+constexpr size_t BLOB_ALIGNMENT{8};
+constexpr size_t DEFAULT_OUTPUT_SIZE{64 << 10};
+
+enum class PointerTag : uint8_t { Null, Offset, Blob, Output, StringArray, PointerArray };
+
+class Writer
+{
+public:
+    void put_bytes(const void *data, size_t size) {
+        const auto *bytes{static_cast<const uint8_t *>(data)};
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+    template <class T>
+    void put(const T &value) {
+        put_bytes(&value, sizeof(T));
+    }
+
+    void put_varint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer_.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        buffer_.push_back(static_cast<uint8_t>(value));
+    }
+
+    // 数据按文件偏移对齐，回放时可直接把指针交给驱动
+    void put_blob(const void *data, size_t size) {
+        put_varint(size);
+        while (0 != (base_offset_ + buffer_.size()) % BLOB_ALIGNMENT) {
+            buffer_.push_back(0);
+        }
+        put_bytes(data, size);
+    }
+
+    size_t size() const { return buffer_.size(); }
+    uint8_t *data() { return buffer_.data(); }
+
+    void flush(std::FILE *file) {
+        std::fwrite(buffer_.data(), 1, buffer_.size(), file);
+        base_offset_ += buffer_.size();
+        buffer_.clear();
+    }
+
+private:
+    std::vector<uint8_t> buffer_{};
+    size_t base_offset_{};
+};
+
+class Reader
+{
+public:
+    explicit Reader(std::span<const uint8_t> data) : data_{data} {}
+
+    bool empty() const { return position_ >= data_.size(); }
+    size_t position() const { return position_; }
+    void seek(size_t position) { position_ = position; }
+
+    const uint8_t *get_bytes(size_t size) {
+        if (position_ + size > data_.size()) {
+            throw std::runtime_error{"ERROR::TRACE what:unexpected end of trace"};
+        }
+        const auto *bytes{data_.data() + position_};
+        position_ += size;
+        return bytes;
+    }
+
+    template <class T>
+    T get() {
+        T value{};
+        std::memcpy(&value, get_bytes(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    uint64_t get_varint() {
+        uint64_t value{};
+        for (int shift{}; shift < 64; shift += 7) {
+            const auto byte{get<uint8_t>()};
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (0 == (byte & 0x80)) {
+                break;
+            }
+        }
+        return value;
+    }
+
+    std::span<const uint8_t> get_blob() {
+        const auto size{static_cast<size_t>(get_varint())};
+        while (0 != position_ % BLOB_ALIGNMENT) {
+            ++position_;
+        }
+        return {get_bytes(size), size};
+    }
+
+private:
+    std::span<const uint8_t> data_;
+    size_t position_{};
+};
+
+/***************************************************************************************************
+ * 指针参数的大小规则
+ **************************************************************************************************/
+
+// 输出参数（回读）的字节数参数
+constexpr SizeRule output_rule(FunctionId id)
+{
+    switch (id) {
+        case FunctionId::glGetBufferSubData:
+        case FunctionId::glGetNamedBufferSubData:         return {3, 2};
+        case FunctionId::glReadnPixels:                   return {7, 6};
+        case FunctionId::glGetTextureImage:
+        case FunctionId::glGetnTexImage:                  return {5, 4};
+        case FunctionId::glGetCompressedTextureImage:
+        case FunctionId::glGetnCompressedTexImage:        return {3, 2};
+        case FunctionId::glGetTextureSubImage:            return {11, 10};
+        case FunctionId::glGetCompressedTextureSubImage:  return {9, 8};
+        default:                                          return {};
+    }
+}
+
+// 读取像素的函数：绑定 GL_PIXEL_PACK_BUFFER 时输出指针是缓冲偏移
+constexpr bool is_pixel_pack(FunctionId id)
+{
+    switch (id) {
+        case FunctionId::glReadPixels:
+        case FunctionId::glReadnPixels:
+        case FunctionId::glGetTexImage:
+        case FunctionId::glGetnTexImage:
+        case FunctionId::glGetTextureImage:
+        case FunctionId::glGetTextureSubImage:
+        case FunctionId::glGetCompressedTexImage:
+        case FunctionId::glGetnCompressedTexImage:
+        case FunctionId::glGetCompressedTextureImage:
+        case FunctionId::glGetCompressedTextureSubImage:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// 上传像素的函数：绑定 GL_PIXEL_UNPACK_BUFFER 时数据指针是缓冲偏移
+constexpr bool is_pixel_unpack(FunctionId id)
+{
+    const auto name{Hook::function_name(id)};
+    return (name.starts_with("glTex") || name.starts_with("glTexture") || name.starts_with("glCompressedTex"))
+        && name.contains("Image");
+}
+
+// glMultiDraw* 的数组参数长度为 drawcount
+constexpr size_t multi_draw_count_index(FunctionId id)
+{
+    switch (id) {
+        case FunctionId::glMultiDrawArrays:             return 3;
+        case FunctionId::glMultiDrawElements:
+        case FunctionId::glMultiDrawElementsBaseVertex: return 4;
+        default:                                        return NONE;
+    }
+}
+
+// 输出大小未知、回放时无法安全执行的函数
+constexpr bool skip_on_replay(FunctionId id)
+{
+    switch (id) {
+        case FunctionId::glDebugMessageCallback:
+        case FunctionId::glGetTexImage:
+        case FunctionId::glGetCompressedTexImage:
+            return true;
+        default:
+            return false;
+    }
+}
+
+constexpr size_t vertex_attrib_elements(std::string_view name)
+{
+    if (!name.starts_with("glVertexAttrib") || !name.ends_with('v')) {
+        return 0;
+    }
+    for (const char c : name.substr(14)) {
+        if ('1' <= c && c <= '4') {
+            return static_cast<size_t>(c - '0');
+        }
+    }
+    return 0;
+}
+
+// glTexParameterfv / glClearBufferfv 等以 4 个元素为上限的参数数组
+constexpr bool is_vec4_parameter(std::string_view name)
+{
+    return (name.contains("Parameter") || name.starts_with("glClearBuffer") || name.starts_with("glClearNamedFramebuffer"))
+        && name.ends_with('v');
+}
+
+// 第 I 个参数前面紧跟一个 GLsizei（数量或长度）
+template <size_t I, class Tuple>
+constexpr bool follows_sizei()
+{
+    if constexpr (0 == I) {
+        return false;
+    }
+    else {
+        return std::is_same_v<std::tuple_element_t<I - 1, Tuple>, GLsizei>;
+    }
+}
+
+template <class T>
+size_t count_value(T value)
+{
+    if constexpr (std::is_signed_v<T>) {
+        return value > 0 ? static_cast<size_t>(value) : 0;
+    }
+    else {
+        return static_cast<size_t>(value);
+    }
+}
+
+template <class T>
+uint64_t to_u64(T value)
+{
+    if constexpr (std::is_pointer_v<T>) {
+        return reinterpret_cast<uintptr_t>(value);
+    }
+    else {
+        return static_cast<uint64_t>(value);
+    }
+}
+
+template <class T>
+T from_u64(uint64_t value)
+{
+    if constexpr (std::is_pointer_v<T>) {
+        return reinterpret_cast<T>(static_cast<uintptr_t>(value));
+    }
+    else {
+        return static_cast<T>(value);
+    }
+}
+
+/***************************************************************************************************
+ * 录制
+ **************************************************************************************************/
+
+struct RecordLayer;
+
+inline GLint query_integer(GLenum pname)
+{
+    GLint value{};
+    Hook::call_original<RecordLayer, FunctionId::glGetIntegerv>(pname, &value);
+    return value;
+}
+
+// 常量数据指针的字节数；std::nullopt 表示按数值（缓冲偏移）记录
+template <FunctionId Id, size_t I, class Tuple>
+std::optional<size_t> data_size(const Tuple &args)
+{
+    using T = std::tuple_element_t<I, Tuple>;
+    using Element = std::remove_const_t<std::remove_pointer_t<T>>;
+    constexpr auto name{Hook::function_name(Id)};
+    constexpr size_t element_size{std::is_void_v<Element> ? 1 : sizeof(std::conditional_t<std::is_void_v<Element>, char, Element>)};
+    constexpr size_t arity{std::tuple_size_v<Tuple>};
+    constexpr auto sized{size_rule(Id)};
+    constexpr auto pixel{pixel_rule(Id)};
+
+    if constexpr (is_pixel_unpack(Id) && (I == sized.data_index || I == pixel.data_index)) {
+        if (0 != query_integer(GL_PIXEL_UNPACK_BUFFER_BINDING)) {
+            return std::nullopt;
+        }
+    }
+
+    if constexpr (I == sized.data_index) {
+        return count_value(std::get<sized.size_index>(args));
+    }
+    else if constexpr (I == pixel.data_index) {
+        const auto dimension = [&]<size_t K>(std::integral_constant<size_t, K>) -> GLsizei {
+            if constexpr (K == NONE) { return 1; }
+            else { return std::get<K>(args); }
+        };
+        return image_bytes(
+            dimension(std::integral_constant<size_t, pixel.width>{}),
+            dimension(std::integral_constant<size_t, pixel.height>{}),
+            dimension(std::integral_constant<size_t, pixel.depth>{}),
+            std::get<pixel.format>(args),
+            std::get<pixel.type>(args),
+            query_integer(GL_UNPACK_ALIGNMENT));
+    }
+    else if constexpr (NONE != multi_draw_count_index(Id)) {
+        return count_value(std::get<multi_draw_count_index(Id)>(args)) * element_size;
+    }
+    else if constexpr (FunctionId::glSpecializeShader == Id) {
+        return count_value(std::get<2>(args)) * element_size;
+    }
+    else if constexpr (is_uniform_setter(name) && I + 1 == arity) {
+        return count_value(std::get<uniform_location_index(name) + 1>(args)) * uniform_elements(name) * element_size;
+    }
+    else if constexpr (0 != vertex_attrib_elements(name)) {
+        return vertex_attrib_elements(name) * element_size;
+    }
+    else if constexpr (is_vec4_parameter(name)) {
+        return 4 * element_size;
+    }
+    else if constexpr (name.ends_with("Arrayv") && I > 0) {
+        return count_value(std::get<I - 1>(args)) * (name.contains("DepthRange") ? 2 : 4) * element_size;
+    }
+    else if constexpr (!std::is_void_v<Element> && follows_sizei<I, Tuple>()) {
+        return count_value(std::get<I - 1>(args)) * element_size;
+    }
+    else {
+        return std::nullopt;
+    }
+}
+
+// 输出参数在回放时需要的暂存空间，std::nullopt 表示按数值（缓冲偏移）记录
+template <FunctionId Id, size_t I, class Tuple>
+std::optional<size_t> output_size(const Tuple &args)
+{
+    using Element = std::remove_pointer_t<std::tuple_element_t<I, Tuple>>;
+    constexpr size_t element_size{std::is_void_v<Element> ? 1 : sizeof(std::conditional_t<std::is_void_v<Element>, char, Element>)};
+    constexpr auto sized{output_rule(Id)};
+
+    if constexpr (is_pixel_pack(Id)) {
+        if (0 != query_integer(GL_PIXEL_PACK_BUFFER_BINDING)) {
+            return std::nullopt;
+        }
+    }
+
+    if constexpr (FunctionId::glReadPixels == Id) {
+        return std::max(DEFAULT_OUTPUT_SIZE, image_bytes(std::get<2>(args), std::get<3>(args), 1,
+            std::get<4>(args), std::get<5>(args), query_integer(GL_PACK_ALIGNMENT)));
+    }
+    else if constexpr (I == sized.data_index) {
+        return std::max(DEFAULT_OUTPUT_SIZE, count_value(std::get<sized.size_index>(args)));
+    }
+    else if constexpr (follows_sizei<I, Tuple>()) {
+        return std::max(DEFAULT_OUTPUT_SIZE, count_value(std::get<I - 1>(args)) * element_size);
+    }
+    else {
+        return DEFAULT_OUTPUT_SIZE;
+    }
+}
+
+template <FunctionId Id, size_t I, class Tuple>
+void write_arg(Writer &writer, const Tuple &args)
+{
+    using T = std::tuple_element_t<I, Tuple>;
+    const T &arg{std::get<I>(args)};
+
+    if constexpr (std::is_same_v<T, GLsync>) {
+        writer.put(to_u64(arg));
+    }
+    else if constexpr (std::is_same_v<T, GLDEBUGPROC>) {
+        // 回调函数不记录
+    }
+    else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+        writer.put(arg);
+    }
+    else {
+        static_assert(std::is_pointer_v<T>);
+        using Pointee = std::remove_pointer_t<T>;
+
+        // glShaderSource 的字符串已按长度截断并补 0，长度数组不再需要
+        if (nullptr == arg || (FunctionId::glShaderSource == Id && 3 == I)) {
+            writer.put(PointerTag::Null);
+        }
+        else if constexpr (!std::is_const_v<Pointee>) {
+            if (const auto size{output_size<Id, I>(args)}) {
+                writer.put(PointerTag::Output);
+                writer.put_varint(*size);
+            }
+            else {
+                writer.put(PointerTag::Offset);
+                writer.put(to_u64(arg));
+            }
+        }
+        else if constexpr (std::is_same_v<std::remove_cv_t<Pointee>, const GLchar *>) {
+            // glShaderSource 等的字符串数组，count 总是第 2 个参数
+            const auto count{count_value(std::get<1>(args))};
+            writer.put(PointerTag::StringArray);
+            writer.put_varint(count);
+            for (size_t i{}; i < count; ++i) {
+                size_t length{std::strlen(arg[i])};
+                if constexpr (FunctionId::glShaderSource == Id) {
+                    const GLint *lengths{std::get<3>(args)};
+                    if (nullptr != lengths && lengths[i] >= 0) {
+                        length = static_cast<size_t>(lengths[i]);
+                    }
+                }
+                std::string text{arg[i], length};
+                writer.put_blob(text.c_str(), length + 1);
+            }
+        }
+        else if constexpr (std::is_pointer_v<std::remove_cv_t<Pointee>>) {
+            const auto count{data_size<Id, I>(args).value_or(0) / sizeof(void *)};
+            writer.put(PointerTag::PointerArray);
+            writer.put_varint(count);
+            for (size_t i{}; i < count; ++i) {
+                writer.put(to_u64(arg[i]));
+            }
+        }
+        else if constexpr (std::is_same_v<std::remove_cv_t<Pointee>, GLchar>) {
+            size_t length{std::strlen(arg)};
+            if constexpr (follows_sizei<I, Tuple>()) {
+                if (std::get<I - 1>(args) >= 0) {
+                    length = static_cast<size_t>(std::get<I - 1>(args));
+                }
+            }
+            std::string text{arg, length};
+            writer.put(PointerTag::Blob);
+            writer.put_blob(text.c_str(), length + 1);
+        }
+        else {
+            if (const auto size{data_size<Id, I>(args)}) {
+                writer.put(PointerTag::Blob);
+                writer.put_blob(arg, *size);
+            }
+            else {
+                writer.put(PointerTag::Offset);
+                writer.put(to_u64(arg));
+            }
+        }
+    }
+}
+
+struct RecorderState
+{
+    std::mutex mutex{};
+    std::unique_ptr<std::FILE, int (*)(std::FILE *)> file{nullptr, &std::fclose};
+    Writer writer{};
+    std::chrono::steady_clock::time_point last_call{};
+    uint64_t frames{};
+
+    uint64_t elapsed_ns() {
+        const auto now{std::chrono::steady_clock::now()};
+        const auto delta{std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_call).count()};
+        last_call = now;
+        return static_cast<uint64_t>(std::max<int64_t>(delta, 0));
+    }
+
+    template <FunctionId Id, class R, class Tuple>
+    void record(const Tuple &args, uint64_t result) {
+        std::lock_guard lock{mutex};
+        writer.put(static_cast<uint16_t>(Id));
+        writer.put_varint(elapsed_ns());
+
+        // 记录负载长度，回放端遇到未知函数时可以跳过
+        const size_t size_position{writer.size()};
+        writer.put(uint32_t{});
+        [&]<size_t ...I>(std::index_sequence<I...>) {
+            (write_arg<Id, I>(writer, args), ...);
+        }(std::make_index_sequence<std::tuple_size_v<Tuple>>{});
+        if constexpr (!std::is_void_v<R>) {
+            writer.put(result);
+        }
+        const auto payload_size{static_cast<uint32_t>(writer.size() - size_position - sizeof(uint32_t))};
+        std::memcpy(writer.data() + size_position, &payload_size, sizeof(payload_size));
+    }
+};
+
+inline std::unique_ptr<RecorderState> g_recorder;
+
+struct RecordLayer
+{
+    template <FunctionId Id, class R, class ...Args>
+    static R invoke(R (APIENTRYP original)(Args...), Args... args) {
+        if constexpr (std::is_void_v<R>) {
+            original(args...);
+            g_recorder->record<Id, R>(std::tuple<Args...>{args...}, 0);
+        }
+        else {
+            const R result{original(args...)};
+            g_recorder->record<Id, R>(std::tuple<Args...>{args...}, to_u64(result));
+            return result;
+        }
+    }
+};
+
+/***************************************************************************************************
+ * 回放
+ **************************************************************************************************/
+
+struct ReplayState
+{
+    std::unordered_map<uint64_t, GLsync> syncs{};
+    std::map<std::pair<GLuint, GLint>, GLint> locations{};
+    GLuint current_program{};
+    std::array<std::vector<uint8_t>, 16> outputs{};
+    std::array<std::vector<const void *>, 4> pointer_arrays{};
+    bool names_diverged{false};
+
+    GLint remap_location(GLuint program, GLint location) const {
+        const auto it{locations.find({program, location})};
+        return it == locations.end() ? location : it->second;
+    }
+};
+
+template <class T, size_t I>
+T read_arg(Reader &reader, ReplayState &state)
+{
+    if constexpr (std::is_same_v<T, GLsync>) {
+        const auto it{state.syncs.find(reader.get<uint64_t>())};
+        return it == state.syncs.end() ? nullptr : it->second;
+    }
+    else if constexpr (std::is_same_v<T, GLDEBUGPROC>) {
+        return nullptr;
+    }
+    else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+        return reader.get<T>();
+    }
+    else {
+        using Pointee = std::remove_pointer_t<T>;
+        switch (reader.get<PointerTag>()) {
+            case PointerTag::Offset: {
+                return from_u64<T>(reader.get<uint64_t>());
+            }
+            case PointerTag::Blob: {
+                if constexpr (std::is_const_v<Pointee>) {
+                    return reinterpret_cast<T>(reader.get_blob().data());
+                }
+                break;
+            }
+            case PointerTag::Output: {
+                auto &output{state.outputs[I]};
+                output.resize(std::max<size_t>(output.size(), reader.get_varint()));
+                if constexpr (!std::is_const_v<Pointee>) {
+                    return reinterpret_cast<T>(output.data());
+                }
+                break;
+            }
+            case PointerTag::StringArray:
+            case PointerTag::PointerArray: {
+                auto &pointers{state.pointer_arrays[std::min<size_t>(I, state.pointer_arrays.size() - 1)]};
+                pointers.resize(reader.get_varint());
+                for (auto &pointer : pointers) {
+                    if constexpr (std::is_same_v<std::remove_cv_t<Pointee>, const GLchar *>) {
+                        pointer = reader.get_blob().data();
+                    }
+                    else {
+                        pointer = from_u64<const void *>(reader.get<uint64_t>());
+                    }
+                }
+                if constexpr (std::is_same_v<T, const GLchar *const *> || std::is_same_v<T, const void *const *>) {
+                    return reinterpret_cast<T>(pointers.data());
+                }
+                break;
+            }
+            case PointerTag::Null:
+                break;
+        }
+        return nullptr;
+    }
+}
+
+template <FunctionId Id, class R, class ...Args>
+void replay_invoke(Reader &reader, ReplayState &state, bool execute, R (APIENTRYP function)(Args...))
+{
+    auto args{[&]<size_t ...I>(std::index_sequence<I...>) {
+        return std::tuple<Args...>{read_arg<Args, I>(reader, state)...};
+    }(std::index_sequence_for<Args...>{})};
+    [[maybe_unused]] const uint64_t recorded{std::is_void_v<R> ? 0 : reader.get<uint64_t>()};
+
+    if (!execute || nullptr == function || skip_on_replay(Id)) {
+        return;
+    }
+
+    constexpr auto name{Hook::function_name(Id)};
+    if constexpr (is_uniform_setter(name)) {
+        constexpr size_t location_index{uniform_location_index(name)};
+        auto &location{std::get<location_index>(args)};
+        if constexpr (0 == location_index) {
+            location = state.remap_location(state.current_program, location);
+        }
+        else {
+            location = state.remap_location(std::get<0>(args), location);
+        }
+    }
+
+    if constexpr (std::is_void_v<R>) {
+        std::apply(function, args);
+    }
+    else {
+        const R result{std::apply(function, args)};
+        if constexpr (FunctionId::glFenceSync == Id) {
+            state.syncs[recorded] = result;
+        }
+        else if constexpr (FunctionId::glGetUniformLocation == Id) {
+            state.locations[{std::get<0>(args), from_u64<GLint>(recorded)}] = result;
+        }
+        else if constexpr (FunctionId::glCreateShader == Id || FunctionId::glCreateProgram == Id) {
+            state.names_diverged |= recorded != to_u64(result);
+        }
+    }
+
+    if constexpr (FunctionId::glUseProgram == Id) {
+        state.current_program = std::get<0>(args);
+    }
+    else if constexpr (FunctionId::glDeleteSync == Id) {
+        std::erase_if(state.syncs, [&](const auto &item) { return item.second == std::get<0>(args); });
+    }
+}
+
+using ReplayFunction = void (*)(Reader &, ReplayState &, bool);
+
+template <FunctionId Id>
+void replay_call(Reader &reader, ReplayState &state, bool execute)
+{
+    replay_invoke<Id>(reader, state, execute, Hook::Entry<Id>::pointer);
+}
+
+inline constexpr std::array<ReplayFunction, Hook::FUNCTION_COUNT> REPLAY_TABLE{
+#define GL_FUNCTION(name) &replay_call<FunctionId::name>,
+#include "opengl/gl_functions.inc"
+#undef GL_FUNCTION
+};
+
+} // namespace detail
+
+/**
+ * 开始录制，所有 glad 入口被替换为录制层；需在 GL 函数加载之后、当前上下文中调用
+ */
+inline void start_recording(const std::filesystem::path &path, uint32_t width, uint32_t height)
+{
+    auto state{std::make_unique<detail::RecorderState>()};
+    state->file.reset(std::fopen(path.string().c_str(), "wb"));
+    if (nullptr == state->file) {
+        throw std::runtime_error{std::format("ERROR::TRACE what:can not open {}", path.string())};
+    }
+
+    auto &writer{state->writer};
+    writer.put(detail::TRACE_MAGIC);
+    writer.put(detail::TRACE_VERSION);
+    writer.put(width);
+    writer.put(height);
+    writer.put(static_cast<uint32_t>(Hook::FUNCTION_COUNT));
+    for (const auto name : Hook::FUNCTION_NAMES) {
+        writer.put(static_cast<uint8_t>(name.size()));
+        writer.put_bytes(name.data(), name.size());
+    }
+    writer.flush(state->file.get());
+    state->last_call = std::chrono::steady_clock::now();
+
+    detail::g_recorder = std::move(state);
+    Hook::install_layer<detail::RecordLayer>();
+}
+
+inline bool is_recording()
+{
+    return nullptr != detail::g_recorder;
+}
+
+// 在每帧 SwapWindow 之前调用，写入帧标记并把本帧数据落盘
+inline void end_frame()
+{
+    if (!is_recording()) {
+        return;
+    }
+    auto &state{*detail::g_recorder};
+    std::lock_guard lock{state.mutex};
+    state.writer.put(detail::FRAME_MARKER);
+    state.writer.put_varint(state.elapsed_ns());
+    state.writer.put(uint32_t{});
+    state.writer.flush(state.file.get());
+    state.frames += 1;
+}
+
+inline uint64_t stop_recording()
+{
+    if (!is_recording()) {
+        return 0;
+    }
+    Hook::uninstall_layer<detail::RecordLayer>();
+    auto state{std::move(detail::g_recorder)};
+    std::lock_guard lock{state->mutex};
+    state->writer.flush(state->file.get());
+    return state->frames;
+}
+
+struct ReplayStats
+{
+    uint64_t frames{};
+    uint64_t calls{};
+    uint64_t unknown_calls{};       // 当前构建中不存在的函数
+    double total_ms{};              // 回放耗时（不含计时模式下的等待）
+    double worst_frame_ms{};
+};
+
+class Replayer
+{
+public:
+    explicit Replayer(const std::filesystem::path &path) {
+        std::ifstream file{path, std::ios::binary};
+        if (!file) {
+            throw std::runtime_error{std::format("ERROR::TRACE what:can not open {}", path.string())};
+        }
+        data_.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+
+        detail::Reader reader{data_};
+        if (detail::TRACE_MAGIC != reader.get<uint32_t>() || detail::TRACE_VERSION != reader.get<uint32_t>()) {
+            throw std::runtime_error{std::format("ERROR::TRACE what:{} is not a trace file", path.string())};
+        }
+        width_  = reader.get<uint32_t>();
+        height_ = reader.get<uint32_t>();
+
+        // 按函数名把录制时的编号映射到当前构建
+        std::unordered_map<std::string_view, size_t> current;
+        for (size_t i{}; i < Hook::FUNCTION_COUNT; ++i) {
+            current.emplace(Hook::FUNCTION_NAMES[i], i);
+        }
+        const auto count{reader.get<uint32_t>()};
+        function_map_.resize(count, UNKNOWN_FUNCTION);
+        for (auto &mapped : function_map_) {
+            const auto length{reader.get<uint8_t>()};
+            const std::string_view name{reinterpret_cast<const char *>(reader.get_bytes(length)), length};
+            if (const auto it{current.find(name)}; it != current.end()) {
+                mapped = it->second;
+            }
+        }
+        records_begin_ = reader.position();
+    }
+
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+    const ReplayStats &stats() const { return stats_; }
+    bool names_diverged() const { return state_.names_diverged; }
+
+    void rewind() {
+        position_ = records_begin_;
+        state_ = {};
+    }
+
+    /**
+     * 回放到下一个帧标记，返回 false 表示 trace 已结束
+     * max_speed 为 false 时按录制时的调用间隔等待，重现应用端的节奏
+     */
+    bool replay_frame(bool max_speed) {
+        detail::Reader reader{data_};
+        reader.seek(0 == position_ ? records_begin_ : position_);
+        if (reader.empty()) {
+            return false;
+        }
+
+        using Clock = std::chrono::steady_clock;
+        const auto frame_begin{Clock::now()};
+        auto target{frame_begin};
+        Clock::duration waited{};
+
+        while (!reader.empty()) {
+            const auto id{reader.get<uint16_t>()};
+            target += std::chrono::nanoseconds{reader.get_varint()};
+            const auto payload_size{reader.get<uint32_t>()};
+            if (detail::FRAME_MARKER == id) {
+                break;
+            }
+
+            if (!max_speed) {
+                const auto now{Clock::now()};
+                if (now < target) {
+                    std::this_thread::sleep_until(target);
+                    waited += Clock::now() - now;
+                }
+            }
+
+            const size_t next{reader.position() + payload_size};
+            const size_t mapped{id < function_map_.size() ? function_map_[id] : UNKNOWN_FUNCTION};
+            if (UNKNOWN_FUNCTION == mapped) {
+                stats_.unknown_calls += 1;
+            }
+            else {
+                detail::REPLAY_TABLE[mapped](reader, state_, true);
+                stats_.calls += 1;
+            }
+            reader.seek(next);
+        }
+        position_ = reader.position();
+
+        const double frame_ms{std::chrono::duration<double, std::milli>(Clock::now() - frame_begin - waited).count()};
+        stats_.frames += 1;
+        stats_.total_ms += frame_ms;
+        stats_.worst_frame_ms = std::max(stats_.worst_frame_ms, frame_ms);
+        return true;
+    }
+
+private:
+    static constexpr size_t UNKNOWN_FUNCTION{~size_t{}};
+
+    std::vector<uint8_t> data_{};
+    std::vector<size_t> function_map_{};
+    size_t records_begin_{};
+    size_t position_{};
+    uint32_t width_{};
+    uint32_t height_{};
+    detail::ReplayState state_{};
+    ReplayStats stats_{};
+};
+
+} // namespace GL::Trace
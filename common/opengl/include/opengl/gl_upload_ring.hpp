@@ -0,0 +1,166 @@
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <deque>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <glad/glad.h>
+
+namespace GL {
+
+struct UploadRingStats
+{
+    uint64_t bytes{};           // 已分配（写入）的字节数
+    uint64_t submits{};
+    uint64_t full{};            // try_allocate 因 GPU 仍在读取而失败的次数
+    double stall_ms{};          // allocate 等待 fence 的总耗时
+
+    std::string to_string() const {
+        return std::format("{:.1f} MB written, {} submits, {} full, {:.3f} ms stalled",
+            static_cast<double>(bytes) / (1024.0 * 1024.0), submits, full, stall_ms);
+    }
+};
+
+/**
+ * 持久映射的 GL_PIXEL_UNPACK_BUFFER 环
+ *
+ * CPU 直接把像素写入映射内存，再以缓冲区偏移调用 glTexSubImage2D，驱动不必在调用时同步拷贝客户端内存。
+ * 每次 submit() 插入一个 fence，覆盖上次 submit 以来的分配；fence 完成后空间才会被复用，
+ * 因此写入与 GPU 读取互不覆盖，上传与渲染重叠进行。
+ *
+ * 只能在 GL 线程使用；使用分配结果前需把 buffer() 绑定到 GL_PIXEL_UNPACK_BUFFER。
+ */
+class UploadRing
+{
+public:
+    struct Allocation
+    {
+        std::byte *data{};          // 映射内存，写入后无需 flush（coherent）
+        GLintptr offset{};          // 作为 glTexSubImage2D 的 pixels 参数
+    };
+
+    explicit UploadRing(GLsizeiptr size = GLsizeiptr{16} << 20)
+        : size_{static_cast<uint64_t>(size)}
+    {
+        constexpr GLbitfield MAP_FLAGS{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+        glGenBuffers(1, &buffer_);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, MAP_FLAGS);
+        mapped_ = static_cast<std::byte *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, MAP_FLAGS));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (nullptr == mapped_) {
+            glDeleteBuffers(1, &buffer_);
+            throw std::runtime_error{"ERROR::UPLOAD_RING what:map pixel unpack buffer failed"};
+        }
+    }
+    // 不等待 GPU：删除仍在使用的缓冲区由驱动延迟释放
+    ~UploadRing() {
+        for (const auto &region : regions_) {
+            glDeleteSync(region.fence);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &buffer_);
+    }
+    UploadRing(const UploadRing &) = delete;
+    UploadRing(UploadRing &&) = delete;
+    UploadRing &operator=(const UploadRing &) = delete;
+    UploadRing &operator=(UploadRing &&) = delete;
+
+    // 不阻塞；空间仍被 GPU 占用时返回 std::nullopt，调用方下一帧再试
+    std::optional<Allocation> try_allocate(size_t bytes, size_t alignment = 4) {
+        if (bytes > size_) {
+            throw std::runtime_error{std::format("ERROR::UPLOAD_RING what:{} bytes exceeds ring size {}", bytes, size_)};
+        }
+        retire();
+        if (tail_ == head_) {
+            // 环已空闲，从缓冲区开头分配，避免尾部剩余空间放不下时白白等待
+            head_ = (head_ + size_ - 1) / size_ * size_;
+            tail_ = submitted_ = head_;
+        }
+        uint64_t begin{(head_ + alignment - 1) / alignment * alignment};
+        if (begin % size_ + bytes > size_) {
+            begin = (begin / size_ + 1) * size_;    // 尾部放不下，从下一圈开头分配
+        }
+        if (begin + bytes - tail_ > size_) {
+            stats_.full += 1;
+            return std::nullopt;
+        }
+        head_ = begin + bytes;
+        stats_.bytes += bytes;
+        const auto offset{static_cast<size_t>(begin % size_)};
+        return Allocation{mapped_ + offset, static_cast<GLintptr>(offset)};
+    }
+
+    // 空间不足时等待最早的 fence
+    Allocation allocate(size_t bytes, size_t alignment = 4) {
+        while (true) {
+            if (auto allocation{try_allocate(bytes, alignment)}) {
+                return *allocation;
+            }
+            if (regions_.empty()) {
+                submit();
+            }
+            const auto start{std::chrono::steady_clock::now()};
+            glClientWaitSync(regions_.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT_NS);
+            stats_.stall_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    // 在读取本次分配的 GL 命令（glTexSubImage2D 等）之后调用
+    void submit() {
+        if (head_ == submitted_) {
+            return;
+        }
+        regions_.push_back({head_, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+        submitted_ = head_;
+        stats_.submits += 1;
+    }
+
+    GLuint buffer() const { return buffer_; }
+    size_t size() const { return static_cast<size_t>(size_); }
+    const UploadRingStats &stats() const { return stats_; }
+
+private:
+    static constexpr GLuint64 WAIT_TIMEOUT_NS{1'000'000'000};
+
+    struct Region
+    {
+        uint64_t end{};         // 该 fence 覆盖到的位置
+        GLsync fence{};
+    };
+
+    // 按提交顺序回收已完成的区域，遇到未完成的即停止
+    void retire() {
+        while (!regions_.empty()) {
+            const auto &region{regions_.front()};
+            if (GL_TIMEOUT_EXPIRED == glClientWaitSync(region.fence, 0, 0)) {
+                break;
+            }
+            tail_ = region.end;
+            glDeleteSync(region.fence);
+            regions_.pop_front();
+        }
+    }
+
+private:
+    uint64_t size_{};
+    GLuint buffer_{};
+    std::byte *mapped_{};
+
+    // 单调递增的位置，对 size_ 取模即为缓冲区偏移
+    uint64_t head_{};           // 下一次分配的起点
+    uint64_t submitted_{};      // 已插入 fence 的位置
+    uint64_t tail_{};           // GPU 可能仍在读取的最早位置
+    std::deque<Region> regions_{};
+
+    UploadRingStats stats_{};
+};
+
+} // namespace GL
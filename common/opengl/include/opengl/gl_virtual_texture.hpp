@@ -0,0 +1,583 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "gl_shader.hpp"
+#include "gl_upload_ring.hpp"
+#include "image/virtual_texture.hpp"
+
+/**
+ * 软件虚拟纹理：只使用 GL 4.6 核心功能，不依赖 ARB_sparse_texture，llvmpipe 上也能运行
+ *
+ * - 物理缓存：cache_pages x cache_pages 个页槽的普通 2D 纹理，每槽放一页（含边框）
+ * - 页表：GL_RGBA8UI、每级一个 mip，texel 为 (槽 x, 槽 y, 实际驻留的级, 1)；
+ *   未驻留的页指向最近的已驻留祖先，最粗一级常驻，着色器总能取到（较模糊的）内容
+ * - 反馈：场景以 VIRTUAL_TEXTURE_GLSL 中的 vt_feedback() 渲染到 1/FEEDBACK_SCALE 分辨率的帧缓冲，
+ *   输出每个像素需要的页；glReadPixels 写入持久映射的 PBO 并插入 fence，之后的 update() 中非阻塞读取
+ * - update()：解析反馈，缺失的页（连同祖先，粗的优先）交给工作线程从 mmap 的 .vtex 读出；
+ *   读完的页在预算内经 UploadRing 上传到最久未使用的槽（LRU），然后重建页表
+ *
+ * 只能在 GL 线程使用（工作线程只读文件）。
+ */
+namespace GL {
+
+/**
+ * 拼接到使用虚拟纹理的着色器中（#version 之后）
+ *   vt_sample(uv)    按屏幕导数选级，取样物理缓存
+ *   vt_feedback(uv)  反馈通道的输出颜色
+ */
+inline constexpr std::string_view VIRTUAL_TEXTURE_GLSL{R"glsl(
+uniform usampler2D u_vt_page_table;
+uniform sampler2D u_vt_cache;
+uniform vec4 u_vt_params;   // 虚拟空间边长（像素）、最粗一级的级号、物理缓存每边页数、lod 偏移
+uniform vec4 u_vt_page;     // 原图占虚拟空间的比例 xy、页边长、边框
+
+vec2 vt_virtual_uv(vec2 uv) {
+    return clamp(uv, 0.0, 1.0) * u_vt_page.xy;
+}
+
+float vt_level(vec2 virtual_uv) {
+    vec2 texel = virtual_uv * u_vt_params.x;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + u_vt_params.w;
+    return clamp(floor(lod), 0.0, u_vt_params.y);
+}
+
+ivec2 vt_page(vec2 virtual_uv, float level) {
+    float pages = exp2(u_vt_params.y - level);
+    return min(ivec2(virtual_uv * pages), ivec2(pages) - 1);
+}
+
+vec4 vt_feedback(vec2 uv) {
+    vec2 virtual_uv = vt_virtual_uv(uv);
+    float level = vt_level(virtual_uv);
+    return vec4(vec2(vt_page(virtual_uv, level)), level, 255.0) / 255.0;
+}
+
+vec4 vt_sample(vec2 uv) {
+    vec2 virtual_uv = vt_virtual_uv(uv);
+    float level = vt_level(virtual_uv);
+    uvec4 entry = texelFetch(u_vt_page_table, vt_page(virtual_uv, level), int(level));
+    float resident = float(entry.z);
+    vec2 in_page = virtual_uv * exp2(u_vt_params.y - resident) - vec2(vt_page(virtual_uv, resident));
+    float tile = u_vt_page.z + 2.0 * u_vt_page.w;
+    vec2 texel = vec2(entry.xy) * tile + u_vt_page.w + in_page * u_vt_page.z;
+    return textureLod(u_vt_cache, texel / (u_vt_params.z * tile), 0.0);
+}
+)glsl"};
+
+// 把 VIRTUAL_TEXTURE_GLSL 插入到 code 的 #version 行之后
+inline std::string with_virtual_texture_glsl(std::string_view code)
+{
+    const auto line_end{code.find('\n')};
+    const auto split{std::string_view::npos == line_end ? code.size() : line_end + 1};
+    return std::format("{}{}{}", code.substr(0, split), VIRTUAL_TEXTURE_GLSL, code.substr(split));
+}
+
+struct VirtualTextureStats
+{
+    uint64_t feedback_frames{};     // 已解析的反馈帧
+    uint64_t feedback_skipped{};    // 回读槽都在等待 GPU、跳过的反馈帧
+    uint64_t requested{};           // 交给工作线程读取的页
+    uint64_t uploaded{};
+    uint64_t evicted{};
+    uint64_t thrashing{};           // 所有槽都是最近一帧需要的页、无法换出的次数
+    double max_update_ms{};
+
+    std::string to_string() const {
+        return std::format("{} feedback frames ({} skipped), {} pages requested, {} uploaded, {} evicted, {} thrashing, worst update {:.3f} ms",
+            feedback_frames, feedback_skipped, requested, uploaded, evicted, thrashing, max_update_ms);
+    }
+};
+
+class VirtualTexture
+{
+public:
+    static constexpr GLsizei FEEDBACK_SCALE{8};
+
+    VirtualTexture(const std::filesystem::path &path, uint32_t cache_pages = 16, size_t threads = 2)
+        : file_{path}, cache_pages_{std::clamp<uint32_t>(cache_pages, 2, 255)},
+          ring_{static_cast<GLsizeiptr>(file_.tile_bytes() * UPLOAD_RING_PAGES)}
+    {
+        const auto tile{static_cast<GLsizei>(file_.tile_size())};
+        const auto top{file_.level_count() - 1};
+
+        GLint previous_texture{};
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+        glGenTextures(1, &cache_);
+        glBindTexture(GL_TEXTURE_2D, cache_);
+        glTexStorage2D(GL_TEXTURE_2D, 1, Image::is_srgb(file_.format()) ? GL_SRGB8_ALPHA8 : GL_RGBA8,
+            tile * static_cast<GLsizei>(cache_pages_), tile * static_cast<GLsizei>(cache_pages_));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // 整数纹理须使用 NEAREST 过滤才完整
+        glGenTextures(1, &page_table_);
+        glBindTexture(GL_TEXTURE_2D, page_table_);
+        glTexStorage2D(GL_TEXTURE_2D, static_cast<GLsizei>(file_.level_count()), GL_RGBA8UI,
+            static_cast<GLsizei>(file_.pages_per_side(0)), static_cast<GLsizei>(file_.pages_per_side(0)));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        table_.resize(file_.level_count());
+        for (uint32_t level{}; level < file_.level_count(); ++level) {
+            table_[level].resize(static_cast<size_t>(file_.pages_per_side(level)) * file_.pages_per_side(level));
+        }
+        slots_.resize(static_cast<size_t>(cache_pages_) * cache_pages_);
+
+        // 最粗一级只有一页，同步上传到 0 号槽并固定
+        GLint previous_unpack_buffer{};
+        GLint previous_alignment{};
+        glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &previous_unpack_buffer);
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_alignment);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, cache_);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tile, tile, GL_RGBA, GL_UNSIGNED_BYTE, file_.page(top, 0, 0).data());
+        const uint32_t top_key{key(top, 0, 0)};
+        slots_[0] = {top_key, 0, true, true};
+        resident_.emplace(top_key, 0);
+        upload_page_table();
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, static_cast<GLuint>(previous_unpack_buffer));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, previous_alignment);
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous_texture));
+
+        workers_.reserve(std::max<size_t>(threads, 1));
+        for (size_t i{}; i < std::max<size_t>(threads, 1); ++i) {
+            workers_.emplace_back([this](std::stop_token token) { worker_loop(token); });
+        }
+    }
+    ~VirtualTexture() {
+        for (auto &worker : workers_) {
+            worker.request_stop();
+        }
+        tasks_cv_.notify_all();
+        workers_.clear();
+        release_feedback();
+        glDeleteTextures(1, &page_table_);
+        glDeleteTextures(1, &cache_);
+    }
+    VirtualTexture(const VirtualTexture &) = delete;
+    VirtualTexture(VirtualTexture &&) = delete;
+    VirtualTexture &operator=(const VirtualTexture &) = delete;
+    VirtualTexture &operator=(VirtualTexture &&) = delete;
+
+    /**
+     * 绑定并清空反馈帧缓冲（viewport 的 1/FEEDBACK_SCALE），之后用 vt_feedback() 绘制场景
+     * 着色器须以 bind(program, ..., true) 设置 uniform，lod 按缩小的分辨率补偿
+     */
+    void begin_feedback(GLsizei viewport_width, GLsizei viewport_height) {
+        const GLsizei width{std::max(1, (viewport_width + FEEDBACK_SCALE - 1) / FEEDBACK_SCALE)};
+        const GLsizei height{std::max(1, (viewport_height + FEEDBACK_SCALE - 1) / FEEDBACK_SCALE)};
+        if (width != feedback_width_ || height != feedback_height_) {
+            create_feedback(width, height);
+        }
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_framebuffer_);
+        glGetIntegerv(GL_VIEWPORT, previous_viewport_.data());
+        glBindFramebuffer(GL_FRAMEBUFFER, feedback_framebuffer_);
+        glViewport(0, 0, width, height);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    // 把反馈读回空闲的 PBO 槽（不等待），恢复之前的帧缓冲与 viewport
+    void end_feedback() {
+        const auto slot{std::ranges::find_if(readbacks_, [](const Readback &readback) { return nullptr == readback.fence; })};
+        if (readbacks_.end() == slot) {
+            stats_.feedback_skipped += 1;
+        }
+        else {
+            GLint previous_pack_buffer{};
+            glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &previous_pack_buffer);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, feedback_framebuffer_);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glReadPixels(0, 0, feedback_width_, feedback_height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            slot->sequence = ++readback_sequence_;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, static_cast<GLuint>(previous_pack_buffer));
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous_framebuffer_));
+        glViewport(previous_viewport_[0], previous_viewport_[1], previous_viewport_[2], previous_viewport_[3]);
+    }
+
+    /**
+     * GL 线程每帧调用一次：解析已完成的反馈，请求缺失的页，在 budget 内上传已读出的页
+     * 不等待 GPU 也不等待工作线程
+     */
+    void update(std::chrono::microseconds budget = std::chrono::microseconds{2000}) {
+        const auto start{std::chrono::steady_clock::now()};
+        frame_ += 1;
+        read_feedback();
+
+        GLint previous_texture{};
+        GLint previous_unpack_buffer{};
+        GLint previous_alignment{};
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+        glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &previous_unpack_buffer);
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring_.buffer());
+        glBindTexture(GL_TEXTURE_2D, cache_);
+        bool uploaded{false};
+        while (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start) < budget) {
+            LoadedPage page;
+            {
+                std::lock_guard lock{mutex_};
+                if (loaded_.empty()) {
+                    break;
+                }
+                page = std::move(loaded_.front());
+                loaded_.pop_front();
+            }
+            const auto result{upload(page)};
+            if (UploadResult::Retry == result) {
+                std::lock_guard lock{mutex_};
+                loaded_.push_front(std::move(page));
+                break;
+            }
+            pending_.erase(page.key);
+            if (UploadResult::Thrashing == result) {
+                break;
+            }
+            uploaded = uploaded || UploadResult::Uploaded == result;
+        }
+        if (uploaded) {
+            ring_.submit();
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            upload_page_table();
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, static_cast<GLuint>(previous_unpack_buffer));
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous_texture));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, previous_alignment);
+        stats_.max_update_ms = std::max(stats_.max_update_ms,
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // program 须已 use()；feedback 为 true 时按反馈帧缓冲的分辨率偏移 lod
+    void bind(const ShaderProgram &program, GLuint page_table_unit, GLuint cache_unit, bool feedback = false) const {
+        glActiveTexture(GL_TEXTURE0 + page_table_unit);
+        glBindTexture(GL_TEXTURE_2D, page_table_);
+        glActiveTexture(GL_TEXTURE0 + cache_unit);
+        glBindTexture(GL_TEXTURE_2D, cache_);
+        glUniform1i(program.getUniformLocation("u_vt_page_table"), static_cast<GLint>(page_table_unit));
+        glUniform1i(program.getUniformLocation("u_vt_cache"), static_cast<GLint>(cache_unit));
+        const auto size{static_cast<float>(file_.virtual_size())};
+        glUniform4f(program.getUniformLocation("u_vt_params"), size, static_cast<float>(file_.level_count() - 1),
+            static_cast<float>(cache_pages_), feedback ? -std::log2(static_cast<float>(FEEDBACK_SCALE)) : 0.0f);
+        glUniform4f(program.getUniformLocation("u_vt_page"), static_cast<float>(file_.width()) / size,
+            static_cast<float>(file_.height()) / size, static_cast<float>(file_.page_size()), static_cast<float>(file_.border()));
+    }
+
+    size_t resident_pages() const { return resident_.size(); }
+    size_t cache_pages() const { return slots_.size(); }
+    const Image::MappedVirtualTexture &file() const { return file_; }
+    const VirtualTextureStats &stats() const { return stats_; }
+
+private:
+    static constexpr size_t UPLOAD_RING_PAGES{16};
+    static constexpr size_t MAX_PENDING_PAGES{64};
+    static constexpr uint32_t EMPTY_KEY{std::numeric_limits<uint32_t>::max()};
+
+    enum class UploadResult : uint8_t { Uploaded, Skipped, Retry, Thrashing };
+
+    struct Slot
+    {
+        uint32_t key{EMPTY_KEY};
+        uint64_t last_used{};
+        bool pinned{false};
+        bool occupied{false};
+    };
+
+    struct LoadedPage
+    {
+        uint32_t key{};
+        std::vector<uint8_t> pixels{};
+    };
+
+    struct Readback
+    {
+        GLuint buffer{};
+        const uint8_t *mapped{};
+        GLsync fence{};
+        uint64_t sequence{};
+    };
+
+    static constexpr uint32_t key(uint32_t level, uint32_t x, uint32_t y) { return level << 16 | y << 8 | x; }
+    static constexpr uint32_t key_level(uint32_t page) { return page >> 16; }
+    static constexpr uint32_t key_x(uint32_t page) { return page & 0xFF; }
+    static constexpr uint32_t key_y(uint32_t page) { return page >> 8 & 0xFF; }
+
+    void create_feedback(GLsizei width, GLsizei height) {
+        release_feedback();
+        feedback_width_ = width;
+        feedback_height_ = height;
+
+        GLint previous_renderbuffer{};
+        GLint previous_framebuffer{};
+        GLint previous_pack_buffer{};
+        glGetIntegerv(GL_RENDERBUFFER_BINDING, &previous_renderbuffer);
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_framebuffer);
+        glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &previous_pack_buffer);
+
+        glGenRenderbuffers(static_cast<GLsizei>(feedback_renderbuffers_.size()), feedback_renderbuffers_.data());
+        glBindRenderbuffer(GL_RENDERBUFFER, feedback_renderbuffers_[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, feedback_renderbuffers_[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glGenFramebuffers(1, &feedback_framebuffer_);
+        glBindFramebuffer(GL_FRAMEBUFFER, feedback_framebuffer_);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, feedback_renderbuffers_[0]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedback_renderbuffers_[1]);
+        const GLenum status{glCheckFramebufferStatus(GL_FRAMEBUFFER)};
+
+        constexpr GLbitfield MAP_FLAGS{GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+        const auto bytes{static_cast<GLsizeiptr>(width) * height * 4};
+        for (auto &readback : readbacks_) {
+            glGenBuffers(1, &readback.buffer);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+            glBufferStorage(GL_PIXEL_PACK_BUFFER, bytes, nullptr, MAP_FLAGS);
+            readback.mapped = static_cast<const uint8_t *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, MAP_FLAGS));
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, static_cast<GLuint>(previous_pack_buffer));
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous_framebuffer));
+        glBindRenderbuffer(GL_RENDERBUFFER, static_cast<GLuint>(previous_renderbuffer));
+        if (GL_FRAMEBUFFER_COMPLETE != status || std::ranges::any_of(readbacks_, [](const Readback &readback) { return nullptr == readback.mapped; })) {
+            throw std::runtime_error{std::format("ERROR::VIRTUAL_TEXTURE what:create {}x{} feedback buffer failed", width, height)};
+        }
+    }
+
+    void release_feedback() {
+        for (auto &readback : readbacks_) {
+            if (nullptr != readback.fence) {
+                glDeleteSync(readback.fence);
+            }
+            if (0 != readback.buffer) {
+                glDeleteBuffers(1, &readback.buffer);   // 删除时自动解除映射
+            }
+            readback = {};
+        }
+        if (0 != feedback_framebuffer_) {
+            glDeleteFramebuffers(1, &feedback_framebuffer_);
+            glDeleteRenderbuffers(static_cast<GLsizei>(feedback_renderbuffers_.size()), feedback_renderbuffers_.data());
+        }
+        feedback_framebuffer_ = 0;
+        feedback_renderbuffers_ = {};
+        feedback_width_ = 0;
+        feedback_height_ = 0;
+    }
+
+    // 按提交顺序解析 GPU 已完成的反馈；需要的页连同祖先标记为本帧使用，缺失的交给工作线程
+    void read_feedback() {
+        std::vector<uint32_t> requested;
+        while (true) {
+            Readback *oldest{};
+            for (auto &readback : readbacks_) {
+                if (nullptr != readback.fence && (nullptr == oldest || readback.sequence < oldest->sequence)) {
+                    oldest = &readback;
+                }
+            }
+            if (nullptr == oldest || GL_TIMEOUT_EXPIRED == glClientWaitSync(oldest->fence, 0, 0)) {
+                break;
+            }
+            glDeleteSync(oldest->fence);
+            oldest->fence = nullptr;
+            stats_.feedback_frames += 1;
+
+            const size_t n_pixels{static_cast<size_t>(feedback_width_) * static_cast<size_t>(feedback_height_)};
+            uint32_t previous{EMPTY_KEY};
+            for (size_t i{}; i < n_pixels; ++i) {
+                const uint8_t *pixel{oldest->mapped + i * 4};
+                if (255 != pixel[3]) {
+                    continue;
+                }
+                const uint32_t page{key(pixel[2], pixel[0], pixel[1])};
+                // 相邻像素多半请求同一页
+                if (page != previous && pixel[2] < file_.level_count()
+                    && pixel[0] < file_.pages_per_side(pixel[2]) && pixel[1] < file_.pages_per_side(pixel[2])) {
+                    requested.push_back(page);
+                    previous = page;
+                }
+            }
+        }
+        if (requested.empty()) {
+            return;
+        }
+
+        std::ranges::sort(requested);
+        const auto [first, last]{std::ranges::unique(requested)};
+        requested.erase(first, last);
+        std::unordered_set<uint32_t> needed;
+        for (const auto page : requested) {
+            uint32_t level{key_level(page)};
+            uint32_t x{key_x(page)};
+            uint32_t y{key_y(page)};
+            // 祖先已在集合中时，更粗的各级也已加入
+            for (; level < file_.level_count() && needed.insert(key(level, x, y)).second; ++level, x /= 2, y /= 2) {}
+        }
+
+        std::vector<uint32_t> missing;
+        for (const auto page : needed) {
+            if (const auto it{resident_.find(page)}; resident_.end() != it) {
+                slots_[it->second].last_used = frame_;
+            }
+            else if (!pending_.contains(page)) {
+                missing.push_back(page);
+            }
+        }
+        // 粗的级先读，尽快替换掉更模糊的祖先
+        std::ranges::sort(missing, std::ranges::greater{}, [](uint32_t page) { return key_level(page); });
+        std::lock_guard lock{mutex_};
+        for (const auto page : missing) {
+            if (pending_.size() >= MAX_PENDING_PAGES) {
+                break;
+            }
+            pending_.insert(page);
+            tasks_.push_back(page);
+            stats_.requested += 1;
+        }
+        tasks_cv_.notify_all();
+    }
+
+    // 工作线程：从映射的文件读出一页（首次访问时触发磁盘读取）
+    void worker_loop(std::stop_token token) {
+        std::unique_lock lock{mutex_};
+        while (tasks_cv_.wait(lock, token, [this] { return !tasks_.empty(); })) {
+            const uint32_t page{tasks_.front()};
+            tasks_.pop_front();
+            lock.unlock();
+            const auto source{file_.page(key_level(page), key_x(page), key_y(page))};
+            LoadedPage loaded{page, {source.begin(), source.end()}};
+            lock.lock();
+            loaded_.push_back(std::move(loaded));
+        }
+    }
+
+    // 选空槽或最久未使用的槽；槽中的页在本帧解析的反馈中仍需要（或刚上传）时不换出
+    UploadResult upload(const LoadedPage &page) {
+        if (resident_.contains(page.key)) {
+            return UploadResult::Skipped;
+        }
+        auto victim{slots_.end()};
+        for (auto it{slots_.begin()}; it != slots_.end(); ++it) {
+            if (!it->occupied) {
+                victim = it;
+                break;
+            }
+            if (!it->pinned && (slots_.end() == victim || it->last_used < victim->last_used)) {
+                victim = it;
+            }
+        }
+        if (slots_.end() == victim || (victim->occupied && victim->last_used == frame_)) {
+            stats_.thrashing += 1;
+            return UploadResult::Thrashing;
+        }
+
+        const auto allocation{ring_.try_allocate(page.pixels.size(), 16)};
+        if (!allocation.has_value()) {
+            return UploadResult::Retry;
+        }
+        std::memcpy(allocation->data, page.pixels.data(), page.pixels.size());
+
+        if (victim->occupied) {
+            resident_.erase(victim->key);
+            stats_.evicted += 1;
+        }
+        const auto index{static_cast<uint32_t>(victim - slots_.begin())};
+        const auto tile{static_cast<GLsizei>(file_.tile_size())};
+        glTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(index % cache_pages_) * tile, static_cast<GLint>(index / cache_pages_) * tile,
+            tile, tile, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void *>(allocation->offset));
+        *victim = {page.key, frame_, false, true};
+        resident_.emplace(page.key, index);
+        stats_.uploaded += 1;
+        return UploadResult::Uploaded;
+    }
+
+    // 从最粗一级往下：驻留的页指向自己的槽，其余继承父页的条目；调用前须解绑 GL_PIXEL_UNPACK_BUFFER
+    void upload_page_table() {
+        const auto levels{file_.level_count()};
+        for (uint32_t level{levels}; level-- > 0;) {
+            const uint32_t side{file_.pages_per_side(level)};
+            for (uint32_t y{}; y < side; ++y) {
+                for (uint32_t x{}; x < side; ++x) {
+                    auto &entry{table_[level][static_cast<size_t>(y) * side + x]};
+                    if (const auto it{resident_.find(key(level, x, y))}; resident_.end() != it) {
+                        entry = {static_cast<uint8_t>(it->second % cache_pages_), static_cast<uint8_t>(it->second / cache_pages_),
+                            static_cast<uint8_t>(level), 1};
+                    }
+                    else {
+                        entry = table_[level + 1][static_cast<size_t>(y / 2) * (side / 2) + x / 2];
+                    }
+                }
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, page_table_);
+        for (uint32_t level{}; level < levels; ++level) {
+            const auto side{static_cast<GLsizei>(file_.pages_per_side(level))};
+            glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), 0, 0, side, side, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, table_[level].data());
+        }
+        glBindTexture(GL_TEXTURE_2D, cache_);
+    }
+
+private:
+    Image::MappedVirtualTexture file_;
+    uint32_t cache_pages_{};        // 物理缓存每边的槽数
+    GLuint cache_{};
+    GLuint page_table_{};
+    std::vector<std::vector<std::array<uint8_t, 4>>> table_{};     // 页表的 CPU 副本，每级一个
+    std::vector<Slot> slots_{};
+    std::unordered_map<uint32_t, uint32_t> resident_{};            // 页 -> 槽
+    std::unordered_set<uint32_t> pending_{};                       // 已请求、尚未上传的页（仅 GL 线程）
+    UploadRing ring_;
+    uint64_t frame_{};
+
+    GLuint feedback_framebuffer_{};
+    std::array<GLuint, 2> feedback_renderbuffers_{};               // 颜色、深度
+    GLsizei feedback_width_{};
+    GLsizei feedback_height_{};
+    std::array<Readback, 3> readbacks_{};
+    uint64_t readback_sequence_{};
+    GLint previous_framebuffer_{};
+    std::array<GLint, 4> previous_viewport_{};
+
+    VirtualTextureStats stats_{};
+
+    std::mutex mutex_{};
+    std::condition_variable_any tasks_cv_{};
+    std::deque<uint32_t> tasks_{};
+    std::deque<LoadedPage> loaded_{};
+
+    // 最后声明，析构时先停止工作线程
+    std::vector<std::jthread> workers_{};
+};
+
+} // namespace GL
@@ -0,0 +1,169 @@
+#include <cstdio>
+#include <exception>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "opengl/gl_residency.hpp"
+
+/**
+ * GL::ResidencyManager 的驱逐、异步加载与推迟释放，不需要 GL 上下文：
+ * 资源的加载、卸载只修改计数，用量由测试提供
+ */
+
+namespace {
+
+void check(bool condition, std::string_view what)
+{
+    if (!condition) {
+        throw std::runtime_error{std::format("ERROR::RESIDENCY_TEST what:{}", what)};
+    }
+}
+
+// 模拟 GL 分配：unload 只登记待删除，flush() 时才真正释放（与 TextureCache 在下一次 update() 时删除相同）
+struct FakeMemory
+{
+    uint64_t allocated{};
+    uint64_t deferred{};
+    bool defer_free{false};
+
+    GL::ResidencyManager::Loader loader(uint64_t bytes) {
+        return [this, bytes] {
+            allocated += bytes;
+            return std::optional<uint64_t>{bytes};
+        };
+    }
+    GL::ResidencyManager::Unloader unloader(uint64_t bytes) {
+        return [this, bytes] {
+            if (defer_free) {
+                deferred += bytes;
+            }
+            else {
+                allocated -= bytes;
+            }
+        };
+    }
+    void flush() {
+        allocated -= deferred;
+        deferred = 0;
+    }
+};
+
+// 本帧用过的资源不驱逐；超出预算时从最久未使用的开始驱逐
+void evicts_least_recently_used()
+{
+    FakeMemory memory;
+    GL::ResidencyManager residency{100, [&memory] { return memory.allocated; }};
+    std::vector<GL::ResourceId> ids;
+    for (int i{}; i < 3; ++i) {
+        ids.push_back(residency.add(GL::ResourceKind::Texture, memory.loader(60), memory.unloader(60)));
+    }
+
+    for (const auto id : ids) {
+        check(residency.use(id), "synchronous load is resident at once");
+    }
+    residency.end_frame();
+    check(180 == memory.allocated, "nothing used this frame is evicted");
+    check(1 == residency.stats().over_budget_frames, "frame over budget is counted");
+
+    residency.use(ids[2]);
+    residency.end_frame();
+    check(!residency.resident(ids[0]) && !residency.resident(ids[1]) && residency.resident(ids[2]), "oldest two are evicted");
+    check(60 == memory.allocated, "usage is back under budget");
+    check(2 == residency.stats().kind(GL::ResourceKind::Texture).evictions, "evictions are counted");
+
+    check(residency.use(ids[0]), "evicted resource reloads on use");
+    check(1 == residency.stats().kind(GL::ResourceKind::Texture).reloads, "reload is counted");
+}
+
+// 卸载推迟时用量在本帧不下降，只驱逐够用的资源，而不是全部
+void deferred_free_evicts_only_what_is_needed()
+{
+    FakeMemory memory{.defer_free = true};
+    GL::ResidencyManager residency{130, [&memory] { return memory.allocated; }};
+    std::vector<GL::ResourceId> ids;
+    for (int i{}; i < 3; ++i) {
+        ids.push_back(residency.add(GL::ResourceKind::Texture, memory.loader(60), memory.unloader(60)));
+        residency.use(ids.back());
+    }
+    residency.end_frame();
+
+    residency.use(ids[2]);
+    residency.end_frame();
+    check(!residency.resident(ids[0]), "least recently used is evicted");
+    check(residency.resident(ids[1]), "one eviction covers the overshoot although usage has not dropped yet");
+    memory.flush();
+    check(120 == memory.allocated, "deferred free happens on flush");
+
+    residency.use(ids[2]);
+    residency.end_frame();
+    check(residency.resident(ids[1]), "nothing more is evicted once the deferred free lands");
+}
+
+// load 返回 nullopt 时为异步加载：use() 返回 false，直到 load 返回字节数
+void asynchronous_load()
+{
+    int polls{};
+    bool unloaded{};
+    GL::ResidencyManager residency{1024, [] { return uint64_t{0}; }};
+    const auto id{residency.add(GL::ResourceKind::Texture, [&polls]() -> std::optional<uint64_t> {
+        if (++polls < 3) {
+            return std::nullopt;
+        }
+        return 256;
+    }, [&unloaded] { unloaded = true; })};
+
+    check(!residency.use(id), "first use starts the load");
+    check(1 == residency.stats().kind(GL::ResourceKind::Texture).loading, "loading resource is counted");
+    residency.end_frame();
+    check(!residency.use(id), "still loading");
+    check(residency.use(id), "resident once load returns bytes");
+    check(0 == residency.stats().kind(GL::ResourceKind::Texture).loading, "loading count drops");
+    check(256 == residency.stats().kind(GL::ResourceKind::Texture).resident_bytes, "bytes are recorded");
+
+    // 加载中途移除时放弃加载
+    polls = 0;
+    const auto pending{residency.add(GL::ResourceKind::Texture, [&polls]() -> std::optional<uint64_t> {
+        ++polls;
+        return std::nullopt;
+    }, [&unloaded] { unloaded = true; })};
+    check(!residency.use(pending), "pending load");
+    residency.remove(pending);
+    check(unloaded, "remove cancels a pending load");
+    check(0 == residency.stats().kind(GL::ResourceKind::Texture).loading, "cancelled load is not counted");
+}
+
+void non_evictable_stays_resident()
+{
+    FakeMemory memory;
+    GL::ResidencyManager residency{10, [&memory] { return memory.allocated; }};
+    const auto pinned{residency.add(GL::ResourceKind::Texture, memory.loader(100), memory.unloader(100), false)};
+    const auto mesh{residency.add(GL::ResourceKind::Mesh, memory.loader(50), memory.unloader(50))};
+    residency.use(pinned);
+    residency.use(mesh);
+    residency.end_frame();
+    residency.end_frame();
+    check(residency.resident(pinned), "non-evictable resource is never evicted");
+    check(!residency.resident(mesh), "evictable resource is evicted");
+    check(2 == residency.stats().over_budget_frames, "pinned bytes keep the frames over budget");
+}
+
+} // namespace
+
+int main()
+{
+    try {
+        evicts_least_recently_used();
+        deferred_free_evicts_only_what_is_needed();
+        asynchronous_load();
+        non_evictable_stays_resident();
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    std::printf("residency_test: passed\n");
+    return 0;
+}
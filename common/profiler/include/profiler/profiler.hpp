@@ -0,0 +1,326 @@
+#pragma once
+
+#include <cinttypes>
+#include <filesystem>
+#include <string_view>
+
+#if defined(PROFILER_ENABLED)
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+#endif
+
+/**
+ * CPU zone profiler
+ *
+ * PROFILE_SCOPE("name") 在作用域结束时向当前线程的缓冲写入一个 {name, begin, end} 事件，
+ * 缓冲为单生产者的块链表，写入不加锁；导出时按块读取已发布的事件，生成 Chrome / Perfetto trace JSON。
+ * x86-64 上用 rdtsc 计时（要求 invariant TSC），导出时按 steady_clock 线性换算为纳秒，
+ * 因此可以与 GL::GpuProfiler 换算后的 GPU zone 放在同一时间轴上。
+ *
+ * 只有定义 PROFILER_ENABLED（cmake -DENABLE_PROFILER=ON）时才编译，
+ * 否则全部宏展开为空、接口为空实现。
+ * name 必须是字符串常量（只保存指针）。
+ */
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+
+#if defined(PROFILER_ENABLED)
+#define PROFILE_SCOPE(name) const ::Profiler::Scope PROFILER_CONCAT(profile_scope_, __LINE__){name}
+#define PROFILE_FRAME() ::Profiler::frame_mark()
+#define PROFILE_THREAD_NAME(name) ::Profiler::set_thread_name(name)
+#else
+#define PROFILE_SCOPE(name) static_cast<void>(0)
+#define PROFILE_FRAME() static_cast<void>(0)
+#define PROFILE_THREAD_NAME(name) static_cast<void>(0)
+#endif
+
+namespace Profiler {
+
+#if defined(PROFILER_ENABLED)
+
+inline constexpr bool ENABLED{true};
+
+namespace detail {
+
+inline constexpr char FRAME_MARKER[]{"frame"};
+inline constexpr uint32_t GPU_THREAD_ID{~uint32_t{}};
+
+inline int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t ticks()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(now_ns());
+#endif
+}
+
+struct Event
+{
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// 单生产者块链表：写线程填满一块后挂上新块，count 以 release 发布，读线程 acquire 读取
+struct Block
+{
+    static constexpr size_t CAPACITY{4096};
+
+    std::array<Event, CAPACITY> events{};
+    std::atomic<size_t> count{0};
+    std::atomic<Block *> next{nullptr};
+};
+
+struct ThreadBuffer
+{
+    uint32_t thread_id{};
+    std::string name{};
+    bool ticks_are_ns{false};   // GPU zone 直接以纳秒写入
+    std::unique_ptr<Block> head{std::make_unique<Block>()};
+    Block *tail{head.get()};
+    std::vector<std::unique_ptr<Block>> owned{};   // 仅写线程修改
+
+    void push(const char *event_name, uint64_t begin, uint64_t end) {
+        size_t index{tail->count.load(std::memory_order_relaxed)};
+        if (Block::CAPACITY == index) {
+            auto block{std::make_unique<Block>()};
+            Block *next{block.get()};
+            owned.push_back(std::move(block));
+            tail->next.store(next, std::memory_order_release);
+            tail = next;
+            index = 0;
+        }
+        tail->events[index] = {event_name, begin, end};
+        tail->count.store(index + 1, std::memory_order_release);
+    }
+};
+
+// 时钟校准点：程序首次使用 profiler 时记录，导出时与当前时刻一起做线性换算
+struct Calibration
+{
+    uint64_t ticks{detail::ticks()};
+    int64_t ns{now_ns()};
+};
+
+struct Registry
+{
+    std::mutex mutex{};
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers{};
+    uint32_t next_thread_id{1};
+    Calibration origin{};
+};
+
+inline Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+inline ThreadBuffer &thread_buffer()
+{
+    thread_local ThreadBuffer *buffer{nullptr};
+    if (nullptr == buffer) {
+        auto &reg{registry()};
+        std::lock_guard lock{reg.mutex};
+        auto &owned{reg.buffers.emplace_back(std::make_unique<ThreadBuffer>())};
+        owned->thread_id = reg.next_thread_id++;
+        buffer = owned.get();
+    }
+    return *buffer;
+}
+
+inline ThreadBuffer &gpu_buffer()
+{
+    static ThreadBuffer *buffer{[] {
+        auto &reg{registry()};
+        std::lock_guard lock{reg.mutex};
+        auto &owned{reg.buffers.emplace_back(std::make_unique<ThreadBuffer>())};
+        owned->thread_id = GPU_THREAD_ID;
+        owned->name = "GPU";
+        owned->ticks_are_ns = true;
+        return owned.get();
+    }()};
+    return *buffer;
+}
+
+inline void append_json_string(std::string &out, std::string_view text)
+{
+    out += '"';
+    for (const char c : text) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += std::format("\\u{:04x}", static_cast<unsigned>(c));
+                }
+                else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+} // namespace detail
+
+class Scope
+{
+public:
+    explicit Scope(const char *name) : name_{name}, begin_{detail::ticks()} {}
+    ~Scope() { detail::thread_buffer().push(name_, begin_, detail::ticks()); }
+    Scope(const Scope &) = delete;
+    Scope(Scope &&) = delete;
+    Scope &operator=(const Scope &) = delete;
+    Scope &operator=(Scope &&) = delete;
+
+private:
+    const char *name_{};
+    uint64_t begin_{};
+};
+
+// 帧标记，在 SDL_AppIterate 开头调用
+inline void frame_mark()
+{
+    const auto now{detail::ticks()};
+    detail::thread_buffer().push(detail::FRAME_MARKER, now, now);
+}
+
+inline void set_thread_name(std::string_view name)
+{
+    auto &buffer{detail::thread_buffer()};
+    std::lock_guard lock{detail::registry().mutex};
+    buffer.name = name;
+}
+
+/**
+ * 写入一个 GPU zone，时间为 steady_clock 纳秒（GL::GpuZone::begin_ns / end_ns）
+ * 需在同一线程（GL 线程）调用
+ */
+inline void add_gpu_zone(const char *name, int64_t begin_ns, int64_t end_ns)
+{
+    detail::gpu_buffer().push(name, static_cast<uint64_t>(begin_ns), static_cast<uint64_t>(end_ns));
+}
+
+/**
+ * 导出为 Chrome trace event JSON（chrome://tracing / ui.perfetto.dev）
+ * 可以在其他线程仍在写入时调用，只导出调用时已发布的事件
+ * 时间以 profiler 首次使用为 0；早于它的事件（先于注册表构造开始的 zone、更早的 GPU zone）
+ * 会让整条时间轴平移，使最早的事件从 0 开始，部分查看器不接受负的 ts
+ */
+inline size_t write_chrome_trace(const std::filesystem::path &path)
+{
+    auto &reg{detail::registry()};
+    const detail::Calibration now{};
+    const auto &origin{reg.origin};
+    const double ns_per_tick{now.ticks > origin.ticks
+        ? static_cast<double>(now.ns - origin.ns) / static_cast<double>(now.ticks - origin.ticks)
+        : 1.0};
+    const auto to_us = [&](const detail::ThreadBuffer &buffer, uint64_t value) -> double {
+        if (buffer.ticks_are_ns) {
+            return static_cast<double>(static_cast<int64_t>(value) - origin.ns) / 1e3;
+        }
+        return (static_cast<double>(value) - static_cast<double>(origin.ticks)) * ns_per_tick / 1e3;
+    };
+
+    std::unique_ptr<std::FILE, int (*)(std::FILE *)> file{std::fopen(path.string().c_str(), "wb"), &std::fclose};
+    if (nullptr == file) {
+        throw std::runtime_error{std::format("ERROR::PROFILER what:can not open {}", path.string())};
+    }
+
+    std::lock_guard lock{reg.mutex};
+    // 第一遍只求最早的时间；之后发布的事件只会更晚
+    double earliest{0.0};
+    for (const auto &buffer : reg.buffers) {
+        for (const detail::Block *block{buffer->head.get()}; nullptr != block;
+             block = block->next.load(std::memory_order_acquire)) {
+            const size_t count{block->count.load(std::memory_order_acquire)};
+            for (size_t i{}; i < count; ++i) {
+                earliest = std::min(earliest, to_us(*buffer, block->events[i].begin));
+            }
+        }
+    }
+
+    std::string out{"{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"};
+    size_t event_count{};
+    // 除第一个对象外，每个对象前加逗号
+    bool first{true};
+    const auto separate = [&] {
+        out += first ? "" : ",\n";
+        first = false;
+    };
+    for (const auto &buffer : reg.buffers) {
+        separate();
+        out += std::format("{{\"ph\":\"M\",\"pid\":1,\"tid\":{},\"name\":\"thread_name\",\"args\":{{\"name\":",
+            buffer->thread_id);
+        detail::append_json_string(out, buffer->name.empty() ? std::format("thread {}", buffer->thread_id) : buffer->name);
+        out += "}}";
+
+        for (const detail::Block *block{buffer->head.get()}; nullptr != block;
+             block = block->next.load(std::memory_order_acquire)) {
+            const size_t count{block->count.load(std::memory_order_acquire)};
+            for (size_t i{}; i < count; ++i) {
+                const auto &event{block->events[i]};
+                const double begin{to_us(*buffer, event.begin) - earliest};
+                separate();
+                if (detail::FRAME_MARKER == event.name) {
+                    out += std::format("{{\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"name\":\"frame\"}}",
+                        buffer->thread_id, begin);
+                }
+                else {
+                    const double end{to_us(*buffer, event.end) - earliest};
+                    out += std::format("{{\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},\"name\":",
+                        buffer->thread_id, begin, std::max(0.0, end - begin));
+                    detail::append_json_string(out, event.name);
+                    out += "}";
+                }
+                event_count += 1;
+            }
+            if (out.size() > (1 << 20)) {
+                std::fwrite(out.data(), 1, out.size(), file.get());
+                out.clear();
+            }
+        }
+    }
+    out += "\n]}\n";
+    std::fwrite(out.data(), 1, out.size(), file.get());
+    return event_count;
+}
+
+#else
+
+inline constexpr bool ENABLED{false};
+
+inline void frame_mark() {}
+inline void set_thread_name(std::string_view) {}
+inline void add_gpu_zone(const char *, int64_t, int64_t) {}
+inline size_t write_chrome_trace(const std::filesystem::path &) { return 0; }
+
+#endif
+
+} // namespace Profiler
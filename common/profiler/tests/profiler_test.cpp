@@ -0,0 +1,98 @@
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "profiler/profiler.hpp"
+
+/**
+ * Profiler::write_chrome_trace 输出合法的 trace JSON：对象之间恰好一个逗号、没有占位对象，
+ * 早于 profiler 首次使用的 zone 与 GPU zone 也不产生负的 ts
+ */
+
+namespace {
+
+namespace fs = std::filesystem;
+
+void check(bool condition, std::string_view what)
+{
+    if (!condition) {
+        throw std::runtime_error{std::format("ERROR::PROFILER_TEST what:{}", what)};
+    }
+}
+
+std::string read_file(const fs::path &path)
+{
+    std::ifstream file{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+// 每个 "ts": 后的数值都不小于 0，返回 ts 的个数
+size_t check_timestamps(std::string_view json)
+{
+    constexpr std::string_view KEY{"\"ts\":"};
+    size_t count{};
+    for (size_t at{json.find(KEY)}; std::string_view::npos != at; at = json.find(KEY, at + 1)) {
+        const char *begin{json.data() + at + KEY.size()};
+        double ts{};
+        const auto [end, ec]{std::from_chars(begin, json.data() + json.size(), ts)};
+        check(std::errc{} == ec && end != begin, "ts is a number");
+        check(ts >= 0.0, std::format("ts {} is not negative", ts));
+        count += 1;
+    }
+    return count;
+}
+
+} // namespace
+
+int main()
+{
+    try {
+        {
+            // 第一个 zone 在注册表（时间原点）构造之前开始
+            PROFILE_SCOPE("before origin");
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        PROFILE_THREAD_NAME("main \"thread\"");
+        PROFILE_FRAME();
+        {
+            PROFILE_SCOPE("work");
+        }
+        std::jthread{[] {
+            PROFILE_SCOPE("worker");
+        }}.join();
+        // GPU zone 早于原点 5 ms
+        const auto now_ns{std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count()};
+        Profiler::add_gpu_zone("gpu", now_ns - 10'000'000, now_ns - 5'000'000);
+
+        const auto path{fs::temp_directory_path() / std::format("profiler_test_{}.json", std::random_device{}())};
+        const size_t events{Profiler::write_chrome_trace(path)};
+        const auto json{read_file(path)};
+        fs::remove(path);
+
+        check(5 == events, std::format("5 events exported, got {}", events));
+        check(json.starts_with("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"), "header");
+        check(json.ends_with("}\n]}\n"), "last object closes the array");
+        check(std::string::npos == json.find("{}"), "no placeholder object");
+        check(std::string::npos == json.find(",\n]") && std::string::npos == json.find("[\n,"), "no stray comma");
+        check(std::string::npos != json.find("\"main \\\"thread\\\"\""), "thread name is escaped");
+        check(5 == check_timestamps(json), "every event has a ts");
+        check(std::string::npos != json.find("\"ts\":0.000,"), "earliest event starts at 0");
+    }
+    catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    std::printf("profiler_test: passed\n");
+    return 0;
+}